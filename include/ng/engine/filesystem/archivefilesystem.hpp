@@ -0,0 +1,88 @@
+#ifndef NG_ARCHIVEFILESYSTEM_HPP
+#define NG_ARCHIVEFILESYSTEM_HPP
+
+#include "ng/engine/filesystem/filesystem.hpp"
+
+#include "ng/engine/util/stringview.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ng
+{
+
+class IReadFile;
+
+// Serves files out of a single .ngpak archive: a table of contents sorted
+// by path, followed by the contents of every file. Opening a file is a
+// binary search over the table, so the OS filesystem is only touched
+// once, to open the archive itself.
+//
+// Files may be stored as is, which reads them straight out of the
+// archive's memory, or LZ4 compressed in independent blocks, which are
+// decompressed in parallel when the file is large enough.
+class ArchiveFileSystem : public IFileSystem
+{
+public:
+    class Entry
+    {
+    public:
+        string_view Path;
+        std::size_t Size;
+        std::size_t StoredSize;
+        bool IsCompressed;
+        const char* Data;
+    };
+
+private:
+    std::shared_ptr<IReadFile> mArchive;
+
+    // sorted by Path.
+    std::vector<Entry> mEntries;
+
+    const Entry* FindEntry(const char* path) const;
+
+    std::shared_ptr<IReadFile> OpenEntry(const Entry& entry, bool allowParallel) const;
+
+public:
+    // throws std::runtime_error if the file isn't a valid .ngpak
+    // of the version this was compiled with.
+    explicit ArchiveFileSystem(std::shared_ptr<IReadFile> archiveFile);
+
+    // paths are normalized with NormalizePath before they're looked up.
+    // throws std::runtime_error if there's no such file in the archive.
+    std::shared_ptr<IReadFile> GetReadFile(
+        const char* path, FileReadMode mode) override;
+
+    // opens several files at once, decompressing them in parallel.
+    std::vector<std::shared_ptr<IReadFile>> GetReadFiles(
+        const std::vector<std::string>& paths, FileReadMode mode);
+
+    bool Contains(const char* path) const;
+
+    const std::vector<Entry>& GetEntries() const
+    {
+        return mEntries;
+    }
+};
+
+class ArchiveInput
+{
+public:
+    // stored normalized with NormalizePath.
+    std::string Path;
+    string_view Contents;
+};
+
+// writes the inputs to an .ngpak archive. With compress set, each file
+// is compressed unless that wouldn't make it any smaller.
+// throws std::runtime_error if two inputs have the same path.
+void SaveArchive(
+        const char* path,
+        const std::vector<ArchiveInput>& inputs,
+        bool compress);
+
+} // end namespace ng
+
+#endif // NG_ARCHIVEFILESYSTEM_HPP
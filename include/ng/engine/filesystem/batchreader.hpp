@@ -0,0 +1,151 @@
+#ifndef NG_BATCHREADER_HPP
+#define NG_BATCHREADER_HPP
+
+#include "ng/engine/filesystem/filesystem.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ng
+{
+
+class IReadFile;
+
+class BatchReadRequest
+{
+public:
+    std::string Path;
+
+    // the file is read from Offset until Size bytes were read or it ends.
+    char* Buffer;
+    std::size_t Size;
+    std::size_t Offset = 0;
+};
+
+class BatchReadResult
+{
+public:
+    std::size_t BytesRead;
+
+    // an errno value, or 0 if the read succeeded.
+    int Error;
+};
+
+class BatchReadStats
+{
+public:
+    bool UsedIoUring;
+    std::size_t QueueDepth;
+
+    // the most requests that were ever in flight at once.
+    std::size_t MaxInFlight;
+
+    std::size_t NumFiles;
+    std::size_t NumFailed;
+    std::size_t NumBytes;
+    double Seconds;
+
+    double GetMegabytesPerSecond() const
+    {
+        return Seconds > 0.0 ? NumBytes / (1024.0 * 1024.0) / Seconds : 0.0;
+    }
+};
+
+// Reads many files at once, keeping up to a queue depth of open and
+// read requests in flight. On Linux, requests go through io_uring.
+// Elsewhere, or if io_uring is unavailable, a pool of threads with one
+// thread per queue slot reads them with pread.
+//
+// Deeper queues pay off on storage that serves many requests in parallel
+// (NVMe), shallower ones avoid thrashing slow or remote storage.
+class BatchReader
+{
+    class IoUring;
+
+    std::unique_ptr<IoUring> mRing;
+    std::size_t mQueueDepth;
+
+    BatchReadStats ReadWithIoUring(
+            const std::vector<BatchReadRequest>& requests,
+            const std::function<void(std::size_t, const BatchReadResult&)>& onComplete);
+
+    BatchReadStats ReadWithThreads(
+            const std::vector<BatchReadRequest>& requests,
+            const std::function<void(std::size_t, const BatchReadResult&)>& onComplete);
+
+public:
+    // with allowIoUring unset, the thread pool is used even where
+    // io_uring is available, eg. to compare the two.
+    explicit BatchReader(std::size_t queueDepth = 32, bool allowIoUring = true);
+    ~BatchReader();
+
+    BatchReader(const BatchReader&) = delete;
+    BatchReader& operator=(const BatchReader&) = delete;
+
+    bool UsesIoUring() const
+    {
+        return mRing != nullptr;
+    }
+
+    std::size_t GetQueueDepth() const
+    {
+        return mQueueDepth;
+    }
+
+    // reads all the requests, calling onComplete(requestIndex, result) on
+    // the calling thread as each one finishes, in the order they finish.
+    // exceptions thrown by onComplete are rethrown once the reads in
+    // flight are done.
+    BatchReadStats Read(
+            const std::vector<BatchReadRequest>& requests,
+            std::function<void(std::size_t, const BatchReadResult&)> onComplete);
+};
+
+// Serves files that were read ahead of time with a BatchReader,
+// and anything else through another file system.
+class PreloadFileSystem : public IFileSystem
+{
+    class PreloadedFile
+    {
+    public:
+        std::shared_ptr<const char> Buffer;
+        std::size_t Size;
+    };
+
+    std::shared_ptr<IFileSystem> mFallback;
+    BatchReader mReader;
+
+    // keyed by normalized path.
+    std::mutex mMutex;
+    std::map<std::string, PreloadedFile> mPreloaded;
+
+public:
+    PreloadFileSystem(std::shared_ptr<IFileSystem> fallback, std::size_t queueDepth = 32);
+
+    // reads the files in one batch. onLoaded(path, file) is called as each
+    // file lands, so parsing can start before the whole batch is read.
+    // files that can't be read are skipped, and counted in NumFailed.
+    BatchReadStats Preload(
+            const std::vector<std::string>& paths,
+            std::function<void(const std::string&, std::shared_ptr<IReadFile>)> onLoaded = nullptr);
+
+    // drops the preloaded copy of the file, if there is one.
+    void Evict(const std::string& path);
+
+    std::shared_ptr<IReadFile> GetReadFile(
+        const char* path, FileReadMode mode) override;
+
+    const BatchReader& GetReader() const
+    {
+        return mReader;
+    }
+};
+
+} // end namespace ng
+
+#endif // NG_BATCHREADER_HPP
@@ -0,0 +1,70 @@
+#ifndef NG_MEMORYREADFILE_HPP
+#define NG_MEMORYREADFILE_HPP
+
+#include "ng/engine/filesystem/readfile.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ng
+{
+
+// Serves ReadRecords out of a block of memory holding the whole file,
+// so reading byte by byte costs a memcpy instead of a trip through stdio.
+class MemoryReadFile : public IReadFile
+{
+    const char* mData = nullptr;
+    std::size_t mSize = 0;
+    std::size_t mPosition = 0;
+    bool mEoF = false;
+
+protected:
+    void SetContents(const char* data, std::size_t size)
+    {
+        mData = data;
+        mSize = size;
+    }
+
+public:
+    std::size_t ReadRecords(
+        void *buffer,
+        std::size_t recordSize,
+        std::size_t recordCount) override
+    {
+        if (recordSize == 0)
+        {
+            return 0;
+        }
+
+        std::size_t available = (mSize - mPosition) / recordSize;
+        std::size_t numRead = std::min(recordCount, available);
+
+        if (numRead > 0)
+        {
+            std::memcpy(buffer, mData + mPosition, numRead * recordSize);
+            mPosition += numRead * recordSize;
+        }
+
+        // same as feof: only set once a read comes up short.
+        if (numRead < recordCount)
+        {
+            mEoF = true;
+        }
+
+        return numRead;
+    }
+
+    bool EoF() const override
+    {
+        return mEoF;
+    }
+
+    string_view GetContents() const override
+    {
+        return string_view(mData, mSize);
+    }
+};
+
+} // end namespace ng
+
+#endif // NG_MEMORYREADFILE_HPP
@@ -0,0 +1,18 @@
+#ifndef NG_PATH_HPP
+#define NG_PATH_HPP
+
+#include "ng/engine/util/stringview.hpp"
+
+#include <string>
+
+namespace ng
+{
+
+// collapses "." and ".." components, repeated separators and backslashes,
+// so "models/./bob//x/../bob.md5mesh" and "models\bob\bob.md5mesh"
+// both become "models/bob/bob.md5mesh".
+std::string NormalizePath(string_view path);
+
+} // end namespace ng
+
+#endif // NG_PATH_HPP
@@ -1,6 +1,8 @@
 #ifndef NG_READFILE_HPP
 #define NG_READFILE_HPP
 
+#include "ng/engine/util/stringview.hpp"
+
 #include <cstddef>
 #include <string>
 
@@ -18,6 +20,11 @@ public:
         std::size_t recordCount) = 0;
 
     virtual bool EoF() const = 0;
+
+    // The whole file as one contiguous block of bytes,
+    // regardless of how much was consumed through ReadRecords.
+    // Stays valid for as long as the file is alive.
+    virtual string_view GetContents() const = 0;
 };
 
 bool getline(std::string& s, IReadFile& file);
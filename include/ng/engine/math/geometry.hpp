@@ -4,6 +4,7 @@
 #include "ng/engine/math/linearalgebra.hpp"
 
 #include <limits>
+#include <utility>
 
 namespace ng
 {
@@ -78,8 +79,28 @@ public:
         if (point.y > Maximum.y) Maximum.y = point.y;
         if (point.z > Maximum.z) Maximum.z = point.z;
     }
+
+    void AddBox(const AxisAlignedBoundingBox<T>& box)
+    {
+        AddPoint(box.Minimum);
+        AddPoint(box.Maximum);
+    }
+
+    T GetSurfaceArea() const
+    {
+        vec<T,3> size = Maximum - Minimum;
+        return 2 * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
 };
 
+// contains everything, for things whose bounds aren't known.
+template<class T>
+AxisAlignedBoundingBox<T> InfiniteBounds()
+{
+    T inf = std::numeric_limits<T>::infinity();
+    return AxisAlignedBoundingBox<T>(vec<T,3>(-inf), vec<T,3>(inf));
+}
+
 template<class T>
 class Sphere
 {
@@ -95,6 +116,43 @@ public:
     { }
 };
 
+// the volume seen through a camera, as six planes facing inwards.
+template<class T>
+class Frustum
+{
+public:
+    enum PlaneIndex
+    {
+        Left, Right, Bottom, Top, Near, Far
+    };
+
+    Plane<T> Planes[6];
+
+    Frustum() = default;
+
+    // the planes of a projection * view matrix, with OpenGL's clip space.
+    explicit Frustum(const mat<T,4,4>& viewProjection)
+    {
+        vec<T,4> rows[4];
+        for (int row = 0; row < 4; row++)
+        {
+            rows[row] = vec<T,4>(viewProjection[0][row], viewProjection[1][row],
+                                 viewProjection[2][row], viewProjection[3][row]);
+        }
+
+        vec<T,4> planes[6] = {
+            rows[3] + rows[0], rows[3] - rows[0],
+            rows[3] + rows[1], rows[3] - rows[1],
+            rows[3] + rows[2], rows[3] - rows[2]
+        };
+
+        for (int i = 0; i < 6; i++)
+        {
+            Planes[i] = Plane<T>(vec<T,3>(planes[i]), planes[i].w);
+        }
+    }
+};
+
 template<class T>
 class Point
 {
@@ -112,17 +170,82 @@ template<class T>
 bool AABBoxIntersect(const AxisAlignedBoundingBox<T>& a, const AxisAlignedBoundingBox<T>& b)
 {
     bool xOverlap = (a.Minimum.x >= b.Minimum.x && a.Minimum.x <= b.Maximum.x) ||
-                    (b.Minimum.x >= a.Minimum.x && b.Minimum.x <= b.Maximum.x);
+                    (b.Minimum.x >= a.Minimum.x && b.Minimum.x <= a.Maximum.x);
 
     bool yOverlap = (a.Minimum.y >= b.Minimum.y && a.Minimum.y <= b.Maximum.y) ||
-                    (b.Minimum.y >= a.Minimum.y && b.Minimum.y <= b.Maximum.y);
+                    (b.Minimum.y >= a.Minimum.y && b.Minimum.y <= a.Maximum.y);
 
     bool zOverlap = (a.Minimum.z >= b.Minimum.z && a.Minimum.z <= b.Maximum.z) ||
-                    (b.Minimum.z >= a.Minimum.z && b.Minimum.z <= b.Maximum.z);
+                    (b.Minimum.z >= a.Minimum.z && b.Minimum.z <= a.Maximum.z);
 
     return xOverlap && yOverlap && zOverlap;
 }
 
+// conservative: a few boxes just outside the corners of the frustum
+// are reported as intersecting it.
+template<class T>
+bool FrustumAABBoxIntersect(const Frustum<T>& frustum, const AxisAlignedBoundingBox<T>& box)
+{
+    for (const Plane<T>& plane : frustum.Planes)
+    {
+        // the corner furthest along the plane's normal.
+        vec<T,3> corner(
+            plane.Normal.x >= 0 ? box.Maximum.x : box.Minimum.x,
+            plane.Normal.y >= 0 ? box.Maximum.y : box.Minimum.y,
+            plane.Normal.z >= 0 ? box.Maximum.z : box.Minimum.z);
+
+        if (dot(plane.Normal, corner) + plane.D < 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// the frustum's planes don't need to be normalized.
+template<class T>
+bool FrustumSphereIntersect(const Frustum<T>& frustum, const Sphere<T>& sphere)
+{
+    for (const Plane<T>& plane : frustum.Planes)
+    {
+        if (dot(plane.Normal, sphere.Center) + plane.D < -sphere.Radius * length(plane.Normal))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// returns where the ray enters the box, or tmin if it starts inside it.
+template<class T>
+bool RayAABBoxIntersect(const Ray<T>& ray, const AxisAlignedBoundingBox<T>& box, T tmin, T tmax, T& t)
+{
+    for (int axis = 0; axis < 3; axis++)
+    {
+        T inverseDirection = 1 / ray.Direction[axis];
+        T t0 = (box.Minimum[axis] - ray.Origin[axis]) * inverseDirection;
+        T t1 = (box.Maximum[axis] - ray.Origin[axis]) * inverseDirection;
+
+        if (inverseDirection < 0)
+        {
+            std::swap(t0, t1);
+        }
+
+        tmin = t0 > tmin ? t0 : tmin;
+        tmax = t1 < tmax ? t1 : tmax;
+
+        if (tmax < tmin)
+        {
+            return false;
+        }
+    }
+
+    t = tmin;
+    return true;
+}
+
 template<class T>
 bool RayPlaneIntersect(const Ray<T>& ray, const Plane<T>& plane, T tmin, T tmax, T& t)
 {
@@ -187,6 +310,52 @@ bool RaySphereIntersect(const Ray<T>& ray, const Sphere<T>& sphere, T tmin, T tm
     return true;
 }
 
+// Möller and Trumbore's ray-triangle intersection, hitting both sides.
+// u and v are the barycentric coordinates of the hit relative to v1 and v2.
+template<class T>
+bool RayTriangleIntersect(const Ray<T>& ray, const vec<T,3>& v0, const vec<T,3>& v1, const vec<T,3>& v2,
+                          T tmin, T tmax, T& t, T& u, T& v)
+{
+    vec<T,3> edge1 = v1 - v0;
+    vec<T,3> edge2 = v2 - v0;
+
+    vec<T,3> p = cross(ray.Direction, edge2);
+    T determinant = dot(edge1, p);
+
+    if (std::abs(determinant) <= std::numeric_limits<T>::epsilon())
+    {
+        // parallel to the triangle
+        return false;
+    }
+
+    T inverseDeterminant = 1 / determinant;
+
+    vec<T,3> toOrigin = ray.Origin - v0;
+    T resultU = dot(toOrigin, p) * inverseDeterminant;
+    if (resultU < 0 || resultU > 1)
+    {
+        return false;
+    }
+
+    vec<T,3> q = cross(toOrigin, edge1);
+    T resultV = dot(ray.Direction, q) * inverseDeterminant;
+    if (resultV < 0 || resultU + resultV > 1)
+    {
+        return false;
+    }
+
+    T result = dot(edge2, q) * inverseDeterminant;
+    if (result < tmin || result > tmax)
+    {
+        return false;
+    }
+
+    t = result;
+    u = resultU;
+    v = resultV;
+    return true;
+}
+
 } // end namespace ng
 
 #endif // NG_GEOMETRY_HPP
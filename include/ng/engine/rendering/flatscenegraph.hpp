@@ -0,0 +1,205 @@
+#ifndef NG_FLATSCENEGRAPH_HPP
+#define NG_FLATSCENEGRAPH_HPP
+
+#include "ng/engine/rendering/renderresources.hpp"
+
+#include "ng/engine/math/linearalgebra.hpp"
+#include "ng/engine/math/geometry.hpp"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ng
+{
+
+
+enum class SceneLayer
+{
+    World,
+    Overlay
+};
+
+class FlatSceneCamera
+{
+public:
+    mat4 Projection;
+
+    ivec2 ViewportTopLeft;
+    ivec2 ViewportSize;
+};
+
+// A scene stored as flat arrays instead of a tree of nodes. Parents are
+// always stored before their children, so world transforms can be
+// computed in a single forward pass, and each node caches its world
+// transform until it or one of its ancestors moves.
+//
+// Moving a node marks it dirty, and UpdateWorldTransforms() recomputes
+// only the subtrees under dirty nodes. A scene with many static nodes
+// and a few moving ones costs only as much as the moving subtrees.
+//
+// Both the 3D scene and the 2D overlay live in the same arrays, each
+// node inheriting the layer of its root.
+//
+// Updating transforms and extracting render batches can be split across
+// worker threads, each handling separate subtrees or ranges of nodes.
+// The results are the same as with a single thread.
+class FlatSceneGraph
+{
+public:
+    typedef std::uint32_t NodeIndex;
+
+    static const NodeIndex kNoNode = ~NodeIndex(0);
+
+    // as stored in GetFlags().
+    enum NodeFlags : std::uint8_t
+    {
+        kDirtyFlag = 1,
+        kOverlayFlag = 2,
+        kCameraFlag = 4,
+        kActiveCameraFlag = 8,
+        kBoundsFlag = 16
+    };
+
+private:
+
+    std::vector<NodeIndex> mParents;
+    std::vector<NodeIndex> mFirstChildren;
+    std::vector<NodeIndex> mNextSiblings;
+    std::vector<std::uint8_t> mFlags;
+
+    std::vector<mat4> mLocalTransforms;
+    std::vector<mat4> mWorldTransforms;
+
+    // only meaningful for nodes with kBoundsFlag set.
+    std::vector<AxisAlignedBoundingBox<float>> mLocalBounds;
+    std::vector<AxisAlignedBoundingBox<float>> mWorldBounds;
+
+    std::vector<MeshHandle> mMeshes;
+    std::vector<MaterialHandle> mMaterials;
+
+    // sorted by node index, so they're extracted in scene order.
+    std::vector<std::pair<NodeIndex, FlatSceneCamera>> mCameras;
+
+    // nodes whose local transform changed since the last update.
+    std::vector<NodeIndex> mDirtyNodes;
+
+    // bumped by every change, and stored with the nodes it changed,
+    // so snapshots can copy only the nodes that changed since they were made.
+    std::uint64_t mVersion = 0;
+    std::vector<std::uint64_t> mNodeVersions;
+
+    NodeIndex AddNode(NodeIndex parent, std::uint8_t flags, const mat4& localTransform);
+
+    void MarkDirty(NodeIndex node);
+
+    void MarkChanged(NodeIndex node);
+
+    void CheckNode(NodeIndex node) const;
+
+    void UpdateNode(NodeIndex node);
+
+    // returns the number of nodes updated.
+    std::size_t UpdateSubtree(NodeIndex root);
+
+public:
+    // adds a node with no parent to the given layer.
+    NodeIndex AddRoot(SceneLayer layer, const mat4& localTransform = mat4());
+
+    NodeIndex AddChild(NodeIndex parent, const mat4& localTransform = mat4());
+
+    void Reserve(std::size_t numNodes);
+
+    std::size_t GetNumNodes() const
+    {
+        return mParents.size();
+    }
+
+    NodeIndex GetParent(NodeIndex node) const;
+    SceneLayer GetLayer(NodeIndex node) const;
+
+    const mat4& GetLocalTransform(NodeIndex node) const;
+    void SetLocalTransform(NodeIndex node, const mat4& localTransform);
+
+    // as of the last call to UpdateWorldTransforms().
+    const mat4& GetWorldTransform(NodeIndex node) const;
+
+    // the bounds of the node's mesh, in the node's space. nodes without
+    // bounds have infinite world bounds, so they're never culled.
+    void SetLocalBounds(NodeIndex node, const AxisAlignedBoundingBox<float>& bounds);
+    bool HasBounds(NodeIndex node) const;
+
+    // as of the last call to UpdateWorldTransforms().
+    const AxisAlignedBoundingBox<float>& GetWorldBounds(NodeIndex node) const;
+
+    // resources are added to the renderer's RenderResources first.
+    MeshHandle GetMesh(NodeIndex node) const;
+    void SetMesh(NodeIndex node, MeshHandle mesh);
+
+    MaterialHandle GetMaterial(NodeIndex node) const;
+    void SetMaterial(NodeIndex node, MaterialHandle material);
+
+    // makes the node a camera, which isn't rendered from until it's activated.
+    // A camera views the scene from its world transform, so it moves with
+    // its parents. A SceneGraph camera only uses its own Transform.
+    void SetCamera(NodeIndex node, const FlatSceneCamera& camera);
+    void SetCameraActive(NodeIndex node, bool active);
+    bool IsCameraActive(NodeIndex node) const;
+
+    // recomputes the world transforms and bounds of the dirty subtrees,
+    // and returns the number of nodes that were recomputed. With more
+    // than one worker, separate subtrees are updated in parallel.
+    std::size_t UpdateWorldTransforms(std::size_t numWorkers = 1);
+
+    bool HasStaleWorldTransforms() const
+    {
+        return !mDirtyNodes.empty();
+    }
+
+    // the version of the most recent change. nodes changed after
+    // GetVersion() returned v have a node version greater than v.
+    std::uint64_t GetVersion() const
+    {
+        return mVersion;
+    }
+
+    // the flat arrays, indexed by node, for extracting the scene in bulk.
+    const std::vector<std::uint8_t>& GetFlags() const
+    {
+        return mFlags;
+    }
+
+    const std::vector<std::uint64_t>& GetNodeVersions() const
+    {
+        return mNodeVersions;
+    }
+
+    const std::vector<mat4>& GetWorldTransforms() const
+    {
+        return mWorldTransforms;
+    }
+
+    const std::vector<AxisAlignedBoundingBox<float>>& GetWorldBounds() const
+    {
+        return mWorldBounds;
+    }
+
+    const std::vector<MeshHandle>& GetMeshes() const
+    {
+        return mMeshes;
+    }
+
+    const std::vector<MaterialHandle>& GetMaterials() const
+    {
+        return mMaterials;
+    }
+
+    const std::vector<std::pair<NodeIndex, FlatSceneCamera>>& GetCameras() const
+    {
+        return mCameras;
+    }
+};
+
+} // end namespace ng
+
+#endif // NG_FLATSCENEGRAPH_HPP
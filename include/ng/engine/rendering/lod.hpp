@@ -0,0 +1,35 @@
+#ifndef NG_LOD_HPP
+#define NG_LOD_HPP
+
+#include <cstddef>
+
+namespace ng
+{
+
+// what picking levels of detail did in a scene.
+class LodStats
+{
+public:
+    std::size_t NumObjects = 0;
+
+    // the objects drawn with a coarser level than the full mesh.
+    std::size_t NumSimplifiedObjects = 0;
+
+    // the objects whose level changed since they were last drawn.
+    std::size_t NumLevelChanges = 0;
+
+    // the triangles that would have been drawn with only the full meshes,
+    // and those drawn with the levels that were picked.
+    std::size_t NumTrianglesWithoutLod = 0;
+    std::size_t NumTrianglesWithLod = 0;
+
+    // the fraction of triangles that levels of detail saved.
+    double GetTriangleReduction() const
+    {
+        return NumTrianglesWithoutLod == 0 ? 0.0 : 1.0 - double(NumTrianglesWithLod) / NumTrianglesWithoutLod;
+    }
+};
+
+} // end namespace ng
+
+#endif // NG_LOD_HPP
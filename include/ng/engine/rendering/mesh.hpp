@@ -3,7 +3,11 @@
 
 #include "ng/engine/rendering/vertexformat.hpp"
 
+#include "ng/engine/math/linearalgebra.hpp"
+
 #include <cstddef>
+#include <cstdint>
+#include <vector>
 
 namespace ng
 {
@@ -25,6 +29,24 @@ public:
     virtual std::size_t WriteIndices(void* buffer) const = 0;
 };
 
+// the positions written by a mesh made of triangles, and 3 indices per
+// triangle, whether or not the mesh is indexed.
+void ReadTriangles(const IMesh& mesh, std::vector<vec3>& positions, std::vector<std::uint32_t>& indices);
+
+// the same, with vertices the mesh already wrote, in the given format.
+void ReadTriangles(const IMesh& mesh, const VertexFormat& format, const char* vertices, std::size_t numVertices,
+                   std::vector<vec3>& positions, std::vector<std::uint32_t>& indices);
+
+// the vertices written by a mesh, with the enabled attributes of each one
+// packed one after the other, as described by packedFormat. The padding
+// is zeroed, so vertices with the same attributes have the same bytes.
+std::vector<char> PackVertices(const IMesh& mesh, VertexFormat& packedFormat,
+                               std::size_t& stride, std::size_t& numVertices);
+
+// the most triangles the mesh can write, going by its buffer sizes
+// rather than writing it. 0 if it isn't made of triangles.
+std::size_t GetMaxNumTriangles(const IMesh& mesh);
+
 } // end namespace ng
 
 #endif // NG_MESH_HPP
@@ -0,0 +1,94 @@
+#ifndef NG_MESHBVH_HPP
+#define NG_MESHBVH_HPP
+
+#include "ng/engine/math/geometry.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace ng
+{
+
+class IMesh;
+
+class MeshRayHit
+{
+public:
+    float T;
+
+    // the triangle's index in the mesh.
+    std::uint32_t Triangle;
+
+    // the barycentric coordinates of the hit, relative to the triangle's
+    // second and third vertices.
+    float U;
+    float V;
+};
+
+// A bounding volume hierarchy over the triangles of a mesh, to find where
+// rays hit it. Positions and indices are read from whatever the mesh
+// writes, as described by its VertexFormat.
+//
+// Nodes are 32 bytes, so two fit in a cache line, and the two children of
+// a node are next to each other. The triangles' positions are copied in
+// the order of the leaves, so a leaf's triangles are next to each other too.
+class MeshBVH
+{
+    class Node
+    {
+    public:
+        float Minimum[3];
+
+        // for leaves, the first triangle. otherwise, the left child,
+        // with the right child right after it.
+        std::uint32_t First;
+
+        float Maximum[3];
+
+        // 0 for nodes that aren't leaves.
+        std::uint32_t NumTriangles;
+    };
+
+    static_assert(sizeof(Node) == 32, "MeshBVH nodes should stay compact");
+
+    std::vector<Node> mNodes;
+
+    // 3 per triangle, in the order of the leaves.
+    std::vector<vec3> mTriangleVertices;
+    std::vector<std::uint32_t> mTriangleIndices;
+
+    // the mesh's index of each triangle.
+    std::vector<std::uint32_t> mTriangleIds;
+
+    std::size_t mNumVertices = 0;
+
+    void RefitNodes();
+
+public:
+    // the mesh must be made of triangles.
+    explicit MeshBVH(const IMesh& mesh);
+
+    // moves the triangles to where the mesh's vertices are now, keeping
+    // the shape of the tree. For meshes that deform, like skinned meshes,
+    // with the same triangles as when the tree was built.
+    void Refit(const IMesh& mesh);
+
+    // the closest hit between tmin and tmax.
+    bool RayCast(const Ray<float>& ray, float tmin, float tmax, MeshRayHit& hit) const;
+
+    std::size_t GetNumTriangles() const
+    {
+        return mTriangleIds.size();
+    }
+
+    std::size_t GetNumNodes() const
+    {
+        return mNodes.size();
+    }
+
+    AxisAlignedBoundingBox<float> GetBounds() const;
+};
+
+} // end namespace ng
+
+#endif // NG_MESHBVH_HPP
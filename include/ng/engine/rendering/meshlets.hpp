@@ -0,0 +1,100 @@
+#ifndef NG_MESHLETS_HPP
+#define NG_MESHLETS_HPP
+
+#include "ng/engine/math/linearalgebra.hpp"
+#include "ng/engine/math/geometry.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ng
+{
+
+class IMesh;
+
+// a small cluster of neighbouring triangles.
+class Meshlet
+{
+public:
+    // the meshlet's triangles, in the meshlets' indices.
+    std::uint32_t FirstIndex;
+    std::uint32_t NumIndices;
+
+    Sphere<float> Bounds;
+
+    // all the triangles face away from viewpoints where
+    // dot(normalize(ConeApex - viewpoint), ConeAxis) >= ConeCutoff.
+    // ConeCutoff is above 1 when the triangles face too many ways for that.
+    vec3 ConeApex;
+    vec3 ConeAxis;
+    float ConeCutoff;
+};
+
+// consecutive indices to draw, in the meshlets' indices.
+class MeshletRange
+{
+public:
+    std::uint32_t FirstIndex;
+    std::uint32_t NumIndices;
+};
+
+class MeshletCullStats
+{
+public:
+    std::size_t NumMeshlets = 0;
+    std::size_t NumVisibleMeshlets = 0;
+
+    std::size_t NumTriangles = 0;
+    std::size_t NumVisibleTriangles = 0;
+
+    // the fraction of triangles that were culled.
+    double GetTriangleReduction() const
+    {
+        return NumTriangles == 0 ? 0.0 : 1.0 - double(NumVisibleTriangles) / NumTriangles;
+    }
+};
+
+// A mesh's triangles, split into meshlets of neighbouring triangles that
+// mostly face the same way. Each meshlet has a bounding sphere to cull it
+// against the view frustum, and a cone to cull it when all its triangles
+// face away from the camera.
+//
+// Triangles are counter-clockwise when seen from the front. The indices
+// are the mesh's own, reordered so each meshlet's triangles are next to
+// each other, and can replace the mesh's indices to draw the ranges that
+// are left after culling.
+class Meshlets
+{
+    std::vector<std::uint32_t> mIndices;
+    std::vector<Meshlet> mMeshlets;
+
+public:
+    static const std::size_t kDefaultMaxTriangles = 64;
+
+    // the mesh must be made of triangles.
+    explicit Meshlets(const IMesh& mesh, std::size_t maxTriangles = kDefaultMaxTriangles);
+
+    const std::vector<std::uint32_t>& GetIndices() const
+    {
+        return mIndices;
+    }
+
+    const std::vector<Meshlet>& GetMeshlets() const
+    {
+        return mMeshlets;
+    }
+
+    // the ranges of the meshlets that are in the camera's view and face
+    // it, with neighbouring meshlets merged into a single range.
+    MeshletCullStats Cull(const mat4& worldView, const mat4& projection,
+                          std::vector<MeshletRange>& ranges) const;
+
+    // the indices of the meshlets that are in the camera's view and face it.
+    MeshletCullStats Cull(const mat4& worldView, const mat4& projection,
+                          std::vector<std::uint32_t>& indices) const;
+};
+
+} // end namespace ng
+
+#endif // NG_MESHLETS_HPP
@@ -0,0 +1,80 @@
+#ifndef NG_MESHSIMPLIFIER_HPP
+#define NG_MESHSIMPLIFIER_HPP
+
+#include "ng/engine/rendering/mesh.hpp"
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace ng
+{
+
+// A copy of some of a mesh's vertices, with fewer triangles between them.
+// The vertices' attributes are the same as in the original mesh, packed
+// one vertex after the other.
+class SimplifiedMesh : public IMesh
+{
+    VertexFormat mVertexFormat;
+
+    std::vector<char> mVertices;
+    std::size_t mNumVertices;
+
+    std::vector<char> mIndices;
+    std::size_t mNumIndices;
+
+    float mError;
+
+public:
+    SimplifiedMesh(VertexFormat vertexFormat,
+                   std::vector<char> vertices, std::size_t numVertices,
+                   const std::vector<std::uint32_t>& indices,
+                   float error);
+
+    // how far the simplified surface strays from the original, roughly,
+    // in the mesh's units.
+    float GetError() const
+    {
+        return mError;
+    }
+
+    std::size_t GetNumTriangles() const
+    {
+        return mNumIndices / 3;
+    }
+
+    VertexFormat GetVertexFormat() const override;
+
+    std::size_t GetMaxVertexBufferSize() const override;
+    std::size_t GetMaxIndexBufferSize() const override;
+
+    std::size_t WriteVertices(void* buffer) const override;
+    std::size_t WriteIndices(void* buffer) const override;
+};
+
+// Simplifies a mesh made of triangles by collapsing edges, the cheapest
+// first, as measured by the quadric error metric, until it has at most
+// targetTriangles triangles or the next collapse would stray further than
+// maxError from the original surface.
+//
+// Each vertex collapses onto one of its neighbours, so no new vertices
+// are made up. Vertices with the same position but different normals or
+// texture coordinates form a seam, and only collapse along it. Vertices
+// on the border of the mesh only collapse along the border.
+std::shared_ptr<SimplifiedMesh> SimplifyMesh(
+        const IMesh& mesh,
+        std::size_t targetTriangles,
+        float maxError = std::numeric_limits<float>::infinity());
+
+// up to maxLevels levels of detail, each with about half the triangles of
+// the one before it. Stops before going under minTriangles, or once the
+// mesh can't be simplified much more.
+std::vector<std::shared_ptr<SimplifiedMesh>> BuildLodChain(
+        const IMesh& mesh,
+        std::size_t maxLevels = 4,
+        std::size_t minTriangles = 64);
+
+} // end namespace ng
+
+#endif // NG_MESHSIMPLIFIER_HPP
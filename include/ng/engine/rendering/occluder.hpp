@@ -0,0 +1,57 @@
+#ifndef NG_OCCLUDER_HPP
+#define NG_OCCLUDER_HPP
+
+#include "ng/engine/math/linearalgebra.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ng
+{
+
+class IMesh;
+
+// the triangles of a mesh that hides what's behind it, usually a
+// simplified version of a wall, floor or building.
+class OccluderMesh
+{
+public:
+    std::vector<vec3> Positions;
+
+    // 3 per triangle.
+    std::vector<std::uint32_t> Indices;
+
+    explicit OccluderMesh(const IMesh& mesh);
+};
+
+class Occluder
+{
+public:
+    std::shared_ptr<const OccluderMesh> Mesh;
+    mat4 WorldTransform;
+};
+
+// what occlusion culling did, and what it cost.
+class OcclusionStats
+{
+public:
+    std::size_t NumOccluderTriangles = 0;
+
+    std::size_t NumTested = 0;
+    std::size_t NumOccluded = 0;
+
+    double RasterizeMilliseconds = 0.0;
+    double PyramidMilliseconds = 0.0;
+    double TestMilliseconds = 0.0;
+
+    double GetTotalMilliseconds() const
+    {
+        return RasterizeMilliseconds + PyramidMilliseconds + TestMilliseconds;
+    }
+};
+
+} // end namespace ng
+
+#endif // NG_OCCLUDER_HPP
@@ -4,6 +4,7 @@
 #include "ng/engine/math/linearalgebra.hpp"
 
 #include <memory>
+#include <vector>
 
 namespace ng
 {
@@ -11,6 +12,13 @@ namespace ng
 class IWindowManager;
 class IWindow;
 class SceneGraph;
+class FlatSceneGraph;
+class SceneSnapshot;
+class SceneBVH;
+class RenderResources;
+class Occluder;
+class OcclusionStats;
+class LodStats;
 
 class IRenderer
 {
@@ -22,7 +30,38 @@ public:
     // submit a list of objects to render
     virtual void Render(const SceneGraph& scene) = 0;
 
+    // the scene's world transforms must be up to date.
+    virtual void Render(const FlatSceneGraph& scene) = 0;
+
+    // culls the scene with the tree, which must be updated after the scene.
+    virtual void Render(const FlatSceneGraph& scene, const SceneBVH& bvh) = 0;
+
+    // the snapshot is kept until it's rendered, so the scene can be
+    // updated and published again in the meantime.
+    virtual void Render(std::shared_ptr<const SceneSnapshot> snapshot) = 0;
+
     virtual void EndFrame() = 0;
+
+    // the meshes, textures and materials that FlatSceneGraph nodes refer to.
+    virtual RenderResources& GetResources() = 0;
+
+    // hides the objects behind the occluders in the scenes rendered from
+    // now on. Snapshots are extracted on the rendering thread, so they
+    // aren't culled. An empty list turns occlusion culling off.
+    virtual void SetOccluders(std::vector<Occluder> occluders) = 0;
+
+    // what occlusion culling did in the last scene that was culled.
+    virtual OcclusionStats GetOcclusionStats() = 0;
+
+    // meshes added with levels of detail are drawn with the coarsest level
+    // whose error covers at most this many pixels, 1 by default. At 0 only
+    // levels without any error are used. Snapshots are extracted on the
+    // rendering thread, so they always use the full meshes.
+    virtual void SetLodPixelError(float maxPixelError) = 0;
+
+    // the triangles drawn with and without levels of detail in the last
+    // scene that levels were picked for.
+    virtual LodStats GetLodStats() = 0;
 };
 
 std::shared_ptr<IRenderer> CreateRenderer(
@@ -0,0 +1,157 @@
+#ifndef NG_RENDERRESOURCES_HPP
+#define NG_RENDERRESOURCES_HPP
+
+#include "ng/engine/rendering/material.hpp"
+
+#include "ng/engine/util/handlepool.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ng
+{
+
+class IMesh;
+class ITexture;
+
+using MeshHandle = handle<IMesh>;
+using TextureHandle = handle<ITexture>;
+using MaterialHandle = handle<Material>;
+
+// a version of a mesh with fewer triangles, for when it's far away.
+class MeshLod
+{
+public:
+    MeshHandle Mesh;
+
+    // how far the level strays from the full mesh, in the mesh's units.
+    float Error;
+
+    std::size_t NumTriangles;
+};
+
+// Owns the meshes, textures and materials that are rendered, so render
+// batches can refer to them by handle instead of sharing ownership of
+// them every frame. Removing a resource makes its handles stale, and
+// stale handles are skipped when rendering.
+//
+// Resources can be added and removed from any thread. The renderer takes
+// the lock from Lock() just long enough to copy out what a batch refers
+// to, so adding and removing resources doesn't wait for a frame to draw.
+class RenderResources
+{
+    mutable std::mutex mMutex;
+
+    class MeshEntry
+    {
+    public:
+        std::shared_ptr<IMesh> Mesh;
+
+        // starts with the mesh itself, at no error.
+        std::vector<MeshLod> Lods;
+    };
+
+    handle_pool<IMesh, MeshEntry> mMeshes;
+    handle_pool<ITexture, std::shared_ptr<ITexture>> mTextures;
+    handle_pool<Material, Material> mMaterials;
+
+    // scenes hold their materials by value, so they're compared by value.
+    class MaterialKey
+    {
+    public:
+        MaterialType Type;
+        vec3 Tint;
+        const ITexture* Texture0;
+        Sampler Sampler0;
+
+        explicit MaterialKey(const Material& material);
+
+        bool operator==(const MaterialKey& other) const;
+    };
+
+    class MaterialKeyHash
+    {
+    public:
+        std::size_t operator()(const MaterialKey& key) const;
+    };
+
+    // transient resources of the current and the previous frame. Meshes
+    // and materials are often shared by many nodes, so each is added once,
+    // and the ones used again in the next frame are moved to it rather
+    // than added again. The pools keep the keys alive.
+    class TransientFrame
+    {
+    public:
+        std::unordered_map<const IMesh*, MeshHandle> Meshes;
+        std::unordered_map<MaterialKey, MaterialHandle, MaterialKeyHash> Materials;
+    };
+
+    TransientFrame mTransientFrames[2];
+    int mCurrentTransientFrame = 0;
+
+    // these must be called with the lock held.
+    MeshHandle InsertMesh(std::shared_ptr<IMesh> mesh, std::size_t numTriangles);
+    MeshHandle InsertMeshLod(MeshHandle mesh, std::shared_ptr<IMesh> lod, float error, std::size_t numTriangles);
+    void EraseMesh(MeshHandle mesh, std::vector<MeshEntry>& removed);
+
+public:
+    MeshHandle AddMesh(std::shared_ptr<IMesh> mesh);
+    TextureHandle AddTexture(std::shared_ptr<ITexture> texture);
+    MaterialHandle AddMaterial(Material material);
+
+    // adds a coarser level of detail to a mesh, as a mesh of its own that
+    // is removed along with it. Levels must be added from the finest to
+    // the coarsest. throws std::logic_error if the handle is stale, or the
+    // level is finer than the last one.
+    MeshHandle AddMeshLod(MeshHandle mesh, std::shared_ptr<IMesh> lod, float error);
+
+    // adds a mesh made of triangles along with its chain of simplified
+    // levels of detail, built before taking the lock.
+    MeshHandle AddMeshWithLods(std::shared_ptr<IMesh> mesh,
+                               std::size_t maxLevels = 4,
+                               std::size_t minTriangles = 64);
+
+    // throws std::logic_error if the handle is stale.
+    void RemoveMesh(MeshHandle mesh);
+    void RemoveTexture(TextureHandle texture);
+    void RemoveMaterial(MaterialHandle material);
+
+    // return null (or false) if the handle is stale.
+    std::shared_ptr<IMesh> GetMesh(MeshHandle mesh) const;
+    std::shared_ptr<ITexture> GetTexture(TextureHandle texture) const;
+    bool TryGetMaterial(MaterialHandle material, Material& result) const;
+
+    // for scenes that hold their resources by shared_ptr. Transient
+    // resources live until the second AdvanceTransientFrame() after they
+    // were last used, which covers a rendering thread that runs a frame
+    // behind. A scene that doesn't change only takes the lock once.
+    // these must all be called from the same thread.
+    MeshHandle AddTransientMesh(const std::shared_ptr<IMesh>& mesh);
+    MaterialHandle AddTransientMaterial(const Material& material);
+    void AdvanceTransientFrame();
+
+    std::unique_lock<std::mutex> Lock() const
+    {
+        return std::unique_lock<std::mutex>(mMutex);
+    }
+
+    // only valid while the lock from Lock() is held. return null if the handle is stale.
+    const IMesh* ResolveMesh(MeshHandle mesh) const;
+    std::shared_ptr<IMesh> ResolveSharedMesh(MeshHandle mesh) const;
+    const ITexture* ResolveTexture(TextureHandle texture) const;
+    const Material* ResolveMaterial(MaterialHandle material) const;
+
+    // the mesh's levels of detail, starting with the mesh itself.
+    const std::vector<MeshLod>* ResolveMeshLods(MeshHandle mesh) const;
+
+    std::size_t GetNumMeshes() const;
+    std::size_t GetNumTextures() const;
+    std::size_t GetNumMaterials() const;
+};
+
+} // end namespace ng
+
+#endif // NG_RENDERRESOURCES_HPP
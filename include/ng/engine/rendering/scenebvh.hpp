@@ -0,0 +1,118 @@
+#ifndef NG_SCENEBVH_HPP
+#define NG_SCENEBVH_HPP
+
+#include "ng/engine/rendering/flatscenegraph.hpp"
+
+#include "ng/engine/math/geometry.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace ng
+{
+
+// A bounding volume hierarchy over the world bounds of a FlatSceneGraph's
+// nodes, for culling and spatial queries that don't visit every node.
+//
+// Only the nodes of the world layer that have bounds are in the tree.
+// The tree is built with the surface area heuristic, then refitted to
+// the nodes that moved since. Refitting keeps the tree's shape, so as
+// things move around it gets looser, and Update() rebuilds it once it
+// got too expensive to traverse, or when nodes were added to the scene.
+class SceneBVH
+{
+public:
+    typedef FlatSceneGraph::NodeIndex NodeIndex;
+
+private:
+    class Node
+    {
+    public:
+        AxisAlignedBoundingBox<float> Bounds;
+
+        // the children are at Left and Left + 1. 0 for leaves,
+        // since the root is nobody's child.
+        std::uint32_t Left;
+
+        // the scene nodes in this subtree, in mItems.
+        std::uint32_t ItemBegin;
+        std::uint32_t ItemEnd;
+    };
+
+    static const std::uint32_t kNoNode = ~std::uint32_t(0);
+
+    std::vector<Node> mNodes;
+    std::vector<std::uint32_t> mParents;
+
+    // the scene nodes and their world bounds, grouped by leaf.
+    std::vector<NodeIndex> mItems;
+    std::vector<AxisAlignedBoundingBox<float>> mItemBounds;
+
+    // the position of each scene node in mItems, or kNoNode if it's not in the tree.
+    std::vector<std::uint32_t> mItemOfNode;
+
+    // the leaf that holds each item.
+    std::vector<std::uint32_t> mLeaves;
+
+    // the scene's version as of the last build or refit.
+    std::uint64_t mVersion = 0;
+
+    // the surface area heuristic's cost of traversing the tree, unscaled.
+    // compared to the cost right after the last build to know when to rebuild.
+    float mCost = 0.0f;
+    float mBuildCost = 0.0f;
+
+    // set when a node got bounds since the last build.
+    bool mNeedsRebuild = false;
+
+    std::size_t mNumBuilds = 0;
+
+    float GetNodeCost(std::uint32_t node) const;
+
+    float GetRelativeCost(float cost) const;
+
+public:
+    // builds the tree from scratch. The scene's world transforms must be up to date.
+    void Build(const FlatSceneGraph& scene);
+
+    // moves the bounds of the nodes that changed since the last build or
+    // refit, keeping the shape of the tree. Nodes added to the scene since
+    // the last build are left out until the next one.
+    void Refit(const FlatSceneGraph& scene);
+
+    // refits the tree, or rebuilds it if it's missing nodes or refitting
+    // made it too loose. Returns whether it was rebuilt.
+    bool Update(const FlatSceneGraph& scene);
+
+    // the scene's version as of the last build or refit, to check that
+    // queries see the scene as it is.
+    std::uint64_t GetVersion() const
+    {
+        return mVersion;
+    }
+
+    std::size_t GetNumNodes() const
+    {
+        return mNodes.size();
+    }
+
+    std::size_t GetNumBuilds() const
+    {
+        return mNumBuilds;
+    }
+
+    // how much more expensive traversal got since the last build, 1 when just built.
+    float GetCostGrowth() const;
+
+    // these append the scene nodes they find to the output, in no particular order.
+    void QueryFrustum(const Frustum<float>& frustum, std::vector<NodeIndex>& nodes) const;
+
+    void QueryBox(const AxisAlignedBoundingBox<float>& box, std::vector<NodeIndex>& nodes) const;
+
+    // the first node whose bounds the ray enters between tmin and tmax.
+    bool RayCast(const Ray<float>& ray, float tmin, float tmax, NodeIndex& node, float& t) const;
+};
+
+} // end namespace ng
+
+#endif // NG_SCENEBVH_HPP
@@ -0,0 +1,125 @@
+#ifndef NG_SCENESNAPSHOT_HPP
+#define NG_SCENESNAPSHOT_HPP
+
+#include "ng/engine/rendering/flatscenegraph.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace ng
+{
+
+// An immutable copy of what's needed to render a FlatSceneGraph,
+// as of when it was published.
+class SceneSnapshot
+{
+    friend class SceneSnapshotPublisher;
+
+    // the scene's version when this was copied from it.
+    std::uint64_t mVersion = 0;
+
+    std::vector<std::uint8_t> mFlags;
+    std::vector<mat4> mWorldTransforms;
+    std::vector<AxisAlignedBoundingBox<float>> mWorldBounds;
+    std::vector<MeshHandle> mMeshes;
+    std::vector<MaterialHandle> mMaterials;
+    std::vector<std::pair<FlatSceneGraph::NodeIndex, FlatSceneCamera>> mCameras;
+
+public:
+    std::uint64_t GetVersion() const
+    {
+        return mVersion;
+    }
+
+    std::size_t GetNumNodes() const
+    {
+        return mFlags.size();
+    }
+
+    // indexed by node, like the arrays of FlatSceneGraph.
+    const std::vector<std::uint8_t>& GetFlags() const
+    {
+        return mFlags;
+    }
+
+    const std::vector<mat4>& GetWorldTransforms() const
+    {
+        return mWorldTransforms;
+    }
+
+    const std::vector<AxisAlignedBoundingBox<float>>& GetWorldBounds() const
+    {
+        return mWorldBounds;
+    }
+
+    const std::vector<MeshHandle>& GetMeshes() const
+    {
+        return mMeshes;
+    }
+
+    const std::vector<MaterialHandle>& GetMaterials() const
+    {
+        return mMaterials;
+    }
+
+    const std::vector<std::pair<FlatSceneGraph::NodeIndex, FlatSceneCamera>>& GetCameras() const
+    {
+        return mCameras;
+    }
+};
+
+// Publishes snapshots of a scene, so the thread updating the scene and
+// the threads reading it (rendering, culling, audio...) never share
+// anything mutable.
+//
+// Each Publish() takes a snapshot that no reader holds anymore and
+// copies only the nodes that changed since that snapshot was published.
+// Readers get the latest snapshot with Acquire(), and keep it for as
+// long as they need it. A snapshot is recycled once the last reader
+// lets go of it, so with readers a frame behind, only two or three
+// snapshots exist at a time.
+//
+// A publisher keeps track of a single scene, since it relies on the
+// scene's versions to know what changed.
+class SceneSnapshotPublisher
+{
+    class Pool;
+    class Recycler;
+
+    std::shared_ptr<Pool> mPool;
+
+    // only accessed through std::atomic_load and std::atomic_store.
+    std::shared_ptr<const SceneSnapshot> mCurrent;
+
+    std::size_t mNumCopiedNodes = 0;
+
+public:
+    SceneSnapshotPublisher();
+    ~SceneSnapshotPublisher();
+
+    SceneSnapshotPublisher(const SceneSnapshotPublisher&) = delete;
+    SceneSnapshotPublisher& operator=(const SceneSnapshotPublisher&) = delete;
+
+    // the scene's world transforms must be up to date.
+    // only one thread may publish at a time.
+    void Publish(const FlatSceneGraph& scene);
+
+    // the latest snapshot, or null if nothing was published yet.
+    // safe to call from any thread.
+    std::shared_ptr<const SceneSnapshot> Acquire() const;
+
+    // how many nodes the last Publish() copied.
+    std::size_t GetNumCopiedNodes() const
+    {
+        return mNumCopiedNodes;
+    }
+
+    // the number of snapshots that exist, whether published, held or recycled.
+    std::size_t GetNumSnapshots() const;
+};
+
+} // end namespace ng
+
+#endif // NG_SCENESNAPSHOT_HPP
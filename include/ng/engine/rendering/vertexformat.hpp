@@ -4,6 +4,7 @@
 #include "ng/engine/util/arithmetictype.hpp"
 
 #include <array>
+#include <cstddef>
 #include <functional>
 
 namespace ng
@@ -62,6 +63,10 @@ public:
     std::size_t IndexOffset;
 };
 
+// the bytes from one vertex's attribute to the next one's. As with
+// glVertexAttribPointer, a stride of 0 means the attribute is tightly packed.
+std::ptrdiff_t GetEffectiveStride(const VertexAttribute& attribute);
+
 std::array<std::reference_wrapper<const VertexAttribute>,5>
     GetAttribArray(const VertexFormat& fmt);
 
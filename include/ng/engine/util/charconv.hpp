@@ -0,0 +1,20 @@
+#ifndef NG_CHARCONV_HPP
+#define NG_CHARCONV_HPP
+
+namespace ng
+{
+
+// parses a number at the start of [first,last), like std::from_chars.
+// returns a pointer past the end of the number, or nullptr if there
+// wasn't one. Leading whitespace isn't skipped.
+
+// accepts the decimal syntax of strtof, without hex floats, inf or nan.
+const char* parse_float(const char* first, const char* last, float& value);
+
+// accepts an optional sign followed by decimal digits.
+// fails if the value doesn't fit in an int.
+const char* parse_int(const char* first, const char* last, int& value);
+
+} // end namespace ng
+
+#endif // NG_CHARCONV_HPP
@@ -2,5 +2,6 @@
 #define NG_COMPILERTRAITS_HPP
 
 #define NG_RESTRICT __restrict__
+#define NG_NOINLINE __attribute__((noinline))
 
 #endif // NG_COMPILERTRAITS_HPP
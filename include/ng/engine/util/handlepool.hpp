@@ -0,0 +1,157 @@
+#ifndef NG_HANDLEPOOL_HPP
+#define NG_HANDLEPOOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace ng
+{
+
+// refers to a value in a handle_pool. Tag only keeps handles to
+// different kinds of things from being mixed up.
+template<class Tag>
+class handle
+{
+public:
+    std::uint32_t index = 0;
+
+    // 0 is never used by a pool, so a default constructed handle is null.
+    std::uint32_t generation = 0;
+
+    explicit operator bool() const
+    {
+        return generation != 0;
+    }
+
+    friend bool operator==(handle a, handle b)
+    {
+        return a.index == b.index && a.generation == b.generation;
+    }
+
+    friend bool operator!=(handle a, handle b)
+    {
+        return !(a == b);
+    }
+};
+
+// Stores values in reusable slots, handing out handles with a 32 bit slot
+// index and a 32 bit generation. A slot's generation changes whenever its
+// value is erased, so handles to erased values stop finding anything,
+// even after the slot is reused.
+template<class Tag, class T>
+class handle_pool
+{
+    class slot
+    {
+    public:
+        T value;
+        std::uint32_t generation = 1;
+        bool used = false;
+    };
+
+    std::vector<slot> mSlots;
+    std::vector<std::uint32_t> mFreeSlots;
+    std::size_t mSize = 0;
+
+public:
+    handle<Tag> insert(T value)
+    {
+        std::uint32_t index;
+        if (!mFreeSlots.empty())
+        {
+            index = mFreeSlots.back();
+            mFreeSlots.pop_back();
+        }
+        else
+        {
+            if (mSlots.size() >= UINT32_MAX)
+            {
+                throw std::length_error("handle_pool is full");
+            }
+
+            index = std::uint32_t(mSlots.size());
+            mSlots.emplace_back();
+        }
+
+        slot& s = mSlots[index];
+        s.value = std::move(value);
+        s.used = true;
+        mSize++;
+
+        handle<Tag> h;
+        h.index = index;
+        h.generation = s.generation;
+        return h;
+    }
+
+    // returns the erased value, so it can be destroyed outside of any lock.
+    // throws std::logic_error if the handle doesn't refer to a value.
+    T erase(handle<Tag> h)
+    {
+        if (find(h) == nullptr)
+        {
+            throw std::logic_error("erase() of a stale or null handle");
+        }
+
+        slot& s = mSlots[h.index];
+
+        T value = std::move(s.value);
+        s.value = T();
+        s.used = false;
+
+        // skip 0 when wrapping around, it's the null generation.
+        if (++s.generation == 0)
+        {
+            s.generation = 1;
+        }
+
+        mFreeSlots.push_back(h.index);
+        mSize--;
+
+        return value;
+    }
+
+    // returns null if the handle is stale or null.
+    T* find(handle<Tag> h)
+    {
+        if (h.index >= mSlots.size())
+        {
+            return nullptr;
+        }
+
+        slot& s = mSlots[h.index];
+        return s.used && s.generation == h.generation ? &s.value : nullptr;
+    }
+
+    const T* find(handle<Tag> h) const
+    {
+        return const_cast<handle_pool*>(this)->find(h);
+    }
+
+    std::size_t size() const
+    {
+        return mSize;
+    }
+};
+
+} // end namespace ng
+
+namespace std
+{
+
+template<class Tag>
+struct hash<ng::handle<Tag>>
+{
+    std::size_t operator()(ng::handle<Tag> h) const
+    {
+        return std::hash<std::uint64_t>()((std::uint64_t(h.index) << 32) | h.generation);
+    }
+};
+
+} // end namespace std
+
+#endif // NG_HANDLEPOOL_HPP
@@ -0,0 +1,30 @@
+#ifndef NG_LZ4_HPP
+#define NG_LZ4_HPP
+
+#include <cstddef>
+
+namespace ng
+{
+
+// compression and decompression of single blocks in the LZ4 block format.
+// the compressor favors simplicity over ratio, but its output can be
+// decoded by any LZ4 implementation, and vice versa.
+
+// the largest possible compressed size of size bytes.
+std::size_t lz4_compress_bound(std::size_t size);
+
+// returns the compressed size, or 0 if it wouldn't fit in capacity bytes.
+std::size_t lz4_compress(
+        const char* src, std::size_t srcSize,
+        char* dst, std::size_t capacity);
+
+// decompresses a block that must expand to exactly dstSize bytes.
+// returns false if the block is malformed, never reading or writing
+// out of bounds.
+bool lz4_decompress(
+        const char* src, std::size_t srcSize,
+        char* dst, std::size_t dstSize);
+
+} // end namespace ng
+
+#endif // NG_LZ4_HPP
@@ -0,0 +1,89 @@
+#ifndef NG_PARALLELFOR_HPP
+#define NG_PARALLELFOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace ng
+{
+
+// one worker per hardware thread, at least one.
+inline std::size_t default_worker_count()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// runs f(worker) on numWorkers threads, the calling thread being worker 0.
+// if threads can't be created (eg. no pthreads), the work runs on fewer of them.
+// the first exception thrown by a worker is rethrown once all of them are done.
+template<class F>
+void run_workers(std::size_t numWorkers, F f)
+{
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto guarded = [&](std::size_t worker)
+    {
+        try
+        {
+            f(worker);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error)
+            {
+                error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    try
+    {
+        for (std::size_t i = 1; i < numWorkers; i++)
+        {
+            threads.emplace_back(guarded, i);
+        }
+    }
+    catch (const std::system_error&)
+    {
+    }
+
+    guarded(0);
+
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+// calls f(i) for i in [0,count), handing out indices to the workers one at a time.
+template<class F>
+void parallel_for(std::size_t count, std::size_t numWorkers, F f)
+{
+    std::atomic<std::size_t> next(0);
+
+    run_workers(std::min(count, numWorkers), [&](std::size_t)
+    {
+        for (std::size_t i = next++; i < count; i = next++)
+        {
+            f(i);
+        }
+    });
+}
+
+} // end namespace ng
+
+#endif // NG_PARALLELFOR_HPP
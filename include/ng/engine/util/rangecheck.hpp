@@ -0,0 +1,18 @@
+#ifndef NG_RANGECHECK_HPP
+#define NG_RANGECHECK_HPP
+
+#include <cstdint>
+
+namespace ng
+{
+
+// checks that [offset, offset + size) lies within [0, totalSize), without
+// overflowing on offsets and sizes read from untrusted files.
+inline bool is_in_range(std::uint64_t offset, std::uint64_t size, std::uint64_t totalSize)
+{
+    return offset <= totalSize && size <= totalSize - offset;
+}
+
+} // end namespace ng
+
+#endif // NG_RANGECHECK_HPP
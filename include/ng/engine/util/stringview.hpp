@@ -0,0 +1,198 @@
+#ifndef NG_STRINGVIEW_HPP
+#define NG_STRINGVIEW_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace ng
+{
+
+// non-owning view of a contiguous run of characters,
+// modeled after C++17's std::string_view.
+class string_view
+{
+    const char* mData = nullptr;
+    std::size_t mSize = 0;
+
+public:
+    typedef const char* const_iterator;
+
+    static constexpr std::size_t npos = std::size_t(-1);
+
+    string_view() = default;
+
+    string_view(const char* data, std::size_t size)
+        : mData(data)
+        , mSize(size)
+    { }
+
+    string_view(const char* s)
+        : mData(s)
+        , mSize(std::strlen(s))
+    { }
+
+    string_view(const std::string& s)
+        : mData(s.data())
+        , mSize(s.size())
+    { }
+
+    const char* data() const { return mData; }
+    std::size_t size() const { return mSize; }
+    bool empty() const { return mSize == 0; }
+
+    const_iterator begin() const { return mData; }
+    const_iterator end() const { return mData + mSize; }
+
+    char operator[](std::size_t i) const { return mData[i]; }
+    char front() const { return mData[0]; }
+    char back() const { return mData[mSize - 1]; }
+
+    void remove_prefix(std::size_t n)
+    {
+        mData += n;
+        mSize -= n;
+    }
+
+    void remove_suffix(std::size_t n)
+    {
+        mSize -= n;
+    }
+
+    // a pos past the end gives an empty view, and like find() it's checked
+    // before subtracting so the size can never wrap around.
+    string_view substr(std::size_t pos, std::size_t count = npos) const
+    {
+        if (pos >= mSize)
+        {
+            return string_view(end(), 0);
+        }
+
+        return string_view(mData + pos, std::min(count, mSize - pos));
+    }
+
+    std::size_t find(char ch, std::size_t pos = 0) const
+    {
+        if (pos >= mSize)
+        {
+            return npos;
+        }
+
+        const void* found = std::memchr(mData + pos, ch, mSize - pos);
+        return found ? static_cast<const char*>(found) - mData : npos;
+    }
+
+    std::size_t find(string_view s, std::size_t pos = 0) const
+    {
+        if (s.empty())
+        {
+            return pos <= mSize ? pos : npos;
+        }
+
+        for (pos = find(s.front(), pos);
+             pos != npos && pos + s.mSize <= mSize;
+             pos = find(s.front(), pos + 1))
+        {
+            if (std::memcmp(mData + pos, s.mData, s.mSize) == 0)
+            {
+                return pos;
+            }
+        }
+
+        return npos;
+    }
+
+    bool starts_with(string_view s) const
+    {
+        return mSize >= s.mSize && std::memcmp(mData, s.mData, s.mSize) == 0;
+    }
+
+    std::string to_string() const
+    {
+        return std::string(mData, mSize);
+    }
+
+    friend bool operator==(string_view a, string_view b)
+    {
+        return a.mSize == b.mSize && std::memcmp(a.mData, b.mData, a.mSize) == 0;
+    }
+
+    friend bool operator!=(string_view a, string_view b)
+    {
+        return !(a == b);
+    }
+};
+
+inline bool is_space(char ch)
+{
+    return ch == ' ' || ch == '\t' || ch == '\n' ||
+           ch == '\r' || ch == '\v' || ch == '\f';
+}
+
+// pops the next line off the front of text, without its line terminator.
+// handles both "\n" and "\r\n" line endings.
+// returns false once text is exhausted.
+inline bool getline(string_view& line, string_view& text)
+{
+    if (text.empty())
+    {
+        return false;
+    }
+
+    std::size_t newline = text.find('\n');
+    std::size_t lineLength = newline == string_view::npos ? text.size() : newline;
+
+    line = text.substr(0, lineLength);
+    text.remove_prefix(std::min(lineLength + 1, text.size()));
+
+    if (!line.empty() && line.back() == '\r')
+    {
+        line.remove_suffix(1);
+    }
+
+    return true;
+}
+
+// pops the next whitespace-delimited token off the front of text.
+// returns false if only whitespace was left.
+inline bool gettoken(string_view& token, string_view& text)
+{
+    const char* first = text.begin();
+    const char* last = text.end();
+
+    while (first != last && is_space(*first))
+    {
+        ++first;
+    }
+
+    const char* tokenEnd = first;
+    while (tokenEnd != last && !is_space(*tokenEnd))
+    {
+        ++tokenEnd;
+    }
+
+    token = string_view(first, tokenEnd - first);
+    text = string_view(tokenEnd, last - tokenEnd);
+
+    return !token.empty();
+}
+
+inline string_view trim(string_view s)
+{
+    while (!s.empty() && is_space(s.front()))
+    {
+        s.remove_prefix(1);
+    }
+
+    while (!s.empty() && is_space(s.back()))
+    {
+        s.remove_suffix(1);
+    }
+
+    return s;
+}
+
+} // end namespace ng
+
+#endif // NG_STRINGVIEW_HPP
@@ -0,0 +1,88 @@
+#ifndef NG_WORKERPOOL_HPP
+#define NG_WORKERPOOL_HPP
+
+#include "ng/engine/util/parallelfor.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ng
+{
+
+// like run_workers(), but the threads are started once and wait on a
+// condition variable between runs, for work that runs every frame.
+// if threads can't be created (eg. no pthreads), the work runs on fewer of them.
+// run() must not be called from more than one thread at a time.
+class worker_pool
+{
+    std::mutex mMutex;
+    std::condition_variable mStarted;
+    std::condition_variable mFinished;
+
+    std::vector<std::thread> mThreads;
+
+    // only set while running.
+    const std::function<void(std::size_t)>* mWork = nullptr;
+    std::exception_ptr mError;
+
+    // bumped by every run, so each thread runs the work once.
+    std::size_t mRun = 0;
+    std::size_t mNumRunning = 0;
+    bool mStopping = false;
+
+    void run_guarded(const std::function<void(std::size_t)>& f, std::size_t worker);
+    void thread_main(std::size_t worker);
+
+public:
+    explicit worker_pool(std::size_t numWorkers = default_worker_count());
+    ~worker_pool();
+
+    worker_pool(const worker_pool&) = delete;
+    worker_pool& operator=(const worker_pool&) = delete;
+
+    // the number of workers, including the calling thread.
+    std::size_t size() const
+    {
+        return mThreads.size() + 1;
+    }
+
+    // runs f(worker) on every worker, the calling thread being worker 0.
+    // the first exception thrown by a worker is rethrown once all of them are done.
+    void run(const std::function<void(std::size_t)>& f);
+
+    // calls f(i) for i in [0,count), handing out indices to the workers one at a time.
+    template<class F>
+    void parallel_for(std::size_t count, F f)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        if (count == 1)
+        {
+            f(0);
+            return;
+        }
+
+        std::atomic<std::size_t> next(0);
+
+        run([&](std::size_t)
+        {
+            for (std::size_t i = next++; i < count; i = next++)
+            {
+                f(i);
+            }
+        });
+    }
+};
+
+} // end namespace ng
+
+#endif // NG_WORKERPOOL_HPP
@@ -0,0 +1,240 @@
+#ifndef NG_ASSETLOADER_HPP
+#define NG_ASSETLOADER_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ng
+{
+
+class IFileSystem;
+class IMesh;
+class SceneGraphNode;
+class ObjModel;
+class MD5Model;
+class MD5Anim;
+
+enum class AssetLoadPriority
+{
+    Low,
+    Normal,
+    High
+};
+
+enum class AssetLoadStatus
+{
+    Pending,
+    Loading,
+    Loaded,
+    Failed,
+    Cancelled
+};
+
+// shared between an AssetLoader's workers and the AssetHandles of one load.
+// the loaded value is type-erased, AssetHandle<T> knows what it really is.
+class AssetLoadState
+{
+    mutable std::mutex mMutex;
+    mutable std::condition_variable mDone;
+
+    AssetLoadStatus mStatus = AssetLoadStatus::Pending;
+    bool mCancelRequested = false;
+
+    std::shared_ptr<void> mValue;
+    std::exception_ptr mError;
+
+public:
+    AssetLoadStatus GetStatus() const;
+
+    // blocks until the load finished, failed or was cancelled.
+    void Wait() const;
+
+    // returns the value if it's loaded, null otherwise.
+    std::shared_ptr<void> TryGetValue() const;
+
+    // waits, then returns the value or rethrows the error that failed the load.
+    // throws std::logic_error if the load was cancelled.
+    std::shared_ptr<void> GetValue() const;
+
+    // returns false if the load already finished.
+    // a load that's in progress still runs to completion,
+    // but its result is thrown away.
+    bool Cancel();
+
+    // used by the workers.
+    // TryStart returns false if the load was cancelled before it started.
+    bool TryStart();
+    void Finish(std::shared_ptr<void> value, std::exception_ptr error);
+};
+
+template<class T>
+class AssetHandle
+{
+    std::shared_ptr<AssetLoadState> mState;
+
+public:
+    AssetHandle() = default;
+
+    explicit AssetHandle(std::shared_ptr<AssetLoadState> state)
+        : mState(std::move(state))
+    { }
+
+    bool IsValid() const
+    {
+        return mState != nullptr;
+    }
+
+    const std::shared_ptr<AssetLoadState>& GetState() const
+    {
+        return mState;
+    }
+
+    AssetLoadStatus GetStatus() const
+    {
+        return mState->GetStatus();
+    }
+
+    // true once it's loaded, failed or cancelled.
+    bool IsDone() const
+    {
+        AssetLoadStatus status = GetStatus();
+        return status != AssetLoadStatus::Pending &&
+               status != AssetLoadStatus::Loading;
+    }
+
+    // never blocks. null until the asset is loaded.
+    std::shared_ptr<T> TryGet() const
+    {
+        return std::static_pointer_cast<T>(mState->TryGetValue());
+    }
+
+    // blocks until the asset is loaded, rethrowing the error if loading failed.
+    std::shared_ptr<T> Get() const
+    {
+        return std::static_pointer_cast<T>(mState->GetValue());
+    }
+
+    void Wait() const
+    {
+        mState->Wait();
+    }
+
+    bool Cancel() const
+    {
+        return mState->Cancel();
+    }
+};
+
+// Loads assets on a pool of worker threads.
+// Higher priority loads are started first, loads of equal priority in the
+// order they were requested. Destroying the loader cancels whatever hasn't
+// started yet and waits for the loads in progress.
+class AssetLoader
+{
+    struct Job
+    {
+        AssetLoadPriority Priority;
+        std::uint64_t Sequence;
+        std::shared_ptr<AssetLoadState> State;
+        std::function<std::shared_ptr<void>()> Load;
+    };
+
+    std::shared_ptr<IFileSystem> mFileSystem;
+
+    std::mutex mQueueMutex;
+    std::condition_variable mQueueCondition;
+    std::vector<Job> mQueue; // heap ordered by priority, then sequence
+    std::uint64_t mNextSequence = 0;
+    bool mStopping = false;
+
+    std::vector<std::thread> mWorkers;
+
+    void Submit(std::shared_ptr<AssetLoadState> state,
+                std::function<std::shared_ptr<void>()> load,
+                AssetLoadPriority priority);
+
+    void WorkerLoop();
+
+public:
+    // with numWorkers == 0 (or if threads can't be created), loads
+    // run synchronously inside the call that requests them.
+    AssetLoader(std::shared_ptr<IFileSystem> fileSystem, std::size_t numWorkers);
+    explicit AssetLoader(std::shared_ptr<IFileSystem> fileSystem);
+
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    const std::shared_ptr<IFileSystem>& GetFileSystem() const
+    {
+        return mFileSystem;
+    }
+
+    // runs load() on a worker. load must return something convertible to
+    // std::shared_ptr<T>, and may throw to fail the load.
+    template<class T, class F>
+    AssetHandle<T> Load(F load, AssetLoadPriority priority = AssetLoadPriority::Normal)
+    {
+        std::shared_ptr<AssetLoadState> state = std::make_shared<AssetLoadState>();
+
+        Submit(state, [load]() -> std::shared_ptr<void> {
+            return std::shared_ptr<T>(load());
+        }, priority);
+
+        return AssetHandle<T>(std::move(state));
+    }
+
+    AssetHandle<ObjModel> LoadObjAsync(
+            std::string path,
+            AssetLoadPriority priority = AssetLoadPriority::Normal);
+
+    AssetHandle<MD5Model> LoadMD5MeshAsync(
+            std::string path,
+            AssetLoadPriority priority = AssetLoadPriority::Normal);
+
+    AssetHandle<MD5Anim> LoadMD5AnimAsync(
+            std::string path,
+            AssetLoadPriority priority = AssetLoadPriority::Normal);
+
+    // number of loads that haven't been picked up by a worker yet.
+    std::size_t GetNumQueued();
+};
+
+// Shows a placeholder mesh on a scene node until an asynchronously loaded
+// mesh is ready, then swaps it in. Update() never blocks, so it can be
+// called every step from the thread that owns the scene.
+class PlaceholderMeshSwap
+{
+    std::shared_ptr<SceneGraphNode> mNode;
+    AssetHandle<IMesh> mMesh;
+    bool mDone = false;
+
+public:
+    PlaceholderMeshSwap() = default;
+
+    PlaceholderMeshSwap(
+            std::shared_ptr<SceneGraphNode> node,
+            std::shared_ptr<IMesh> placeholder,
+            AssetHandle<IMesh> mesh);
+
+    // returns true once the real mesh was published. If loading failed
+    // or was cancelled, the placeholder stays and this also returns true.
+    bool Update();
+
+    bool IsDone() const
+    {
+        return mDone;
+    }
+};
+
+} // end namespace ng
+
+#endif // NG_ASSETLOADER_HPP
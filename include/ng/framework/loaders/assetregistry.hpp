@@ -0,0 +1,167 @@
+#ifndef NG_ASSETREGISTRY_HPP
+#define NG_ASSETREGISTRY_HPP
+
+#include "ng/framework/loaders/assetloader.hpp"
+
+#include "ng/engine/util/stringview.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ng
+{
+
+class AssetStats
+{
+public:
+    std::string Type;
+    std::string Path;
+    std::string Options;
+
+    AssetLoadStatus Status;
+
+    // estimated memory held by the asset, 0 until it's loaded.
+    std::size_t Bytes;
+    double LoadSeconds;
+
+    // how many times the asset was acquired, including the first time.
+    std::size_t NumRequests;
+
+    // whether anything outside the registry still holds the asset.
+    bool IsReferenced;
+};
+
+// Hands out shared handles to assets, so acquiring the same asset twice
+// loads it only once. Assets are keyed by their type, path (as normalized
+// by NormalizePath) and import options.
+//
+// Once the loaded assets use more memory than the budget, the ones nobody
+// references anymore are evicted, least recently acquired first.
+// Since loads finish in the background, call Trim() regularly
+// (eg. once per frame) to enforce the budget between acquisitions.
+class AssetRegistry
+{
+public:
+    // loads the asset at the normalized path and reports how many bytes it uses.
+    typedef std::function<std::shared_ptr<void>(
+            const std::string& path, std::size_t& bytes)> LoadFunction;
+
+private:
+    class Key
+    {
+    public:
+        std::string Type;
+        std::string Path;
+        std::string Options;
+
+        bool operator<(const Key& other) const;
+    };
+
+    class Record
+    {
+    public:
+        std::shared_ptr<AssetLoadState> State;
+
+        // kept alive by the registry once it's loaded.
+        std::shared_ptr<void> Value;
+
+        // written by the loader thread before the load finishes.
+        std::atomic<std::size_t> Bytes{0};
+        std::atomic<std::int64_t> LoadNanoseconds{0};
+
+        std::uint64_t LastUsed = 0;
+        std::size_t NumRequests = 0;
+
+        bool IsReferenced() const;
+    };
+
+    AssetLoader& mLoader;
+
+    std::mutex mMutex;
+    std::map<Key, std::shared_ptr<Record>> mRecords;
+    std::size_t mMemoryBudget;
+    std::uint64_t mUseCounter = 0;
+    std::size_t mNumEvictions = 0;
+
+    std::shared_ptr<AssetLoadState> AcquireState(
+            std::string type,
+            string_view path,
+            std::string options,
+            LoadFunction load,
+            AssetLoadPriority priority);
+
+    void TrimLocked();
+
+public:
+    // the loader must outlive the registry.
+    AssetRegistry(AssetLoader& loader, std::size_t memoryBudget);
+
+    AssetRegistry(const AssetRegistry&) = delete;
+    AssetRegistry& operator=(const AssetRegistry&) = delete;
+
+    // returns the handle of the asset if it was already acquired,
+    // otherwise starts loading it with load(normalizedPath, bytes).
+    // type tells apart different assets made from the same file.
+    template<class T, class F>
+    AssetHandle<T> Acquire(
+            std::string type,
+            string_view path,
+            std::string options,
+            F load,
+            AssetLoadPriority priority = AssetLoadPriority::Normal)
+    {
+        return AssetHandle<T>(AcquireState(
+                    std::move(type), path, std::move(options),
+                    [load](const std::string& normalizedPath, std::size_t& bytes)
+                        -> std::shared_ptr<void> {
+                        return std::shared_ptr<T>(load(normalizedPath, bytes));
+                    },
+                    priority));
+    }
+
+    AssetHandle<ObjModel> AcquireObjModel(
+            string_view path,
+            AssetLoadPriority priority = AssetLoadPriority::Normal);
+
+    AssetHandle<MD5Model> AcquireMD5Model(
+            string_view path,
+            AssetLoadPriority priority = AssetLoadPriority::Normal);
+
+    AssetHandle<MD5Anim> AcquireMD5Anim(
+            string_view path,
+            AssetLoadPriority priority = AssetLoadPriority::Normal);
+
+    // meshes own a copy of their model, so sharing the mesh
+    // is what avoids keeping the same model in memory twice.
+    AssetHandle<IMesh> AcquireObjMesh(
+            string_view path,
+            AssetLoadPriority priority = AssetLoadPriority::Normal);
+
+    AssetHandle<IMesh> AcquireMD5Mesh(
+            string_view path,
+            AssetLoadPriority priority = AssetLoadPriority::Normal);
+
+    // evicts unreferenced assets until the budget is met.
+    void Trim();
+
+    std::size_t GetMemoryBudget();
+    void SetMemoryBudget(std::size_t memoryBudget);
+
+    // bytes used by the loaded assets.
+    std::size_t GetMemoryUsage();
+
+    std::size_t GetNumEvictions();
+
+    std::vector<AssetStats> GetStats();
+};
+
+} // end namespace ng
+
+#endif // NG_ASSETREGISTRY_HPP
@@ -0,0 +1,100 @@
+#ifndef NG_ADAPTIVEIMPLICITSURFACEMESH_HPP
+#define NG_ADAPTIVEIMPLICITSURFACEMESH_HPP
+
+#include "ng/framework/meshes/implicitsurfacemesh.hpp"
+
+#include "ng/engine/rendering/mesh.hpp"
+
+#include "ng/engine/math/angles.hpp"
+#include "ng/engine/math/linearalgebra.hpp"
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+namespace ng
+{
+
+class AdaptiveImplicitSurfaceOptions
+{
+public:
+    // size of the smallest cells, which the octree never splits.
+    float MinVoxelSize = 0.1f;
+
+    // cells bigger than this are always split.
+    float MaxVoxelSize = 4.0f;
+
+    // cells are split while the normals of the field inside them
+    // differ by more than this angle (ie. where the surface curves.)
+    Radiansf MaxNormalDeviation{0.35f};
+
+    // cells are split while the surface inside them is estimated to be
+    // further than this from the trilinear interpolation of their corners.
+    float MaxGeometricError = 0.05f;
+
+    // when set, MaxGeometricError is replaced by an error of MaxScreenSpaceError
+    // pixels as seen from CameraPosition, so cells far from the camera stay coarse.
+    // PixelsPerUnit is the size in pixels of one unit at a distance of one,
+    // ie. viewportHeight / (2 * tan(fovy / 2)).
+    bool UseCamera = false;
+    vec3 CameraPosition;
+    float PixelsPerUnit = 0.0f;
+    float MaxScreenSpaceError = 1.0f;
+};
+
+class AdaptiveImplicitSurfaceStats
+{
+public:
+    std::size_t NumTriangles = 0;
+    std::size_t NumVertices = 0;
+    std::size_t NumLeaves = 0;
+
+    // number of leaves at each depth of the octree, the root being at depth 0.
+    std::vector<std::size_t> NumLeavesPerDepth;
+
+    // triangles a uniform grid of MinVoxelSize cells would need for the same surface.
+    // estimated from the area of the surface each generated polygon stands for.
+    std::size_t NumUniformTriangles = 0;
+};
+
+// polygonizes an implicit surface on an octree that is only refined where
+// the surface needs it, by dual contouring: a vertex is placed on the surface
+// inside each leaf, and every smallest octree edge crossing the surface joins
+// the vertices of the leaves around it. the leaves around an edge always agree
+// on it whatever their sizes, so there are no cracks between levels.
+class AdaptiveImplicitSurfaceMesh : public IMesh
+{
+    class Vertex
+    {
+    public:
+        vec3 Position;
+        vec3 Normal;
+    };
+
+    std::vector<Vertex> mVertices;
+    std::vector<std::uint32_t> mIndices;
+
+    AdaptiveImplicitSurfaceStats mStats;
+
+    ArithmeticType GetIndexType() const;
+
+public:
+    AdaptiveImplicitSurfaceMesh(
+            std::vector<ImplicitSurfacePrimitive> primitives,
+            float isoValue,
+            const AdaptiveImplicitSurfaceOptions& options);
+
+    const AdaptiveImplicitSurfaceStats& GetStats() const;
+
+    VertexFormat GetVertexFormat() const override;
+
+    std::size_t GetMaxVertexBufferSize() const override;
+    std::size_t GetMaxIndexBufferSize() const override;
+
+    std::size_t WriteVertices(void* buffer) const override;
+    std::size_t WriteIndices(void* buffer) const override;
+};
+
+} // end namespace ng
+
+#endif // NG_ADAPTIVEIMPLICITSURFACEMESH_HPP
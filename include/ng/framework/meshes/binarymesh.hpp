@@ -0,0 +1,50 @@
+#ifndef NG_BINARYMESH_HPP
+#define NG_BINARYMESH_HPP
+
+#include "ng/engine/rendering/mesh.hpp"
+
+#include <memory>
+
+namespace ng
+{
+
+class IReadFile;
+
+// A mesh stored in the .ngmesh format: a header holding the VertexFormat,
+// followed by the vertex and index buffers exactly as they get uploaded.
+// The buffers are copied straight out of the file's contents, so a
+// memory-mapped file is never parsed or converted.
+class BinaryMesh : public IMesh
+{
+    std::shared_ptr<IReadFile> mFile;
+
+    VertexFormat mVertexFormat;
+
+    const char* mVertexData;
+    std::size_t mVertexDataSize;
+    std::size_t mNumVertices;
+
+    const char* mIndexData;
+    std::size_t mIndexDataSize;
+    std::size_t mNumIndices;
+
+public:
+    // throws std::runtime_error if the file isn't a valid .ngmesh
+    // of the version this was compiled with.
+    BinaryMesh(std::shared_ptr<IReadFile> ngmeshFile);
+
+    VertexFormat GetVertexFormat() const override;
+
+    std::size_t GetMaxVertexBufferSize() const override;
+    std::size_t GetMaxIndexBufferSize() const override;
+
+    std::size_t WriteVertices(void* buffer) const override;
+    std::size_t WriteIndices(void* buffer) const override;
+};
+
+// writes the buffers the renderer would get out of mesh to an .ngmesh file.
+void SaveBinaryMesh(const IMesh& mesh, const char* path);
+
+} // end namespace ng
+
+#endif // NG_BINARYMESH_HPP
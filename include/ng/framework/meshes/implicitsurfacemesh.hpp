@@ -7,11 +7,14 @@
 #include "ng/engine/math/linearalgebra.hpp"
 
 #include "ng/engine/util/memory.hpp"
+#include "ng/engine/util/compilertraits.hpp"
 
-#include <functional>
 #include <memory>
 #include <vector>
+#include <map>
 #include <cmath>
+#include <cstdint>
+#include <limits>
 
 namespace ng
 {
@@ -29,6 +32,18 @@ public:
     {
         return std::exp(-StandardDeviation * d2);
     }
+
+    // d/d(d2)
+    float Derivative(float d2) const
+    {
+        return -StandardDeviation * std::exp(-StandardDeviation * d2);
+    }
+
+    // gaussians never reach zero.
+    float GetSupportRadius() const
+    {
+        return std::numeric_limits<float>::infinity();
+    }
 };
 
 class MetaballFilter
@@ -43,11 +58,28 @@ public:
     float operator()(float d2) const
     {
         float ratio = d2 / MaxDistanceSquared;
+        float oneMinusRatio = 1.0f - std::sqrt(ratio);
 
         return d2 <= MaxDistanceSquared / 9.0f ? 1.0f - 3.0f * ratio
-             : d2 <= MaxDistanceSquared ? 3.0f / 2.0f * std::pow(1.0f - std::sqrt(ratio), 2)
+             : d2 <= MaxDistanceSquared ? 3.0f / 2.0f * oneMinusRatio * oneMinusRatio
              : 0.0f;
     }
+
+    // d/d(d2)
+    float Derivative(float d2) const
+    {
+        float ratio = d2 / MaxDistanceSquared;
+        float sqrtRatio = std::sqrt(ratio);
+
+        return d2 <= MaxDistanceSquared / 9.0f ? -3.0f / MaxDistanceSquared
+             : d2 <= MaxDistanceSquared ? -3.0f / 2.0f * (1.0f - sqrtRatio) / (sqrtRatio * MaxDistanceSquared)
+             : 0.0f;
+    }
+
+    float GetSupportRadius() const
+    {
+        return std::sqrt(MaxDistanceSquared);
+    }
 };
 
 class SoftObjectsFilter
@@ -63,11 +95,30 @@ public:
     {
         float ratio = d2 / MaxDistanceSquared;
 
-        return 1.0f
+        // the polynomial climbs back above zero past the max distance,
+        // so it has to be cut off explicitly.
+        return d2 > MaxDistanceSquared ? 0.0f
+             : 1.0f
              - 4.0f / 9.0f * ratio * ratio * ratio
              + 17.0f / 9.0f * ratio * ratio
              - 22.0f / 9.0f * ratio;
     }
+
+    // d/d(d2)
+    float Derivative(float d2) const
+    {
+        float ratio = d2 / MaxDistanceSquared;
+
+        return d2 > MaxDistanceSquared ? 0.0f
+             : (- 12.0f / 9.0f * ratio * ratio
+                + 34.0f / 9.0f * ratio
+                - 22.0f / 9.0f) / MaxDistanceSquared;
+    }
+
+    float GetSupportRadius() const
+    {
+        return std::sqrt(MaxDistanceSquared);
+    }
 };
 
 class WyvillFilter
@@ -85,6 +136,19 @@ public:
         float oneMinusRatio = 1.0f - ratio;
         return oneMinusRatio * oneMinusRatio * oneMinusRatio;
     }
+
+    // d/d(d2)
+    float Derivative(float d2) const
+    {
+        float ratio = d2 / MaxDistanceSquared;
+        float oneMinusRatio = 1.0f - ratio;
+        return -3.0f * oneMinusRatio * oneMinusRatio / MaxDistanceSquared;
+    }
+
+    float GetSupportRadius() const
+    {
+        return std::sqrt(MaxDistanceSquared);
+    }
 };
 
 class ImplicitSurfacePrimitive
@@ -94,50 +158,157 @@ class ImplicitSurfacePrimitive
     public:
         virtual ~IPrimitive() = default;
 
-        virtual float GetDistanceSquaredToSkeleton(vec3 position) const = 0;
+        virtual float GetFieldValue(vec3 position) const = 0;
+
+        // adds this primitive's contribution to a batch of points.
+        virtual void AccumulateFieldValues(
+                const float* NG_RESTRICT xs,
+                const float* NG_RESTRICT ys,
+                const float* NG_RESTRICT zs,
+                float* NG_RESTRICT values,
+                std::size_t count) const = 0;
+
+        // same as above, but also adds the gradient of the contribution.
+        virtual void AccumulateFieldValuesAndGradients(
+                const float* NG_RESTRICT xs,
+                const float* NG_RESTRICT ys,
+                const float* NG_RESTRICT zs,
+                float* NG_RESTRICT values,
+                float* NG_RESTRICT gradientXs,
+                float* NG_RESTRICT gradientYs,
+                float* NG_RESTRICT gradientZs,
+                std::size_t count) const = 0;
+
         virtual vec3 GetPointOnSkeleton() const = 0;
+        virtual AxisAlignedBoundingBox<float> GetSupportBounds() const = 0;
     };
 
-    template<class PrimitiveT>
+    template<class PrimitiveT, class FilterT>
     class PrimitiveImpl : public IPrimitive
     {
         PrimitiveT mPrimitive;
+        FilterT mFilter;
 
     public:
-        PrimitiveImpl(PrimitiveT primitive)
+        PrimitiveImpl(PrimitiveT primitive, FilterT filter)
             : mPrimitive(std::move(primitive))
+            , mFilter(std::move(filter))
         { }
 
-        float GetDistanceSquaredToSkeleton(vec3 position) const override
+        float GetFieldValue(vec3 position) const override
+        {
+            return std::max(mFilter(DistanceSquaredToSkeleton(mPrimitive, position)), 0.0f);
+        }
+
+        void AccumulateFieldValues(
+                const float* NG_RESTRICT xs,
+                const float* NG_RESTRICT ys,
+                const float* NG_RESTRICT zs,
+                float* NG_RESTRICT values,
+                std::size_t count) const override
         {
-            return DistanceSquaredToSkeleton(mPrimitive, position);
+            // kept free of calls and aliasing so the compiler can vectorize it.
+            for (std::size_t i = 0; i < count; i++)
+            {
+                float f = mFilter(DistanceSquaredToSkeleton(mPrimitive, vec3(xs[i], ys[i], zs[i])));
+                values[i] += f > 0.0f ? f : 0.0f;
+            }
+        }
+
+        void AccumulateFieldValuesAndGradients(
+                const float* NG_RESTRICT xs,
+                const float* NG_RESTRICT ys,
+                const float* NG_RESTRICT zs,
+                float* NG_RESTRICT values,
+                float* NG_RESTRICT gradientXs,
+                float* NG_RESTRICT gradientYs,
+                float* NG_RESTRICT gradientZs,
+                std::size_t count) const override
+        {
+            for (std::size_t i = 0; i < count; i++)
+            {
+                vec3 position(xs[i], ys[i], zs[i]);
+                float d2 = DistanceSquaredToSkeleton(mPrimitive, position);
+                float f = mFilter(d2);
+
+                // the field is clamped to zero, and so is its gradient.
+                float dfdd2 = f > 0.0f ? mFilter.Derivative(d2) : 0.0f;
+                vec3 gradient = dfdd2 * GradientOfDistanceSquaredToSkeleton(mPrimitive, position);
+
+                values[i] += f > 0.0f ? f : 0.0f;
+                gradientXs[i] += gradient.x;
+                gradientYs[i] += gradient.y;
+                gradientZs[i] += gradient.z;
+            }
         }
 
         vec3 GetPointOnSkeleton() const override
         {
             return PointOnSkeleton(mPrimitive);
         }
+
+        AxisAlignedBoundingBox<float> GetSupportBounds() const override
+        {
+            AxisAlignedBoundingBox<float> bounds = SkeletonBounds(mPrimitive);
+            vec3 radius(mFilter.GetSupportRadius());
+            bounds.Minimum -= radius;
+            bounds.Maximum += radius;
+            return bounds;
+        }
     };
 
-    std::unique_ptr<IPrimitive> mPrimitive;
-    std::function<float(float)> mFilter;
+    // immutable, so copies of a primitive can share it.
+    std::shared_ptr<const IPrimitive> mPrimitive;
 
 public:
     template<class PrimitiveT, class FilterT>
     ImplicitSurfacePrimitive(PrimitiveT primitive, FilterT filter)
-        : mPrimitive(ng::make_unique<PrimitiveImpl<typename std::remove_reference<PrimitiveT>::type>>(primitive))
-        , mFilter(std::move(filter))
+        : mPrimitive(std::make_shared<PrimitiveImpl<
+                     typename std::remove_reference<PrimitiveT>::type,
+                     typename std::remove_reference<FilterT>::type>>(
+                         std::move(primitive), std::move(filter)))
     { }
 
     float GetFieldValue(vec3 position) const
     {
-        return std::max(mFilter(mPrimitive->GetDistanceSquaredToSkeleton(position)),0.0f);
+        return mPrimitive->GetFieldValue(position);
+    }
+
+    void AccumulateFieldValues(
+            const float* NG_RESTRICT xs,
+            const float* NG_RESTRICT ys,
+            const float* NG_RESTRICT zs,
+            float* NG_RESTRICT values,
+            std::size_t count) const
+    {
+        mPrimitive->AccumulateFieldValues(xs, ys, zs, values, count);
+    }
+
+    void AccumulateFieldValuesAndGradients(
+            const float* NG_RESTRICT xs,
+            const float* NG_RESTRICT ys,
+            const float* NG_RESTRICT zs,
+            float* NG_RESTRICT values,
+            float* NG_RESTRICT gradientXs,
+            float* NG_RESTRICT gradientYs,
+            float* NG_RESTRICT gradientZs,
+            std::size_t count) const
+    {
+        mPrimitive->AccumulateFieldValuesAndGradients(
+                    xs, ys, zs, values, gradientXs, gradientYs, gradientZs, count);
     }
 
     vec3 GetPointOnSkeleton() const
     {
         return mPrimitive->GetPointOnSkeleton();
     }
+
+    // the field of this primitive is zero outside of these bounds.
+    // infinite if the filter never falls off to zero.
+    AxisAlignedBoundingBox<float> GetSupportBounds() const
+    {
+        return mPrimitive->GetSupportBounds();
+    }
 };
 
 template<class T>
@@ -147,19 +318,103 @@ float DistanceSquaredToSkeleton(const Point<T>& pt, vec3 position)
     return dot(diff,diff);
 }
 
+template<class T>
+vec3 GradientOfDistanceSquaredToSkeleton(const Point<T>& pt, vec3 position)
+{
+    return 2.0f * (position - pt.Position);
+}
+
 template<class T>
 vec3 PointOnSkeleton(const Point<T>& pt)
 {
     return pt.Position;
 }
 
+template<class T>
+AxisAlignedBoundingBox<T> SkeletonBounds(const Point<T>& pt)
+{
+    return { pt.Position, pt.Position };
+}
+
+// Sum of the fields of a set of primitives.
+// Primitives with finite support are binned into a uniform grid
+// so each evaluation only visits the ones that can contribute.
+class ImplicitSurfaceField
+{
+    std::vector<ImplicitSurfacePrimitive> mPrimitives;
+
+    // primitives with infinite support are visited by every evaluation.
+    std::vector<std::uint32_t> mUnboundedPrimitives;
+
+    float mCellSize;
+    ivec3 mGridMinimum;
+    ivec3 mGridSize;
+
+    // primitives of cell i are mCellPrimitives[mCellStarts[i]..mCellStarts[i+1]]
+    std::vector<std::uint32_t> mCellStarts;
+    std::vector<std::uint32_t> mCellPrimitives;
+
+    ivec3 GetCellIndex(vec3 position) const;
+
+    // finds a cell whose primitives cover all the points of a batch.
+    bool GetBatchCell(
+            const float* xs, const float* ys, const float* zs,
+            std::size_t count,
+            ivec3& cell) const;
+
+    template<class FunctionT>
+    void ForEachPrimitiveInCell(ivec3 cell, FunctionT f) const;
+
+public:
+    // largest batch evaluated in one pass of the filter kernels.
+    static constexpr std::size_t MaxBatchSize = 8;
+
+    // minCellSize should be about the size of the batches of points queried.
+    ImplicitSurfaceField(
+            std::vector<ImplicitSurfacePrimitive> primitives,
+            float minCellSize);
+
+    const std::vector<ImplicitSurfacePrimitive>& GetPrimitives() const;
+
+    float GetFieldValue(vec3 position) const;
+
+    // evaluates many points at once.
+    // fastest when the points are close to each other (like voxel corners.)
+    void GetFieldValues(
+            const vec3* positions,
+            float* values,
+            std::size_t count) const;
+
+    float GetFieldValueAndGradient(vec3 position, vec3& gradient) const;
+
+    void GetFieldValuesAndGradients(
+            const vec3* positions,
+            float* values,
+            vec3* gradients,
+            std::size_t count) const;
+};
+
 class ImplicitSurfaceMesh : public IMesh
 {
-    class Vertex;
+    friend class ImplicitSurface;
 
-    const std::vector<ImplicitSurfacePrimitive> mPrimitives;
-    const float mIsoValue;
-    const float mVoxelSize;
+    class Vertex
+    {
+    public:
+        vec3 Position;
+        vec3 Normal;
+    };
+
+    // immutable once created, so renderers can read it while the surface changes.
+    // each surface vertex is shared by all the triangles around it.
+    std::vector<Vertex> mVertices;
+    std::vector<std::uint32_t> mIndices;
+
+    ImplicitSurfaceMesh(
+            std::vector<Vertex> vertices,
+            std::vector<std::uint32_t> indices);
+
+    ArithmeticType GetIndexType() const;
 
 public:
     ImplicitSurfaceMesh(
@@ -176,6 +431,42 @@ public:
     std::size_t WriteIndices(void* buffer) const override;
 };
 
+// an implicit surface whose primitives can be edited over time.
+// only the bricks of space touched by the support of edited primitives
+// are re-evaluated and re-meshed, the rest of the surface is reused.
+class ImplicitSurface
+{
+public:
+    typedef std::uint32_t PrimitiveID;
+
+private:
+    class Polygonizer;
+
+    const float mVoxelSize;
+
+    // ordered by ID, so the field sums the primitives in a stable order.
+    std::map<PrimitiveID, ImplicitSurfacePrimitive> mPrimitives;
+    PrimitiveID mNextPrimitiveID = 0;
+
+    // support bounds of the primitives edited since the last polygonization.
+    std::vector<AxisAlignedBoundingBox<float>> mDirtyBounds;
+
+    std::unique_ptr<Polygonizer> mPolygonizer;
+    std::shared_ptr<ImplicitSurfaceMesh> mMesh;
+
+public:
+    ImplicitSurface(float isoValue, float voxelSize);
+    ~ImplicitSurface();
+
+    PrimitiveID AddPrimitive(ImplicitSurfacePrimitive primitive);
+    void SetPrimitive(PrimitiveID id, ImplicitSurfacePrimitive primitive);
+    void RemovePrimitive(PrimitiveID id);
+
+    // re-meshes the parts of the surface affected by the edits since the last call.
+    // the returned mesh stays valid and unchanged after further edits.
+    std::shared_ptr<ImplicitSurfaceMesh> Polygonize();
+};
+
 } // end namespace ng
 
 #endif // NG_IMPLCITSURFACEMESH_HPP
@@ -16,6 +16,11 @@ class MD5Mesh : public IMesh
 public:
     MD5Mesh(MD5Model model);
 
+    const MD5Model& GetModel() const
+    {
+        return mModel;
+    }
+
     VertexFormat GetVertexFormat() const override;
 
     std::size_t GetMaxVertexBufferSize() const override;
@@ -89,12 +89,6 @@ public:
     vec3 Orientation;
 };
 
-class MD5Frame
-{
-public:
-    std::vector<float> AnimationComponents;
-};
-
 class MD5Anim
 {
 public:
@@ -104,7 +98,12 @@ public:
     std::vector<MD5AnimationJoint> Joints;
     std::vector<MD5FrameBounds> FrameBounds;
     std::vector<MD5JointPose> BaseFrame;
-    std::vector<MD5Frame> Frames;
+
+    int NumFrames;
+    int NumAnimatedComponents;
+
+    // NumAnimatedComponents values for each frame, one frame after another.
+    std::vector<float> FrameComponents;
 };
 
 
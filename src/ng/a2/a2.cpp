@@ -34,6 +34,11 @@ class A2 : public ng::IApp
 
     std::shared_ptr<ng::SceneGraphNode> mImplicitNode;
 
+    // kept between updates, so only the parts around the moving primitives are re-meshed.
+    ng::ImplicitSurface mImplicitSurface{0.3f, 0.7f};
+    ng::ImplicitSurface::PrimitiveID mBobbingPrimitive;
+    ng::ImplicitSurface::PrimitiveID mBallPrimitive;
+
 public:
     void Init() override
     {
@@ -63,6 +68,15 @@ public:
         mImplicitNode = std::make_shared<ng::SceneGraphNode>();
         mImplicitNode->Material = normalColoredMaterial;
         rootNode->Children.push_back(mImplicitNode);
+
+        mImplicitSurface.AddPrimitive(
+                    ng::ImplicitSurfacePrimitive(ng::Point<float>({0,0,0}), ng::WyvillFilter(5.0f)));
+
+        mBobbingPrimitive = mImplicitSurface.AddPrimitive(
+                    ng::ImplicitSurfacePrimitive(ng::Point<float>({0,0,0}), ng::WyvillFilter(2.0f)));
+
+        mBallPrimitive = mImplicitSurface.AddPrimitive(
+                    ng::ImplicitSurfacePrimitive(ng::Point<float>({0,0,0}), ng::WyvillFilter(3.0f)));
     }
 
     ng::AppStepAction Step() override
@@ -160,21 +174,16 @@ private:
                     4 * std::sin(fTime) * std::cos(fTime * 2 * ng::pi<float>::value * yHz),
                     3 * std::cos(fTime * 2 * ng::pi<float>::value * zHz));
 
-        std::vector<ng::ImplicitSurfacePrimitive> implicitPrimitives;
-
-        implicitPrimitives.emplace_back(
-                    ng::Point<float>({0,0,0}), ng::WyvillFilter(5.0f));
-
-        implicitPrimitives.emplace_back(
-                    ng::Point<float>({0,5*std::sin(0.5f*fTime * 2 * ng::pi<float>::value),0}), ng::WyvillFilter(2.0f));
+        mImplicitSurface.SetPrimitive(
+                    mBobbingPrimitive,
+                    ng::ImplicitSurfacePrimitive(
+                        ng::Point<float>({0,5*std::sin(0.5f*fTime * 2 * ng::pi<float>::value),0}), ng::WyvillFilter(2.0f)));
 
-        implicitPrimitives.emplace_back(
-                    ng::Point<float>(mBallPos), ng::WyvillFilter(3.0f));
+        mImplicitSurface.SetPrimitive(
+                    mBallPrimitive,
+                    ng::ImplicitSurfacePrimitive(ng::Point<float>(mBallPos), ng::WyvillFilter(3.0f)));
 
-        mImplicitNode->Mesh = std::make_shared<ng::ImplicitSurfaceMesh>(
-                    std::move(implicitPrimitives),
-                    0.3f,
-                    0.7f);
+        mImplicitNode->Mesh = mImplicitSurface.Polygonize();
     }
 };
 
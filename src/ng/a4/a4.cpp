@@ -16,12 +16,14 @@
 #include "ng/engine/util/scopeguard.hpp"
 #include "ng/engine/util/debug.hpp"
 
+#include "ng/framework/loaders/assetloader.hpp"
 #include "ng/framework/loaders/md5loader.hpp"
 
 #include "ng/framework/meshes/skeletalmesh.hpp"
 #include "ng/framework/meshes/md5mesh.hpp"
 #include "ng/framework/meshes/basismesh.hpp"
 #include "ng/framework/meshes/skeletonwireframemesh.hpp"
+#include "ng/framework/meshes/cubemesh.hpp"
 
 #include "ng/framework/models/skeletalmodel.hpp"
 #include "ng/framework/models/md5model.hpp"
@@ -42,6 +44,7 @@ class A4 : public ng::IApp
     std::shared_ptr<ng::IWindow> mWindow;
     std::shared_ptr<ng::IRenderer> mRenderer;
     std::shared_ptr<ng::IFileSystem> mFileSystem;
+    std::unique_ptr<ng::AssetLoader> mAssetLoader;
 
     ng::SceneGraph mScene;
     std::shared_ptr<ng::SceneGraphCameraNode> mMainCamera;
@@ -51,7 +54,13 @@ class A4 : public ng::IApp
     std::shared_ptr<ng::immutable<ng::Skeleton>> mAnimationSkeleton;
     std::shared_ptr<ng::IMesh> mAnimationBindPoseMesh;
     std::shared_ptr<ng::SceneGraphNode> mSkeletonNode;
-    ng::MD5Anim mAnimationAnim;
+    std::shared_ptr<ng::MD5Anim> mAnimationAnim;
+
+    // a placeholder is shown until the bind pose mesh loads, which is
+    // animated once the animation loads too.
+    ng::AssetHandle<ng::IMesh> mPendingBindPoseMesh;
+    ng::AssetHandle<ng::MD5Anim> mPendingAnimationAnim;
+    ng::PlaceholderMeshSwap mBindPoseMeshSwap;
     float mCurrentAnimationFrame = 0.0f;
     bool mInBindPose = false;
 
@@ -72,6 +81,8 @@ public:
 
         mFileSystem = ng::CreateFileSystem();
 
+        mAssetLoader = ng::make_unique<ng::AssetLoader>(mFileSystem);
+
         // setup materials
         mModes.emplace_back("NormalColored", ng::MaterialType::NormalColored);
 
@@ -97,32 +108,26 @@ public:
 
         mAnimationNode = std::make_shared<ng::SceneGraphNode>();
 
-        {
+        std::shared_ptr<ng::IFileSystem> fileSystem = mFileSystem;
+
+        mPendingBindPoseMesh = mAssetLoader->Load<ng::IMesh>([fileSystem]{
             std::shared_ptr<ng::IReadFile> robotMD5MeshFile =
-                    mFileSystem->GetReadFile("bob_lamp_update_export.md5mesh",
+                    fileSystem->GetReadFile("bob_lamp_update_export.md5mesh",
                                              ng::FileReadMode::Text);
 
             ng::MD5Model animationModel;
             ng::LoadMD5Mesh(animationModel, *robotMD5MeshFile);
 
-            ng::Skeleton animationSkeleton(ng::Skeleton::FromMD5Model(animationModel));
-
-            mAnimationSkeleton =
-                    std::make_shared<ng::immutable<ng::Skeleton>>(
-                        std::move(animationSkeleton));
+            return std::make_shared<ng::MD5Mesh>(std::move(animationModel));
+        }, ng::AssetLoadPriority::High);
 
-            mAnimationBindPoseMesh =
-                    std::make_shared<ng::MD5Mesh>(
-                        std::move(animationModel));
-        }
+        mPendingAnimationAnim =
+                mAssetLoader->LoadMD5AnimAsync("bob_lamp_update_export.md5anim");
 
-        {
-            std::shared_ptr<ng::IReadFile> robotMD5AnimFile =
-                    mFileSystem->GetReadFile("bob_lamp_update_export.md5anim",
-                                             ng::FileReadMode::Text);
-
-            ng::LoadMD5Anim(mAnimationAnim, *robotMD5AnimFile);
-        }
+        mBindPoseMeshSwap = ng::PlaceholderMeshSwap(
+                    mAnimationNode,
+                    std::make_shared<ng::CubeMesh>(1.0f),
+                    mPendingBindPoseMesh);
 
         mAnimationNode->Material = checkeredMaterial;
         mAnimationNode->Transform = ng::mat4(
@@ -317,19 +322,64 @@ private:
                                ng::vec3(0.0f,1.0f,0.0f)));
     }
 
+    // starts animating the bind pose mesh once it replaced the placeholder
+    // and the animation loaded too. rethrows the load error if either of
+    // them failed.
+    bool PublishAnimationModel()
+    {
+        if (mAnimationSkeleton != nullptr)
+        {
+            return true;
+        }
+
+        if (!mBindPoseMeshSwap.Update() || !mPendingAnimationAnim.IsDone())
+        {
+            return false;
+        }
+
+        // the mesh was loaded as an MD5Mesh.
+        std::shared_ptr<ng::MD5Mesh> bindPoseMesh =
+                std::static_pointer_cast<ng::MD5Mesh>(mPendingBindPoseMesh.Get());
+
+        mAnimationAnim = mPendingAnimationAnim.Get();
+        mAnimationBindPoseMesh = bindPoseMesh;
+        mAnimationSkeleton =
+                std::make_shared<ng::immutable<ng::Skeleton>>(
+                    ng::Skeleton::FromMD5Model(bindPoseMesh->GetModel()));
+
+        mPendingBindPoseMesh = ng::AssetHandle<ng::IMesh>();
+        mPendingAnimationAnim = ng::AssetHandle<ng::MD5Anim>();
+
+        return true;
+    }
+
     void Update(std::chrono::milliseconds dt)
     {
         UpdateCameraToWindow();
         UpdateCameraTransform(dt);
 
+        const std::string& currentModeName =
+            mModes.at(mCurrentModeIndex).first;
+        const ng::Material& currentMaterial =
+            mModes.at(mCurrentModeIndex).second;
+
+        mAnimationNode->Material = currentMaterial;
+
+        if (!PublishAnimationModel())
+        {
+            return;
+        }
+
+        const ng::MD5Anim& animationAnim = *mAnimationAnim;
+
         mCurrentAnimationFrame += dt.count() / 1000.0f
-                                * mAnimationAnim.FrameRate;
+                                * animationAnim.FrameRate;
         mCurrentAnimationFrame = std::fmod(mCurrentAnimationFrame,
-                                           mAnimationAnim.Frames.size());
+                                           animationAnim.NumFrames);
 
         int startFrame = (int) mCurrentAnimationFrame;
         int endFrame = (int) (mCurrentAnimationFrame + 1.0f);
-        if (endFrame >= (int) mAnimationAnim.Frames.size())
+        if (endFrame >= animationAnim.NumFrames)
         {
             // loop over
             endFrame = 0;
@@ -337,12 +387,12 @@ private:
 
         ng::SkeletonLocalPose startLocalPose(
                     ng::SkeletonLocalPose::FromMD5AnimFrame(
-                        mAnimationSkeleton->get(), mAnimationAnim,
+                        mAnimationSkeleton->get(), animationAnim,
                         startFrame));
 
         ng::SkeletonLocalPose endLocalPose(
                     ng::SkeletonLocalPose::FromMD5AnimFrame(
-                        mAnimationSkeleton->get(), mAnimationAnim,
+                        mAnimationSkeleton->get(), animationAnim,
                         endFrame));
 
         ng::SkeletonLocalPose interpolatedPose(
@@ -363,13 +413,6 @@ private:
                     std::make_shared<ng::immutable<ng::SkinningMatrixPalette>>(
                         std::move(animationSkinningPalette));
 
-        const std::string& currentModeName =
-            mModes.at(mCurrentModeIndex).first;
-        const ng::Material& currentMaterial =
-            mModes.at(mCurrentModeIndex).second;
-
-        mAnimationNode->Material = currentMaterial;
-
         if (mInBindPose)
         {
             mAnimationNode->Mesh = mAnimationBindPoseMesh;
@@ -0,0 +1,286 @@
+#include "ng/engine/filesystem/batchreader.hpp"
+#include "ng/engine/filesystem/filesystem.hpp"
+#include "ng/engine/filesystem/readfile.hpp"
+
+#include "ng/engine/util/scopeguard.hpp"
+
+#include "ng/framework/loaders/objloader.hpp"
+#include "ng/framework/loaders/md5loader.hpp"
+
+#include "ng/framework/models/objmodel.hpp"
+#include "ng/framework/models/md5model.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#define NG_HAS_FADVISE
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+// each file is copied this many times, so a batch has enough distinct
+// files to keep a deep queue busy, and cold reads can't hit a copy that
+// an earlier request already cached.
+const std::size_t kNumCopies = 64;
+
+const int kIterations = 5;
+
+const std::size_t kQueueDepths[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+enum class CacheState
+{
+    Warm,
+    Cold
+};
+
+bool HasExtension(const std::string& path, const char* extension)
+{
+    std::size_t length = std::strlen(extension);
+    return path.size() >= length &&
+           path.compare(path.size() - length, length, extension) == 0;
+}
+
+std::vector<std::string> MakeCopies(const std::vector<std::string>& paths)
+{
+    std::vector<std::string> copies;
+
+    for (const std::string& path : paths)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+        {
+            throw std::runtime_error("Failed to open " + path);
+        }
+
+        std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        for (std::size_t i = 0; i < kNumCopies; i++)
+        {
+            std::string copy = "batchreadbench." + std::to_string(i) + "." + path;
+
+            std::ofstream out(copy, std::ios::binary);
+            out.write(contents.data(), contents.size());
+            if (!out)
+            {
+                throw std::runtime_error("Failed to write " + copy);
+            }
+
+            copies.push_back(copy);
+        }
+    }
+
+    return copies;
+}
+
+void EvictFromPageCache(const std::vector<std::string>& paths)
+{
+#ifdef NG_HAS_FADVISE
+    for (const std::string& path : paths)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd != -1)
+        {
+            ::fdatasync(fd);
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            ::close(fd);
+        }
+    }
+#else
+    (void) paths;
+#endif
+}
+
+// the best of a few batches, each reading every file whole.
+ng::BatchReadStats BenchmarkBatch(
+        ng::BatchReader& reader,
+        const std::vector<std::string>& paths,
+        std::vector<std::vector<char>>& buffers,
+        CacheState cacheState)
+{
+    std::vector<ng::BatchReadRequest> requests(paths.size());
+    for (std::size_t i = 0; i < paths.size(); i++)
+    {
+        requests[i].Path = paths[i];
+        requests[i].Buffer = buffers[i].data();
+        requests[i].Size = buffers[i].size();
+    }
+
+    ng::BatchReadStats best;
+
+    for (int i = 0; i < kIterations; i++)
+    {
+        if (cacheState == CacheState::Cold)
+        {
+            EvictFromPageCache(paths);
+        }
+
+        ng::BatchReadStats stats = reader.Read(requests, [](std::size_t, const ng::BatchReadResult&) { });
+
+        if (stats.NumFailed != 0)
+        {
+            throw std::runtime_error("Failed to read " + std::to_string(stats.NumFailed) + " files");
+        }
+
+        if (i == 0 || stats.Seconds < best.Seconds)
+        {
+            best = stats;
+        }
+    }
+
+    return best;
+}
+
+void Parse(const std::string& path, ng::IReadFile& file)
+{
+    if (HasExtension(path, ".obj"))
+    {
+        ng::ObjModel model;
+        ng::LoadObj(model, file);
+    }
+    else if (HasExtension(path, ".md5mesh"))
+    {
+        ng::MD5Model model;
+        ng::LoadMD5Mesh(model, file);
+    }
+    else if (HasExtension(path, ".md5anim"))
+    {
+        ng::MD5Anim anim;
+        ng::LoadMD5Anim(anim, file);
+    }
+}
+
+// loading every file one after the other, against preloading them in one
+// batch and parsing each one as soon as it lands.
+void BenchmarkLoading(const std::vector<std::string>& paths, CacheState cacheState)
+{
+    std::shared_ptr<ng::IFileSystem> fileSystem = ng::CreateFileSystem();
+
+    double sequentialMs = 0.0;
+    double preloadMs = 0.0;
+
+    for (int i = 0; i < kIterations; i++)
+    {
+        if (cacheState == CacheState::Cold)
+        {
+            EvictFromPageCache(paths);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (const std::string& path : paths)
+        {
+            Parse(path, *fileSystem->GetReadFile(path.c_str(), ng::FileReadMode::Text));
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        sequentialMs = i == 0 ? ms : std::min(sequentialMs, ms);
+
+        if (cacheState == CacheState::Cold)
+        {
+            EvictFromPageCache(paths);
+        }
+
+        ng::PreloadFileSystem preloader(fileSystem);
+
+        start = std::chrono::high_resolution_clock::now();
+        preloader.Preload(paths, [](const std::string& path, std::shared_ptr<ng::IReadFile> file)
+        {
+            Parse(path, *file);
+        });
+        end = std::chrono::high_resolution_clock::now();
+
+        ms = std::chrono::duration<double, std::milli>(end - start).count();
+        preloadMs = i == 0 ? ms : std::min(preloadMs, ms);
+    }
+
+    std::printf("  %-5s load and parse: %8.3f ms one by one | %8.3f ms preloaded in one batch\n",
+                cacheState == CacheState::Cold ? "cold" : "warm", sequentialMs, preloadMs);
+}
+
+} // end anonymous namespace
+
+int main(int argc, char* argv[]) try
+{
+    std::vector<std::string> paths(argv + 1, argv + argc);
+    if (paths.empty())
+    {
+        paths = { "bunny.obj", "teapot.obj",
+                  "bob_lamp_update_export.md5mesh", "bob_lamp_update_export.md5anim" };
+    }
+
+    std::vector<std::string> copies = MakeCopies(paths);
+
+    auto removeCopiesScope = ng::make_scope_guard([&]{
+        for (const std::string& copy : copies)
+        {
+            std::remove(copy.c_str());
+        }
+    });
+
+    std::vector<std::vector<char>> buffers;
+    std::size_t numBytes = 0;
+    for (const std::string& copy : copies)
+    {
+        std::ifstream in(copy, std::ios::binary | std::ios::ate);
+        buffers.emplace_back(std::size_t(in.tellg()));
+        numBytes += buffers.back().size();
+    }
+
+#ifdef NG_HAS_FADVISE
+    std::vector<CacheState> cacheStates = { CacheState::Warm, CacheState::Cold };
+#else
+    std::vector<CacheState> cacheStates = { CacheState::Warm };
+#endif
+
+    std::printf("%zu files, %.2f MB per batch\n", copies.size(), numBytes / (1024.0 * 1024.0));
+
+    for (int allowIoUring = 1; allowIoUring >= 0; allowIoUring--)
+    {
+        for (std::size_t queueDepth : kQueueDepths)
+        {
+            ng::BatchReader reader(queueDepth, allowIoUring != 0);
+
+            // without io_uring, the io_uring pass would only repeat the threads.
+            if (allowIoUring && !reader.UsesIoUring())
+            {
+                std::printf("io_uring isn't available, reading with threads only\n");
+                break;
+            }
+
+            std::printf("%-8s queue depth %3zu |", reader.UsesIoUring() ? "io_uring" : "threads", queueDepth);
+
+            for (CacheState cacheState : cacheStates)
+            {
+                ng::BatchReadStats stats = BenchmarkBatch(reader, copies, buffers, cacheState);
+
+                std::printf(" %s %9.1f MB/s (%3zu in flight) |",
+                            cacheState == CacheState::Cold ? "cold" : "warm",
+                            stats.GetMegabytesPerSecond(), stats.MaxInFlight);
+            }
+
+            std::printf("\n");
+        }
+    }
+
+    for (CacheState cacheState : cacheStates)
+    {
+        BenchmarkLoading(copies, cacheState);
+    }
+}
+catch (const std::exception& e)
+{
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+}
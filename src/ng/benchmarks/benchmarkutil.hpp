@@ -0,0 +1,74 @@
+#ifndef NG_BENCHMARKUTIL_HPP
+#define NG_BENCHMARKUTIL_HPP
+
+#include "ng/engine/filesystem/filesystem.hpp"
+#include "ng/engine/filesystem/readfile.hpp"
+
+#include "ng/framework/loaders/objloader.hpp"
+#include "ng/framework/loaders/md5loader.hpp"
+
+#include "ng/framework/meshes/objmesh.hpp"
+#include "ng/framework/meshes/md5mesh.hpp"
+
+#include "ng/framework/models/objmodel.hpp"
+#include "ng/framework/models/md5model.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace benchmarks
+{
+
+// loads a .obj, or otherwise a .md5mesh.
+inline std::unique_ptr<ng::IMesh> LoadTextMesh(ng::IFileSystem& fileSystem, const std::string& path)
+{
+    std::shared_ptr<ng::IReadFile> file =
+            fileSystem.GetReadFile(path.c_str(), ng::FileReadMode::Text);
+
+    if (path.size() > 4 && path.compare(path.size() - 4, 4, ".obj") == 0)
+    {
+        ng::ObjModel model;
+        ng::LoadObj(model, *file);
+        return std::unique_ptr<ng::IMesh>(new ng::ObjMesh(std::move(model)));
+    }
+    else
+    {
+        ng::MD5Model model;
+        ng::LoadMD5Mesh(model, *file);
+        return std::unique_ptr<ng::IMesh>(new ng::MD5Mesh(std::move(model)));
+    }
+}
+
+// the fastest of a few runs of f, each one after an untimed run of setup.
+inline double BestMilliseconds(int iterations,
+                               const std::function<void()>& setup,
+                               const std::function<void()>& f)
+{
+    double best = 0.0;
+
+    for (int i = 0; i < iterations; i++)
+    {
+        setup();
+
+        auto start = std::chrono::high_resolution_clock::now();
+        f();
+        auto end = std::chrono::high_resolution_clock::now();
+
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        best = i == 0 ? ms : std::min(best, ms);
+    }
+
+    return best;
+}
+
+inline double BestMilliseconds(int iterations, const std::function<void()>& f)
+{
+    return BestMilliseconds(iterations, []{ }, f);
+}
+
+} // end namespace benchmarks
+
+#endif // NG_BENCHMARKUTIL_HPP
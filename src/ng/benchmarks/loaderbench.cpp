@@ -0,0 +1,527 @@
+#include "ng/engine/filesystem/filesystem.hpp"
+#include "ng/engine/filesystem/readfile.hpp"
+
+#include "ng/framework/loaders/objloader.hpp"
+#include "ng/framework/loaders/md5loader.hpp"
+
+#include "ng/framework/models/objmodel.hpp"
+#include "ng/framework/models/md5model.hpp"
+
+#include "ng/engine/util/compilertraits.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#define NG_HAS_FADVISE
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+// counts every allocation made through operator new, which is what the
+// loaders allocate their models with. every form of new and delete is
+// replaced, and none of them can be inlined, so the compiler never sees a
+// pointer from the builtin operator new being passed to free().
+namespace
+{
+
+std::atomic<std::size_t> gNumAllocations(0);
+std::atomic<std::size_t> gNumAllocatedBytes(0);
+
+void* Count(void* p, std::size_t size) noexcept
+{
+    gNumAllocations.fetch_add(1, std::memory_order_relaxed);
+    gNumAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    return p;
+}
+
+void* CountedMalloc(std::size_t size) noexcept
+{
+    return Count(std::malloc(size == 0 ? 1 : size), size);
+}
+
+void* CountedNew(std::size_t size)
+{
+    if (void* p = CountedMalloc(size))
+    {
+        return p;
+    }
+
+    throw std::bad_alloc();
+}
+
+#ifdef __cpp_aligned_new
+// aligned_alloc() needs the size to be a multiple of the alignment.
+void* CountedAlignedMalloc(std::size_t size, std::align_val_t alignment) noexcept
+{
+    std::size_t align = static_cast<std::size_t>(alignment);
+    std::size_t paddedSize = (size + align - 1) / align * align;
+    return Count(std::aligned_alloc(align, paddedSize == 0 ? align : paddedSize), size);
+}
+
+void* CountedAlignedNew(std::size_t size, std::align_val_t alignment)
+{
+    if (void* p = CountedAlignedMalloc(size, alignment))
+    {
+        return p;
+    }
+
+    throw std::bad_alloc();
+}
+#endif
+
+} // end anonymous namespace
+
+NG_NOINLINE void* operator new(std::size_t size)
+{
+    return CountedNew(size);
+}
+
+NG_NOINLINE void* operator new[](std::size_t size)
+{
+    return CountedNew(size);
+}
+
+NG_NOINLINE void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return CountedMalloc(size);
+}
+
+NG_NOINLINE void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return CountedMalloc(size);
+}
+
+NG_NOINLINE void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+NG_NOINLINE void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+NG_NOINLINE void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+
+NG_NOINLINE void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+
+NG_NOINLINE void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+NG_NOINLINE void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+#ifdef __cpp_aligned_new
+NG_NOINLINE void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return CountedAlignedNew(size, alignment);
+}
+
+NG_NOINLINE void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return CountedAlignedNew(size, alignment);
+}
+
+NG_NOINLINE void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return CountedAlignedMalloc(size, alignment);
+}
+
+NG_NOINLINE void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return CountedAlignedMalloc(size, alignment);
+}
+
+NG_NOINLINE void operator delete(void* p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+NG_NOINLINE void operator delete[](void* p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+NG_NOINLINE void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+
+NG_NOINLINE void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+
+NG_NOINLINE void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+NG_NOINLINE void operator delete[](void* p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+#endif
+
+namespace
+{
+
+// each file is loaded repeatedly until at least this much time was spent on it
+const double kMinSecondsPerRun = 1.0;
+const int kMinIterationsPerRun = 10;
+
+// cold loads read from disk, so they get a shorter budget.
+const double kMinSecondsPerColdRun = 0.5;
+const int kMinIterationsPerColdRun = 3;
+
+enum class CacheState
+{
+    Warm,
+    Cold
+};
+
+class RunResult
+{
+public:
+    int Iterations = 0;
+    double MeanSeconds = 0.0;
+    double BestSeconds = 0.0;
+    double AllocationsPerLoad = 0.0;
+    double AllocatedBytesPerLoad = 0.0;
+    long PeakRssKB = -1;
+
+    // how much of the file was still cached after asking the OS to drop it,
+    // or -1 if that couldn't be checked. anything much above 0 means the
+    // cold numbers were really warm (eg. the file lives on tmpfs).
+    double ResidentAfterEvict = -1.0;
+};
+
+// the loader for a file, picked by its extension.
+std::function<void(ng::IReadFile&)> GetLoader(const std::string& path, std::string& loaderName)
+{
+    auto hasExtension = [&](const char* extension)
+    {
+        std::size_t length = std::strlen(extension);
+        return path.size() >= length &&
+               path.compare(path.size() - length, length, extension) == 0;
+    };
+
+    if (hasExtension(".obj"))
+    {
+        loaderName = "LoadObj";
+        return [](ng::IReadFile& file)
+        {
+            ng::ObjModel model;
+            ng::LoadObj(model, file);
+        };
+    }
+    else if (hasExtension(".md5mesh"))
+    {
+        loaderName = "LoadMD5Mesh";
+        return [](ng::IReadFile& file)
+        {
+            ng::MD5Model model;
+            ng::LoadMD5Mesh(model, file);
+        };
+    }
+    else if (hasExtension(".md5anim"))
+    {
+        loaderName = "LoadMD5Anim";
+        return [](ng::IReadFile& file)
+        {
+            ng::MD5Anim anim;
+            ng::LoadMD5Anim(anim, file);
+        };
+    }
+
+    throw std::runtime_error("No loader for " + path);
+}
+
+// resets the peak RSS, where the OS allows it, so each run reports its own.
+void ResetPeakRss()
+{
+#if defined(__linux__)
+    if (FILE* clearRefs = std::fopen("/proc/self/clear_refs", "w"))
+    {
+        std::fputs("5", clearRefs);
+        std::fclose(clearRefs);
+    }
+#endif
+}
+
+// the peak resident set size in KiB, or -1 if it's unknown.
+long GetPeakRssKB()
+{
+#if defined(__linux__)
+    if (FILE* status = std::fopen("/proc/self/status", "r"))
+    {
+        char line[256];
+        long peak = -1;
+        while (std::fgets(line, sizeof(line), status))
+        {
+            if (std::sscanf(line, "VmHWM: %ld kB", &peak) == 1)
+            {
+                break;
+            }
+        }
+
+        std::fclose(status);
+        if (peak != -1)
+        {
+            return peak;
+        }
+    }
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+#if defined(__APPLE__)
+        return usage.ru_maxrss / 1024;
+#else
+        return usage.ru_maxrss;
+#endif
+    }
+#endif
+
+    return -1;
+}
+
+#ifdef NG_HAS_FADVISE
+// drops the file from the page cache, then returns the fraction of its
+// pages that are still resident, or -1 if that's unknown.
+double EvictFromPageCache(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        throw std::runtime_error("Failed to open " + path);
+    }
+
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+
+    double resident = -1.0;
+
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        void* mapping = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapping != MAP_FAILED)
+        {
+            long pageSize = ::sysconf(_SC_PAGESIZE);
+            std::size_t numPages = (st.st_size + pageSize - 1) / pageSize;
+            std::vector<unsigned char> pages(numPages);
+
+            if (::mincore(mapping, st.st_size, pages.data()) == 0)
+            {
+                std::size_t numResident = std::count_if(
+                            pages.begin(), pages.end(),
+                            [](unsigned char page) { return (page & 1) != 0; });
+
+                resident = double(numResident) / numPages;
+            }
+
+            ::munmap(mapping, st.st_size);
+        }
+    }
+
+    ::close(fd);
+    return resident;
+}
+#endif
+
+// times opening and loading the file, the way the game does at startup.
+RunResult BenchmarkRun(
+        ng::IFileSystem& fileSystem, const std::string& path,
+        const std::function<void(ng::IReadFile&)>& load,
+        CacheState cacheState)
+{
+    double minSeconds = cacheState == CacheState::Cold ? kMinSecondsPerColdRun : kMinSecondsPerRun;
+    int minIterations = cacheState == CacheState::Cold ? kMinIterationsPerColdRun : kMinIterationsPerRun;
+
+    RunResult result;
+    double totalSeconds = 0.0;
+    std::size_t numAllocations = 0;
+    std::size_t numAllocatedBytes = 0;
+    double totalResident = 0.0;
+
+    // once without timing it, so a warm run starts from a warm cache.
+    load(*fileSystem.GetReadFile(path.c_str(), ng::FileReadMode::Text));
+
+    ResetPeakRss();
+
+    while (totalSeconds < minSeconds || result.Iterations < minIterations)
+    {
+#ifdef NG_HAS_FADVISE
+        if (cacheState == CacheState::Cold)
+        {
+            totalResident += EvictFromPageCache(path);
+        }
+#endif
+
+        std::size_t allocationsBefore = gNumAllocations;
+        std::size_t bytesBefore = gNumAllocatedBytes;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        load(*fileSystem.GetReadFile(path.c_str(), ng::FileReadMode::Text));
+        auto end = std::chrono::high_resolution_clock::now();
+
+        numAllocations += gNumAllocations - allocationsBefore;
+        numAllocatedBytes += gNumAllocatedBytes - bytesBefore;
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        result.BestSeconds = result.Iterations == 0 ? seconds : std::min(result.BestSeconds, seconds);
+        totalSeconds += seconds;
+        result.Iterations++;
+    }
+
+    result.MeanSeconds = totalSeconds / result.Iterations;
+    result.AllocationsPerLoad = double(numAllocations) / result.Iterations;
+    result.AllocatedBytesPerLoad = double(numAllocatedBytes) / result.Iterations;
+    result.PeakRssKB = GetPeakRssKB();
+
+    if (cacheState == CacheState::Cold && totalResident >= 0.0)
+    {
+        result.ResidentAfterEvict = totalResident / result.Iterations;
+    }
+
+    return result;
+}
+
+std::string JsonString(const std::string& s)
+{
+    std::string json = "\"";
+
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+        {
+            json += '\\';
+            json += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            json += escaped;
+        }
+        else
+        {
+            json += c;
+        }
+    }
+
+    return json + "\"";
+}
+
+void PrintRun(const char* name, const RunResult& run, double sizeInMB, bool isLast)
+{
+    std::printf("      %s: {\n", JsonString(name).c_str());
+    std::printf("        \"iterations\": %d,\n", run.Iterations);
+    std::printf("        \"mean_ms\": %.4f,\n", run.MeanSeconds * 1000.0);
+    std::printf("        \"best_ms\": %.4f,\n", run.BestSeconds * 1000.0);
+    std::printf("        \"mean_mb_per_s\": %.2f,\n", sizeInMB / run.MeanSeconds);
+    std::printf("        \"best_mb_per_s\": %.2f,\n", sizeInMB / run.BestSeconds);
+    std::printf("        \"allocations_per_load\": %.1f,\n", run.AllocationsPerLoad);
+    std::printf("        \"allocated_bytes_per_load\": %.0f,\n", run.AllocatedBytesPerLoad);
+
+    if (run.ResidentAfterEvict >= 0.0)
+    {
+        std::printf("        \"resident_after_evict\": %.3f,\n", run.ResidentAfterEvict);
+    }
+
+    std::printf("        \"peak_rss_kb\": %ld\n", run.PeakRssKB);
+    std::printf("      }%s\n", isLast ? "" : ",");
+}
+
+} // end anonymous namespace
+
+// prints a JSON report to stdout, so runs can be diffed across versions.
+int main(int argc, char* argv[]) try
+{
+    std::vector<std::string> paths(argv + 1, argv + argc);
+    if (paths.empty())
+    {
+        paths = { "bunny.obj", "teapot.obj",
+                  "bob_lamp_update_export.md5mesh", "bob_lamp_update_export.md5anim" };
+    }
+
+    std::shared_ptr<ng::IFileSystem> fileSystem = ng::CreateFileSystem();
+
+#ifdef NG_HAS_FADVISE
+    bool hasColdRuns = true;
+#else
+    bool hasColdRuns = false;
+#endif
+
+    std::printf("{\n");
+    std::printf("  \"cold_cache\": %s,\n", hasColdRuns ? "\"posix_fadvise\"" : "null");
+    std::printf("  \"files\": [\n");
+
+    for (std::size_t i = 0; i < paths.size(); i++)
+    {
+        const std::string& path = paths[i];
+
+        std::string loaderName;
+        std::function<void(ng::IReadFile&)> load = GetLoader(path, loaderName);
+
+        std::size_t size = fileSystem->GetReadFile(path.c_str(), ng::FileReadMode::Text)
+                ->GetContents().size();
+        double sizeInMB = size / (1024.0 * 1024.0);
+
+        RunResult warm = BenchmarkRun(*fileSystem, path, load, CacheState::Warm);
+
+        std::printf("    {\n");
+        std::printf("      \"path\": %s,\n", JsonString(path).c_str());
+        std::printf("      \"loader\": %s,\n", JsonString(loaderName).c_str());
+        std::printf("      \"bytes\": %zu,\n", size);
+
+        PrintRun("warm", warm, sizeInMB, !hasColdRuns);
+
+        if (hasColdRuns)
+        {
+            RunResult cold = BenchmarkRun(*fileSystem, path, load, CacheState::Cold);
+            PrintRun("cold", cold, sizeInMB, true);
+        }
+
+        std::printf("    }%s\n", i + 1 == paths.size() ? "" : ",");
+        std::fflush(stdout);
+    }
+
+    std::printf("  ]\n");
+    std::printf("}\n");
+}
+catch (const std::exception& e)
+{
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+}
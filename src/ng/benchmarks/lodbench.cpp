@@ -0,0 +1,203 @@
+#include "ng/engine/filesystem/filesystem.hpp"
+
+#include "ng/engine/rendering/flatscenegraph.hpp"
+#include "ng/engine/rendering/lod.hpp"
+#include "ng/engine/rendering/lodselector.hpp"
+#include "ng/engine/rendering/meshsimplifier.hpp"
+#include "ng/engine/rendering/mesh.hpp"
+#include "ng/engine/rendering/renderbatch.hpp"
+#include "ng/engine/rendering/renderresources.hpp"
+
+#include "ng/benchmarks/benchmarkutil.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+const int kIterations = 5;
+
+const int kGridSize = 32;
+const int kNumFrames = 600;
+
+ng::AxisAlignedBoundingBox<float> GetBounds(const ng::IMesh& mesh)
+{
+    std::vector<ng::vec3> positions;
+    std::vector<std::uint32_t> indices;
+    ng::ReadTriangles(mesh, positions, indices);
+
+    ng::AxisAlignedBoundingBox<float> bounds(positions.front(), positions.front());
+    for (const ng::vec3& position : positions)
+    {
+        bounds.AddPoint(position);
+    }
+    return bounds;
+}
+
+void BenchmarkChain(ng::IFileSystem& fileSystem, const std::string& path)
+{
+    std::unique_ptr<ng::IMesh> mesh = benchmarks::LoadTextMesh(fileSystem, path);
+
+    ng::AxisAlignedBoundingBox<float> bounds = GetBounds(*mesh);
+    float diagonal = ng::length(bounds.Maximum - bounds.Minimum);
+
+    std::vector<std::shared_ptr<ng::SimplifiedMesh>> chain;
+    double buildMs = benchmarks::BestMilliseconds(kIterations, [&]{
+        chain = ng::BuildLodChain(*mesh);
+    });
+
+    std::printf("%-32s %7zu triangles | chain built in %8.3f ms |",
+                path.c_str(), ng::GetMaxNumTriangles(*mesh), buildMs);
+
+    for (const std::shared_ptr<ng::SimplifiedMesh>& lod : chain)
+    {
+        std::printf(" %zu (%.2f%%)", lod->GetNumTriangles(), 100.0 * lod->GetError() / diagonal);
+    }
+
+    std::printf("%s\n", chain.empty() ? " can't be simplified" : "");
+}
+
+class FrameTotals
+{
+public:
+    std::size_t NumTrianglesWithoutLod = 0;
+    std::size_t NumTrianglesWithLod = 0;
+    std::size_t NumLevelChanges = 0;
+    double SelectMilliseconds = 0.0;
+
+    void Add(const ng::LodStats& stats, double ms)
+    {
+        NumTrianglesWithoutLod += stats.NumTrianglesWithoutLod;
+        NumTrianglesWithLod += stats.NumTrianglesWithLod;
+        NumLevelChanges += stats.NumLevelChanges;
+        SelectMilliseconds += ms;
+    }
+};
+
+// a grid of meshes seen by a camera that walks over it, bobbing back and
+// forth a little every frame, the way a hand held camera does.
+void BenchmarkScene(ng::IFileSystem& fileSystem, const std::vector<std::string>& paths)
+{
+    ng::RenderResources resources;
+
+    std::vector<ng::MeshHandle> meshes;
+    std::vector<ng::AxisAlignedBoundingBox<float>> meshBounds;
+    float spacing = 0.0f;
+
+    for (const std::string& path : paths)
+    {
+        std::shared_ptr<ng::IMesh> mesh = benchmarks::LoadTextMesh(fileSystem, path);
+        meshBounds.push_back(GetBounds(*mesh));
+        meshes.push_back(resources.AddMeshWithLods(mesh));
+
+        spacing = std::max(spacing, 2.0f * ng::length(meshBounds.back().Maximum - meshBounds.back().Minimum));
+    }
+
+    ng::MaterialHandle material = resources.AddMaterial(ng::Material());
+
+    ng::FlatSceneGraph scene;
+    for (int y = 0; y < kGridSize; y++)
+    {
+        for (int x = 0; x < kGridSize; x++)
+        {
+            std::size_t which = (x + y) % meshes.size();
+
+            ng::FlatSceneGraph::NodeIndex node = scene.AddRoot(
+                        ng::SceneLayer::World,
+                        ng::translate4x4(ng::vec3(x * spacing, 0.0f, y * spacing) - meshBounds[which].GetCenter()));
+
+            scene.SetMesh(node, meshes[which]);
+            scene.SetMaterial(node, material);
+            scene.SetLocalBounds(node, meshBounds[which]);
+        }
+    }
+
+    ng::FlatSceneCamera camera;
+    camera.Projection = ng::perspective(ng::Radiansf(ng::Degreesf(70.0f)), 16.0f / 9.0f,
+                                        0.01f * spacing, 100.0f * spacing);
+    camera.ViewportTopLeft = ng::ivec2(0, 0);
+    camera.ViewportSize = ng::ivec2(1280, 720);
+
+    ng::FlatSceneGraph::NodeIndex cameraNode = scene.AddRoot(ng::SceneLayer::World);
+    scene.SetCamera(cameraNode, camera);
+    scene.SetCameraActive(cameraNode, true);
+
+    ng::LodSelector withHysteresis;
+    ng::LodSelector withoutHysteresis(1.0f, 0.0f);
+
+    FrameTotals totalsWith;
+    FrameTotals totalsWithout;
+
+    float extent = kGridSize * spacing;
+
+    for (int frame = 0; frame < kNumFrames; frame++)
+    {
+        float walked = extent * frame / kNumFrames;
+        float bob = 0.25f * spacing * std::sin(frame * 2.0f);
+
+        ng::vec3 eye(0.5f * extent, 0.5f * spacing, -spacing + walked + bob);
+        ng::vec3 target = eye + ng::vec3(0.0f, -0.1f, 1.0f);
+        scene.SetLocalTransform(cameraNode, ng::inverse(ng::lookAt(eye, target, ng::vec3(0.0f, 1.0f, 0.0f))));
+        scene.UpdateWorldTransforms();
+
+        for (int hysteresis = 0; hysteresis < 2; hysteresis++)
+        {
+            ng::RenderBatch batch = ng::RenderBatch::FromScene(scene);
+
+            ng::LodSelector& selector = hysteresis ? withHysteresis : withoutHysteresis;
+
+            auto start = std::chrono::high_resolution_clock::now();
+            ng::LodStats stats = selector.Select(batch, resources);
+            auto end = std::chrono::high_resolution_clock::now();
+
+            (hysteresis ? totalsWith : totalsWithout).Add(
+                        stats, std::chrono::duration<double, std::milli>(end - start).count());
+        }
+    }
+
+    std::printf("\n%d objects over %d frames, at most 1 pixel of error:\n", kGridSize * kGridSize, kNumFrames);
+    std::printf("  without lod:     %9.0f triangles/frame\n",
+                double(totalsWith.NumTrianglesWithoutLod) / kNumFrames);
+
+    for (const FrameTotals* totals : { &totalsWithout, &totalsWith })
+    {
+        std::printf("  %-16s %9.0f triangles/frame (%5.1f%% fewer) | %6.2f level changes/frame | select %.4f ms/frame\n",
+                    totals == &totalsWith ? "with hysteresis:" : "with lod:",
+                    double(totals->NumTrianglesWithLod) / kNumFrames,
+                    100.0 * (1.0 - double(totals->NumTrianglesWithLod) / totals->NumTrianglesWithoutLod),
+                    double(totals->NumLevelChanges) / kNumFrames,
+                    totals->SelectMilliseconds / kNumFrames);
+    }
+}
+
+} // end anonymous namespace
+
+int main(int argc, char* argv[]) try
+{
+    std::vector<std::string> paths(argv + 1, argv + argc);
+    if (paths.empty())
+    {
+        paths = { "bunny.obj", "teapot.obj", "bob_lamp_update_export.md5mesh" };
+    }
+
+    std::shared_ptr<ng::IFileSystem> fileSystem = ng::CreateFileSystem();
+
+    for (const std::string& path : paths)
+    {
+        BenchmarkChain(*fileSystem, path);
+    }
+
+    BenchmarkScene(*fileSystem, paths);
+}
+catch (const std::exception& e)
+{
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+}
@@ -0,0 +1,78 @@
+#include "ng/engine/filesystem/filesystem.hpp"
+
+#include "ng/framework/meshes/binarymesh.hpp"
+
+#include "ng/benchmarks/benchmarkutil.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+const int kIterations = 20;
+
+// startup cost of a mesh: everything from opening the file
+// until the vertex buffer is ready to be uploaded.
+std::vector<char> BuildVertexBuffer(const ng::IMesh& mesh)
+{
+    std::vector<char> vertexBuffer(mesh.GetMaxVertexBufferSize());
+    mesh.WriteVertices(vertexBuffer.data());
+    return vertexBuffer;
+}
+
+void BenchmarkFile(ng::IFileSystem& fileSystem, const std::string& path)
+{
+    std::string ngmeshPath = path.substr(0, path.find_last_of('.')) + ".ngmesh";
+    ng::SaveBinaryMesh(*benchmarks::LoadTextMesh(fileSystem, path), ngmeshPath.c_str());
+
+    std::vector<char> textVertices, binaryVertices;
+
+    double textMs = benchmarks::BestMilliseconds(kIterations, [&]{
+        textVertices = BuildVertexBuffer(*benchmarks::LoadTextMesh(fileSystem, path));
+    });
+
+    double binaryMs = benchmarks::BestMilliseconds(kIterations, [&]{
+        ng::BinaryMesh mesh(fileSystem.GetReadFile(ngmeshPath.c_str(),
+                                                   ng::FileReadMode::Binary));
+        binaryVertices = BuildVertexBuffer(mesh);
+    });
+
+    if (textVertices.size() != binaryVertices.size() ||
+        std::memcmp(textVertices.data(), binaryVertices.data(), textVertices.size()) != 0)
+    {
+        throw std::runtime_error(ngmeshPath + " doesn't match " + path);
+    }
+
+    std::printf("%-32s %8.3f ms | %-32s %8.3f ms | %6.1fx faster, %zu bytes of vertices\n",
+                path.c_str(), textMs, ngmeshPath.c_str(), binaryMs,
+                textMs / binaryMs, binaryVertices.size());
+}
+
+} // end anonymous namespace
+
+int main(int argc, char* argv[]) try
+{
+    std::vector<std::string> paths(argv + 1, argv + argc);
+    if (paths.empty())
+    {
+        paths = { "bunny.obj", "teapot.obj", "bob_lamp_update_export.md5mesh" };
+    }
+
+    std::shared_ptr<ng::IFileSystem> fileSystem = ng::CreateFileSystem();
+
+    for (const std::string& path : paths)
+    {
+        BenchmarkFile(*fileSystem, path);
+    }
+}
+catch (const std::exception& e)
+{
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+}
@@ -0,0 +1,182 @@
+#include "ng/engine/filesystem/filesystem.hpp"
+
+#include "ng/engine/rendering/meshlets.hpp"
+#include "ng/engine/rendering/mesh.hpp"
+
+#include "ng/benchmarks/benchmarkutil.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+const int kIterations = 5;
+const std::size_t kNumViews = 256;
+
+class View
+{
+public:
+    ng::mat4 WorldView;
+    ng::mat4 Projection;
+};
+
+// half the views see the whole mesh from around it, so only back facing
+// meshlets go. The other half are close ups, where most of the mesh is
+// off screen too.
+std::vector<View> MakeViews(ng::vec3 center, float radius, std::size_t count)
+{
+    std::mt19937 random(1234);
+    std::normal_distribution<float> normal;
+
+    std::vector<View> views;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        ng::vec3 direction = ng::normalize(ng::vec3(normal(random), normal(random), normal(random)));
+        bool closeUp = i % 2 == 1;
+
+        ng::vec3 target = closeUp ? center + direction * (0.5f * radius) : center;
+        ng::vec3 eye = target + direction * (closeUp ? 0.5f * radius : 2.5f * radius);
+        ng::vec3 up = std::abs(direction.y) > 0.99f ? ng::vec3(1.0f, 0.0f, 0.0f) : ng::vec3(0.0f, 1.0f, 0.0f);
+
+        View view;
+        view.WorldView = ng::lookAt(eye, target, up);
+        view.Projection = ng::perspective(ng::Radiansf(ng::Degreesf(70.0f)), 16.0f / 9.0f,
+                                          0.01f * radius, 10.0f * radius);
+        views.push_back(view);
+    }
+
+    return views;
+}
+
+// every triangle that faces the camera with a corner on screen must be kept.
+void CheckConservative(const std::vector<ng::vec3>& positions, const std::vector<std::uint32_t>& keptIndices,
+                       const std::vector<std::uint32_t>& allIndices, const View& view, const std::string& path)
+{
+    std::vector<std::uint32_t> kept;
+    for (std::size_t i = 0; i + 2 < keptIndices.size(); i += 3)
+    {
+        kept.push_back(keptIndices[i]);
+    }
+
+    ng::mat4 viewProjection = view.Projection * view.WorldView;
+    ng::vec3 eye = ng::vec3(ng::inverse(view.WorldView) * ng::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+
+    std::vector<std::uint32_t> needed;
+    for (std::size_t i = 0; i + 2 < allIndices.size(); i += 3)
+    {
+        const ng::vec3& p0 = positions[allIndices[i]];
+        const ng::vec3& p1 = positions[allIndices[i + 1]];
+        const ng::vec3& p2 = positions[allIndices[i + 2]];
+
+        if (ng::dot(eye - p0, ng::cross(p1 - p0, p2 - p0)) <= 0.0f)
+        {
+            continue;
+        }
+
+        for (const ng::vec3* corner : { &p0, &p1, &p2 })
+        {
+            ng::vec4 clip = viewProjection * ng::vec4(*corner, 1.0f);
+            if (std::abs(clip.x) < clip.w && std::abs(clip.y) < clip.w && std::abs(clip.z) < clip.w)
+            {
+                needed.push_back(allIndices[i]);
+                break;
+            }
+        }
+    }
+
+    // triangles are told apart by their first index, which is good enough
+    // to catch meshlets that shouldn't have been culled.
+    std::sort(kept.begin(), kept.end());
+    for (std::uint32_t index : needed)
+    {
+        if (!std::binary_search(kept.begin(), kept.end(), index))
+        {
+            throw std::runtime_error("A visible triangle of " + path + " was culled");
+        }
+    }
+}
+
+void BenchmarkFile(ng::IFileSystem& fileSystem, const std::string& path)
+{
+    std::unique_ptr<ng::IMesh> mesh = benchmarks::LoadTextMesh(fileSystem, path);
+
+    std::unique_ptr<ng::Meshlets> meshlets;
+    double buildMs = benchmarks::BestMilliseconds(kIterations, [&]{
+        meshlets.reset(new ng::Meshlets(*mesh));
+    });
+
+    std::vector<ng::vec3> positions;
+    std::vector<std::uint32_t> indices;
+    ng::ReadTriangles(*mesh, positions, indices);
+
+    ng::AxisAlignedBoundingBox<float> bounds(positions.front(), positions.front());
+    for (const ng::vec3& position : positions)
+    {
+        bounds.AddPoint(position);
+    }
+
+    std::vector<View> views = MakeViews(bounds.GetCenter(), ng::length(bounds.Maximum - bounds.GetCenter()), kNumViews);
+
+    std::vector<ng::MeshletRange> ranges;
+    std::size_t numRanges = 0;
+    std::size_t numTriangles = 0;
+    std::size_t numVisibleTriangles = 0;
+    double cullMs = benchmarks::BestMilliseconds(kIterations, [&]{
+        numRanges = 0;
+        numTriangles = 0;
+        numVisibleTriangles = 0;
+
+        for (const View& view : views)
+        {
+            ng::MeshletCullStats stats = meshlets->Cull(view.WorldView, view.Projection, ranges);
+            numRanges += ranges.size();
+            numTriangles += stats.NumTriangles;
+            numVisibleTriangles += stats.NumVisibleTriangles;
+        }
+    });
+
+    std::vector<std::uint32_t> keptIndices;
+    for (const View& view : views)
+    {
+        meshlets->Cull(view.WorldView, view.Projection, keptIndices);
+        CheckConservative(positions, keptIndices, indices, view, path);
+    }
+
+    std::printf("%-32s %7zu triangles %5zu meshlets | build %8.3f ms | cull %7.4f ms/view | "
+                "%6.1f ranges/view | %5.1f%% of triangles culled\n",
+                path.c_str(), indices.size() / 3, meshlets->GetMeshlets().size(),
+                buildMs, cullMs / views.size(),
+                double(numRanges) / views.size(),
+                100.0 * (1.0 - double(numVisibleTriangles) / numTriangles));
+}
+
+} // end anonymous namespace
+
+int main(int argc, char* argv[]) try
+{
+    std::vector<std::string> paths(argv + 1, argv + argc);
+    if (paths.empty())
+    {
+        paths = { "bunny.obj", "teapot.obj", "bob_lamp_update_export.md5mesh" };
+    }
+
+    std::shared_ptr<ng::IFileSystem> fileSystem = ng::CreateFileSystem();
+
+    for (const std::string& path : paths)
+    {
+        BenchmarkFile(*fileSystem, path);
+    }
+}
+catch (const std::exception& e)
+{
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+}
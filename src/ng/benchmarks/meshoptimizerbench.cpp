@@ -0,0 +1,176 @@
+#include "ng/engine/filesystem/filesystem.hpp"
+
+#include "ng/engine/rendering/meshoptimizer.hpp"
+#include "ng/engine/rendering/mesh.hpp"
+
+#include "ng/engine/math/geometry.hpp"
+
+#include "ng/framework/meshes/cubemesh.hpp"
+#include "ng/framework/meshes/loopsubdivisionmesh.hpp"
+
+#include "ng/benchmarks/benchmarkutil.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+const int kIterations = 5;
+
+const int kOverdrawSize = 256;
+const std::size_t kNumOverdrawViews = 32;
+
+// the mean number of times each covered pixel passes the depth test, when
+// the front faces are drawn in order with orthographic views from around
+// the mesh.
+double MeasureOverdraw(const ng::IMesh& mesh)
+{
+    std::vector<ng::vec3> positions;
+    std::vector<std::uint32_t> indices;
+    ng::ReadTriangles(mesh, positions, indices);
+
+    ng::AxisAlignedBoundingBox<float> bounds(positions.front(), positions.front());
+    for (const ng::vec3& position : positions)
+    {
+        bounds.AddPoint(position);
+    }
+
+    ng::vec3 center = bounds.GetCenter();
+    float radius = ng::length(bounds.Maximum - center);
+
+    std::mt19937 random(1234);
+    std::normal_distribution<float> normal;
+
+    std::vector<float> depths(kOverdrawSize * kOverdrawSize);
+    std::size_t numPassed = 0;
+    std::size_t numCovered = 0;
+
+    for (std::size_t view = 0; view < kNumOverdrawViews; view++)
+    {
+        ng::vec3 forward = ng::normalize(ng::vec3(normal(random), normal(random), normal(random)));
+        ng::vec3 right = ng::normalize(ng::cross(forward, std::abs(forward.y) > 0.99f
+                                                 ? ng::vec3(1.0f, 0.0f, 0.0f)
+                                                 : ng::vec3(0.0f, 1.0f, 0.0f)));
+        ng::vec3 up = ng::cross(right, forward);
+
+        float scale = kOverdrawSize / (2.0f * radius);
+
+        std::vector<ng::vec3> screen(positions.size());
+        for (std::size_t i = 0; i < positions.size(); i++)
+        {
+            ng::vec3 p = positions[i] - center;
+            screen[i] = ng::vec3((ng::dot(p, right) + radius) * scale,
+                                 (ng::dot(p, up) + radius) * scale,
+                                 ng::dot(p, forward));
+        }
+
+        std::fill(depths.begin(), depths.end(), std::numeric_limits<float>::infinity());
+
+        for (std::size_t t = 0; t + 2 < indices.size(); t += 3)
+        {
+            const ng::vec3& a = screen[indices[t]];
+            const ng::vec3& b = screen[indices[t + 1]];
+            const ng::vec3& c = screen[indices[t + 2]];
+
+            // counter-clockwise when seen from the front, with y up.
+            float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+            if (area <= 0.0f)
+            {
+                continue;
+            }
+
+            int minX = std::max(0, int(std::floor(std::min({ a.x, b.x, c.x }))));
+            int maxX = std::min(kOverdrawSize - 1, int(std::ceil(std::max({ a.x, b.x, c.x }))));
+            int minY = std::max(0, int(std::floor(std::min({ a.y, b.y, c.y }))));
+            int maxY = std::min(kOverdrawSize - 1, int(std::ceil(std::max({ a.y, b.y, c.y }))));
+
+            for (int y = minY; y <= maxY; y++)
+            {
+                for (int x = minX; x <= maxX; x++)
+                {
+                    float px = x + 0.5f;
+                    float py = y + 0.5f;
+
+                    float wa = (b.x - px) * (c.y - py) - (b.y - py) * (c.x - px);
+                    float wb = (c.x - px) * (a.y - py) - (c.y - py) * (a.x - px);
+                    float wc = (a.x - px) * (b.y - py) - (a.y - py) * (b.x - px);
+
+                    if (wa < 0.0f || wb < 0.0f || wc < 0.0f)
+                    {
+                        continue;
+                    }
+
+                    float depth = (wa * a.z + wb * b.z + wc * c.z) / area;
+
+                    float& stored = depths[y * kOverdrawSize + x];
+                    if (depth < stored)
+                    {
+                        numCovered += stored == std::numeric_limits<float>::infinity();
+                        numPassed++;
+                        stored = depth;
+                    }
+                }
+            }
+        }
+    }
+
+    return numCovered == 0 ? 0.0 : double(numPassed) / numCovered;
+}
+
+void BenchmarkMesh(const std::string& name, const ng::IMesh& mesh)
+{
+    std::unique_ptr<ng::OptimizedMesh> optimized;
+    double optimizeMs = benchmarks::BestMilliseconds(kIterations, [&]{
+        optimized.reset(new ng::OptimizedMesh(mesh));
+    });
+
+    const ng::MeshOptimizationStats& stats = optimized->GetStats();
+
+    std::printf("%-32s %7zu triangles | %7zu -> %6zu vertices | optimized in %8.3f ms | "
+                "acmr %.3f -> %.3f | overdraw %.3f -> %.3f\n",
+                name.c_str(), stats.NumTrianglesBefore,
+                stats.NumVerticesBefore, stats.NumVerticesAfter,
+                optimizeMs,
+                stats.AcmrBefore, stats.AcmrAfter,
+                MeasureOverdraw(mesh), MeasureOverdraw(*optimized));
+}
+
+} // end anonymous namespace
+
+int main(int argc, char* argv[]) try
+{
+    std::vector<std::string> paths(argv + 1, argv + argc);
+    if (paths.empty())
+    {
+        paths = { "bunny.obj", "teapot.obj", "bob_lamp_update_export.md5mesh" };
+    }
+
+    std::shared_ptr<ng::IFileSystem> fileSystem = ng::CreateFileSystem();
+
+    for (const std::string& path : paths)
+    {
+        BenchmarkMesh(path, *benchmarks::LoadTextMesh(*fileSystem, path));
+    }
+
+    // subdividing writes a triangle soup.
+    std::shared_ptr<ng::IMesh> cube = std::make_shared<ng::CubeMesh>(1.0f);
+    std::shared_ptr<ng::IMesh> subdividedCube = std::make_shared<ng::LoopSubdivisionMesh>(cube);
+    for (int level = 2; level <= 4; level++)
+    {
+        subdividedCube = std::make_shared<ng::LoopSubdivisionMesh>(subdividedCube);
+        BenchmarkMesh("cube subdivided " + std::to_string(level) + " times", *subdividedCube);
+    }
+}
+catch (const std::exception& e)
+{
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+}
@@ -0,0 +1,205 @@
+#include "ng/engine/filesystem/filesystem.hpp"
+
+#include "ng/engine/rendering/meshbvh.hpp"
+
+#include "ng/benchmarks/benchmarkutil.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+const int kIterations = 5;
+const std::size_t kNumRays = 200000;
+
+// brute force is only checked against a few of the rays, it's slow.
+const std::size_t kNumCheckedRays = 2000;
+
+// the mesh's triangles as a flat list of corners, read independently
+// of MeshBVH to check against.
+std::vector<ng::vec3> ReadCorners(const ng::IMesh& mesh)
+{
+    ng::VertexFormat fmt = mesh.GetVertexFormat();
+
+    if (fmt.Position.Type != ng::ArithmeticType::Float || fmt.Position.Cardinality < 3)
+    {
+        throw std::runtime_error("Only meshes with 3D float positions can be checked");
+    }
+
+    std::vector<char> vertices(mesh.GetMaxVertexBufferSize());
+    std::size_t numVertices = mesh.WriteVertices(vertices.data());
+
+    std::vector<std::uint32_t> indices;
+    if (fmt.IsIndexed)
+    {
+        if (fmt.IndexType != ng::ArithmeticType::UInt32 && fmt.IndexType != ng::ArithmeticType::UInt16)
+        {
+            throw std::runtime_error("Only meshes with 16 or 32 bit indices can be checked");
+        }
+
+        std::vector<char> indexBuffer(mesh.GetMaxIndexBufferSize());
+        std::size_t numIndices = mesh.WriteIndices(indexBuffer.data());
+        for (std::size_t i = 0; i < numIndices; i++)
+        {
+            const char* index = indexBuffer.data() + fmt.IndexOffset;
+            indices.push_back(fmt.IndexType == ng::ArithmeticType::UInt32
+                              ? reinterpret_cast<const std::uint32_t*>(index)[i]
+                              : reinterpret_cast<const std::uint16_t*>(index)[i]);
+        }
+    }
+    else
+    {
+        for (std::size_t i = 0; i < numVertices; i++)
+        {
+            indices.push_back(std::uint32_t(i));
+        }
+    }
+
+    std::vector<ng::vec3> corners;
+    for (std::size_t i = 0; i < indices.size(); i++)
+    {
+        const float* position = reinterpret_cast<const float*>(
+                    vertices.data() + fmt.Position.Offset + fmt.Position.Stride * indices[i]);
+        corners.push_back(ng::vec3(position[0], position[1], position[2]));
+    }
+    corners.resize(corners.size() - corners.size() % 3);
+
+    return corners;
+}
+
+// rays from around the mesh towards random points inside its bounds,
+// so most of them hit and some of them graze it.
+std::vector<ng::Ray<float>> MakeRays(const ng::AxisAlignedBoundingBox<float>& bounds, std::size_t count)
+{
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::normal_distribution<float> normal;
+
+    ng::vec3 center = bounds.GetCenter();
+    float radius = 2.0f * length(bounds.Maximum - center);
+
+    std::vector<ng::Ray<float>> rays;
+    rays.reserve(count);
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        ng::vec3 origin = center + radius * normalize(ng::vec3(normal(random), normal(random), normal(random)));
+
+        ng::vec3 target;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            target[axis] = bounds.Minimum[axis] + unit(random) * (bounds.Maximum[axis] - bounds.Minimum[axis]);
+        }
+
+        rays.push_back(ng::Ray<float>(origin, normalize(target - origin)));
+    }
+
+    return rays;
+}
+
+bool BruteForceRayCast(const std::vector<ng::vec3>& corners, const ng::Ray<float>& ray, float& closest)
+{
+    bool found = false;
+    float tmax = std::numeric_limits<float>::infinity();
+
+    for (std::size_t i = 0; i < corners.size(); i += 3)
+    {
+        float t, u, v;
+        if (ng::RayTriangleIntersect(ray, corners[i], corners[i + 1], corners[i + 2], 0.0f, tmax, t, u, v))
+        {
+            tmax = t;
+            found = true;
+        }
+    }
+
+    closest = tmax;
+    return found;
+}
+
+void BenchmarkFile(ng::IFileSystem& fileSystem, const std::string& path)
+{
+    std::unique_ptr<ng::IMesh> mesh = benchmarks::LoadTextMesh(fileSystem, path);
+
+    std::unique_ptr<ng::MeshBVH> bvh;
+    double buildMs = benchmarks::BestMilliseconds(kIterations, [&]{
+        bvh.reset(new ng::MeshBVH(*mesh));
+    });
+
+    double refitMs = benchmarks::BestMilliseconds(kIterations, [&]{
+        bvh->Refit(*mesh);
+    });
+
+    std::vector<ng::Ray<float>> rays = MakeRays(bvh->GetBounds(), kNumRays);
+
+    std::size_t numHits = 0;
+    double castMs = benchmarks::BestMilliseconds(kIterations, [&]{
+        numHits = 0;
+        for (const ng::Ray<float>& ray : rays)
+        {
+            ng::MeshRayHit hit;
+            numHits += bvh->RayCast(ray, 0.0f, std::numeric_limits<float>::infinity(), hit);
+        }
+    });
+
+    std::vector<ng::vec3> corners = ReadCorners(*mesh);
+
+    auto bruteForceStart = std::chrono::high_resolution_clock::now();
+    for (std::size_t i = 0; i < kNumCheckedRays; i++)
+    {
+        ng::MeshRayHit hit;
+        bool bvhFound = bvh->RayCast(rays[i], 0.0f, std::numeric_limits<float>::infinity(), hit);
+
+        float closest;
+        bool bruteForceFound = BruteForceRayCast(corners, rays[i], closest);
+
+        if (bvhFound != bruteForceFound || (bvhFound && hit.T != closest))
+        {
+            throw std::runtime_error("MeshBVH doesn't agree with brute force on " + path);
+        }
+    }
+    auto bruteForceEnd = std::chrono::high_resolution_clock::now();
+
+    double bruteForceMs = std::chrono::duration<double, std::milli>(bruteForceEnd - bruteForceStart).count();
+    double bruteForceRaysPerSecond = kNumCheckedRays / (bruteForceMs / 1000.0);
+    double raysPerSecond = kNumRays / (castMs / 1000.0);
+
+    std::printf("%-32s %7zu triangles %7zu nodes | build %8.3f ms | refit %7.3f ms | "
+                "%6.2f Mrays/s (%4.1f%% hit) | brute force %8.4f Mrays/s | %6.0fx faster\n",
+                path.c_str(), bvh->GetNumTriangles(), bvh->GetNumNodes(),
+                buildMs, refitMs,
+                raysPerSecond / 1e6, 100.0 * numHits / kNumRays,
+                bruteForceRaysPerSecond / 1e6, raysPerSecond / bruteForceRaysPerSecond);
+}
+
+} // end anonymous namespace
+
+int main(int argc, char* argv[]) try
+{
+    std::vector<std::string> paths(argv + 1, argv + argc);
+    if (paths.empty())
+    {
+        paths = { "bunny.obj", "teapot.obj", "bob_lamp_update_export.md5mesh" };
+    }
+
+    std::shared_ptr<ng::IFileSystem> fileSystem = ng::CreateFileSystem();
+
+    for (const std::string& path : paths)
+    {
+        BenchmarkFile(*fileSystem, path);
+    }
+}
+catch (const std::exception& e)
+{
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+}
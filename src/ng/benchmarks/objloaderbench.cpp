@@ -0,0 +1,77 @@
+#include "ng/engine/filesystem/filesystem.hpp"
+#include "ng/engine/filesystem/readfile.hpp"
+
+#include "ng/framework/loaders/objloader.hpp"
+
+#include "ng/framework/models/objmodel.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <vector>
+
+namespace
+{
+
+// each file is parsed repeatedly until at least this much time was spent on it
+const double kMinSecondsPerFile = 1.0;
+const int kMinIterationsPerFile = 10;
+
+void BenchmarkFile(ng::IFileSystem& fileSystem, const char* path)
+{
+    // the file stays open so only parsing is measured, not disk I/O.
+    std::shared_ptr<ng::IReadFile> objFile =
+            fileSystem.GetReadFile(path, ng::FileReadMode::Text);
+
+    double sizeInMB = objFile->GetContents().size() / (1024.0 * 1024.0);
+
+    double totalSeconds = 0.0;
+    double bestSeconds = 0.0;
+    int iterations = 0;
+    ng::ObjModel model;
+
+    while (totalSeconds < kMinSecondsPerFile || iterations < kMinIterationsPerFile)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        ng::LoadObj(model, *objFile);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        bestSeconds = iterations == 0 ? seconds : std::min(bestSeconds, seconds);
+        totalSeconds += seconds;
+        iterations++;
+    }
+
+    double meanSeconds = totalSeconds / iterations;
+
+    std::printf("%-16s %8.3f MB %6zu positions %7zu indices | "
+                "mean %8.3f ms (%7.1f MB/s) best %8.3f ms (%7.1f MB/s)\n",
+                path, sizeInMB,
+                model.Positions.size(), model.Indices.size(),
+                meanSeconds * 1000.0, sizeInMB / meanSeconds,
+                bestSeconds * 1000.0, sizeInMB / bestSeconds);
+}
+
+} // end anonymous namespace
+
+int main(int argc, char* argv[]) try
+{
+    std::vector<const char*> paths(argv + 1, argv + argc);
+    if (paths.empty())
+    {
+        paths = { "bunny.obj", "teapot.obj" };
+    }
+
+    std::shared_ptr<ng::IFileSystem> fileSystem = ng::CreateFileSystem();
+
+    for (const char* path : paths)
+    {
+        BenchmarkFile(*fileSystem, path);
+    }
+}
+catch (const std::exception& e)
+{
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+}
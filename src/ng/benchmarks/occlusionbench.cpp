@@ -0,0 +1,181 @@
+#include "ng/engine/rendering/occlusionculler.hpp"
+#include "ng/engine/rendering/occluder.hpp"
+#include "ng/engine/rendering/renderbatch.hpp"
+
+#include "ng/engine/util/parallelfor.hpp"
+
+#include "ng/framework/meshes/cubemesh.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+const int kIterations = 5;
+
+class Scenario
+{
+public:
+    std::string Name;
+    ng::RenderBatch Batch;
+    std::vector<ng::Occluder> Occluders;
+
+    // how many objects must end up culled, or -1 if it isn't known.
+    long ExpectedOccluded = -1;
+};
+
+ng::RenderCamera MakeCamera(ng::vec3 eye, ng::vec3 center)
+{
+    ng::RenderCamera camera;
+    camera.Projection = ng::perspective(ng::Radiansf(ng::Degreesf(70.0f)), 2.0f, 0.1f, 1000.0f);
+    camera.WorldView = ng::lookAt(eye, center, ng::vec3(0.0f, 1.0f, 0.0f));
+    camera.ViewportTopLeft = ng::ivec2(0, 0);
+    camera.ViewportSize = ng::ivec2(1280, 640);
+    return camera;
+}
+
+void AddObject(ng::RenderBatch& batch, ng::vec3 center, float size)
+{
+    ng::RenderObject object = ng::RenderObject();
+    object.WorldTransform = ng::translate4x4(center);
+    object.WorldBounds = ng::AxisAlignedBoundingBox<float>(center - ng::vec3(size / 2), center + ng::vec3(size / 2));
+    batch.RenderObjects.push_back(object);
+}
+
+ng::Occluder MakeBox(const std::shared_ptr<const ng::OccluderMesh>& cube, ng::vec3 center, ng::vec3 size)
+{
+    return ng::Occluder{cube, ng::translate4x4(center) * ng::scale4x4(size)};
+}
+
+// a wall filling the view, with objects on both sides of it. all the
+// ones behind it are hidden, none of the ones in front of it are.
+Scenario MakeWallScenario(const std::shared_ptr<const ng::OccluderMesh>& cube, std::size_t numObjects)
+{
+    Scenario scenario;
+    scenario.Name = "wall";
+    scenario.Batch.RenderCameras.push_back(MakeCamera(ng::vec3(0.0f), ng::vec3(0.0f, 0.0f, -1.0f)));
+    scenario.Occluders.push_back(MakeBox(cube, ng::vec3(0.0f, 0.0f, -10.0f), ng::vec3(60.0f, 30.0f, 1.0f)));
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    std::size_t numBehind = numObjects - numObjects / 10;
+    for (std::size_t i = 0; i < numObjects; i++)
+    {
+        bool behind = i < numBehind;
+        float z = behind ? -45.0f + 30.0f * unit(random) : -5.0f + 2.0f * unit(random);
+        AddObject(scenario.Batch, ng::vec3(unit(random) * -z, unit(random) * -z * 0.5f, z), 0.5f);
+    }
+
+    scenario.ExpectedOccluded = long(numBehind);
+    return scenario;
+}
+
+// blocks of buildings seen from the street, with small objects scattered
+// on the ground between them.
+Scenario MakeCityScenario(const std::shared_ptr<const ng::OccluderMesh>& cube, std::size_t numObjects)
+{
+    const int kBlocks = 16;
+    const float kSpacing = 12.0f;
+    const float kHalfExtent = kBlocks * kSpacing / 2;
+
+    Scenario scenario;
+    scenario.Name = "city";
+    scenario.Batch.RenderCameras.push_back(MakeCamera(ng::vec3(0.0f, 2.0f, kHalfExtent + 20.0f),
+                                                      ng::vec3(20.0f, 2.0f, 0.0f)));
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    for (int z = 0; z < kBlocks; z++)
+    {
+        for (int x = 0; x < kBlocks; x++)
+        {
+            float height = 5.0f + 25.0f * unit(random);
+            ng::vec3 center((x + 0.5f) * kSpacing - kHalfExtent, height / 2, (z + 0.5f) * kSpacing - kHalfExtent);
+            scenario.Occluders.push_back(MakeBox(cube, center, ng::vec3(8.0f, height, 8.0f)));
+        }
+    }
+
+    for (std::size_t i = 0; i < numObjects; i++)
+    {
+        ng::vec3 center((unit(random) * 2 - 1) * kHalfExtent, 0.5f, (unit(random) * 2 - 1) * kHalfExtent);
+        AddObject(scenario.Batch, center, 1.0f);
+    }
+
+    return scenario;
+}
+
+void BenchmarkScenario(const Scenario& scenario, const std::vector<std::size_t>& workerCounts)
+{
+    double serialMs = 0.0;
+
+    for (std::size_t workers : workerCounts)
+    {
+        ng::OcclusionCuller culler(256, 128, workers);
+
+        // the stats of the fastest run.
+        ng::OcclusionStats best;
+        for (int i = 0; i < kIterations; i++)
+        {
+            ng::RenderBatch batch = scenario.Batch;
+            ng::OcclusionStats stats = culler.Cull(batch, scenario.Occluders);
+
+            if (i == 0 || stats.GetTotalMilliseconds() < best.GetTotalMilliseconds())
+            {
+                best = stats;
+            }
+        }
+
+        if (scenario.ExpectedOccluded >= 0 && long(best.NumOccluded) != scenario.ExpectedOccluded)
+        {
+            throw std::runtime_error("Wrong number of objects culled in the " + scenario.Name + " scenario");
+        }
+
+        if (workers == workerCounts.front())
+        {
+            serialMs = best.GetTotalMilliseconds();
+        }
+
+        std::printf("%-5s %3zu workers | %6zu occluder triangles | %7zu/%7zu occluded (%5.1f%%) | "
+                    "rasterize %7.3f ms | pyramid %6.3f ms | test %7.3f ms | total %7.3f ms (%5.2fx)\n",
+                    scenario.Name.c_str(), workers, best.NumOccluderTriangles,
+                    best.NumOccluded, best.NumTested, 100.0 * best.NumOccluded / best.NumTested,
+                    best.RasterizeMilliseconds, best.PyramidMilliseconds, best.TestMilliseconds,
+                    best.GetTotalMilliseconds(), serialMs / best.GetTotalMilliseconds());
+    }
+}
+
+} // end anonymous namespace
+
+// usage: occlusionbench [numObjects] [maxWorkers]
+int main(int argc, char* argv[]) try
+{
+    std::size_t numObjects = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    std::size_t maxWorkers = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : ng::default_worker_count();
+
+    std::vector<std::size_t> workerCounts;
+    for (std::size_t workers = 1; workers < maxWorkers; workers *= 2)
+    {
+        workerCounts.push_back(workers);
+    }
+    workerCounts.push_back(std::max<std::size_t>(maxWorkers, 1));
+
+    std::shared_ptr<const ng::OccluderMesh> cube = std::make_shared<ng::OccluderMesh>(ng::CubeMesh(1.0f));
+
+    BenchmarkScenario(MakeWallScenario(cube, numObjects), workerCounts);
+    BenchmarkScenario(MakeCityScenario(cube, numObjects), workerCounts);
+}
+catch (const std::exception& e)
+{
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+}
@@ -0,0 +1,143 @@
+#include "ng/engine/rendering/flatscenegraph.hpp"
+
+#include "ng/engine/rendering/renderbatch.hpp"
+
+#include "ng/engine/util/parallelfor.hpp"
+
+#include "ng/benchmarks/benchmarkutil.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+
+const int kIterations = 5;
+
+// a synthetic scene: a few thousand roots, each node's parent picked
+// among the nodes just before it, so trees are a few dozen levels deep.
+// most nodes have a mesh, the rest are only there to group their children.
+void BuildScene(ng::FlatSceneGraph& scene, std::size_t numNodes, std::vector<ng::FlatSceneGraph::NodeIndex>& roots)
+{
+    const std::size_t kNumRoots = 4096;
+    const std::uint32_t kParentWindow = 64;
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+
+    ng::MeshHandle mesh;
+    mesh.generation = 1;
+
+    scene.Reserve(numNodes);
+
+    for (std::size_t i = 0; i < numNodes; i++)
+    {
+        ng::mat4 transform = ng::translate4x4(ng::vec3(offset(random), offset(random), offset(random)));
+
+        ng::FlatSceneGraph::NodeIndex node;
+        if (i < kNumRoots)
+        {
+            node = scene.AddRoot(ng::SceneLayer::World, transform);
+            roots.push_back(node);
+        }
+        else
+        {
+            std::uint32_t back = 1 + random() % std::min<std::uint32_t>(kParentWindow, std::uint32_t(i));
+            node = scene.AddChild(ng::FlatSceneGraph::NodeIndex(i - back), transform);
+        }
+
+        if (random() % 4 != 0)
+        {
+            // one mesh per material, so the draw keys vary.
+            ng::MaterialHandle material;
+            material.index = random() % 64;
+            material.generation = 1;
+
+            scene.SetMesh(node, mesh);
+            scene.SetMaterial(node, material);
+            scene.SetLocalBounds(node, ng::AxisAlignedBoundingBox<float>(ng::vec3(-0.5f), ng::vec3(0.5f)));
+        }
+    }
+}
+
+bool SameObjects(const std::vector<ng::RenderObject>& a, const std::vector<ng::RenderObject>& b)
+{
+    return a.size() == b.size() &&
+           std::memcmp(a.data(), b.data(), a.size() * sizeof(ng::RenderObject)) == 0;
+}
+
+} // end anonymous namespace
+
+// usage: sceneextractbench [numNodes] [maxWorkers]
+int main(int argc, char* argv[]) try
+{
+    std::size_t numNodes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    std::size_t maxWorkers = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : ng::default_worker_count();
+
+    ng::FlatSceneGraph scene;
+    std::vector<ng::FlatSceneGraph::NodeIndex> roots;
+    BuildScene(scene, numNodes, roots);
+    scene.UpdateWorldTransforms();
+
+    ng::RenderBatch serialBatch = ng::RenderBatch::FromScene(scene, 1);
+
+    std::printf("%zu nodes, %zu render objects, %zu hardware threads\n",
+                scene.GetNumNodes(), serialBatch.RenderObjects.size(),
+                ng::default_worker_count());
+
+    std::vector<std::size_t> workerCounts;
+    for (std::size_t workers = 1; workers < maxWorkers; workers *= 2)
+    {
+        workerCounts.push_back(workers);
+    }
+    workerCounts.push_back(std::max<std::size_t>(maxWorkers, 1));
+
+    double serialUpdateMs = 0.0;
+    double serialExtractMs = 0.0;
+
+    for (std::size_t workers : workerCounts)
+    {
+        // moving every root dirties the whole scene.
+        double updateMs = benchmarks::BestMilliseconds(
+            kIterations,
+            [&]{
+                for (ng::FlatSceneGraph::NodeIndex root : roots)
+                {
+                    scene.SetLocalTransform(root, scene.GetLocalTransform(root));
+                }
+            },
+            [&]{ scene.UpdateWorldTransforms(workers); });
+
+        ng::RenderBatch batch;
+        double extractMs = benchmarks::BestMilliseconds(
+            kIterations,
+            [&]{ batch = ng::RenderBatch::FromScene(scene, workers); });
+
+        if (!SameObjects(batch.RenderObjects, serialBatch.RenderObjects))
+        {
+            throw std::runtime_error("Parallel extraction doesn't match the serial one");
+        }
+
+        if (workers == 1)
+        {
+            serialUpdateMs = updateMs;
+            serialExtractMs = extractMs;
+        }
+
+        std::printf("%3zu workers | update %8.3f ms (%5.2fx) | extract %8.3f ms (%5.2fx)\n",
+                    workers,
+                    updateMs, serialUpdateMs / updateMs,
+                    extractMs, serialExtractMs / extractMs);
+    }
+}
+catch (const std::exception& e)
+{
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+}
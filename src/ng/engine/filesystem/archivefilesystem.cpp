@@ -0,0 +1,530 @@
+#include "ng/engine/filesystem/archivefilesystem.hpp"
+
+#include "ng/engine/filesystem/memoryreadfile.hpp"
+#include "ng/engine/filesystem/path.hpp"
+
+#include "ng/engine/util/lz4.hpp"
+#include "ng/engine/util/parallelfor.hpp"
+#include "ng/engine/util/rangecheck.hpp"
+#include "ng/engine/util/scopeguard.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace ng
+{
+
+namespace
+{
+
+// Layout of an .ngpak file, all in the byte order of the machine that wrote it:
+//
+//   NGPakHeader
+//   NGPakEntry for every file, sorted by path
+//   the paths of all files, back to back
+//   the data of every file, each starting on a kDataAlignment boundary
+//
+// A compressed file's data is a table of one uint32 per kBlockSize bytes
+// of the file, holding the size of each compressed block, followed by the
+// blocks themselves. Blocks that didn't compress are stored as is and
+// flagged with kRawBlockFlag.
+// Bump kNGPakVersion whenever the layout changes.
+
+const char kNGPakMagic[4] = { 'N', 'G', 'P', 'K' };
+const std::uint32_t kNGPakVersion = 1;
+const std::uint32_t kNGPakByteOrderMark = 0x01020304;
+const std::size_t kDataAlignment = 64;
+
+const std::uint32_t kCompressedEntryFlag = 1;
+
+const std::size_t kBlockSize = 64 * 1024;
+const std::uint32_t kRawBlockFlag = 0x80000000;
+
+// below this, starting threads costs more than decompressing on one.
+const std::size_t kParallelDecompressionThreshold = 1024 * 1024;
+
+struct NGPakHeader
+{
+    char Magic[4];
+    std::uint32_t Version;
+    std::uint32_t ByteOrderMark;
+    std::uint32_t NumEntries;
+    std::uint64_t EntriesOffset;
+    std::uint64_t PathsOffset;
+    std::uint64_t PathsSize;
+};
+
+static_assert(sizeof(NGPakHeader) == 40, "NGPakHeader must not have implicit padding");
+
+struct NGPakEntry
+{
+    std::uint64_t PathOffset;
+    std::uint32_t PathSize;
+    std::uint32_t Flags;
+    std::uint64_t DataOffset;
+    std::uint64_t StoredSize;
+    std::uint64_t Size;
+};
+
+static_assert(sizeof(NGPakEntry) == 40, "NGPakEntry must not have implicit padding");
+
+std::uint64_t AlignData(std::uint64_t offset)
+{
+    return (offset + kDataAlignment - 1) / kDataAlignment * kDataAlignment;
+}
+
+bool PathLess(string_view a, string_view b)
+{
+    int cmp = std::memcmp(a.data(), b.data(), std::min(a.size(), b.size()));
+    return cmp < 0 || (cmp == 0 && a.size() < b.size());
+}
+
+std::size_t GetNumBlocks(std::size_t size)
+{
+    return (size + kBlockSize - 1) / kBlockSize;
+}
+
+std::uint32_t GetBlockTableValue(const char* data, std::size_t block)
+{
+    std::uint32_t value;
+    std::memcpy(&value, data + block * sizeof(value), sizeof(value));
+    return value;
+}
+
+// checks the block table of a compressed entry against the size of its data.
+bool IsValidBlockTable(const ArchiveFileSystem::Entry& entry)
+{
+    std::size_t numBlocks = GetNumBlocks(entry.Size);
+    std::size_t tableSize = numBlocks * sizeof(std::uint32_t);
+
+    if (entry.StoredSize < tableSize)
+    {
+        return false;
+    }
+
+    std::uint64_t total = tableSize;
+    for (std::size_t i = 0; i < numBlocks; i++)
+    {
+        total += GetBlockTableValue(entry.Data, i) & ~kRawBlockFlag;
+    }
+
+    return total == entry.StoredSize;
+}
+
+class ArchiveEntryReadFile : public MemoryReadFile
+{
+    // the entry's data points into the archive.
+    std::shared_ptr<IReadFile> mArchive;
+
+public:
+    ArchiveEntryReadFile(std::shared_ptr<IReadFile> archive, const char* data, std::size_t size)
+        : mArchive(std::move(archive))
+    {
+        SetContents(data, size);
+    }
+};
+
+class DecompressedReadFile : public MemoryReadFile
+{
+    std::vector<char> mBuffer;
+
+public:
+    DecompressedReadFile(const ArchiveFileSystem::Entry& entry, bool allowParallel)
+        : mBuffer(entry.Size)
+    {
+        std::size_t numBlocks = GetNumBlocks(entry.Size);
+
+        std::vector<const char*> blockData(numBlocks);
+        const char* cursor = entry.Data + numBlocks * sizeof(std::uint32_t);
+        for (std::size_t i = 0; i < numBlocks; i++)
+        {
+            blockData[i] = cursor;
+            cursor += GetBlockTableValue(entry.Data, i) & ~kRawBlockFlag;
+        }
+
+        auto decompressBlock = [&](std::size_t i)
+        {
+            std::uint32_t tableValue = GetBlockTableValue(entry.Data, i);
+            std::size_t storedSize = tableValue & ~kRawBlockFlag;
+
+            char* out = mBuffer.data() + i * kBlockSize;
+            std::size_t outSize = std::min(kBlockSize, entry.Size - i * kBlockSize);
+
+            bool ok;
+            if (tableValue & kRawBlockFlag)
+            {
+                ok = storedSize == outSize;
+                if (ok)
+                {
+                    std::memcpy(out, blockData[i], outSize);
+                }
+            }
+            else
+            {
+                ok = lz4_decompress(blockData[i], storedSize, out, outSize);
+            }
+
+            if (!ok)
+            {
+                throw std::runtime_error("Corrupt .ngpak file: bad compressed block in "
+                                       + entry.Path.to_string());
+            }
+        };
+
+        std::size_t numWorkers =
+                allowParallel && entry.Size >= kParallelDecompressionThreshold
+                ? default_worker_count() : 1;
+
+        parallel_for(numBlocks, numWorkers, decompressBlock);
+
+        SetContents(mBuffer.data(), mBuffer.size());
+    }
+};
+
+} // end anonymous namespace
+
+ArchiveFileSystem::ArchiveFileSystem(std::shared_ptr<IReadFile> archiveFile)
+    : mArchive(std::move(archiveFile))
+{
+    string_view contents = mArchive->GetContents();
+
+    NGPakHeader header;
+
+    if (contents.size() < sizeof(header))
+    {
+        throw std::runtime_error("Not an .ngpak file: too small for the header");
+    }
+
+    std::memcpy(&header, contents.data(), sizeof(header));
+
+    if (std::memcmp(header.Magic, kNGPakMagic, sizeof(kNGPakMagic)) != 0)
+    {
+        throw std::runtime_error("Not an .ngpak file: bad magic number");
+    }
+
+    if (header.ByteOrderMark != kNGPakByteOrderMark)
+    {
+        throw std::runtime_error(".ngpak file was written with a different byte order");
+    }
+
+    if (header.Version != kNGPakVersion)
+    {
+        throw std::runtime_error(
+                    "Unsupported .ngpak version " + std::to_string(header.Version)
+                  + " (expected " + std::to_string(kNGPakVersion) + ")");
+    }
+
+    if (!is_in_range(header.EntriesOffset,
+                     std::uint64_t(header.NumEntries) * sizeof(NGPakEntry),
+                     contents.size()) ||
+        !is_in_range(header.PathsOffset, header.PathsSize, contents.size()))
+    {
+        throw std::runtime_error("Corrupt .ngpak file: table of contents is out of bounds");
+    }
+
+    const char* paths = contents.data() + header.PathsOffset;
+
+    mEntries.reserve(header.NumEntries);
+
+    for (std::uint32_t i = 0; i < header.NumEntries; i++)
+    {
+        NGPakEntry serialized;
+        std::memcpy(&serialized,
+                    contents.data() + header.EntriesOffset + i * sizeof(NGPakEntry),
+                    sizeof(serialized));
+
+        if (!is_in_range(serialized.PathOffset, serialized.PathSize, header.PathsSize) ||
+            !is_in_range(serialized.DataOffset, serialized.StoredSize, contents.size()))
+        {
+            throw std::runtime_error("Corrupt .ngpak file: entry is out of bounds");
+        }
+
+        Entry entry;
+        entry.Path = string_view(paths + serialized.PathOffset, serialized.PathSize);
+        entry.Size = serialized.Size;
+        entry.StoredSize = serialized.StoredSize;
+        entry.IsCompressed = (serialized.Flags & kCompressedEntryFlag) != 0;
+        entry.Data = contents.data() + serialized.DataOffset;
+
+        if (entry.IsCompressed ? !IsValidBlockTable(entry) : entry.StoredSize != entry.Size)
+        {
+            throw std::runtime_error("Corrupt .ngpak file: bad size for "
+                                   + entry.Path.to_string());
+        }
+
+        // lookups rely on the order, which also rules out duplicates.
+        if (!mEntries.empty() && !PathLess(mEntries.back().Path, entry.Path))
+        {
+            throw std::runtime_error("Corrupt .ngpak file: table of contents isn't sorted");
+        }
+
+        mEntries.push_back(entry);
+    }
+}
+
+const ArchiveFileSystem::Entry* ArchiveFileSystem::FindEntry(const char* path) const
+{
+    std::string normalized = NormalizePath(path);
+    string_view key = normalized;
+
+    auto it = std::lower_bound(
+                mEntries.begin(), mEntries.end(), key,
+                [](const Entry& entry, string_view p) {
+        return PathLess(entry.Path, p);
+    });
+
+    return it != mEntries.end() && it->Path == key ? &*it : nullptr;
+}
+
+std::shared_ptr<IReadFile> ArchiveFileSystem::OpenEntry(const Entry& entry, bool allowParallel) const
+{
+    if (entry.IsCompressed)
+    {
+        return std::make_shared<DecompressedReadFile>(entry, allowParallel);
+    }
+
+    return std::make_shared<ArchiveEntryReadFile>(mArchive, entry.Data, entry.Size);
+}
+
+std::shared_ptr<IReadFile> ArchiveFileSystem::GetReadFile(
+    const char* path, FileReadMode mode)
+{
+    if (mode != FileReadMode::Text && mode != FileReadMode::Binary)
+    {
+        throw std::logic_error("Invalid FileReadMode");
+    }
+
+    // files are stored byte for byte, so text and binary mode read the same,
+    // just like they do through the C library on POSIX systems.
+    const Entry* entry = FindEntry(path);
+    if (entry == nullptr)
+    {
+        throw std::runtime_error(std::string("Failed to open ") + path
+                               + " (not in the archive)");
+    }
+
+    return OpenEntry(*entry, true);
+}
+
+std::vector<std::shared_ptr<IReadFile>> ArchiveFileSystem::GetReadFiles(
+    const std::vector<std::string>& paths, FileReadMode mode)
+{
+    if (mode != FileReadMode::Text && mode != FileReadMode::Binary)
+    {
+        throw std::logic_error("Invalid FileReadMode");
+    }
+
+    std::vector<const Entry*> entries;
+    entries.reserve(paths.size());
+
+    for (const std::string& path : paths)
+    {
+        entries.push_back(FindEntry(path.c_str()));
+
+        if (entries.back() == nullptr)
+        {
+            throw std::runtime_error("Failed to open " + path + " (not in the archive)");
+        }
+    }
+
+    std::vector<std::shared_ptr<IReadFile>> files(paths.size());
+
+    // the files are spread over the workers, so each is decompressed on one thread.
+    parallel_for(files.size(), default_worker_count(), [&](std::size_t i)
+    {
+        files[i] = OpenEntry(*entries[i], false);
+    });
+
+    return files;
+}
+
+bool ArchiveFileSystem::Contains(const char* path) const
+{
+    return FindEntry(path) != nullptr;
+}
+
+void SaveArchive(
+        const char* path,
+        const std::vector<ArchiveInput>& inputs,
+        bool compress)
+{
+    class PackedEntry
+    {
+    public:
+        std::string Path;
+        const ArchiveInput* Input;
+        bool IsCompressed = false;
+        std::vector<char> CompressedData;
+    };
+
+    std::vector<PackedEntry> entries(inputs.size());
+
+    for (std::size_t i = 0; i < inputs.size(); i++)
+    {
+        entries[i].Path = NormalizePath(inputs[i].Path);
+        entries[i].Input = &inputs[i];
+    }
+
+    std::sort(entries.begin(), entries.end(),
+              [](const PackedEntry& a, const PackedEntry& b) {
+        return PathLess(a.Path, b.Path);
+    });
+
+    for (std::size_t i = 1; i < entries.size(); i++)
+    {
+        if (entries[i - 1].Path == entries[i].Path)
+        {
+            throw std::runtime_error("Can't pack " + entries[i].Path + " twice");
+        }
+    }
+
+    if (compress)
+    {
+        parallel_for(entries.size(), default_worker_count(), [&](std::size_t i)
+        {
+            PackedEntry& entry = entries[i];
+            string_view contents = entry.Input->Contents;
+
+            std::size_t numBlocks = GetNumBlocks(contents.size());
+            std::vector<std::uint32_t> table(numBlocks);
+            std::vector<char> blocks;
+            std::vector<char> scratch(lz4_compress_bound(kBlockSize));
+
+            for (std::size_t b = 0; b < numBlocks; b++)
+            {
+                const char* block = contents.data() + b * kBlockSize;
+                std::size_t blockSize = std::min(kBlockSize, contents.size() - b * kBlockSize);
+
+                // only keep the compressed block if it's smaller.
+                std::size_t compressedSize = lz4_compress(
+                            block, blockSize, scratch.data(), blockSize - 1);
+
+                if (compressedSize == 0)
+                {
+                    table[b] = std::uint32_t(blockSize) | kRawBlockFlag;
+                    blocks.insert(blocks.end(), block, block + blockSize);
+                }
+                else
+                {
+                    table[b] = std::uint32_t(compressedSize);
+                    blocks.insert(blocks.end(), scratch.data(), scratch.data() + compressedSize);
+                }
+            }
+
+            std::size_t tableSize = numBlocks * sizeof(std::uint32_t);
+            if (tableSize + blocks.size() >= contents.size())
+            {
+                return;
+            }
+
+            entry.IsCompressed = true;
+            entry.CompressedData.resize(tableSize + blocks.size());
+            if (tableSize > 0)
+            {
+                std::memcpy(entry.CompressedData.data(), table.data(), tableSize);
+            }
+            std::copy(blocks.begin(), blocks.end(), entry.CompressedData.begin() + tableSize);
+        });
+    }
+
+    NGPakHeader header;
+    std::memset(&header, 0, sizeof(header));
+
+    std::memcpy(header.Magic, kNGPakMagic, sizeof(kNGPakMagic));
+    header.Version = kNGPakVersion;
+    header.ByteOrderMark = kNGPakByteOrderMark;
+    header.NumEntries = std::uint32_t(entries.size());
+    header.EntriesOffset = sizeof(header);
+    header.PathsOffset = header.EntriesOffset + entries.size() * sizeof(NGPakEntry);
+
+    std::vector<NGPakEntry> serializedEntries(entries.size());
+    std::string paths;
+
+    for (std::size_t i = 0; i < entries.size(); i++)
+    {
+        NGPakEntry& serialized = serializedEntries[i];
+        std::memset(&serialized, 0, sizeof(serialized));
+
+        serialized.PathOffset = paths.size();
+        serialized.PathSize = std::uint32_t(entries[i].Path.size());
+        paths += entries[i].Path;
+    }
+
+    header.PathsSize = paths.size();
+
+    std::uint64_t dataOffset = header.PathsOffset + header.PathsSize;
+
+    for (std::size_t i = 0; i < entries.size(); i++)
+    {
+        NGPakEntry& serialized = serializedEntries[i];
+        const PackedEntry& entry = entries[i];
+
+        dataOffset = AlignData(dataOffset);
+
+        serialized.Flags = entry.IsCompressed ? kCompressedEntryFlag : 0;
+        serialized.DataOffset = dataOffset;
+        serialized.Size = entry.Input->Contents.size();
+        serialized.StoredSize = entry.IsCompressed
+                              ? entry.CompressedData.size()
+                              : entry.Input->Contents.size();
+
+        dataOffset += serialized.StoredSize;
+    }
+
+    FILE* filePtr = std::fopen(path, "wb");
+    if (filePtr == NULL)
+    {
+        throw std::runtime_error(std::string("Failed to open ") + path + " for writing");
+    }
+
+    bool closed = false;
+    auto closeScope = make_scope_guard([&]{
+        if (!closed)
+        {
+            std::fclose(filePtr);
+        }
+    });
+
+    const char zeros[kDataAlignment] = { };
+    std::uint64_t written = 0;
+
+    auto write = [&](const void* data, std::size_t size)
+    {
+        if (size > 0 && std::fwrite(data, 1, size, filePtr) != size)
+        {
+            throw std::runtime_error(std::string("Failed to write ") + path);
+        }
+        written += size;
+    };
+
+    write(&header, sizeof(header));
+    write(serializedEntries.data(), serializedEntries.size() * sizeof(NGPakEntry));
+    write(paths.data(), paths.size());
+
+    for (std::size_t i = 0; i < entries.size(); i++)
+    {
+        const PackedEntry& entry = entries[i];
+
+        write(zeros, serializedEntries[i].DataOffset - written);
+
+        if (entry.IsCompressed)
+        {
+            write(entry.CompressedData.data(), entry.CompressedData.size());
+        }
+        else
+        {
+            write(entry.Input->Contents.data(), entry.Input->Contents.size());
+        }
+    }
+
+    closed = true;
+    if (std::fclose(filePtr) != 0)
+    {
+        throw std::runtime_error(std::string("Failed to write ") + path);
+    }
+}
+
+} // end namespace ng
@@ -0,0 +1,911 @@
+#include "ng/engine/filesystem/batchreader.hpp"
+
+#include "ng/engine/filesystem/memoryreadfile.hpp"
+#include "ng/engine/filesystem/path.hpp"
+
+#include "ng/engine/util/scopeguard.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(NG_USE_EMSCRIPTEN)
+#define NG_HAS_PREAD
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && !defined(NG_USE_EMSCRIPTEN) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define NG_HAS_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace ng
+{
+
+namespace
+{
+
+// a single read can't ask for more than the kernel's (and io_uring's) limit.
+const std::size_t kMaxReadSize = std::size_t(1) << 30;
+
+// reads the request synchronously, for the thread pool.
+BatchReadResult ReadRequest(const BatchReadRequest& request)
+{
+    BatchReadResult result;
+    result.BytesRead = 0;
+    result.Error = 0;
+
+#ifdef NG_HAS_PREAD
+    int fd = ::open(request.Path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        result.Error = errno;
+        return result;
+    }
+
+    while (result.BytesRead < request.Size)
+    {
+        ssize_t numRead = ::pread(
+                    fd, request.Buffer + result.BytesRead,
+                    std::min(request.Size - result.BytesRead, kMaxReadSize),
+                    request.Offset + result.BytesRead);
+
+        if (numRead < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            result.Error = errno;
+            break;
+        }
+
+        if (numRead == 0)
+        {
+            break;
+        }
+
+        result.BytesRead += numRead;
+    }
+
+    ::close(fd);
+#else
+    FILE* filePtr = std::fopen(request.Path.c_str(), "rb");
+    if (filePtr == NULL)
+    {
+        result.Error = errno != 0 ? errno : ENOENT;
+        return result;
+    }
+
+    if (std::fseek(filePtr, long(request.Offset), SEEK_SET) != 0)
+    {
+        result.Error = errno != 0 ? errno : EIO;
+    }
+    else
+    {
+        result.BytesRead = std::fread(request.Buffer, 1, request.Size, filePtr);
+        if (std::ferror(filePtr))
+        {
+            result.Error = EIO;
+        }
+    }
+
+    std::fclose(filePtr);
+#endif
+
+    return result;
+}
+
+bool GetFileSize(const char* path, std::size_t& size)
+{
+#ifdef NG_HAS_PREAD
+    struct stat st;
+    if (::stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        return false;
+    }
+
+    size = st.st_size;
+    return true;
+#else
+    FILE* filePtr = std::fopen(path, "rb");
+    if (filePtr == NULL)
+    {
+        return false;
+    }
+
+    long end = std::fseek(filePtr, 0, SEEK_END) == 0 ? std::ftell(filePtr) : -1;
+    std::fclose(filePtr);
+
+    if (end < 0)
+    {
+        return false;
+    }
+
+    size = end;
+    return true;
+#endif
+}
+
+class PreloadedReadFile : public MemoryReadFile
+{
+    std::shared_ptr<const char> mBuffer;
+
+public:
+    PreloadedReadFile(std::shared_ptr<const char> buffer, std::size_t size)
+        : mBuffer(std::move(buffer))
+    {
+        SetContents(mBuffer.get(), size);
+    }
+};
+
+} // end anonymous namespace
+
+#ifdef NG_HAS_IO_URING
+
+// A minimal io_uring, driven through the raw system calls so it
+// doesn't need liburing. Only one thread may use it at a time.
+class BatchReader::IoUring
+{
+    int mFd = -1;
+
+    void* mSqRing = MAP_FAILED;
+    std::size_t mSqRingSize = 0;
+    void* mCqRing = MAP_FAILED;
+    std::size_t mCqRingSize = 0;
+    io_uring_sqe* mSqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    std::size_t mSqesSize = 0;
+
+    unsigned* mSqHead;
+    unsigned* mSqTail;
+    unsigned* mSqArray;
+    unsigned mSqMask;
+    unsigned mSqEntries;
+
+    unsigned* mCqHead;
+    unsigned* mCqTail;
+    io_uring_cqe* mCqes;
+    unsigned mCqMask;
+
+    // entries handed out by GetSqe, and how many of them the kernel has seen.
+    unsigned mSqLocalTail = 0;
+    unsigned mSqSubmittedTail = 0;
+
+    static void* Map(int fd, std::size_t size, off_t offset)
+    {
+        return ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, offset);
+    }
+
+    bool SupportsOperations()
+    {
+        const unsigned numOps = 256;
+
+        std::vector<char> storage(sizeof(io_uring_probe) + numOps * sizeof(io_uring_probe_op));
+        io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+
+        if (::syscall(__NR_io_uring_register, mFd, IORING_REGISTER_PROBE, probe, numOps) < 0)
+        {
+            return false;
+        }
+
+        for (unsigned op : { unsigned(IORING_OP_OPENAT), unsigned(IORING_OP_READ) })
+        {
+            if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+public:
+    // returns null if io_uring, or the operations it's needed for,
+    // aren't supported (old kernels, seccomp filters, ...)
+    static std::unique_ptr<IoUring> TryCreate(unsigned entries)
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+
+        // completions can't outnumber the requests in flight, but leave room.
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = entries * 2;
+
+        int fd = int(::syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0)
+        {
+            return nullptr;
+        }
+
+        std::unique_ptr<IoUring> ring(new IoUring());
+        ring->mFd = fd;
+
+        ring->mSqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        ring->mCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+        bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap)
+        {
+            ring->mSqRingSize = ring->mCqRingSize =
+                    std::max(ring->mSqRingSize, ring->mCqRingSize);
+        }
+
+        ring->mSqRing = Map(fd, ring->mSqRingSize, IORING_OFF_SQ_RING);
+        if (ring->mSqRing == MAP_FAILED)
+        {
+            return nullptr;
+        }
+
+        if (!singleMap)
+        {
+            ring->mCqRing = Map(fd, ring->mCqRingSize, IORING_OFF_CQ_RING);
+            if (ring->mCqRing == MAP_FAILED)
+            {
+                return nullptr;
+            }
+        }
+
+        ring->mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        ring->mSqes = static_cast<io_uring_sqe*>(Map(fd, ring->mSqesSize, IORING_OFF_SQES));
+        if (ring->mSqes == MAP_FAILED)
+        {
+            return nullptr;
+        }
+
+        char* sq = static_cast<char*>(ring->mSqRing);
+        ring->mSqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        ring->mSqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        ring->mSqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        ring->mSqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        ring->mSqEntries = params.sq_entries;
+
+        char* cq = static_cast<char*>(singleMap ? ring->mSqRing : ring->mCqRing);
+        ring->mCqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        ring->mCqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        ring->mCqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        ring->mCqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+
+        ring->mSqLocalTail = ring->mSqSubmittedTail = *ring->mSqTail;
+
+        if (!ring->SupportsOperations())
+        {
+            return nullptr;
+        }
+
+        return ring;
+    }
+
+    ~IoUring()
+    {
+        if (mSqes != MAP_FAILED)
+        {
+            ::munmap(mSqes, mSqesSize);
+        }
+
+        if (mCqRing != MAP_FAILED)
+        {
+            ::munmap(mCqRing, mCqRingSize);
+        }
+
+        if (mSqRing != MAP_FAILED)
+        {
+            ::munmap(mSqRing, mSqRingSize);
+        }
+
+        if (mFd != -1)
+        {
+            ::close(mFd);
+        }
+    }
+
+    // returns a zeroed submission entry, or null if the queue is full.
+    io_uring_sqe* GetSqe()
+    {
+        unsigned head = __atomic_load_n(mSqHead, __ATOMIC_ACQUIRE);
+        if (mSqLocalTail - head >= mSqEntries)
+        {
+            return nullptr;
+        }
+
+        unsigned index = mSqLocalTail & mSqMask;
+        mSqLocalTail++;
+
+        mSqArray[index] = index;
+
+        io_uring_sqe* sqe = &mSqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    // hands the new entries to the kernel, then waits until at least
+    // minComplete completions are ready.
+    void SubmitAndWait(unsigned minComplete)
+    {
+        __atomic_store_n(mSqTail, mSqLocalTail, __ATOMIC_RELEASE);
+
+        for (;;)
+        {
+            unsigned toSubmit = mSqLocalTail - mSqSubmittedTail;
+
+            int ret = int(::syscall(__NR_io_uring_enter, mFd, toSubmit, minComplete,
+                                    minComplete > 0 ? IORING_ENTER_GETEVENTS : 0,
+                                    nullptr, 0));
+            if (ret >= 0)
+            {
+                mSqSubmittedTail += ret;
+                if (mSqSubmittedTail == mSqLocalTail)
+                {
+                    return;
+                }
+
+                // only part of the batch was consumed, and the wait was done.
+                minComplete = 0;
+                continue;
+            }
+
+            if (errno != EINTR && errno != EAGAIN)
+            {
+                throw std::system_error(errno, std::generic_category(), "io_uring_enter failed");
+            }
+        }
+    }
+
+    bool PopCqe(io_uring_cqe& cqe)
+    {
+        unsigned head = *mCqHead;
+        if (head == __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE))
+        {
+            return false;
+        }
+
+        cqe = mCqes[head & mCqMask];
+        __atomic_store_n(mCqHead, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+};
+
+#else
+
+class BatchReader::IoUring
+{
+};
+
+#endif // NG_HAS_IO_URING
+
+BatchReader::BatchReader(std::size_t queueDepth, bool allowIoUring)
+    : mQueueDepth(std::max<std::size_t>(queueDepth, 1))
+{
+#ifdef NG_HAS_IO_URING
+    if (allowIoUring)
+    {
+        // io_uring rounds the queue up to a power of two, at most 4096 entries.
+        mQueueDepth = std::min<std::size_t>(mQueueDepth, 4096);
+        mRing = IoUring::TryCreate(unsigned(mQueueDepth));
+    }
+#else
+    (void) allowIoUring;
+#endif
+}
+
+BatchReader::~BatchReader() = default;
+
+BatchReadStats BatchReader::Read(
+        const std::vector<BatchReadRequest>& requests,
+        std::function<void(std::size_t, const BatchReadResult&)> onComplete)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    BatchReadStats stats = mRing != nullptr
+            ? ReadWithIoUring(requests, onComplete)
+            : ReadWithThreads(requests, onComplete);
+
+    auto end = std::chrono::steady_clock::now();
+
+    stats.UsedIoUring = mRing != nullptr;
+    stats.QueueDepth = mQueueDepth;
+    stats.NumFiles = requests.size();
+    stats.Seconds = std::chrono::duration<double>(end - start).count();
+
+    return stats;
+}
+
+BatchReadStats BatchReader::ReadWithIoUring(
+        const std::vector<BatchReadRequest>& requests,
+        const std::function<void(std::size_t, const BatchReadResult&)>& onComplete)
+{
+    BatchReadStats stats;
+    stats.MaxInFlight = 0;
+    stats.NumFailed = 0;
+    stats.NumBytes = 0;
+
+#ifdef NG_HAS_IO_URING
+    // the low bit of each request's user_data says which step completed.
+    const std::uint64_t kOpenStep = 0;
+    const std::uint64_t kReadStep = 1;
+
+    // marks the completions of cancel requests.
+    const std::uint64_t kCancelData = ~std::uint64_t(0);
+
+    class FileState
+    {
+    public:
+        int Fd = -1;
+        std::size_t BytesRead = 0;
+
+        // each file has at most one open or read in flight.
+        bool InFlight = false;
+    };
+
+    std::vector<FileState> files(requests.size());
+
+    std::size_t numStarted = 0;
+    std::size_t numFinished = 0;
+    std::size_t numInFlight = 0;
+
+    std::exception_ptr callbackError;
+
+    // if the ring fails, requests may still be in flight, pointing at the
+    // caller's paths and buffers. they're cancelled and waited for before
+    // unwinding, and the files that were opened are closed.
+    auto cleanupScope = make_scope_guard([&]
+    {
+        try
+        {
+            for (std::size_t i = 0; i < files.size() && numInFlight > 0; i++)
+            {
+                if (files[i].InFlight)
+                {
+                    if (io_uring_sqe* sqe = mRing->GetSqe())
+                    {
+                        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                        sqe->addr = files[i].Fd == -1 ? i * 2 + kOpenStep : i * 2 + kReadStep;
+                        sqe->user_data = kCancelData;
+                    }
+                }
+            }
+
+            while (numInFlight > 0)
+            {
+                mRing->SubmitAndWait(1);
+
+                io_uring_cqe cqe;
+                while (mRing->PopCqe(cqe))
+                {
+                    if (cqe.user_data == kCancelData)
+                    {
+                        continue;
+                    }
+
+                    numInFlight--;
+
+                    FileState& file = files[std::size_t(cqe.user_data / 2)];
+                    file.InFlight = false;
+
+                    if (cqe.user_data % 2 == kOpenStep && cqe.res >= 0)
+                    {
+                        file.Fd = cqe.res;
+                    }
+                }
+            }
+        }
+        catch (...)
+        {
+            // the ring can't be waited on, so it's closed, which has the
+            // kernel cancel what's left. later batches are read by threads.
+            mRing.reset();
+        }
+
+        for (FileState& file : files)
+        {
+            if (file.Fd != -1)
+            {
+                ::close(file.Fd);
+                file.Fd = -1;
+            }
+        }
+    });
+
+    auto queueRead = [&](std::size_t i)
+    {
+        const BatchReadRequest& request = requests[i];
+        FileState& file = files[i];
+
+        io_uring_sqe* sqe = mRing->GetSqe();
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = file.Fd;
+        sqe->addr = reinterpret_cast<std::uint64_t>(request.Buffer + file.BytesRead);
+        sqe->len = unsigned(std::min(request.Size - file.BytesRead, kMaxReadSize));
+        sqe->off = request.Offset + file.BytesRead;
+        sqe->user_data = i * 2 + kReadStep;
+
+        file.InFlight = true;
+        numInFlight++;
+    };
+
+    auto finish = [&](std::size_t i, int error)
+    {
+        FileState& file = files[i];
+
+        if (file.Fd != -1)
+        {
+            ::close(file.Fd);
+            file.Fd = -1;
+        }
+
+        BatchReadResult result;
+        result.BytesRead = file.BytesRead;
+        result.Error = error;
+
+        stats.NumBytes += result.BytesRead;
+        if (error != 0)
+        {
+            stats.NumFailed++;
+        }
+
+        numFinished++;
+
+        // once a callback threw, the rest of the batch is only drained.
+        if (!callbackError)
+        {
+            try
+            {
+                onComplete(i, result);
+            }
+            catch (...)
+            {
+                callbackError = std::current_exception();
+            }
+        }
+    };
+
+    while (numFinished < numStarted || (numStarted < requests.size() && !callbackError))
+    {
+        // every request takes one slot from its open until its last read,
+        // so the queue can't overflow.
+        while (numInFlight < mQueueDepth && numStarted < requests.size() && !callbackError)
+        {
+            io_uring_sqe* sqe = mRing->GetSqe();
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = reinterpret_cast<std::uint64_t>(requests[numStarted].Path.c_str());
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            sqe->user_data = numStarted * 2 + kOpenStep;
+
+            files[numStarted].InFlight = true;
+            numStarted++;
+            numInFlight++;
+        }
+
+        stats.MaxInFlight = std::max(stats.MaxInFlight, numInFlight);
+
+        mRing->SubmitAndWait(1);
+
+        io_uring_cqe cqe;
+        while (mRing->PopCqe(cqe))
+        {
+            numInFlight--;
+
+            std::size_t i = std::size_t(cqe.user_data / 2);
+            const BatchReadRequest& request = requests[i];
+            FileState& file = files[i];
+            file.InFlight = false;
+
+            if (cqe.user_data % 2 == kOpenStep)
+            {
+                if (cqe.res < 0)
+                {
+                    finish(i, -cqe.res);
+                }
+                else
+                {
+                    file.Fd = cqe.res;
+
+                    if (request.Size == 0)
+                    {
+                        finish(i, 0);
+                    }
+                    else
+                    {
+                        queueRead(i);
+                    }
+                }
+            }
+            else if (cqe.res == -EINTR || cqe.res == -EAGAIN)
+            {
+                queueRead(i);
+            }
+            else if (cqe.res < 0)
+            {
+                finish(i, -cqe.res);
+            }
+            else
+            {
+                file.BytesRead += cqe.res;
+
+                // stop at the end of the file or when the buffer is full.
+                if (cqe.res == 0 || file.BytesRead == request.Size)
+                {
+                    finish(i, 0);
+                }
+                else
+                {
+                    queueRead(i);
+                }
+            }
+        }
+    }
+
+    if (callbackError)
+    {
+        std::rethrow_exception(callbackError);
+    }
+#else
+    (void) requests;
+    (void) onComplete;
+#endif
+
+    return stats;
+}
+
+BatchReadStats BatchReader::ReadWithThreads(
+        const std::vector<BatchReadRequest>& requests,
+        const std::function<void(std::size_t, const BatchReadResult&)>& onComplete)
+{
+    BatchReadStats stats;
+    stats.MaxInFlight = 0;
+    stats.NumFailed = 0;
+    stats.NumBytes = 0;
+
+    std::mutex mutex;
+    std::condition_variable resultReady;
+    std::deque<std::pair<std::size_t, BatchReadResult>> results;
+
+    std::atomic<std::size_t> nextRequest(0);
+    std::atomic<std::size_t> numInFlight(0);
+    std::atomic<std::size_t> maxInFlight(0);
+    std::atomic<bool> stopping(false);
+    std::size_t numActiveWorkers = 0;
+
+    auto worker = [&]
+    {
+        for (std::size_t i = nextRequest++;
+             i < requests.size() && !stopping;
+             i = nextRequest++)
+        {
+            std::size_t inFlight = ++numInFlight;
+            std::size_t seenMax = maxInFlight;
+            while (inFlight > seenMax && !maxInFlight.compare_exchange_weak(seenMax, inFlight))
+            { }
+
+            BatchReadResult result = ReadRequest(requests[i]);
+            numInFlight--;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            results.emplace_back(i, result);
+            resultReady.notify_one();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        numActiveWorkers--;
+        resultReady.notify_one();
+    };
+
+    std::vector<std::thread> threads;
+    try
+    {
+        std::size_t numWorkers = std::min(mQueueDepth, requests.size());
+        for (std::size_t i = 0; i < numWorkers; i++)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                numActiveWorkers++;
+            }
+
+            try
+            {
+                threads.emplace_back(worker);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                numActiveWorkers--;
+                throw;
+            }
+        }
+    }
+    catch (const std::system_error&)
+    {
+        // carry on with however many threads could be created.
+    }
+    catch (...)
+    {
+        // the workers that started must be joined before the threads are
+        // destroyed, or std::terminate is called.
+        stopping = true;
+        for (std::thread& t : threads)
+        {
+            t.join();
+        }
+        throw;
+    }
+
+    bool readInline = threads.empty();
+
+    std::exception_ptr callbackError;
+
+    auto deliver = [&](std::size_t i, const BatchReadResult& result)
+    {
+        stats.NumBytes += result.BytesRead;
+        if (result.Error != 0)
+        {
+            stats.NumFailed++;
+        }
+
+        if (!callbackError)
+        {
+            try
+            {
+                onComplete(i, result);
+            }
+            catch (...)
+            {
+                callbackError = std::current_exception();
+                stopping = true;
+            }
+        }
+    };
+
+    if (readInline)
+    {
+        stats.MaxInFlight = requests.empty() ? 0 : 1;
+
+        for (std::size_t i = 0; i < requests.size() && !callbackError; i++)
+        {
+            deliver(i, ReadRequest(requests[i]));
+        }
+    }
+    else
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        for (;;)
+        {
+            resultReady.wait(lock, [&]{ return !results.empty() || numActiveWorkers == 0; });
+
+            if (results.empty())
+            {
+                break;
+            }
+
+            std::pair<std::size_t, BatchReadResult> result = results.front();
+            results.pop_front();
+
+            lock.unlock();
+            deliver(result.first, result.second);
+            lock.lock();
+        }
+
+        lock.unlock();
+
+        for (std::thread& t : threads)
+        {
+            t.join();
+        }
+
+        stats.MaxInFlight = maxInFlight;
+    }
+
+    if (callbackError)
+    {
+        std::rethrow_exception(callbackError);
+    }
+
+    return stats;
+}
+
+PreloadFileSystem::PreloadFileSystem(std::shared_ptr<IFileSystem> fallback, std::size_t queueDepth)
+    : mFallback(std::move(fallback))
+    , mReader(queueDepth)
+{ }
+
+BatchReadStats PreloadFileSystem::Preload(
+        const std::vector<std::string>& paths,
+        std::function<void(const std::string&, std::shared_ptr<IReadFile>)> onLoaded)
+{
+    std::vector<BatchReadRequest> requests;
+    std::vector<std::size_t> pathIndices;
+    std::vector<std::shared_ptr<char>> buffers;
+
+    std::size_t numMissing = 0;
+
+    for (std::size_t i = 0; i < paths.size(); i++)
+    {
+        std::size_t size;
+        if (!GetFileSize(paths[i].c_str(), size))
+        {
+            numMissing++;
+            continue;
+        }
+
+        buffers.push_back(std::shared_ptr<char>(new char[size], std::default_delete<char[]>()));
+
+        BatchReadRequest request;
+        request.Path = paths[i];
+        request.Buffer = buffers.back().get();
+        request.Size = size;
+        requests.push_back(request);
+
+        pathIndices.push_back(i);
+    }
+
+    BatchReadStats stats = mReader.Read(requests, [&](std::size_t i, const BatchReadResult& result)
+    {
+        if (result.Error != 0)
+        {
+            return;
+        }
+
+        PreloadedFile preloaded;
+        preloaded.Buffer = buffers[i];
+        preloaded.Size = result.BytesRead;
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mPreloaded[NormalizePath(requests[i].Path)] = preloaded;
+        }
+
+        if (onLoaded)
+        {
+            onLoaded(paths[pathIndices[i]],
+                     std::make_shared<PreloadedReadFile>(preloaded.Buffer, preloaded.Size));
+        }
+    });
+
+    stats.NumFiles += numMissing;
+    stats.NumFailed += numMissing;
+
+    return stats;
+}
+
+void PreloadFileSystem::Evict(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPreloaded.erase(NormalizePath(path));
+}
+
+std::shared_ptr<IReadFile> PreloadFileSystem::GetReadFile(
+    const char* path, FileReadMode mode)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        auto found = mPreloaded.find(NormalizePath(path));
+        if (found != mPreloaded.end())
+        {
+            // preloaded files are read byte for byte, so text and binary
+            // mode read the same, like they do on POSIX systems.
+            return std::make_shared<PreloadedReadFile>(found->second.Buffer, found->second.Size);
+        }
+    }
+
+    return mFallback->GetReadFile(path, mode);
+}
+
+} // end namespace ng
@@ -1,55 +1,141 @@
 #include "ng/engine/filesystem/filesystem.hpp"
-#include "ng/engine/filesystem/readfile.hpp"
+#include "ng/engine/filesystem/memoryreadfile.hpp"
 
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(NG_USE_EMSCRIPTEN)
+#define NG_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace ng
 {
 
-class StdCReadFile : public IReadFile
+class BufferedReadFile : public MemoryReadFile
 {
-    FILE* mFilePtr = nullptr;
+    std::vector<char> mBuffer;
 
 public:
-    StdCReadFile(const char* path, const char* mode)
+    BufferedReadFile(const char* path, const char* mode)
     {
-        mFilePtr = std::fopen(path, mode);
-        if (mFilePtr == NULL)
+        FILE* filePtr = std::fopen(path, mode);
+        if (filePtr == NULL)
         {
             throw std::runtime_error(std::string("Failed to open ") + path);
         }
-    }
 
-    ~StdCReadFile()
-    {
-        std::fclose(mFilePtr);
+        // the size isn't known ahead of time in text mode or for pipes,
+        // so grow the buffer until fread comes up short.
+        std::size_t numRead = 0;
+        do
+        {
+            mBuffer.resize(std::max<std::size_t>(mBuffer.size() * 2, 64 * 1024));
+            numRead += std::fread(
+                        mBuffer.data() + numRead, 1,
+                        mBuffer.size() - numRead, filePtr);
+        } while (numRead == mBuffer.size());
+
+        bool failed = std::ferror(filePtr);
+        std::fclose(filePtr);
+
+        if (failed)
+        {
+            throw std::runtime_error(std::string("Failed to read ") + path);
+        }
+
+        mBuffer.resize(numRead);
+        mBuffer.shrink_to_fit();
+        SetContents(mBuffer.data(), mBuffer.size());
     }
+};
+
+#ifdef NG_HAS_MMAP
+
+class MappedReadFile : public MemoryReadFile
+{
+    void* mMapping = nullptr;
+    std::size_t mMappingSize = 0;
 
-    std::size_t ReadRecords(
-        void *buffer,
-        std::size_t recordSize,
-        std::size_t recordCount) override
+public:
+    // returns null if the file can't be mapped (eg. it's a pipe),
+    // in which case the caller should fall back to BufferedReadFile.
+    static std::shared_ptr<MappedReadFile> TryMap(const char* path)
     {
-        return std::fread(buffer, recordSize, recordCount, mFilePtr);
+        int fd = ::open(path, O_RDONLY);
+        if (fd == -1)
+        {
+            throw std::runtime_error(std::string("Failed to open ") + path);
+        }
+
+        std::shared_ptr<MappedReadFile> file;
+
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+        {
+            file = std::make_shared<MappedReadFile>();
+
+            if (st.st_size > 0)
+            {
+                void* mapping = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapping == MAP_FAILED)
+                {
+                    file = nullptr;
+                }
+                else
+                {
+                    // loaders scan front to back, so read ahead aggressively.
+                    ::madvise(mapping, st.st_size, MADV_SEQUENTIAL);
+
+                    file->mMapping = mapping;
+                    file->mMappingSize = st.st_size;
+                    file->SetContents(static_cast<const char*>(mapping), st.st_size);
+                }
+            }
+        }
+
+        ::close(fd);
+
+        return file;
     }
 
-    bool EoF() const override
+    ~MappedReadFile()
     {
-        return std::feof(mFilePtr);
+        if (mMapping)
+        {
+            ::munmap(mMapping, mMappingSize);
+        }
     }
 };
 
+#endif // NG_HAS_MMAP
+
 class StdCFileSystem : public IFileSystem
 {
 public:
     std::shared_ptr<IReadFile> GetReadFile(
         const char* path, FileReadMode mode) override
     {
-        return std::make_shared<StdCReadFile>(
-            path,
+        const char* modeString =
             mode == FileReadMode::Binary ? "rb"
           : mode == FileReadMode::Text ? "r"
-          : throw std::logic_error("Invalid FileReadMode"));
+          : throw std::logic_error("Invalid FileReadMode");
+
+#ifdef NG_HAS_MMAP
+        // text and binary mode read the same bytes on POSIX systems.
+        if (std::shared_ptr<MappedReadFile> mapped = MappedReadFile::TryMap(path))
+        {
+            return mapped;
+        }
+#endif
+
+        return std::make_shared<BufferedReadFile>(path, modeString);
     }
 };
 
@@ -0,0 +1,64 @@
+#include "ng/engine/filesystem/path.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace ng
+{
+
+std::string NormalizePath(string_view path)
+{
+    bool isAbsolute = !path.empty() && (path.front() == '/' || path.front() == '\\');
+
+    std::vector<string_view> components;
+
+    while (!path.empty())
+    {
+        std::size_t separator = 0;
+        while (separator < path.size() && path[separator] != '/' && path[separator] != '\\')
+        {
+            separator++;
+        }
+
+        string_view component = path.substr(0, separator);
+        path.remove_prefix(std::min(separator + 1, path.size()));
+
+        if (component.empty() || component == ".")
+        {
+            continue;
+        }
+
+        if (component == "..")
+        {
+            if (!components.empty() && components.back() != "..")
+            {
+                components.pop_back();
+                continue;
+            }
+
+            if (isAbsolute)
+            {
+                // there's nothing above the root.
+                continue;
+            }
+        }
+
+        components.push_back(component);
+    }
+
+    std::string normalized = isAbsolute ? "/" : "";
+
+    for (std::size_t i = 0; i < components.size(); i++)
+    {
+        if (i > 0)
+        {
+            normalized += '/';
+        }
+
+        normalized.append(components[i].data(), components[i].size());
+    }
+
+    return normalized;
+}
+
+} // end namespace ng
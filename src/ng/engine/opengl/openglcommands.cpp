@@ -17,8 +17,10 @@ void EndFrameCommand::Accept(IRendererCommandVisitor& visitor)
     visitor.Visit(*this);
 }
 
-RenderBatchCommand::RenderBatchCommand(RenderBatch batch)
+RenderBatchCommand::RenderBatchCommand(
+        RenderBatch batch, std::shared_ptr<const RenderResources> resources)
     : Batch(std::move(batch))
+    , Resources(std::move(resources))
 { }
 
 void RenderBatchCommand::Accept(IRendererCommandVisitor& visitor)
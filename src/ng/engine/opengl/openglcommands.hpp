@@ -9,6 +9,7 @@ namespace ng
 {
 
 class IRendererCommandVisitor;
+class SceneSnapshot;
 
 class IRendererCommand
 {
@@ -39,9 +40,15 @@ class RenderBatchCommand : public IRendererCommand
 public:
     RenderBatch Batch;
 
+    // what the batch's handles refer to.
+    std::shared_ptr<const RenderResources> Resources;
+
+    // if set, the batch is extracted from it when the command is visited.
+    std::shared_ptr<const SceneSnapshot> Snapshot;
+
     RenderBatchCommand() = default;
 
-    RenderBatchCommand(RenderBatch batch);
+    RenderBatchCommand(RenderBatch batch, std::shared_ptr<const RenderResources> resources);
 
     void Accept(IRendererCommandVisitor& visitor) override;
 };
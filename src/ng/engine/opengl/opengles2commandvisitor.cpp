@@ -6,6 +6,7 @@
 #include "ng/engine/rendering/mesh.hpp"
 #include "ng/engine/rendering/material.hpp"
 #include "ng/engine/rendering/texture.hpp"
+#include "ng/engine/rendering/scenesnapshot.hpp"
 
 #include "ng/engine/opengl/openglenumconversion.hpp"
 
@@ -306,6 +307,55 @@ void OpenGLES2CommandVisitor::Visit(EndFrameCommand&)
     mWindow->SwapBuffers();
 }
 
+void OpenGLES2CommandVisitor::ResolvePass(Pass& pass, const RenderResources& resources)
+{
+    pass.Meshes.resize(pass.RenderObjects.size());
+    pass.Materials.resize(pass.RenderObjects.size());
+
+    for (std::size_t i = 0; i < pass.RenderObjects.size(); i++)
+    {
+        const RenderObject& obj = pass.RenderObjects[i];
+
+        auto mesh = mResolvedMeshes.find(obj.Mesh);
+        if (mesh == mResolvedMeshes.end())
+        {
+            std::shared_ptr<IMesh> held = resources.ResolveSharedMesh(obj.Mesh);
+            mesh = mResolvedMeshes.emplace(obj.Mesh, held.get()).first;
+
+            if (held != nullptr)
+            {
+                mHeldMeshes.push_back(std::move(held));
+            }
+        }
+
+        auto material = mResolvedMaterials.find(obj.Material);
+        if (material == mResolvedMaterials.end())
+        {
+            const Material* found = resources.ResolveMaterial(obj.Material);
+            const Material* held = nullptr;
+
+            if (found != nullptr)
+            {
+                mHeldMaterials.push_back(*found);
+                held = &mHeldMaterials.back();
+            }
+
+            material = mResolvedMaterials.emplace(obj.Material, held).first;
+        }
+
+        pass.Meshes[i] = mesh->second;
+        pass.Materials[i] = material->second;
+    }
+}
+
+void OpenGLES2CommandVisitor::ReleaseResolved()
+{
+    mResolvedMeshes.clear();
+    mResolvedMaterials.clear();
+    mHeldMeshes.clear();
+    mHeldMaterials.clear();
+}
+
 void OpenGLES2CommandVisitor::RenderPass(const Pass& pass)
 {
     for (GLenum flag : pass.FlagsToEnable)
@@ -356,15 +406,20 @@ void OpenGLES2CommandVisitor::RenderPass(const Pass& pass)
                 cam.ViewportTopLeft.x, cam.ViewportTopLeft.y,
                 cam.ViewportSize.x, cam.ViewportSize.y);
 
-        for (const RenderObject& obj : pass.RenderObjects)
+        for (std::size_t i = 0; i < pass.RenderObjects.size(); i++)
         {
-            if (obj.Mesh == nullptr || obj.Material.Type == MaterialType::Null)
+            const RenderObject& obj = pass.RenderObjects[i];
+            const IMesh* meshPtr = pass.Meshes[i];
+            const Material* matPtr = pass.Materials[i];
+
+            // skips objects whose resources were removed since the batch was made.
+            if (meshPtr == nullptr || matPtr == nullptr || matPtr->Type == MaterialType::Null)
             {
                 continue;
             }
 
-            const IMesh& mesh = *obj.Mesh;
-            const Material& mat = obj.Material;
+            const IMesh& mesh = *meshPtr;
+            const Material& mat = *matPtr;
 
             GLuint program = 0;
             if (mat.Type == MaterialType::Colored ||
@@ -719,9 +774,22 @@ void OpenGLES2CommandVisitor::RenderPass(const Pass& pass)
 
 void OpenGLES2CommandVisitor::Visit(RenderBatchCommand& cmd)
 {
+    if (cmd.Resources == nullptr)
+    {
+        throw std::logic_error("RenderBatchCommand without resources");
+    }
+
+    if (cmd.Snapshot != nullptr)
+    {
+        cmd.Batch = RenderBatch::FromScene(*cmd.Snapshot);
+        cmd.Snapshot.reset();
+    }
+
     Pass scenePass{
         cmd.Batch.RenderObjects,
         cmd.Batch.RenderCameras,
+        { },
+        { },
         { GL_DEPTH_TEST },
         { }
     };
@@ -730,6 +798,8 @@ void OpenGLES2CommandVisitor::Visit(RenderBatchCommand& cmd)
         cmd.Batch.OverlayRenderObjects,
         cmd.Batch.OverlayRenderCameras,
         { },
+        { },
+        { },
         { GL_DEPTH_TEST }
     };
 
@@ -742,6 +812,18 @@ void OpenGLES2CommandVisitor::Visit(RenderBatchCommand& cmd)
                (b.WorldTransform * vec4(0,0,0,1)).z;
     });
 
+    // the resources the batch uses are held until it's drawn, and
+    // released here rather than under the lock.
+    auto resolvedScope = make_scope_guard([&]{
+        ReleaseResolved();
+    });
+
+    {
+        std::unique_lock<std::mutex> resourcesLock = cmd.Resources->Lock();
+        ResolvePass(scenePass, *cmd.Resources);
+        ResolvePass(overlayPass, *cmd.Resources);
+    }
+
     RenderPass(scenePass);
     RenderPass(overlayPass);
 }
@@ -5,7 +5,11 @@
 
 #include <GL/gl.h>
 
+#include <deque>
 #include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 namespace ng
 {
@@ -70,10 +74,26 @@ class OpenGLES2CommandVisitor : public IRendererCommandVisitor
         std::vector<RenderObject>& RenderObjects;
         std::vector<RenderCamera>& RenderCameras;
 
+        // each object's mesh and material, null if they were removed.
+        std::vector<const IMesh*> Meshes;
+        std::vector<const Material*> Materials;
+
         std::vector<GLenum> FlagsToEnable;
         std::vector<GLenum> FlagsToDisable;
     };
 
+    // what the batch being drawn refers to, copied out of the resources
+    // while they're locked, so they aren't locked while drawing.
+    std::vector<std::shared_ptr<IMesh>> mHeldMeshes;
+    std::deque<Material> mHeldMaterials;
+    std::unordered_map<MeshHandle, const IMesh*> mResolvedMeshes;
+    std::unordered_map<MaterialHandle, const Material*> mResolvedMaterials;
+
+    // must be called with the resources locked.
+    void ResolvePass(Pass& pass, const RenderResources& resources);
+
+    void ReleaseResolved();
+
     void RenderPass(const Pass& pass);
 
     ProgramPtr mColoredProgram;
@@ -6,12 +6,20 @@
 
 #include "ng/engine/rendering/renderer.hpp"
 #include "ng/engine/rendering/scenegraph.hpp"
+#include "ng/engine/rendering/flatscenegraph.hpp"
+#include "ng/engine/rendering/scenesnapshot.hpp"
+#include "ng/engine/rendering/renderresources.hpp"
+#include "ng/engine/rendering/occluder.hpp"
+#include "ng/engine/rendering/occlusionculler.hpp"
+#include "ng/engine/rendering/lod.hpp"
+#include "ng/engine/rendering/lodselector.hpp"
 
 #include "ng/engine/opengl/opengles2commandvisitor.hpp"
 #include "ng/engine/opengl/openglcommands.hpp"
 
 #include "ng/engine/util/scopeguard.hpp"
 #include "ng/engine/util/memory.hpp"
+#include "ng/engine/util/parallelfor.hpp"
 
 #include "ng/engine/util/debug.hpp"
 
@@ -79,6 +87,15 @@ class OpenGLRenderer : public IRenderer, public std::enable_shared_from_this<Ope
     RendererState mState = RendererState::OutsideFrame;
     std::mutex mInterfaceMutex;
 
+    std::shared_ptr<RenderResources> mResources = std::make_shared<RenderResources>();
+
+    OcclusionCuller mOcclusionCuller{256, 128, default_worker_count()};
+    std::vector<Occluder> mOccluders;
+    OcclusionStats mOcclusionStats;
+
+    LodSelector mLodSelector;
+    LodStats mLodStats;
+
     static void SetupGLContextAndVisitor(RenderingThreadData& threadData)
     {
         std::shared_ptr<IGLContext> context =
@@ -168,6 +185,66 @@ class OpenGLRenderer : public IRenderer, public std::enable_shared_from_this<Ope
         ng::DebugPrintf("RenderingThread error: (unknown)\n");
     }
 
+    template<class... Scene>
+    void RenderScene(const Scene&... scene)
+    {
+        std::unique_lock<std::mutex> interfaceLock(
+                    mInterfaceMutex,
+                    std::defer_lock);
+
+        if (mUseRenderingThread)
+        {
+            interfaceLock.lock();
+        }
+
+        if (mState != RendererState::InsideFrame)
+        {
+            throw std::logic_error("Render() called when not in a frame");
+        }
+
+        mRenderingThreadData.CommandQueue.push_back(MakeBatchCommand(scene...));
+    }
+
+    std::unique_ptr<RenderBatchCommand> MakeCulledBatchCommand(RenderBatch batch)
+    {
+        if (!mOccluders.empty())
+        {
+            mOcclusionStats = mOcclusionCuller.Cull(batch, mOccluders);
+        }
+
+        // after culling, so hidden objects don't count.
+        mLodStats = mLodSelector.Select(batch, *mResources);
+
+        return ng::make_unique<RenderBatchCommand>(
+                    std::move(batch),
+                    mResources);
+    }
+
+    std::unique_ptr<RenderBatchCommand> MakeBatchCommand(const SceneGraph& scene)
+    {
+        return MakeCulledBatchCommand(RenderBatch::FromScene(scene, *mResources));
+    }
+
+    std::unique_ptr<RenderBatchCommand> MakeBatchCommand(const FlatSceneGraph& scene)
+    {
+        return MakeCulledBatchCommand(RenderBatch::FromScene(scene));
+    }
+
+    std::unique_ptr<RenderBatchCommand> MakeBatchCommand(const FlatSceneGraph& scene, const SceneBVH& bvh)
+    {
+        return MakeCulledBatchCommand(RenderBatch::FromScene(scene, bvh));
+    }
+
+    // the batch is extracted from the snapshot when the command runs.
+    std::unique_ptr<RenderBatchCommand> MakeBatchCommand(
+            const std::shared_ptr<const SceneSnapshot>& snapshot)
+    {
+        std::unique_ptr<RenderBatchCommand> cmd = ng::make_unique<RenderBatchCommand>();
+        cmd->Resources = mResources;
+        cmd->Snapshot = snapshot;
+        return cmd;
+    }
+
 public:
     OpenGLRenderer(std::shared_ptr<IWindowManager> windowManager,
                    std::shared_ptr<IWindow> window,
@@ -249,11 +326,45 @@ public:
             mRenderingThreadData.BatchProducerLock.lock();
         }
 
+        // the rendering thread is done with the frame before last,
+        // so the transient resources it used can go.
+        mResources->AdvanceTransientFrame();
+
         mRenderingThreadData.CommandQueue.push_back(
                     ng::make_unique<BeginFrameCommand>(clearColor));
     }
 
     void Render(const SceneGraph& scene) override
+    {
+        RenderScene(scene);
+    }
+
+    void Render(const FlatSceneGraph& scene) override
+    {
+        RenderScene(scene);
+    }
+
+    void Render(const FlatSceneGraph& scene, const SceneBVH& bvh) override
+    {
+        RenderScene(scene, bvh);
+    }
+
+    void Render(std::shared_ptr<const SceneSnapshot> snapshot) override
+    {
+        if (snapshot == nullptr)
+        {
+            throw std::logic_error("Render() called without a snapshot");
+        }
+
+        RenderScene(snapshot);
+    }
+
+    RenderResources& GetResources() override
+    {
+        return *mResources;
+    }
+
+    void SetOccluders(std::vector<Occluder> occluders) override
     {
         std::unique_lock<std::mutex> interfaceLock(
                     mInterfaceMutex,
@@ -264,14 +375,50 @@ public:
             interfaceLock.lock();
         }
 
-        if (mState != RendererState::InsideFrame)
+        mOccluders = std::move(occluders);
+        mOcclusionStats = OcclusionStats();
+    }
+
+    OcclusionStats GetOcclusionStats() override
+    {
+        std::unique_lock<std::mutex> interfaceLock(
+                    mInterfaceMutex,
+                    std::defer_lock);
+
+        if (mUseRenderingThread)
         {
-            throw std::logic_error("Render() called when not in a frame");
+            interfaceLock.lock();
         }
 
-        mRenderingThreadData.CommandQueue.push_back(
-                    ng::make_unique<RenderBatchCommand>(
-                        RenderBatch::FromScene(scene)));
+        return mOcclusionStats;
+    }
+
+    void SetLodPixelError(float maxPixelError) override
+    {
+        std::unique_lock<std::mutex> interfaceLock(
+                    mInterfaceMutex,
+                    std::defer_lock);
+
+        if (mUseRenderingThread)
+        {
+            interfaceLock.lock();
+        }
+
+        mLodSelector.SetMaxPixelError(maxPixelError);
+    }
+
+    LodStats GetLodStats() override
+    {
+        std::unique_lock<std::mutex> interfaceLock(
+                    mInterfaceMutex,
+                    std::defer_lock);
+
+        if (mUseRenderingThread)
+        {
+            interfaceLock.lock();
+        }
+
+        return mLodStats;
     }
 
     void EndFrame() override
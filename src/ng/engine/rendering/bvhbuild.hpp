@@ -0,0 +1,123 @@
+#ifndef NG_BVHBUILD_HPP
+#define NG_BVHBUILD_HPP
+
+#include "ng/engine/math/geometry.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+// shared by the builders of the scene and mesh bounding volume hierarchies.
+
+namespace ng
+{
+
+inline AxisAlignedBoundingBox<float> EmptyBounds()
+{
+    float inf = std::numeric_limits<float>::infinity();
+    return AxisAlignedBoundingBox<float>(vec3(inf), vec3(-inf));
+}
+
+// finds the cheapest split of the items (anything with Bounds and a
+// Centroid) along the axis where their centroids are the most spread out,
+// by binning the centroids.
+// returns false if keeping them all in a leaf is cheaper.
+template<class Item>
+bool FindSAHSplit(const Item* begin, const Item* end, const AxisAlignedBoundingBox<float>& bounds,
+                  std::size_t maxLeafSize, int& splitAxis, float& splitPosition)
+{
+    std::size_t count = end - begin;
+    if (count <= 1)
+    {
+        return false;
+    }
+
+    AxisAlignedBoundingBox<float> centroidBounds = EmptyBounds();
+    for (const Item* item = begin; item != end; ++item)
+    {
+        centroidBounds.AddPoint(item->Centroid);
+    }
+
+    vec3 extent = centroidBounds.Maximum - centroidBounds.Minimum;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+    if (!(extent[axis] > 0.0f))
+    {
+        // all the centroids are at the same place, nothing to split.
+        return false;
+    }
+
+    const int kNumBins = 16;
+
+    std::size_t binCounts[kNumBins] = { };
+    AxisAlignedBoundingBox<float> binBounds[kNumBins];
+    std::fill(binBounds, binBounds + kNumBins, EmptyBounds());
+
+    float binScale = kNumBins / extent[axis];
+    for (const Item* item = begin; item != end; ++item)
+    {
+        int bin = std::min(kNumBins - 1, int((item->Centroid[axis] - centroidBounds.Minimum[axis]) * binScale));
+        binCounts[bin]++;
+        binBounds[bin].AddBox(item->Bounds);
+    }
+
+    // the cost of everything right of each split, sweeping from the right.
+    float rightCosts[kNumBins] = { };
+    AxisAlignedBoundingBox<float> rightBounds = EmptyBounds();
+    std::size_t rightCount = 0;
+    for (int bin = kNumBins - 1; bin > 0; bin--)
+    {
+        // an empty bin's bounds are inside out.
+        if (binCounts[bin] != 0)
+        {
+            rightBounds.AddBox(binBounds[bin]);
+            rightCount += binCounts[bin];
+        }
+
+        rightCosts[bin] = rightCount == 0 ? 0.0f : rightBounds.GetSurfaceArea() * rightCount;
+    }
+
+    float bestCost = std::numeric_limits<float>::infinity();
+    int bestSplit = 0;
+
+    AxisAlignedBoundingBox<float> leftBounds = EmptyBounds();
+    std::size_t leftCount = 0;
+    for (int split = 1; split < kNumBins; split++)
+    {
+        if (binCounts[split - 1] != 0)
+        {
+            leftBounds.AddBox(binBounds[split - 1]);
+            leftCount += binCounts[split - 1];
+        }
+
+        if (leftCount == 0 || leftCount == count)
+        {
+            continue;
+        }
+
+        float cost = leftBounds.GetSurfaceArea() * leftCount + rightCosts[split];
+        if (cost < bestCost)
+        {
+            bestCost = cost;
+            bestSplit = split;
+        }
+    }
+
+    // the costs are scaled by the area of the parent, relative to
+    // one traversal step and one intersection per item.
+    float leafCost = bounds.GetSurfaceArea() * count;
+    float splitCost = bounds.GetSurfaceArea() + bestCost;
+
+    if (bestSplit == 0 || (count <= maxLeafSize && splitCost >= leafCost))
+    {
+        return false;
+    }
+
+    splitAxis = axis;
+    splitPosition = centroidBounds.Minimum[axis] + bestSplit / binScale;
+    return true;
+}
+
+} // end namespace ng
+
+#endif // NG_BVHBUILD_HPP
@@ -0,0 +1,401 @@
+#include "ng/engine/rendering/flatscenegraph.hpp"
+
+#include "ng/engine/util/parallelfor.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace ng
+{
+
+const FlatSceneGraph::NodeIndex FlatSceneGraph::kNoNode;
+
+namespace
+{
+
+// the box around the transformed box, from its center and half extents.
+AxisAlignedBoundingBox<float> TransformBounds(
+        const mat4& transform, const AxisAlignedBoundingBox<float>& bounds)
+{
+    vec3 center = bounds.GetCenter();
+    vec3 extent = bounds.Maximum - center;
+
+    vec3 worldCenter = vec3(transform * vec4(center, 1.0f));
+    vec3 worldExtent;
+
+    for (int row = 0; row < 3; row++)
+    {
+        worldExtent[row] = std::abs(transform[0][row]) * extent.x
+                         + std::abs(transform[1][row]) * extent.y
+                         + std::abs(transform[2][row]) * extent.z;
+    }
+
+    return AxisAlignedBoundingBox<float>(worldCenter - worldExtent, worldCenter + worldExtent);
+}
+
+} // end anonymous namespace
+
+void FlatSceneGraph::CheckNode(NodeIndex node) const
+{
+    if (node >= mParents.size())
+    {
+        throw std::logic_error("Scene node " + std::to_string(node) + " doesn't exist");
+    }
+}
+
+void FlatSceneGraph::MarkDirty(NodeIndex node)
+{
+    if (!(mFlags[node] & kDirtyFlag))
+    {
+        mFlags[node] |= kDirtyFlag;
+        mDirtyNodes.push_back(node);
+    }
+}
+
+void FlatSceneGraph::MarkChanged(NodeIndex node)
+{
+    mNodeVersions[node] = ++mVersion;
+}
+
+FlatSceneGraph::NodeIndex FlatSceneGraph::AddNode(
+        NodeIndex parent, std::uint8_t flags, const mat4& localTransform)
+{
+    if (mParents.size() >= kNoNode)
+    {
+        throw std::logic_error("Too many scene nodes");
+    }
+
+    NodeIndex node = NodeIndex(mParents.size());
+
+    mParents.push_back(parent);
+    mFirstChildren.push_back(kNoNode);
+    mNextSiblings.push_back(kNoNode);
+    mFlags.push_back(flags);
+    mLocalTransforms.push_back(localTransform);
+    mWorldTransforms.push_back(localTransform);
+    mLocalBounds.push_back(InfiniteBounds<float>());
+    mWorldBounds.push_back(InfiniteBounds<float>());
+    mMeshes.emplace_back();
+    mMaterials.emplace_back();
+    mNodeVersions.push_back(0);
+
+    if (parent != kNoNode)
+    {
+        // children are pushed to the front, their order doesn't matter.
+        mNextSiblings[node] = mFirstChildren[parent];
+        mFirstChildren[parent] = node;
+    }
+
+    MarkDirty(node);
+    MarkChanged(node);
+
+    return node;
+}
+
+FlatSceneGraph::NodeIndex FlatSceneGraph::AddRoot(SceneLayer layer, const mat4& localTransform)
+{
+    return AddNode(kNoNode, layer == SceneLayer::Overlay ? kOverlayFlag : 0, localTransform);
+}
+
+FlatSceneGraph::NodeIndex FlatSceneGraph::AddChild(NodeIndex parent, const mat4& localTransform)
+{
+    CheckNode(parent);
+    return AddNode(parent, mFlags[parent] & kOverlayFlag, localTransform);
+}
+
+void FlatSceneGraph::Reserve(std::size_t numNodes)
+{
+    mParents.reserve(numNodes);
+    mFirstChildren.reserve(numNodes);
+    mNextSiblings.reserve(numNodes);
+    mFlags.reserve(numNodes);
+    mLocalTransforms.reserve(numNodes);
+    mWorldTransforms.reserve(numNodes);
+    mLocalBounds.reserve(numNodes);
+    mWorldBounds.reserve(numNodes);
+    mMeshes.reserve(numNodes);
+    mMaterials.reserve(numNodes);
+    mNodeVersions.reserve(numNodes);
+}
+
+FlatSceneGraph::NodeIndex FlatSceneGraph::GetParent(NodeIndex node) const
+{
+    CheckNode(node);
+    return mParents[node];
+}
+
+SceneLayer FlatSceneGraph::GetLayer(NodeIndex node) const
+{
+    CheckNode(node);
+    return (mFlags[node] & kOverlayFlag) ? SceneLayer::Overlay : SceneLayer::World;
+}
+
+const mat4& FlatSceneGraph::GetLocalTransform(NodeIndex node) const
+{
+    CheckNode(node);
+    return mLocalTransforms[node];
+}
+
+void FlatSceneGraph::SetLocalTransform(NodeIndex node, const mat4& localTransform)
+{
+    CheckNode(node);
+    mLocalTransforms[node] = localTransform;
+    MarkDirty(node);
+}
+
+const mat4& FlatSceneGraph::GetWorldTransform(NodeIndex node) const
+{
+    CheckNode(node);
+    return mWorldTransforms[node];
+}
+
+void FlatSceneGraph::SetLocalBounds(NodeIndex node, const AxisAlignedBoundingBox<float>& bounds)
+{
+    CheckNode(node);
+    mLocalBounds[node] = bounds;
+    mFlags[node] |= kBoundsFlag;
+    MarkDirty(node);
+}
+
+bool FlatSceneGraph::HasBounds(NodeIndex node) const
+{
+    CheckNode(node);
+    return (mFlags[node] & kBoundsFlag) != 0;
+}
+
+const AxisAlignedBoundingBox<float>& FlatSceneGraph::GetWorldBounds(NodeIndex node) const
+{
+    CheckNode(node);
+    return mWorldBounds[node];
+}
+
+MeshHandle FlatSceneGraph::GetMesh(NodeIndex node) const
+{
+    CheckNode(node);
+    return mMeshes[node];
+}
+
+void FlatSceneGraph::SetMesh(NodeIndex node, MeshHandle mesh)
+{
+    CheckNode(node);
+    mMeshes[node] = mesh;
+    MarkChanged(node);
+}
+
+MaterialHandle FlatSceneGraph::GetMaterial(NodeIndex node) const
+{
+    CheckNode(node);
+    return mMaterials[node];
+}
+
+void FlatSceneGraph::SetMaterial(NodeIndex node, MaterialHandle material)
+{
+    CheckNode(node);
+    mMaterials[node] = material;
+    MarkChanged(node);
+}
+
+void FlatSceneGraph::SetCamera(NodeIndex node, const FlatSceneCamera& camera)
+{
+    CheckNode(node);
+
+    auto it = std::lower_bound(
+            mCameras.begin(), mCameras.end(), node,
+            [](const std::pair<NodeIndex, FlatSceneCamera>& cam, NodeIndex n) {
+                return cam.first < n;
+            });
+
+    if (it != mCameras.end() && it->first == node)
+    {
+        it->second = camera;
+    }
+    else
+    {
+        mCameras.insert(it, std::make_pair(node, camera));
+        mFlags[node] |= kCameraFlag;
+    }
+
+    MarkChanged(node);
+}
+
+void FlatSceneGraph::SetCameraActive(NodeIndex node, bool active)
+{
+    CheckNode(node);
+
+    if (!(mFlags[node] & kCameraFlag))
+    {
+        throw std::logic_error("Scene node " + std::to_string(node) + " isn't a camera");
+    }
+
+    if (active)
+    {
+        mFlags[node] |= kActiveCameraFlag;
+    }
+    else
+    {
+        mFlags[node] &= ~kActiveCameraFlag;
+    }
+
+    MarkChanged(node);
+}
+
+bool FlatSceneGraph::IsCameraActive(NodeIndex node) const
+{
+    CheckNode(node);
+    return (mFlags[node] & kActiveCameraFlag) != 0;
+}
+
+void FlatSceneGraph::UpdateNode(NodeIndex node)
+{
+    NodeIndex parent = mParents[node];
+    mWorldTransforms[node] = parent == kNoNode
+            ? mLocalTransforms[node]
+            : mWorldTransforms[parent] * mLocalTransforms[node];
+
+    if (mFlags[node] & kBoundsFlag)
+    {
+        mWorldBounds[node] = TransformBounds(mWorldTransforms[node], mLocalBounds[node]);
+    }
+
+    mFlags[node] &= ~kDirtyFlag;
+    mNodeVersions[node] = mVersion;
+}
+
+std::size_t FlatSceneGraph::UpdateSubtree(NodeIndex root)
+{
+    std::size_t numUpdated = 0;
+
+    // walks the subtree in pre-order, without a stack.
+    NodeIndex node = root;
+    for (;;)
+    {
+        UpdateNode(node);
+        numUpdated++;
+
+        if (mFirstChildren[node] != kNoNode)
+        {
+            node = mFirstChildren[node];
+            continue;
+        }
+
+        while (node != root && mNextSiblings[node] == kNoNode)
+        {
+            node = mParents[node];
+        }
+
+        if (node == root)
+        {
+            break;
+        }
+
+        node = mNextSiblings[node];
+    }
+
+    return numUpdated;
+}
+
+std::size_t FlatSceneGraph::UpdateWorldTransforms(std::size_t numWorkers)
+{
+    // parents come before their children, so in index order, a dirty
+    // ancestor is visited first, and updating it cleans its dirty descendants.
+    std::sort(mDirtyNodes.begin(), mDirtyNodes.end());
+
+    if (!mDirtyNodes.empty())
+    {
+        // all the nodes updated here share a version.
+        ++mVersion;
+    }
+
+    std::size_t numUpdated = 0;
+
+    if (numWorkers <= 1)
+    {
+        for (NodeIndex root : mDirtyNodes)
+        {
+            if (mFlags[root] & kDirtyFlag)
+            {
+                numUpdated += UpdateSubtree(root);
+            }
+        }
+
+        mDirtyNodes.clear();
+        return numUpdated;
+    }
+
+    // the dirty nodes without dirty ancestors root disjoint subtrees,
+    // which can be updated in parallel.
+    std::vector<NodeIndex> roots;
+    for (NodeIndex node : mDirtyNodes)
+    {
+        NodeIndex ancestor = mParents[node];
+        while (ancestor != kNoNode && !(mFlags[ancestor] & kDirtyFlag))
+        {
+            ancestor = mParents[ancestor];
+        }
+
+        if (ancestor == kNoNode)
+        {
+            roots.push_back(node);
+        }
+    }
+
+    mDirtyNodes.clear();
+
+    // with too few subtrees to go around (eg. when the root moved),
+    // update the tops of the subtrees here and split them into their children.
+    const std::size_t kMinRootsPerWorker = 4;
+    const int kMaxSplits = 8;
+
+    for (int split = 0; split < kMaxSplits && roots.size() < numWorkers * kMinRootsPerWorker; split++)
+    {
+        std::vector<NodeIndex> children;
+        for (NodeIndex root : roots)
+        {
+            UpdateNode(root);
+            numUpdated++;
+
+            for (NodeIndex child = mFirstChildren[root]; child != kNoNode; child = mNextSiblings[child])
+            {
+                children.push_back(child);
+            }
+        }
+
+        if (children.empty())
+        {
+            return numUpdated;
+        }
+
+        roots.swap(children);
+    }
+
+    // roots are handed out a few at a time when there are plenty of them,
+    // since most subtrees are small.
+    const std::size_t kMaxRootsPerTask = 16;
+    std::size_t rootsPerTask = std::max<std::size_t>(1, std::min(
+            kMaxRootsPerTask, roots.size() / (numWorkers * kMinRootsPerWorker)));
+
+    std::size_t numTasks = (roots.size() + rootsPerTask - 1) / rootsPerTask;
+
+    std::atomic<std::size_t> numUpdatedInParallel(0);
+
+    parallel_for(numTasks, numWorkers, [&](std::size_t task)
+    {
+        std::size_t begin = task * rootsPerTask;
+        std::size_t end = std::min(begin + rootsPerTask, roots.size());
+
+        std::size_t numUpdatedInTask = 0;
+        for (std::size_t i = begin; i < end; i++)
+        {
+            numUpdatedInTask += UpdateSubtree(roots[i]);
+        }
+
+        numUpdatedInParallel += numUpdatedInTask;
+    });
+
+    return numUpdated + numUpdatedInParallel;
+}
+
+} // end namespace ng
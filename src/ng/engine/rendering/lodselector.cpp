@@ -0,0 +1,248 @@
+#include "ng/engine/rendering/lodselector.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+
+namespace ng
+{
+
+const std::uint8_t LodSelector::kUnseen;
+const std::size_t LodSelector::kNoTable;
+
+namespace
+{
+
+class CameraView
+{
+public:
+    vec3 Eye;
+
+    // pixels per world unit, one unit away from the eye if IsPerspective.
+    float PixelsPerUnit;
+    bool IsPerspective;
+};
+
+float DistanceToBox(const vec3& point, const AxisAlignedBoundingBox<float>& box)
+{
+    vec3 closest(std::max(box.Minimum.x, std::min(point.x, box.Maximum.x)),
+                 std::max(box.Minimum.y, std::min(point.y, box.Maximum.y)),
+                 std::max(box.Minimum.z, std::min(point.z, box.Maximum.z)));
+    return length(point - closest);
+}
+
+// how many pixels one unit of the object's mesh covers, at most.
+float GetPixelsPerMeshUnit(const RenderObject& object, const std::vector<CameraView>& cameras)
+{
+    const mat4& world = object.WorldTransform;
+    float worldScale = std::max(length(vec3(world[0])),
+                                std::max(length(vec3(world[1])), length(vec3(world[2]))));
+
+    // objects without bounds are measured from their origin.
+    bool hasBounds = std::isfinite(object.WorldBounds.Minimum.x) && std::isfinite(object.WorldBounds.Maximum.x);
+
+    float pixelsPerUnit = 0.0f;
+    for (const CameraView& camera : cameras)
+    {
+        float cameraPixelsPerUnit = camera.PixelsPerUnit;
+        if (camera.IsPerspective)
+        {
+            float distance = hasBounds
+                    ? DistanceToBox(camera.Eye, object.WorldBounds)
+                    : length(camera.Eye - vec3(world[3]));
+
+            if (distance <= 0.0f)
+            {
+                return std::numeric_limits<float>::infinity();
+            }
+
+            cameraPixelsPerUnit /= distance;
+        }
+
+        pixelsPerUnit = std::max(pixelsPerUnit, cameraPixelsPerUnit);
+    }
+
+    return worldScale * pixelsPerUnit;
+}
+
+// the coarsest level whose error is at most maxError, skipping the levels
+// that were removed.
+std::size_t CoarsestLevelWithin(const std::vector<MeshLod>& lods, float maxError)
+{
+    std::size_t level = 0;
+    for (std::size_t i = 1; i < lods.size() && lods[i].Error <= maxError; i++)
+    {
+        if (lods[i].Mesh)
+        {
+            level = i;
+        }
+    }
+    return level;
+}
+
+} // end anonymous namespace
+
+LodSelector::LodSelector(float maxPixelError, float hysteresis)
+    : mHysteresis(hysteresis)
+{
+    SetMaxPixelError(maxPixelError);
+
+    if (!(hysteresis >= 0.0f && hysteresis < 1.0f))
+    {
+        throw std::logic_error("LodSelector hysteresis must be in [0,1)");
+    }
+}
+
+void LodSelector::SetMaxPixelError(float maxPixelError)
+{
+    if (!(maxPixelError >= 0.0f))
+    {
+        throw std::logic_error("LodSelector needs a non-negative pixel error");
+    }
+
+    mMaxPixelError = maxPixelError;
+}
+
+void LodSelector::CopyLodTables(const RenderBatch& batch, const RenderResources& resources)
+{
+    mLodTableIndices.clear();
+    mObjectTables.resize(batch.RenderObjects.size());
+
+    std::size_t numTables = 0;
+
+    std::unique_lock<std::mutex> lock = resources.Lock();
+
+    for (std::size_t i = 0; i < batch.RenderObjects.size(); i++)
+    {
+        MeshHandle mesh = batch.RenderObjects[i].Mesh;
+
+        auto found = mLodTableIndices.find(mesh);
+        if (found == mLodTableIndices.end())
+        {
+            const std::vector<MeshLod>* lods = resources.ResolveMeshLods(mesh);
+            std::size_t table = kNoTable;
+
+            if (lods != nullptr)
+            {
+                if (numTables == mLodTables.size())
+                {
+                    mLodTables.emplace_back();
+                }
+
+                std::vector<MeshLod>& copy = mLodTables[numTables];
+                copy.assign(lods->begin(), lods->end());
+
+                for (std::size_t level = 1; level < copy.size(); level++)
+                {
+                    if (resources.ResolveMesh(copy[level].Mesh) == nullptr)
+                    {
+                        copy[level].Mesh = MeshHandle();
+                    }
+                }
+
+                table = numTables++;
+            }
+
+            found = mLodTableIndices.emplace(mesh, table).first;
+        }
+
+        mObjectTables[i] = found->second;
+    }
+}
+
+LodStats LodSelector::Select(RenderBatch& batch, const RenderResources& resources)
+{
+    LodStats stats;
+
+    if (batch.RenderCameras.empty())
+    {
+        return stats;
+    }
+
+    std::vector<CameraView> cameras;
+    for (const RenderCamera& camera : batch.RenderCameras)
+    {
+        CameraView view;
+        view.Eye = vec3(inverse(camera.WorldView) * vec4(0.0f, 0.0f, 0.0f, 1.0f));
+        view.PixelsPerUnit = std::abs(camera.Projection[1][1]) * float(camera.ViewportSize.y) / 2.0f;
+        view.IsPerspective = camera.Projection[3][3] == 0.0f;
+        cameras.push_back(view);
+    }
+
+    CopyLodTables(batch, resources);
+
+    for (std::size_t i = 0; i < batch.RenderObjects.size(); i++)
+    {
+        RenderObject& object = batch.RenderObjects[i];
+
+        if (mObjectTables[i] == kNoTable)
+        {
+            continue;
+        }
+
+        const std::vector<MeshLod>* lods = &mLodTables[mObjectTables[i]];
+
+        stats.NumObjects++;
+        stats.NumTrianglesWithoutLod += lods->front().NumTriangles;
+
+        if (lods->size() == 1)
+        {
+            stats.NumTrianglesWithLod += lods->front().NumTriangles;
+            continue;
+        }
+
+        float pixelsPerUnit = GetPixelsPerMeshUnit(object, cameras);
+        float maxError = mMaxPixelError / pixelsPerUnit;
+
+        std::size_t level = CoarsestLevelWithin(*lods, maxError);
+
+        if (object.Node != RenderObject::kNoNode)
+        {
+            if (object.Node >= mLevels.size())
+            {
+                mLevels.resize(object.Node + 1, kUnseen);
+            }
+
+            std::size_t previous = mLevels[object.Node];
+
+            bool previousIsValid = previous < lods->size() && (*lods)[previous].Mesh;
+
+            if (previousIsValid && level > previous)
+            {
+                std::size_t relaxed = CoarsestLevelWithin(*lods, maxError * (1.0f - mHysteresis));
+                level = std::max(previous, relaxed);
+            }
+
+            if (previousIsValid && level != previous)
+            {
+                stats.NumLevelChanges++;
+            }
+
+            // the levels of a chain fit in a byte, longer ones aren't remembered.
+            mLevels[object.Node] = level < kUnseen ? std::uint8_t(level) : kUnseen;
+        }
+
+        const MeshLod& lod = (*lods)[level];
+
+        object.Mesh = lod.Mesh;
+        object.LodLevel = std::uint32_t(level);
+        object.DrawKey = MakeDrawKey(object.Mesh, object.Material);
+
+        stats.NumTrianglesWithLod += lod.NumTriangles;
+        if (level > 0)
+        {
+            stats.NumSimplifiedObjects++;
+        }
+    }
+
+    return stats;
+}
+
+void LodSelector::Reset()
+{
+    mLevels.clear();
+}
+
+} // end namespace ng
@@ -0,0 +1,66 @@
+#ifndef NG_LODSELECTOR_HPP
+#define NG_LODSELECTOR_HPP
+
+#include "ng/engine/rendering/lod.hpp"
+#include "ng/engine/rendering/renderbatch.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace ng
+{
+
+// Swaps the meshes of a batch's objects for their coarsest level of
+// detail whose error is at most maxPixelError pixels on screen. Objects
+// drawn by many cameras get the level that the closest one needs.
+//
+// To keep levels from popping back and forth around the threshold, the
+// level picked for each scene node is remembered: finer levels are picked
+// as soon as they're needed, but coarser ones only once their error is
+// under (1 - hysteresis) times the threshold. Objects that don't come
+// from a node have no memory, so they always get the level that fits.
+class LodSelector
+{
+    float mMaxPixelError;
+    float mHysteresis;
+
+    // the level each node was drawn with last, or kUnseen.
+    std::vector<std::uint8_t> mLevels;
+
+    static const std::uint8_t kUnseen = 0xFF;
+
+    // the levels of detail of the batch's meshes, copied while the
+    // resources are locked. Levels that were removed have null handles.
+    std::vector<std::vector<MeshLod>> mLodTables;
+    std::unordered_map<MeshHandle, std::size_t> mLodTableIndices;
+
+    // the table of each of the batch's objects, or kNoTable.
+    std::vector<std::size_t> mObjectTables;
+
+    static const std::size_t kNoTable = ~std::size_t(0);
+
+    void CopyLodTables(const RenderBatch& batch, const RenderResources& resources);
+
+public:
+    explicit LodSelector(float maxPixelError = 1.0f, float hysteresis = 0.25f);
+
+    float GetMaxPixelError() const
+    {
+        return mMaxPixelError;
+    }
+
+    void SetMaxPixelError(float maxPixelError);
+
+    // locks the resources just long enough to copy the meshes' levels of
+    // detail. The overlay isn't touched.
+    LodStats Select(RenderBatch& batch, const RenderResources& resources);
+
+    // forgets the levels the nodes were drawn with.
+    void Reset();
+};
+
+} // end namespace ng
+
+#endif // NG_LODSELECTOR_HPP
@@ -0,0 +1,205 @@
+#include "ng/engine/rendering/mesh.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+namespace ng
+{
+
+namespace
+{
+
+VertexAttribute VertexFormat::* const kAttributes[] = {
+    &VertexFormat::Position,
+    &VertexFormat::Normal,
+    &VertexFormat::TexCoord0,
+    &VertexFormat::Color,
+    &VertexFormat::JointIndices,
+    &VertexFormat::JointWeights
+};
+
+template<class T>
+vec3 ReadPosition(const char* position, unsigned int cardinality)
+{
+    const T* components = reinterpret_cast<const T*>(position);
+
+    vec3 result(0.0f);
+    for (unsigned int i = 0; i < cardinality && i < 3; i++)
+    {
+        result[i] = float(components[i]);
+    }
+    return result;
+}
+
+template<class T>
+void ReadIndices(const char* buffer, std::size_t numIndices, std::vector<std::uint32_t>& indices)
+{
+    const T* typedIndices = reinterpret_cast<const T*>(buffer);
+    indices.assign(typedIndices, typedIndices + numIndices);
+}
+
+} // end anonymous namespace
+
+void ReadTriangles(const IMesh& mesh, const VertexFormat& fmt, const char* vertices, std::size_t numVertices,
+                   std::vector<vec3>& positions, std::vector<std::uint32_t>& indices)
+{
+    if (fmt.PrimitiveType != PrimitiveType::Triangles)
+    {
+        throw std::logic_error("Can only read the triangles of a mesh made of triangles");
+    }
+
+    if (fmt.Position.Enabled == false)
+    {
+        throw std::logic_error("Cannot read the triangles of a mesh without position");
+    }
+
+    if (fmt.Position.Type != ArithmeticType::Float && fmt.Position.Type != ArithmeticType::Double)
+    {
+        throw std::logic_error("Can only read the triangles of a mesh with float or double positions");
+    }
+
+    std::ptrdiff_t stride = GetEffectiveStride(fmt.Position);
+
+    positions.resize(numVertices);
+    for (std::size_t i = 0; i < numVertices; i++)
+    {
+        const char* position = vertices + fmt.Position.Offset + stride * std::ptrdiff_t(i);
+
+        positions[i] = fmt.Position.Type == ArithmeticType::Float
+                ? ReadPosition<float>(position, fmt.Position.Cardinality)
+                : ReadPosition<double>(position, fmt.Position.Cardinality);
+    }
+
+    if (!fmt.IsIndexed)
+    {
+        indices.resize(numVertices);
+        for (std::size_t i = 0; i < numVertices; i++)
+        {
+            indices[i] = std::uint32_t(i);
+        }
+    }
+    else
+    {
+        std::unique_ptr<char[]> indexBuffer(new char[mesh.GetMaxIndexBufferSize()]);
+        std::size_t numIndices = mesh.WriteIndices(indexBuffer.get());
+        const char* firstIndex = indexBuffer.get() + fmt.IndexOffset;
+
+        if (fmt.IndexType == ArithmeticType::UInt8)
+        {
+            ReadIndices<std::uint8_t>(firstIndex, numIndices, indices);
+        }
+        else if (fmt.IndexType == ArithmeticType::UInt16)
+        {
+            ReadIndices<std::uint16_t>(firstIndex, numIndices, indices);
+        }
+        else if (fmt.IndexType == ArithmeticType::UInt32)
+        {
+            ReadIndices<std::uint32_t>(firstIndex, numIndices, indices);
+        }
+        else
+        {
+            throw std::logic_error("Unhandled IndexType");
+        }
+
+        for (std::uint32_t index : indices)
+        {
+            if (index >= numVertices)
+            {
+                throw std::runtime_error("Mesh index out of bounds");
+            }
+        }
+    }
+
+    // leftover indices don't make a triangle.
+    indices.resize(indices.size() - indices.size() % 3);
+}
+
+void ReadTriangles(const IMesh& mesh, std::vector<vec3>& positions, std::vector<std::uint32_t>& indices)
+{
+    std::unique_ptr<char[]> vertices(new char[mesh.GetMaxVertexBufferSize()]);
+    std::size_t numVertices = mesh.WriteVertices(vertices.get());
+
+    ReadTriangles(mesh, mesh.GetVertexFormat(), vertices.get(), numVertices, positions, indices);
+}
+
+std::vector<char> PackVertices(const IMesh& mesh, VertexFormat& packedFormat,
+                               std::size_t& stride, std::size_t& numVertices)
+{
+    VertexFormat fmt = mesh.GetVertexFormat();
+
+    std::unique_ptr<char[]> vertices(new char[mesh.GetMaxVertexBufferSize()]);
+    numVertices = mesh.WriteVertices(vertices.get());
+
+    packedFormat = fmt;
+    stride = 0;
+
+    std::size_t alignment = 1;
+    for (VertexAttribute VertexFormat::* attribute : kAttributes)
+    {
+        VertexAttribute& packed = packedFormat.*attribute;
+        if (!packed.Enabled)
+        {
+            continue;
+        }
+
+        std::size_t size = SizeOfArithmeticType(packed.Type);
+        stride = (stride + size - 1) / size * size;
+        packed.Offset = stride;
+        stride += packed.Cardinality * size;
+        alignment = std::max(alignment, size);
+    }
+    stride = (stride + alignment - 1) / alignment * alignment;
+
+    // zeroed, so the padding doesn't tell identical vertices apart.
+    std::vector<char> packedVertices(numVertices * stride, 0);
+
+    for (VertexAttribute VertexFormat::* attribute : kAttributes)
+    {
+        const VertexAttribute& source = fmt.*attribute;
+        VertexAttribute& packed = packedFormat.*attribute;
+        if (!packed.Enabled)
+        {
+            continue;
+        }
+
+        packed.Stride = stride;
+
+        std::ptrdiff_t sourceStride = GetEffectiveStride(source);
+
+        std::size_t size = packed.Cardinality * SizeOfArithmeticType(packed.Type);
+        for (std::size_t i = 0; i < numVertices; i++)
+        {
+            std::memcpy(packedVertices.data() + i * stride + packed.Offset,
+                        vertices.get() + source.Offset + sourceStride * std::ptrdiff_t(i),
+                        size);
+        }
+    }
+
+    return packedVertices;
+}
+
+std::size_t GetMaxNumTriangles(const IMesh& mesh)
+{
+    VertexFormat fmt = mesh.GetVertexFormat();
+
+    if (fmt.PrimitiveType != PrimitiveType::Triangles)
+    {
+        return 0;
+    }
+
+    if (fmt.IsIndexed)
+    {
+        return mesh.GetMaxIndexBufferSize() / SizeOfArithmeticType(fmt.IndexType) / 3;
+    }
+
+    if (fmt.Position.Enabled && GetEffectiveStride(fmt.Position) > 0)
+    {
+        return mesh.GetMaxVertexBufferSize() / std::size_t(GetEffectiveStride(fmt.Position)) / 3;
+    }
+
+    return 0;
+}
+
+} // end namespace ng
@@ -0,0 +1,349 @@
+#include "ng/engine/rendering/meshbvh.hpp"
+
+#include "ng/engine/rendering/mesh.hpp"
+#include "ng/engine/rendering/bvhbuild.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+namespace ng
+{
+
+namespace
+{
+
+const std::size_t kMaxLeafSize = 4;
+
+// deeper nodes become leaves, so traversal can use a fixed size stack.
+const std::size_t kMaxDepth = 64;
+
+class BuildItem
+{
+public:
+    std::uint32_t Triangle;
+    AxisAlignedBoundingBox<float> Bounds;
+    vec3 Centroid;
+};
+
+// the ray, set up for slab tests.
+class SlabRay
+{
+public:
+#if defined(__SSE__)
+    __m128 Origin;
+    __m128 InverseDirection;
+#else
+    vec3 Origin;
+    vec3 InverseDirection;
+#endif
+
+    explicit SlabRay(const Ray<float>& ray)
+    {
+        vec3 inverseDirection(1.0f / ray.Direction.x, 1.0f / ray.Direction.y, 1.0f / ray.Direction.z);
+
+#if defined(__SSE__)
+        Origin = _mm_set_ps(0.0f, ray.Origin.z, ray.Origin.y, ray.Origin.x);
+        InverseDirection = _mm_set_ps(0.0f, inverseDirection.z, inverseDirection.y, inverseDirection.x);
+#else
+        Origin = ray.Origin;
+        InverseDirection = inverseDirection;
+#endif
+    }
+};
+
+// where the ray enters the box between tmin and tmax, if it does.
+bool SlabIntersect(const SlabRay& ray, const float* minimum, const float* maximum,
+                   float tmin, float tmax, float& entry)
+{
+#if defined(__SSE__)
+    // the 4th lanes hold whatever comes after the corners, so they're
+    // replaced by copies of the 3rd before taking the min and max.
+    __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(minimum), ray.Origin), ray.InverseDirection);
+    __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(maximum), ray.Origin), ray.InverseDirection);
+
+    __m128 near = _mm_min_ps(t0, t1);
+    __m128 far = _mm_max_ps(t0, t1);
+
+    near = _mm_shuffle_ps(near, near, _MM_SHUFFLE(2, 2, 1, 0));
+    far = _mm_shuffle_ps(far, far, _MM_SHUFFLE(2, 2, 1, 0));
+
+    near = _mm_max_ps(near, _mm_shuffle_ps(near, near, _MM_SHUFFLE(1, 0, 3, 2)));
+    near = _mm_max_ps(near, _mm_shuffle_ps(near, near, _MM_SHUFFLE(2, 3, 0, 1)));
+    far = _mm_min_ps(far, _mm_shuffle_ps(far, far, _MM_SHUFFLE(1, 0, 3, 2)));
+    far = _mm_min_ps(far, _mm_shuffle_ps(far, far, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    tmin = std::max(tmin, _mm_cvtss_f32(near));
+    tmax = std::min(tmax, _mm_cvtss_f32(far));
+#else
+    for (int axis = 0; axis < 3; axis++)
+    {
+        float t0 = (minimum[axis] - ray.Origin[axis]) * ray.InverseDirection[axis];
+        float t1 = (maximum[axis] - ray.Origin[axis]) * ray.InverseDirection[axis];
+
+        tmin = std::max(tmin, std::min(t0, t1));
+        tmax = std::min(tmax, std::max(t0, t1));
+    }
+#endif
+
+    entry = tmin;
+    return tmin <= tmax;
+}
+
+} // end anonymous namespace
+
+MeshBVH::MeshBVH(const IMesh& mesh)
+{
+    std::vector<vec3> positions;
+    std::vector<std::uint32_t> indices;
+    ReadTriangles(mesh, positions, indices);
+
+    mNumVertices = positions.size();
+
+    std::vector<BuildItem> items(indices.size() / 3);
+    for (std::uint32_t triangle = 0; triangle < items.size(); triangle++)
+    {
+        AxisAlignedBoundingBox<float> bounds = EmptyBounds();
+        for (int corner = 0; corner < 3; corner++)
+        {
+            bounds.AddPoint(positions[indices[3 * triangle + corner]]);
+        }
+
+        items[triangle] = BuildItem{triangle, bounds, bounds.GetCenter()};
+    }
+
+    if (items.empty())
+    {
+        return;
+    }
+
+    mNodes.reserve(2 * items.size() / kMaxLeafSize + 1);
+
+    mNodes.push_back(Node());
+    mNodes[0].First = 0;
+    mNodes[0].NumTriangles = std::uint32_t(items.size());
+
+    // nodes are pushed with all their triangles, then split.
+    std::vector<std::pair<std::uint32_t, std::size_t>> stack(1, std::make_pair(0u, std::size_t(1)));
+    while (!stack.empty())
+    {
+        std::uint32_t node = stack.back().first;
+        std::size_t depth = stack.back().second;
+        stack.pop_back();
+
+        BuildItem* begin = items.data() + mNodes[node].First;
+        BuildItem* end = begin + mNodes[node].NumTriangles;
+
+        AxisAlignedBoundingBox<float> bounds = EmptyBounds();
+        for (BuildItem* item = begin; item != end; ++item)
+        {
+            bounds.AddBox(item->Bounds);
+        }
+
+        int axis;
+        float position;
+        if (depth >= kMaxDepth || !FindSAHSplit(begin, end, bounds, kMaxLeafSize, axis, position))
+        {
+            continue;
+        }
+
+        BuildItem* middle = std::partition(begin, end, [&](const BuildItem& item) {
+            return item.Centroid[axis] < position;
+        });
+
+        std::uint32_t left = std::uint32_t(mNodes.size());
+
+        Node leftNode = Node();
+        leftNode.First = mNodes[node].First;
+        leftNode.NumTriangles = std::uint32_t(middle - begin);
+
+        Node rightNode = Node();
+        rightNode.First = std::uint32_t(middle - items.data());
+        rightNode.NumTriangles = std::uint32_t(end - middle);
+
+        mNodes[node].First = left;
+        mNodes[node].NumTriangles = 0;
+        mNodes.push_back(leftNode);
+        mNodes.push_back(rightNode);
+
+        stack.push_back(std::make_pair(left, depth + 1));
+        stack.push_back(std::make_pair(left + 1, depth + 1));
+    }
+
+    mTriangleIds.reserve(items.size());
+    mTriangleIndices.reserve(indices.size());
+    for (const BuildItem& item : items)
+    {
+        mTriangleIds.push_back(item.Triangle);
+        for (int corner = 0; corner < 3; corner++)
+        {
+            mTriangleIndices.push_back(indices[3 * item.Triangle + corner]);
+        }
+    }
+
+    mTriangleVertices.resize(mTriangleIndices.size());
+    for (std::size_t i = 0; i < mTriangleIndices.size(); i++)
+    {
+        mTriangleVertices[i] = positions[mTriangleIndices[i]];
+    }
+
+    RefitNodes();
+}
+
+void MeshBVH::RefitNodes()
+{
+    // children always come after their parent.
+    for (std::size_t i = mNodes.size(); i-- > 0; )
+    {
+        Node& node = mNodes[i];
+
+        AxisAlignedBoundingBox<float> bounds = EmptyBounds();
+
+        if (node.NumTriangles != 0)
+        {
+            std::size_t begin = 3 * std::size_t(node.First);
+            std::size_t end = begin + 3 * std::size_t(node.NumTriangles);
+            for (std::size_t vertex = begin; vertex < end; vertex++)
+            {
+                bounds.AddPoint(mTriangleVertices[vertex]);
+            }
+        }
+        else
+        {
+            for (std::uint32_t child = node.First; child < node.First + 2; child++)
+            {
+                bounds.AddPoint(vec3(mNodes[child].Minimum[0], mNodes[child].Minimum[1], mNodes[child].Minimum[2]));
+                bounds.AddPoint(vec3(mNodes[child].Maximum[0], mNodes[child].Maximum[1], mNodes[child].Maximum[2]));
+            }
+        }
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            node.Minimum[axis] = bounds.Minimum[axis];
+            node.Maximum[axis] = bounds.Maximum[axis];
+        }
+    }
+}
+
+void MeshBVH::Refit(const IMesh& mesh)
+{
+    std::vector<vec3> positions;
+    std::vector<std::uint32_t> indices;
+    ReadTriangles(mesh, positions, indices);
+
+    if (positions.size() != mNumVertices || indices.size() != mTriangleIndices.size())
+    {
+        throw std::logic_error("MeshBVH can only be refitted to a mesh with the same triangles");
+    }
+
+    for (std::size_t i = 0; i < mTriangleIndices.size(); i++)
+    {
+        mTriangleVertices[i] = positions[mTriangleIndices[i]];
+    }
+
+    RefitNodes();
+}
+
+bool MeshBVH::RayCast(const Ray<float>& ray, float tmin, float tmax, MeshRayHit& hit) const
+{
+    if (mNodes.empty())
+    {
+        return false;
+    }
+
+    SlabRay slabRay(ray);
+
+    float entry;
+    if (!SlabIntersect(slabRay, mNodes[0].Minimum, mNodes[0].Maximum, tmin, tmax, entry))
+    {
+        return false;
+    }
+
+    bool found = false;
+
+    std::pair<std::uint32_t, float> stack[kMaxDepth + 1];
+    std::size_t stackSize = 0;
+    stack[stackSize++] = std::make_pair(0u, entry);
+
+    while (stackSize > 0)
+    {
+        std::pair<std::uint32_t, float> top = stack[--stackSize];
+
+        // something closer was hit since this node was pushed.
+        if (top.second > tmax)
+        {
+            continue;
+        }
+
+        const Node& node = mNodes[top.first];
+
+        if (node.NumTriangles != 0)
+        {
+            for (std::uint32_t triangle = node.First; triangle < node.First + node.NumTriangles; triangle++)
+            {
+                const vec3* vertices = &mTriangleVertices[3 * std::size_t(triangle)];
+
+                float t, u, v;
+                if (RayTriangleIntersect(ray, vertices[0], vertices[1], vertices[2], tmin, tmax, t, u, v))
+                {
+                    // only closer hits are looked for from now on.
+                    tmax = t;
+                    hit = MeshRayHit{t, mTriangleIds[triangle], u, v};
+                    found = true;
+                }
+            }
+            continue;
+        }
+
+        const Node& left = mNodes[node.First];
+        const Node& right = mNodes[node.First + 1];
+
+        float leftEntry, rightEntry;
+        bool hitsLeft = SlabIntersect(slabRay, left.Minimum, left.Maximum, tmin, tmax, leftEntry);
+        bool hitsRight = SlabIntersect(slabRay, right.Minimum, right.Maximum, tmin, tmax, rightEntry);
+
+        // the nearest child is visited first, so it's pushed last.
+        if (hitsLeft && hitsRight)
+        {
+            if (leftEntry <= rightEntry)
+            {
+                stack[stackSize++] = std::make_pair(node.First + 1, rightEntry);
+                stack[stackSize++] = std::make_pair(node.First, leftEntry);
+            }
+            else
+            {
+                stack[stackSize++] = std::make_pair(node.First, leftEntry);
+                stack[stackSize++] = std::make_pair(node.First + 1, rightEntry);
+            }
+        }
+        else if (hitsLeft)
+        {
+            stack[stackSize++] = std::make_pair(node.First, leftEntry);
+        }
+        else if (hitsRight)
+        {
+            stack[stackSize++] = std::make_pair(node.First + 1, rightEntry);
+        }
+    }
+
+    return found;
+}
+
+AxisAlignedBoundingBox<float> MeshBVH::GetBounds() const
+{
+    if (mNodes.empty())
+    {
+        return EmptyBounds();
+    }
+
+    const Node& root = mNodes[0];
+    return AxisAlignedBoundingBox<float>(
+                vec3(root.Minimum[0], root.Minimum[1], root.Minimum[2]),
+                vec3(root.Maximum[0], root.Maximum[1], root.Maximum[2]));
+}
+
+} // end namespace ng
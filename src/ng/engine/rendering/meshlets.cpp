@@ -0,0 +1,356 @@
+#include "ng/engine/rendering/meshlets.hpp"
+
+#include "ng/engine/rendering/mesh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace ng
+{
+
+namespace
+{
+
+// cones wider than this are too wide to ever cull anything worthwhile.
+const float kMinConeDot = 0.1f;
+
+// the same id for the vertices at the same position, so triangles that
+// only share positions are still neighbours.
+std::vector<std::uint32_t> WeldPositions(const std::vector<vec3>& positions, std::uint32_t& numWelded)
+{
+    std::vector<std::uint32_t> order(positions.size());
+    for (std::uint32_t i = 0; i < order.size(); i++)
+    {
+        order[i] = i;
+    }
+
+    std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+        const vec3& pa = positions[a];
+        const vec3& pb = positions[b];
+        return pa.x != pb.x ? pa.x < pb.x : pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z;
+    });
+
+    std::vector<std::uint32_t> welded(positions.size());
+    numWelded = 0;
+    for (std::size_t i = 0; i < order.size(); i++)
+    {
+        if (i > 0 && positions[order[i]] != positions[order[i - 1]])
+        {
+            numWelded++;
+        }
+        welded[order[i]] = numWelded;
+    }
+
+    if (!order.empty())
+    {
+        numWelded++;
+    }
+
+    return welded;
+}
+
+template<class Visit>
+MeshletCullStats CullMeshlets(const std::vector<Meshlet>& meshlets,
+                              const mat4& worldView, const mat4& projection,
+                              Visit visit)
+{
+    MeshletCullStats stats;
+
+    // both tests happen in the mesh's space.
+    vec3 eye = vec3(inverse(worldView) * vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    Frustum<float> frustum(projection * worldView);
+
+    for (const Meshlet& meshlet : meshlets)
+    {
+        stats.NumMeshlets++;
+        stats.NumTriangles += meshlet.NumIndices / 3;
+
+        if (!FrustumSphereIntersect(frustum, meshlet.Bounds))
+        {
+            continue;
+        }
+
+        if (meshlet.ConeCutoff <= 1.0f)
+        {
+            vec3 toApex = meshlet.ConeApex - eye;
+            if (dot(toApex, meshlet.ConeAxis) >= meshlet.ConeCutoff * length(toApex))
+            {
+                continue;
+            }
+        }
+
+        stats.NumVisibleMeshlets++;
+        stats.NumVisibleTriangles += meshlet.NumIndices / 3;
+
+        visit(meshlet);
+    }
+
+    return stats;
+}
+
+} // end anonymous namespace
+
+Meshlets::Meshlets(const IMesh& mesh, std::size_t maxTriangles)
+{
+    if (maxTriangles == 0)
+    {
+        throw std::logic_error("Meshlets need room for at least one triangle");
+    }
+
+    std::vector<vec3> positions;
+    std::vector<std::uint32_t> indices;
+    ReadTriangles(mesh, positions, indices);
+
+    std::uint32_t numTriangles = std::uint32_t(indices.size() / 3);
+
+    std::uint32_t numWelded;
+    std::vector<std::uint32_t> welded = WeldPositions(positions, numWelded);
+
+    // the triangles around each welded vertex.
+    std::vector<std::uint32_t> firstAdjacent(numWelded + 1, 0);
+    for (std::uint32_t index : indices)
+    {
+        firstAdjacent[welded[index] + 1]++;
+    }
+    for (std::uint32_t vertex = 0; vertex < numWelded; vertex++)
+    {
+        firstAdjacent[vertex + 1] += firstAdjacent[vertex];
+    }
+
+    std::vector<std::uint32_t> adjacent(indices.size());
+    std::vector<std::uint32_t> numAdjacent(numWelded, 0);
+    for (std::size_t i = 0; i < indices.size(); i++)
+    {
+        std::uint32_t vertex = welded[indices[i]];
+        adjacent[firstAdjacent[vertex] + numAdjacent[vertex]++] = std::uint32_t(i / 3);
+    }
+
+    // degenerate triangles have no normal, and go anywhere.
+    std::vector<vec3> normals(numTriangles);
+    for (std::uint32_t triangle = 0; triangle < numTriangles; triangle++)
+    {
+        const vec3& p0 = positions[indices[3 * triangle]];
+        const vec3& p1 = positions[indices[3 * triangle + 1]];
+        const vec3& p2 = positions[indices[3 * triangle + 2]];
+
+        vec3 normal = cross(p1 - p0, p2 - p0);
+        float area = length(normal);
+        normals[triangle] = area > 0.0f ? normal / area : vec3(0.0f);
+    }
+
+    const std::uint32_t kNone = std::numeric_limits<std::uint32_t>::max();
+
+    // the last meshlet each triangle was a candidate of, and each welded
+    // vertex was part of.
+    std::vector<std::uint32_t> candidateOf(numTriangles, kNone);
+    std::vector<std::uint32_t> vertexOf(numWelded, kNone);
+    std::vector<std::uint8_t> used(numTriangles, 0);
+
+    std::vector<std::uint32_t> candidates;
+    std::vector<std::uint32_t> meshletTriangles;
+    std::uint32_t nextSeed = 0;
+
+    mIndices.reserve(indices.size());
+
+    for (;;)
+    {
+        // meshlets grow from the edge of the previous one, so the
+        // triangles left over don't end up scattered.
+        std::uint32_t seed = kNone;
+        for (std::uint32_t candidate : candidates)
+        {
+            if (!used[candidate])
+            {
+                seed = candidate;
+                break;
+            }
+        }
+
+        if (seed == kNone)
+        {
+            while (nextSeed < numTriangles && used[nextSeed])
+            {
+                nextSeed++;
+            }
+
+            if (nextSeed == numTriangles)
+            {
+                break;
+            }
+
+            seed = nextSeed;
+        }
+
+        std::uint32_t meshletId = std::uint32_t(mMeshlets.size());
+        candidates.clear();
+        meshletTriangles.clear();
+        vec3 normalSum(0.0f);
+
+        std::uint32_t triangle = seed;
+        for (;;)
+        {
+            used[triangle] = 1;
+            meshletTriangles.push_back(triangle);
+            normalSum += normals[triangle];
+
+            for (int corner = 0; corner < 3; corner++)
+            {
+                std::uint32_t vertex = welded[indices[3 * triangle + corner]];
+                vertexOf[vertex] = meshletId;
+
+                for (std::uint32_t i = firstAdjacent[vertex]; i < firstAdjacent[vertex + 1]; i++)
+                {
+                    std::uint32_t neighbour = adjacent[i];
+                    if (!used[neighbour] && candidateOf[neighbour] != meshletId)
+                    {
+                        candidateOf[neighbour] = meshletId;
+                        candidates.push_back(neighbour);
+                    }
+                }
+            }
+
+            if (meshletTriangles.size() == maxTriangles)
+            {
+                break;
+            }
+
+            // the candidate adding the fewest vertices, facing the way
+            // the meshlet does the most.
+            float normalSumLength = length(normalSum);
+            vec3 meshletNormal = normalSumLength > 0.0f ? normalSum / normalSumLength : vec3(0.0f);
+
+            std::uint32_t best = kNone;
+            float bestScore = std::numeric_limits<float>::infinity();
+
+            for (std::size_t i = 0; i < candidates.size(); )
+            {
+                std::uint32_t candidate = candidates[i];
+                if (used[candidate])
+                {
+                    candidates[i] = candidates.back();
+                    candidates.pop_back();
+                    continue;
+                }
+
+                int numNewVertices = 0;
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    numNewVertices += vertexOf[welded[indices[3 * candidate + corner]]] != meshletId;
+                }
+
+                float score = numNewVertices + (1.0f - dot(meshletNormal, normals[candidate]));
+                if (score < bestScore)
+                {
+                    best = candidate;
+                    bestScore = score;
+                }
+
+                i++;
+            }
+
+            if (best == kNone)
+            {
+                break;
+            }
+
+            triangle = best;
+        }
+
+        Meshlet meshlet;
+        meshlet.FirstIndex = std::uint32_t(mIndices.size());
+        meshlet.NumIndices = std::uint32_t(3 * meshletTriangles.size());
+
+        AxisAlignedBoundingBox<float> box(vec3(std::numeric_limits<float>::infinity()),
+                                          vec3(-std::numeric_limits<float>::infinity()));
+
+        for (std::uint32_t t : meshletTriangles)
+        {
+            for (int corner = 0; corner < 3; corner++)
+            {
+                mIndices.push_back(indices[3 * t + corner]);
+                box.AddPoint(positions[indices[3 * t + corner]]);
+            }
+        }
+
+        vec3 center = box.GetCenter();
+        float radius = 0.0f;
+        for (std::uint32_t t : meshletTriangles)
+        {
+            for (int corner = 0; corner < 3; corner++)
+            {
+                radius = std::max(radius, length(positions[indices[3 * t + corner]] - center));
+            }
+        }
+        meshlet.Bounds = Sphere<float>(center, radius);
+
+        // the cone holds the directions from which every triangle is seen
+        // from behind. Its apex is pulled back along the axis until it's
+        // behind all the triangles' planes.
+        float normalSumLength = length(normalSum);
+        meshlet.ConeAxis = normalSumLength > 0.0f ? normalSum / normalSumLength : vec3(0.0f, 0.0f, 1.0f);
+        meshlet.ConeApex = center;
+        meshlet.ConeCutoff = 2.0f;
+
+        float minDot = normalSumLength > 0.0f ? 1.0f : -1.0f;
+        for (std::uint32_t t : meshletTriangles)
+        {
+            if (normals[t] != vec3(0.0f))
+            {
+                minDot = std::min(minDot, dot(meshlet.ConeAxis, normals[t]));
+            }
+        }
+
+        if (minDot > kMinConeDot)
+        {
+            float maxT = -std::numeric_limits<float>::infinity();
+            for (std::uint32_t t : meshletTriangles)
+            {
+                if (normals[t] != vec3(0.0f))
+                {
+                    const vec3& p0 = positions[indices[3 * t]];
+                    maxT = std::max(maxT, dot(center - p0, normals[t]) / dot(meshlet.ConeAxis, normals[t]));
+                }
+            }
+
+            meshlet.ConeApex = center - meshlet.ConeAxis * maxT;
+            meshlet.ConeCutoff = std::sqrt(1.0f - minDot * minDot);
+        }
+
+        mMeshlets.push_back(meshlet);
+    }
+}
+
+MeshletCullStats Meshlets::Cull(const mat4& worldView, const mat4& projection,
+                                std::vector<MeshletRange>& ranges) const
+{
+    ranges.clear();
+
+    return CullMeshlets(mMeshlets, worldView, projection, [&](const Meshlet& meshlet)
+    {
+        if (!ranges.empty() && ranges.back().FirstIndex + ranges.back().NumIndices == meshlet.FirstIndex)
+        {
+            ranges.back().NumIndices += meshlet.NumIndices;
+        }
+        else
+        {
+            ranges.push_back(MeshletRange{meshlet.FirstIndex, meshlet.NumIndices});
+        }
+    });
+}
+
+MeshletCullStats Meshlets::Cull(const mat4& worldView, const mat4& projection,
+                                std::vector<std::uint32_t>& indices) const
+{
+    indices.clear();
+
+    return CullMeshlets(mMeshlets, worldView, projection, [&](const Meshlet& meshlet)
+    {
+        indices.insert(indices.end(),
+                       mIndices.begin() + meshlet.FirstIndex,
+                       mIndices.begin() + meshlet.FirstIndex + meshlet.NumIndices);
+    });
+}
+
+} // end namespace ng
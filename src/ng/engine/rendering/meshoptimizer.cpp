@@ -0,0 +1,541 @@
+#include "ng/engine/rendering/meshoptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace ng
+{
+
+const std::size_t OptimizedMesh::kAcmrCacheSize;
+
+namespace
+{
+
+// the least recently used cache that Forsyth's scores model, and the
+// constants he tuned them with.
+const int kCacheSize = 32;
+const float kCacheDecayPower = 1.5f;
+const float kLastTriangleScore = 0.75f;
+const float kValenceBoostScale = 2.0f;
+const float kValenceBoostPower = 0.5f;
+
+// how much worse than the vertex cache order the clusters sorted for
+// overdraw may use the cache.
+const double kOverdrawThreshold = 1.05;
+
+const std::uint32_t kNone = std::numeric_limits<std::uint32_t>::max();
+
+// a first in, first out cache, which remembers when each vertex was
+// added to it instead of what's in it.
+class FifoCache
+{
+    std::vector<std::uint32_t> mTimestamps;
+    std::uint32_t mTime;
+    std::uint32_t mSize;
+
+public:
+    FifoCache(std::size_t numVertices, std::size_t size)
+        : mTimestamps(numVertices, 0)
+        , mTime(std::uint32_t(size) + 1)
+        , mSize(std::uint32_t(size))
+    { }
+
+    // adds the vertex if it isn't in the cache, and returns whether it wasn't.
+    bool Miss(std::uint32_t vertex)
+    {
+        if (mTime - mTimestamps[vertex] > mSize)
+        {
+            mTimestamps[vertex] = mTime++;
+            return true;
+        }
+
+        return false;
+    }
+
+    int CountMisses(const std::uint32_t* triangle)
+    {
+        return int(Miss(triangle[0])) + int(Miss(triangle[1])) + int(Miss(triangle[2]));
+    }
+
+    void Clear()
+    {
+        mTime += mSize + 1;
+    }
+};
+
+// the same id for vertices with the same bytes.
+std::vector<std::uint32_t> WeldVertices(const std::vector<char>& vertices, std::size_t stride,
+                                        std::size_t numVertices, std::uint32_t& numUnique)
+{
+    std::vector<std::uint32_t> order(numVertices);
+    for (std::uint32_t i = 0; i < numVertices; i++)
+    {
+        order[i] = i;
+    }
+
+    std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return std::memcmp(&vertices[a * stride], &vertices[b * stride], stride) < 0;
+    });
+
+    std::vector<std::uint32_t> unique(numVertices);
+    numUnique = 0;
+    for (std::size_t i = 0; i < order.size(); i++)
+    {
+        if (i > 0 && std::memcmp(&vertices[order[i] * stride], &vertices[order[i - 1] * stride], stride) != 0)
+        {
+            numUnique++;
+        }
+        unique[order[i]] = numUnique;
+    }
+
+    if (!order.empty())
+    {
+        numUnique++;
+    }
+
+    return unique;
+}
+
+float VertexScore(int cachePosition, std::uint32_t numRemaining)
+{
+    if (numRemaining == 0)
+    {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // the last triangle's vertices get a fixed score, so the next
+        // triangle doesn't just go back the way the last one came.
+        score = cachePosition < 3
+                ? kLastTriangleScore
+                : std::pow(1.0f - float(cachePosition - 3) / (kCacheSize - 3), kCacheDecayPower);
+    }
+
+    // vertices with few triangles left are finished off first.
+    return score + kValenceBoostScale * std::pow(float(numRemaining), -kValenceBoostPower);
+}
+
+// Tom Forsyth's "Linear-Speed Vertex Cache Optimisation": triangles are
+// drawn greedily by the scores of their vertices, which favour vertices
+// that are in the cache and have few triangles left.
+std::vector<std::uint32_t> OptimizeVertexCache(const std::vector<std::uint32_t>& indices, std::size_t numVertices)
+{
+    std::size_t numTriangles = indices.size() / 3;
+
+    // the triangles around each vertex, with those not drawn yet first.
+    std::vector<std::uint32_t> firstAdjacent(numVertices + 1, 0);
+    for (std::uint32_t index : indices)
+    {
+        firstAdjacent[index + 1]++;
+    }
+    for (std::size_t vertex = 0; vertex < numVertices; vertex++)
+    {
+        firstAdjacent[vertex + 1] += firstAdjacent[vertex];
+    }
+
+    std::vector<std::uint32_t> adjacent(indices.size());
+    std::vector<std::uint32_t> numRemaining(numVertices, 0);
+    for (std::size_t i = 0; i < indices.size(); i++)
+    {
+        std::uint32_t vertex = indices[i];
+        adjacent[firstAdjacent[vertex] + numRemaining[vertex]++] = std::uint32_t(i / 3);
+    }
+
+    std::vector<int> cachePositions(numVertices, -1);
+    std::vector<float> vertexScores(numVertices);
+    for (std::size_t vertex = 0; vertex < numVertices; vertex++)
+    {
+        vertexScores[vertex] = VertexScore(-1, numRemaining[vertex]);
+    }
+
+    auto triangleScore = [&](std::uint32_t triangle) {
+        const std::uint32_t* corners = &indices[3 * triangle];
+        return vertexScores[corners[0]] + vertexScores[corners[1]] + vertexScores[corners[2]];
+    };
+
+    std::uint32_t best = kNone;
+    float bestScore = -std::numeric_limits<float>::infinity();
+    for (std::uint32_t triangle = 0; triangle < numTriangles; triangle++)
+    {
+        if (triangleScore(triangle) > bestScore)
+        {
+            best = triangle;
+            bestScore = triangleScore(triangle);
+        }
+    }
+
+    std::vector<std::uint8_t> drawn(numTriangles, 0);
+    std::uint32_t nextUndrawn = 0;
+
+    std::uint32_t cache[kCacheSize + 3];
+    int cacheCount = 0;
+
+    std::vector<std::uint32_t> result;
+    result.reserve(indices.size());
+
+    while (best != kNone)
+    {
+        drawn[best] = 1;
+
+        const std::uint32_t* corners = &indices[3 * best];
+        for (int corner = 0; corner < 3; corner++)
+        {
+            std::uint32_t vertex = corners[corner];
+            result.push_back(vertex);
+
+            std::uint32_t* remaining = &adjacent[firstAdjacent[vertex]];
+            std::uint32_t* last = remaining + --numRemaining[vertex];
+            std::iter_swap(std::find(remaining, last, best), last);
+        }
+
+        // the triangle's vertices move to the front of the cache, pushing
+        // the others back, and the last ones out.
+        std::uint32_t newCache[kCacheSize + 3];
+        int newCount = 0;
+        for (int corner = 0; corner < 3; corner++)
+        {
+            newCache[newCount++] = corners[corner];
+        }
+        for (int i = 0; i < cacheCount; i++)
+        {
+            std::uint32_t vertex = cache[i];
+            if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2])
+            {
+                newCache[newCount++] = vertex;
+            }
+        }
+
+        cacheCount = std::min(newCount, kCacheSize);
+        std::copy(newCache, newCache + cacheCount, cache);
+
+        for (int i = 0; i < newCount; i++)
+        {
+            std::uint32_t vertex = newCache[i];
+            cachePositions[vertex] = i < kCacheSize ? i : -1;
+            vertexScores[vertex] = VertexScore(cachePositions[vertex], numRemaining[vertex]);
+        }
+
+        // the next triangle is the best of those around the cache.
+        best = kNone;
+        bestScore = -std::numeric_limits<float>::infinity();
+
+        for (int i = 0; i < cacheCount; i++)
+        {
+            std::uint32_t vertex = cache[i];
+            const std::uint32_t* remaining = &adjacent[firstAdjacent[vertex]];
+
+            for (std::uint32_t j = 0; j < numRemaining[vertex]; j++)
+            {
+                std::uint32_t triangle = remaining[j];
+                float score = triangleScore(triangle);
+
+                if (score > bestScore)
+                {
+                    best = triangle;
+                    bestScore = score;
+                }
+            }
+        }
+
+        // at a dead end, carry on with the triangles in their old order.
+        if (best == kNone)
+        {
+            while (nextUndrawn < numTriangles && drawn[nextUndrawn])
+            {
+                nextUndrawn++;
+            }
+
+            if (nextUndrawn < numTriangles)
+            {
+                best = nextUndrawn;
+            }
+        }
+    }
+
+    return result;
+}
+
+// Sander et al.'s "Fast Triangle Reordering for Vertex Locality and
+// Reduced Overdraw": the triangles are split into clusters wherever the
+// cache starts cold, and where a cluster's cache misses so far are close
+// enough to the whole cluster's. The clusters that face away from the
+// center of the mesh are drawn first, since they're likely to be in front.
+std::vector<std::uint32_t> OptimizeOverdraw(const std::vector<std::uint32_t>& indices, const std::vector<vec3>& positions)
+{
+    std::size_t numTriangles = indices.size() / 3;
+
+    FifoCache cache(positions.size(), OptimizedMesh::kAcmrCacheSize);
+
+    std::vector<std::uint32_t> hardBoundaries;
+    for (std::uint32_t triangle = 0; triangle < numTriangles; triangle++)
+    {
+        if (cache.CountMisses(&indices[3 * triangle]) == 3)
+        {
+            hardBoundaries.push_back(triangle);
+        }
+    }
+    hardBoundaries.push_back(std::uint32_t(numTriangles));
+
+    std::vector<std::uint32_t> boundaries;
+    for (std::size_t i = 0; i + 1 < hardBoundaries.size(); i++)
+    {
+        std::uint32_t begin = hardBoundaries[i];
+        std::uint32_t end = hardBoundaries[i + 1];
+
+        cache.Clear();
+        int clusterMisses = 0;
+        for (std::uint32_t triangle = begin; triangle < end; triangle++)
+        {
+            clusterMisses += cache.CountMisses(&indices[3 * triangle]);
+        }
+
+        double maxMissesPerTriangle = kOverdrawThreshold * clusterMisses / (end - begin);
+
+        boundaries.push_back(begin);
+        cache.Clear();
+
+        int misses = 0;
+        std::uint32_t clusterBegin = begin;
+        for (std::uint32_t triangle = begin; triangle + 1 < end; triangle++)
+        {
+            misses += cache.CountMisses(&indices[3 * triangle]);
+
+            if (misses <= maxMissesPerTriangle * (triangle + 1 - clusterBegin))
+            {
+                boundaries.push_back(triangle + 1);
+                clusterBegin = triangle + 1;
+                misses = 0;
+                cache.Clear();
+            }
+        }
+    }
+    boundaries.push_back(std::uint32_t(numTriangles));
+
+    std::size_t numClusters = boundaries.size() - 1;
+
+    std::vector<vec3> centroids(numClusters, vec3(0.0f));
+    std::vector<vec3> normals(numClusters, vec3(0.0f));
+    std::vector<float> areas(numClusters, 0.0f);
+
+    vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+
+    for (std::size_t cluster = 0; cluster < numClusters; cluster++)
+    {
+        for (std::uint32_t triangle = boundaries[cluster]; triangle < boundaries[cluster + 1]; triangle++)
+        {
+            const vec3& p0 = positions[indices[3 * triangle]];
+            const vec3& p1 = positions[indices[3 * triangle + 1]];
+            const vec3& p2 = positions[indices[3 * triangle + 2]];
+
+            vec3 normal = cross(p1 - p0, p2 - p0);
+            float area = length(normal);
+
+            centroids[cluster] += (p0 + p1 + p2) * (area / 3.0f);
+            normals[cluster] += normal;
+            areas[cluster] += area;
+        }
+
+        meshCentroid += centroids[cluster];
+        meshArea += areas[cluster];
+    }
+
+    if (meshArea > 0.0f)
+    {
+        meshCentroid = meshCentroid / meshArea;
+    }
+
+    std::vector<float> sortKeys(numClusters, 0.0f);
+    for (std::size_t cluster = 0; cluster < numClusters; cluster++)
+    {
+        float normalLength = length(normals[cluster]);
+        if (areas[cluster] > 0.0f && normalLength > 0.0f)
+        {
+            vec3 centroid = centroids[cluster] / areas[cluster];
+            sortKeys[cluster] = dot(centroid - meshCentroid, normals[cluster] / normalLength);
+        }
+    }
+
+    std::vector<std::uint32_t> order(numClusters);
+    for (std::uint32_t cluster = 0; cluster < numClusters; cluster++)
+    {
+        order[cluster] = cluster;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return sortKeys[a] > sortKeys[b];
+    });
+
+    std::vector<std::uint32_t> result;
+    result.reserve(indices.size());
+    for (std::uint32_t cluster : order)
+    {
+        result.insert(result.end(),
+                      indices.begin() + 3 * boundaries[cluster],
+                      indices.begin() + 3 * boundaries[cluster + 1]);
+    }
+
+    return result;
+}
+
+template<class T>
+void StoreIndices(const std::vector<std::uint32_t>& indices, std::vector<char>& buffer)
+{
+    buffer.resize(indices.size() * sizeof(T));
+    T* out = reinterpret_cast<T*>(buffer.data());
+    for (std::size_t i = 0; i < indices.size(); i++)
+    {
+        out[i] = T(indices[i]);
+    }
+}
+
+} // end anonymous namespace
+
+OptimizedMesh::OptimizedMesh(const IMesh& mesh)
+{
+    std::size_t stride, numVertices;
+    std::vector<char> packed = PackVertices(mesh, mVertexFormat, stride, numVertices);
+
+    std::vector<vec3> positions;
+    std::vector<std::uint32_t> indices;
+    ReadTriangles(mesh, mVertexFormat, packed.data(), numVertices, positions, indices);
+
+    mStats.NumVerticesBefore = numVertices;
+    mStats.NumTrianglesBefore = indices.size() / 3;
+    mStats.AcmrBefore = ComputeAcmr(indices);
+
+    std::uint32_t numUnique;
+    std::vector<std::uint32_t> unique = WeldVertices(packed, stride, numVertices, numUnique);
+
+    std::vector<std::uint32_t> sourceOfUnique(numUnique);
+    std::vector<vec3> uniquePositions(numUnique);
+    for (std::uint32_t i = 0; i < numVertices; i++)
+    {
+        sourceOfUnique[unique[i]] = i;
+        uniquePositions[unique[i]] = positions[i];
+    }
+
+    std::vector<std::uint32_t> welded;
+    welded.reserve(indices.size());
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        std::uint32_t a = unique[indices[i]];
+        std::uint32_t b = unique[indices[i + 1]];
+        std::uint32_t c = unique[indices[i + 2]];
+
+        if (a != b && b != c && c != a)
+        {
+            welded.push_back(a);
+            welded.push_back(b);
+            welded.push_back(c);
+        }
+    }
+
+    welded = OptimizeVertexCache(welded, numUnique);
+    welded = OptimizeOverdraw(welded, uniquePositions);
+
+    // vertices are stored in the order they're first used, and the ones
+    // no triangle uses are left out.
+    std::vector<std::uint32_t> newIndexOfUnique(numUnique, kNone);
+    mNumVertices = 0;
+    for (std::uint32_t& index : welded)
+    {
+        if (newIndexOfUnique[index] == kNone)
+        {
+            newIndexOfUnique[index] = std::uint32_t(mNumVertices++);
+            const char* vertex = &packed[sourceOfUnique[index] * stride];
+            mVertices.insert(mVertices.end(), vertex, vertex + stride);
+        }
+
+        index = newIndexOfUnique[index];
+    }
+
+    mNumIndices = welded.size();
+
+    mVertexFormat.PrimitiveType = PrimitiveType::Triangles;
+    mVertexFormat.IsIndexed = true;
+    mVertexFormat.IndexOffset = 0;
+
+    if (mNumVertices <= 0x100)
+    {
+        mVertexFormat.IndexType = ArithmeticType::UInt8;
+        StoreIndices<std::uint8_t>(welded, mIndices);
+    }
+    else if (mNumVertices <= 0x10000)
+    {
+        mVertexFormat.IndexType = ArithmeticType::UInt16;
+        StoreIndices<std::uint16_t>(welded, mIndices);
+    }
+    else
+    {
+        mVertexFormat.IndexType = ArithmeticType::UInt32;
+        StoreIndices<std::uint32_t>(welded, mIndices);
+    }
+
+    mStats.NumVerticesAfter = mNumVertices;
+    mStats.NumTrianglesAfter = mNumIndices / 3;
+    mStats.AcmrAfter = ComputeAcmr(welded);
+}
+
+VertexFormat OptimizedMesh::GetVertexFormat() const
+{
+    return mVertexFormat;
+}
+
+std::size_t OptimizedMesh::GetMaxVertexBufferSize() const
+{
+    return mVertices.size();
+}
+
+std::size_t OptimizedMesh::GetMaxIndexBufferSize() const
+{
+    return mIndices.size();
+}
+
+std::size_t OptimizedMesh::WriteVertices(void* buffer) const
+{
+    if (buffer)
+    {
+        std::memcpy(buffer, mVertices.data(), mVertices.size());
+    }
+
+    return mNumVertices;
+}
+
+std::size_t OptimizedMesh::WriteIndices(void* buffer) const
+{
+    if (buffer)
+    {
+        std::memcpy(buffer, mIndices.data(), mIndices.size());
+    }
+
+    return mNumIndices;
+}
+
+double ComputeAcmr(const std::vector<std::uint32_t>& indices, std::size_t cacheSize)
+{
+    std::size_t numTriangles = indices.size() / 3;
+    if (numTriangles == 0)
+    {
+        return 0.0;
+    }
+
+    std::uint32_t maxIndex = *std::max_element(indices.begin(), indices.end());
+
+    FifoCache cache(std::size_t(maxIndex) + 1, cacheSize);
+
+    std::size_t misses = 0;
+    for (std::size_t triangle = 0; triangle < numTriangles; triangle++)
+    {
+        misses += cache.CountMisses(&indices[3 * triangle]);
+    }
+
+    return double(misses) / numTriangles;
+}
+
+} // end namespace ng
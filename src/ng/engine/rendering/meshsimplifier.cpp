@@ -0,0 +1,751 @@
+#include "ng/engine/rendering/meshsimplifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace ng
+{
+
+namespace
+{
+
+// how much more moving a border or a seam costs than moving the surface.
+const double kBorderWeight = 10.0;
+
+// the sum of the squared distances to some planes, each with a weight.
+class Quadric
+{
+public:
+    // xx, xy, xz, xw, yy, yz, yw, zz, zw, ww
+    double Matrix[10] = {};
+    double Weight = 0.0;
+
+    void AddPlane(vec3 normal, float d, double weight)
+    {
+        double plane[4] = { normal.x, normal.y, normal.z, d };
+
+        int i = 0;
+        for (int row = 0; row < 4; row++)
+        {
+            for (int column = row; column < 4; column++)
+            {
+                Matrix[i++] += weight * plane[row] * plane[column];
+            }
+        }
+
+        Weight += weight;
+    }
+
+    void Add(const Quadric& other)
+    {
+        for (int i = 0; i < 10; i++)
+        {
+            Matrix[i] += other.Matrix[i];
+        }
+
+        Weight += other.Weight;
+    }
+
+    // the weighted mean of the squared distances.
+    double Evaluate(vec3 p) const
+    {
+        if (Weight <= 0.0)
+        {
+            return 0.0;
+        }
+
+        double x = p.x, y = p.y, z = p.z;
+        const double* m = Matrix;
+
+        double sum = m[0] * x * x + 2 * m[1] * x * y + 2 * m[2] * x * z + 2 * m[3] * x
+                   + m[4] * y * y + 2 * m[5] * y * z + 2 * m[6] * y
+                   + m[7] * z * z + 2 * m[8] * z
+                   + m[9];
+
+        return std::max(sum, 0.0) / Weight;
+    }
+};
+
+// the same id for equal keys, as told by a strict weak ordering.
+template<class Less, class Equal>
+std::vector<std::uint32_t> GroupIds(std::size_t count, Less less, Equal equal, std::uint32_t& numGroups)
+{
+    std::vector<std::uint32_t> order(count);
+    for (std::uint32_t i = 0; i < count; i++)
+    {
+        order[i] = i;
+    }
+
+    std::sort(order.begin(), order.end(), less);
+
+    std::vector<std::uint32_t> ids(count);
+    numGroups = 0;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        if (i > 0 && !equal(order[i], order[i - 1]))
+        {
+            numGroups++;
+        }
+        ids[order[i]] = numGroups;
+    }
+
+    if (count > 0)
+    {
+        numGroups++;
+    }
+
+    return ids;
+}
+
+enum class EdgeKind
+{
+    Interior,
+    Seam,
+    Border,
+    NonManifold
+};
+
+class Edge
+{
+public:
+    std::uint32_t A;
+    std::uint32_t B;
+    EdgeKind Kind;
+};
+
+class HalfEdge
+{
+public:
+    std::uint64_t Key;
+    std::uint32_t Triangle;
+    std::uint32_t From;
+    std::uint32_t To;
+};
+
+class Simplifier
+{
+public:
+    std::vector<vec3> Positions;    // per welded vertex
+    std::vector<std::uint32_t> Weld; // per unique vertex
+    std::vector<std::uint32_t> Triangles;
+    std::vector<Quadric> Quadrics;  // per welded vertex
+
+    // the current triangles around each welded vertex.
+    std::vector<std::uint32_t> FirstAdjacent;
+    std::vector<std::uint32_t> Adjacent;
+
+    std::vector<std::uint8_t> IsBorder;
+    std::vector<std::uint8_t> IsLocked;
+
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> Mapping;
+    std::vector<std::uint32_t> NeighboursA;
+    std::vector<std::uint32_t> NeighboursB;
+
+    std::vector<HalfEdge> GetHalfEdges() const
+    {
+        std::vector<HalfEdge> halfEdges;
+        halfEdges.reserve(Triangles.size());
+
+        for (std::uint32_t triangle = 0; triangle < Triangles.size() / 3; triangle++)
+        {
+            for (int corner = 0; corner < 3; corner++)
+            {
+                std::uint32_t from = Triangles[3 * triangle + corner];
+                std::uint32_t to = Triangles[3 * triangle + (corner + 1) % 3];
+                std::uint64_t a = std::min(Weld[from], Weld[to]);
+                std::uint64_t b = std::max(Weld[from], Weld[to]);
+                halfEdges.push_back(HalfEdge{(a << 32) | b, triangle, from, to});
+            }
+        }
+
+        std::sort(halfEdges.begin(), halfEdges.end(), [](const HalfEdge& x, const HalfEdge& y) {
+            return x.Key < y.Key;
+        });
+
+        return halfEdges;
+    }
+
+    // calls f with each edge between welded vertices, its kind, and its half edges.
+    template<class F>
+    static void ForEachEdge(const std::vector<HalfEdge>& halfEdges, F f)
+    {
+        for (std::size_t begin = 0; begin < halfEdges.size(); )
+        {
+            std::size_t end = begin + 1;
+            while (end < halfEdges.size() && halfEdges[end].Key == halfEdges[begin].Key)
+            {
+                end++;
+            }
+
+            EdgeKind kind;
+            if (end - begin == 1)
+            {
+                kind = EdgeKind::Border;
+            }
+            else if (end - begin > 2)
+            {
+                kind = EdgeKind::NonManifold;
+            }
+            else
+            {
+                const HalfEdge& x = halfEdges[begin];
+                const HalfEdge& y = halfEdges[begin + 1];
+                kind = x.From == y.To && x.To == y.From ? EdgeKind::Interior : EdgeKind::Seam;
+            }
+
+            f(halfEdges.data() + begin, halfEdges.data() + end, kind);
+            begin = end;
+        }
+    }
+
+    void BuildQuadrics()
+    {
+        Quadrics.assign(Positions.size(), Quadric());
+
+        for (std::size_t i = 0; i < Triangles.size(); i += 3)
+        {
+            vec3 p0 = Positions[Weld[Triangles[i]]];
+            vec3 p1 = Positions[Weld[Triangles[i + 1]]];
+            vec3 p2 = Positions[Weld[Triangles[i + 2]]];
+
+            vec3 normal = cross(p1 - p0, p2 - p0);
+            float doubleArea = length(normal);
+            if (doubleArea <= 0.0f)
+            {
+                continue;
+            }
+            normal = normal / doubleArea;
+
+            for (int corner = 0; corner < 3; corner++)
+            {
+                Quadrics[Weld[Triangles[i + corner]]].AddPlane(normal, -dot(normal, p0), 0.5 * doubleArea);
+            }
+        }
+
+        // planes along the borders and seams, at a right angle to the
+        // surface, keep them from moving away from where they are.
+        ForEachEdge(GetHalfEdges(), [&](const HalfEdge* begin, const HalfEdge* end, EdgeKind kind)
+        {
+            if (kind == EdgeKind::Interior)
+            {
+                return;
+            }
+
+            for (const HalfEdge* halfEdge = begin; halfEdge != end; ++halfEdge)
+            {
+                const std::uint32_t* triangle = &Triangles[3 * halfEdge->Triangle];
+                vec3 p0 = Positions[Weld[triangle[0]]];
+                vec3 p1 = Positions[Weld[triangle[1]]];
+                vec3 p2 = Positions[Weld[triangle[2]]];
+
+                vec3 from = Positions[Weld[halfEdge->From]];
+                vec3 edge = Positions[Weld[halfEdge->To]] - from;
+
+                vec3 normal = cross(edge, cross(p1 - p0, p2 - p0));
+                float normalLength = length(normal);
+                if (normalLength <= 0.0f)
+                {
+                    continue;
+                }
+                normal = normal / normalLength;
+
+                double weight = kBorderWeight * dot(edge, edge);
+                Quadrics[Weld[halfEdge->From]].AddPlane(normal, -dot(normal, from), weight);
+                Quadrics[Weld[halfEdge->To]].AddPlane(normal, -dot(normal, from), weight);
+            }
+        });
+    }
+
+    void BuildAdjacency()
+    {
+        FirstAdjacent.assign(Positions.size() + 1, 0);
+        for (std::uint32_t vertex : Triangles)
+        {
+            FirstAdjacent[Weld[vertex] + 1]++;
+        }
+        for (std::size_t i = 0; i < Positions.size(); i++)
+        {
+            FirstAdjacent[i + 1] += FirstAdjacent[i];
+        }
+
+        Adjacent.resize(Triangles.size());
+        std::vector<std::uint32_t> filled(FirstAdjacent.begin(), FirstAdjacent.end() - 1);
+        for (std::size_t i = 0; i < Triangles.size(); i++)
+        {
+            Adjacent[filled[Weld[Triangles[i]]]++] = std::uint32_t(i / 3);
+        }
+    }
+
+    void GetNeighbours(std::uint32_t vertex, std::vector<std::uint32_t>& neighbours) const
+    {
+        neighbours.clear();
+        for (std::uint32_t i = FirstAdjacent[vertex]; i < FirstAdjacent[vertex + 1]; i++)
+        {
+            for (int corner = 0; corner < 3; corner++)
+            {
+                std::uint32_t neighbour = Weld[Triangles[3 * Adjacent[i] + corner]];
+                if (neighbour != vertex)
+                {
+                    neighbours.push_back(neighbour);
+                }
+            }
+        }
+
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+    }
+
+    // whether a can move onto b, and which of b's vertices each of a's
+    // vertices becomes.
+    bool CanCollapse(std::uint32_t a, std::uint32_t b)
+    {
+        Mapping.clear();
+        std::size_t numShared = 0;
+
+        for (std::uint32_t i = FirstAdjacent[a]; i < FirstAdjacent[a + 1]; i++)
+        {
+            const std::uint32_t* triangle = &Triangles[3 * Adjacent[i]];
+
+            std::uint32_t fromA = 0, toB = 0;
+            bool hasB = false;
+            for (int corner = 0; corner < 3; corner++)
+            {
+                if (Weld[triangle[corner]] == a)
+                {
+                    fromA = triangle[corner];
+                }
+                else if (Weld[triangle[corner]] == b)
+                {
+                    toB = triangle[corner];
+                    hasB = true;
+                }
+            }
+
+            if (!hasB)
+            {
+                continue;
+            }
+
+            numShared++;
+
+            // a's vertices can't be split or merged across a seam.
+            for (const std::pair<std::uint32_t, std::uint32_t>& mapped : Mapping)
+            {
+                if ((mapped.first == fromA) != (mapped.second == toB))
+                {
+                    return false;
+                }
+            }
+            Mapping.push_back(std::make_pair(fromA, toB));
+        }
+
+        if (numShared == 0)
+        {
+            return false;
+        }
+
+        vec3 target = Positions[b];
+
+        for (std::uint32_t i = FirstAdjacent[a]; i < FirstAdjacent[a + 1]; i++)
+        {
+            const std::uint32_t* triangle = &Triangles[3 * Adjacent[i]];
+
+            bool hasB = false;
+            vec3 before[3];
+            vec3 after[3];
+            for (int corner = 0; corner < 3; corner++)
+            {
+                std::uint32_t vertex = triangle[corner];
+                hasB = hasB || Weld[vertex] == b;
+                before[corner] = Positions[Weld[vertex]];
+                after[corner] = Weld[vertex] == a ? target : before[corner];
+
+                if (Weld[vertex] == a)
+                {
+                    bool mapped = false;
+                    for (const std::pair<std::uint32_t, std::uint32_t>& m : Mapping)
+                    {
+                        mapped = mapped || m.first == vertex;
+                    }
+
+                    if (!mapped)
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            if (hasB)
+            {
+                continue;
+            }
+
+            // the triangles that stay mustn't flip over.
+            vec3 normalBefore = cross(before[1] - before[0], before[2] - before[0]);
+            vec3 normalAfter = cross(after[1] - after[0], after[2] - after[0]);
+            if (dot(normalBefore, normalAfter) <= 0.0f)
+            {
+                return false;
+            }
+        }
+
+        // the only neighbours a and b share are across the triangles
+        // they share, or the surface would fold onto itself.
+        GetNeighbours(a, NeighboursA);
+        GetNeighbours(b, NeighboursB);
+
+        std::size_t numCommon = 0;
+        for (std::size_t i = 0, j = 0; i < NeighboursA.size() && j < NeighboursB.size(); )
+        {
+            if (NeighboursA[i] < NeighboursB[j])
+            {
+                i++;
+            }
+            else if (NeighboursB[j] < NeighboursA[i])
+            {
+                j++;
+            }
+            else
+            {
+                numCommon++;
+                i++;
+                j++;
+            }
+        }
+
+        return numCommon <= numShared;
+    }
+
+    class Candidate
+    {
+    public:
+        double Cost;
+        std::uint32_t From;
+        std::uint32_t To;
+    };
+
+    // collapses as many edges as it can without touching the same
+    // triangles twice, returns how many it did.
+    std::size_t Pass(std::size_t targetTriangles, double maxCost, double& maxCollapsed)
+    {
+        BuildAdjacency();
+
+        std::size_t numWelded = Positions.size();
+        IsBorder.assign(numWelded, 0);
+        IsLocked.assign(numWelded, 0);
+
+        std::vector<Edge> edges;
+        ForEachEdge(GetHalfEdges(), [&](const HalfEdge* begin, const HalfEdge*, EdgeKind kind)
+        {
+            std::uint32_t a = std::uint32_t(begin->Key >> 32);
+            std::uint32_t b = std::uint32_t(begin->Key & 0xFFFFFFFF);
+
+            if (kind == EdgeKind::Border || kind == EdgeKind::NonManifold)
+            {
+                IsBorder[a] = IsBorder[b] = 1;
+            }
+
+            if (kind == EdgeKind::NonManifold)
+            {
+                IsLocked[a] = IsLocked[b] = 1;
+            }
+
+            edges.push_back(Edge{a, b, kind});
+        });
+
+        // both ways along each edge, checked only when they're reached.
+        std::vector<Candidate> candidates;
+        for (const Edge& edge : edges)
+        {
+            for (int direction = 0; direction < 2; direction++)
+            {
+                std::uint32_t from = direction == 0 ? edge.A : edge.B;
+                std::uint32_t to = direction == 0 ? edge.B : edge.A;
+
+                // borders only move along themselves.
+                if (IsLocked[from] || (IsBorder[from] && edge.Kind != EdgeKind::Border))
+                {
+                    continue;
+                }
+
+                double cost = Quadrics[from].Evaluate(Positions[to]);
+                if (cost <= maxCost)
+                {
+                    candidates.push_back(Candidate{cost, from, to});
+                }
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& x, const Candidate& y) {
+            return x.Cost < y.Cost;
+        });
+
+        // vertices around a collapse can't collapse again in the same pass,
+        // so the triangles around the ones that can are still as they were.
+        std::vector<std::uint8_t> touched(numWelded, 0);
+        std::size_t numTriangles = Triangles.size() / 3;
+        std::size_t numCollapsed = 0;
+
+        for (const Candidate& candidate : candidates)
+        {
+            if (numTriangles <= targetTriangles)
+            {
+                break;
+            }
+
+            std::uint32_t a = candidate.From;
+            std::uint32_t b = candidate.To;
+            if (touched[a] || touched[b] || !CanCollapse(a, b))
+            {
+                continue;
+            }
+
+            for (std::uint32_t i = FirstAdjacent[a]; i < FirstAdjacent[a + 1]; i++)
+            {
+                std::uint32_t* triangle = &Triangles[3 * Adjacent[i]];
+
+                bool hasB = false;
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    touched[Weld[triangle[corner]]] = 1;
+                    hasB = hasB || Weld[triangle[corner]] == b;
+                }
+
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    for (const std::pair<std::uint32_t, std::uint32_t>& m : Mapping)
+                    {
+                        if (triangle[corner] == m.first)
+                        {
+                            triangle[corner] = m.second;
+                            break;
+                        }
+                    }
+                }
+
+                numTriangles -= hasB;
+            }
+
+            Quadrics[b].Add(Quadrics[a]);
+            maxCollapsed = std::max(maxCollapsed, candidate.Cost);
+            numCollapsed++;
+        }
+
+        // drops the triangles that collapsed.
+        std::size_t numKept = 0;
+        for (std::size_t i = 0; i < Triangles.size(); i += 3)
+        {
+            std::uint32_t w0 = Weld[Triangles[i]];
+            std::uint32_t w1 = Weld[Triangles[i + 1]];
+            std::uint32_t w2 = Weld[Triangles[i + 2]];
+
+            if (w0 != w1 && w1 != w2 && w2 != w0)
+            {
+                std::copy(&Triangles[i], &Triangles[i] + 3, &Triangles[numKept]);
+                numKept += 3;
+            }
+        }
+        Triangles.resize(numKept);
+
+        return numCollapsed;
+    }
+};
+
+} // end anonymous namespace
+
+SimplifiedMesh::SimplifiedMesh(VertexFormat vertexFormat,
+                               std::vector<char> vertices, std::size_t numVertices,
+                               const std::vector<std::uint32_t>& indices,
+                               float error)
+    : mVertexFormat(vertexFormat)
+    , mVertices(std::move(vertices))
+    , mNumVertices(numVertices)
+    , mNumIndices(indices.size())
+    , mError(error)
+{
+    mVertexFormat.PrimitiveType = PrimitiveType::Triangles;
+    mVertexFormat.IsIndexed = true;
+    mVertexFormat.IndexOffset = 0;
+    mVertexFormat.IndexType = numVertices <= 0x10000 ? ArithmeticType::UInt16 : ArithmeticType::UInt32;
+
+    if (mVertexFormat.IndexType == ArithmeticType::UInt16)
+    {
+        mIndices.resize(indices.size() * sizeof(std::uint16_t));
+        std::uint16_t* out = reinterpret_cast<std::uint16_t*>(mIndices.data());
+        for (std::size_t i = 0; i < indices.size(); i++)
+        {
+            out[i] = std::uint16_t(indices[i]);
+        }
+    }
+    else
+    {
+        mIndices.resize(indices.size() * sizeof(std::uint32_t));
+        std::memcpy(mIndices.data(), indices.data(), mIndices.size());
+    }
+}
+
+VertexFormat SimplifiedMesh::GetVertexFormat() const
+{
+    return mVertexFormat;
+}
+
+std::size_t SimplifiedMesh::GetMaxVertexBufferSize() const
+{
+    return mVertices.size();
+}
+
+std::size_t SimplifiedMesh::GetMaxIndexBufferSize() const
+{
+    return mIndices.size();
+}
+
+std::size_t SimplifiedMesh::WriteVertices(void* buffer) const
+{
+    if (buffer)
+    {
+        std::memcpy(buffer, mVertices.data(), mVertices.size());
+    }
+
+    return mNumVertices;
+}
+
+std::size_t SimplifiedMesh::WriteIndices(void* buffer) const
+{
+    if (buffer)
+    {
+        std::memcpy(buffer, mIndices.data(), mIndices.size());
+    }
+
+    return mNumIndices;
+}
+
+std::shared_ptr<SimplifiedMesh> SimplifyMesh(const IMesh& mesh, std::size_t targetTriangles, float maxError)
+{
+    VertexFormat packedFormat;
+    std::size_t stride, numVertices;
+    std::vector<char> packed = PackVertices(mesh, packedFormat, stride, numVertices);
+
+    std::vector<vec3> positions;
+    std::vector<std::uint32_t> indices;
+    ReadTriangles(mesh, packedFormat, packed.data(), numVertices, positions, indices);
+
+    // vertices with all the same attributes are the same vertex.
+    std::uint32_t numUnique;
+    std::vector<std::uint32_t> unique = GroupIds(
+        numVertices,
+        [&](std::uint32_t a, std::uint32_t b) {
+            return std::memcmp(&packed[a * stride], &packed[b * stride], stride) < 0;
+        },
+        [&](std::uint32_t a, std::uint32_t b) {
+            return std::memcmp(&packed[a * stride], &packed[b * stride], stride) == 0;
+        },
+        numUnique);
+
+    std::vector<std::uint32_t> sourceOfUnique(numUnique);
+    for (std::uint32_t i = 0; i < numVertices; i++)
+    {
+        sourceOfUnique[unique[i]] = i;
+    }
+
+    // and vertices at the same position are welded together.
+    Simplifier simplifier;
+
+    std::uint32_t numWelded;
+    simplifier.Weld = GroupIds(
+        numUnique,
+        [&](std::uint32_t a, std::uint32_t b) {
+            const vec3& pa = positions[sourceOfUnique[a]];
+            const vec3& pb = positions[sourceOfUnique[b]];
+            return pa.x != pb.x ? pa.x < pb.x : pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z;
+        },
+        [&](std::uint32_t a, std::uint32_t b) {
+            return positions[sourceOfUnique[a]] == positions[sourceOfUnique[b]];
+        },
+        numWelded);
+
+    simplifier.Positions.resize(numWelded);
+    for (std::uint32_t u = 0; u < numUnique; u++)
+    {
+        simplifier.Positions[simplifier.Weld[u]] = positions[sourceOfUnique[u]];
+    }
+
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        std::uint32_t corners[3] = { unique[indices[i]], unique[indices[i + 1]], unique[indices[i + 2]] };
+        std::uint32_t w0 = simplifier.Weld[corners[0]];
+        std::uint32_t w1 = simplifier.Weld[corners[1]];
+        std::uint32_t w2 = simplifier.Weld[corners[2]];
+
+        if (w0 != w1 && w1 != w2 && w2 != w0)
+        {
+            simplifier.Triangles.insert(simplifier.Triangles.end(), corners, corners + 3);
+        }
+    }
+
+    simplifier.BuildQuadrics();
+
+    double maxCost = double(maxError) * maxError;
+    double maxCollapsed = 0.0;
+
+    while (simplifier.Triangles.size() / 3 > targetTriangles)
+    {
+        if (simplifier.Pass(targetTriangles, maxCost, maxCollapsed) == 0)
+        {
+            break;
+        }
+    }
+
+    // only the vertices that are left are kept.
+    std::vector<std::uint32_t> newIndexOfUnique(numUnique, std::numeric_limits<std::uint32_t>::max());
+    std::vector<char> vertices;
+    std::vector<std::uint32_t> newIndices;
+    newIndices.reserve(simplifier.Triangles.size());
+
+    std::size_t numNewVertices = 0;
+    for (std::uint32_t u : simplifier.Triangles)
+    {
+        if (newIndexOfUnique[u] == std::numeric_limits<std::uint32_t>::max())
+        {
+            newIndexOfUnique[u] = std::uint32_t(numNewVertices++);
+            const char* vertex = &packed[sourceOfUnique[u] * stride];
+            vertices.insert(vertices.end(), vertex, vertex + stride);
+        }
+
+        newIndices.push_back(newIndexOfUnique[u]);
+    }
+
+    return std::make_shared<SimplifiedMesh>(
+                packedFormat, std::move(vertices), numNewVertices,
+                newIndices, float(std::sqrt(maxCollapsed)));
+}
+
+std::vector<std::shared_ptr<SimplifiedMesh>> BuildLodChain(
+        const IMesh& mesh, std::size_t maxLevels, std::size_t minTriangles)
+{
+    std::vector<vec3> positions;
+    std::vector<std::uint32_t> indices;
+    ReadTriangles(mesh, positions, indices);
+
+    std::vector<std::shared_ptr<SimplifiedMesh>> levels;
+    std::size_t numTriangles = indices.size() / 3;
+
+    while (levels.size() < maxLevels && numTriangles / 2 >= minTriangles)
+    {
+        // each level starts over from the original, so errors don't add up.
+        std::shared_ptr<SimplifiedMesh> level = SimplifyMesh(mesh, numTriangles / 2);
+
+        if (level->GetNumTriangles() > numTriangles * 3 / 4)
+        {
+            break;
+        }
+
+        numTriangles = level->GetNumTriangles();
+        levels.push_back(std::move(level));
+    }
+
+    return levels;
+}
+
+} // end namespace ng
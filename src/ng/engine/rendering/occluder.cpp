@@ -0,0 +1,13 @@
+#include "ng/engine/rendering/occluder.hpp"
+
+#include "ng/engine/rendering/mesh.hpp"
+
+namespace ng
+{
+
+OccluderMesh::OccluderMesh(const IMesh& mesh)
+{
+    ReadTriangles(mesh, Positions, Indices);
+}
+
+} // end namespace ng
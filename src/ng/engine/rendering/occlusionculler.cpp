@@ -0,0 +1,503 @@
+#include "ng/engine/rendering/occlusionculler.hpp"
+
+#include "ng/engine/util/parallelfor.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+namespace ng
+{
+
+namespace
+{
+
+// tiles are rasterized 4 pixels at a time, so their width is a multiple of 4.
+const int kTileWidth = 32;
+const int kTileHeight = 32;
+
+const std::size_t kObjectsPerTask = 1024;
+
+double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(
+                std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// where an edge of the polygon crosses the near plane.
+vec4 ClipToNear(const vec4& inside, const vec4& outside)
+{
+    float insideDistance = inside.z + inside.w;
+    float outsideDistance = outside.z + outside.w;
+    float t = insideDistance / (insideDistance - outsideDistance);
+    return inside + (outside - inside) * t;
+}
+
+} // end anonymous namespace
+
+OcclusionCuller::OcclusionCuller(int width, int height, std::size_t numWorkers)
+    : mNumWorkers(numWorkers)
+{
+    if (width <= 0 || height <= 0)
+    {
+        throw std::logic_error("OcclusionCuller needs a depth buffer of at least one pixel");
+    }
+
+    mNumTilesX = (width + kTileWidth - 1) / kTileWidth;
+    mNumTilesY = (height + kTileHeight - 1) / kTileHeight;
+    mWidth = mNumTilesX * kTileWidth;
+    mHeight = mNumTilesY * kTileHeight;
+
+    mTileBins.resize(mNumTilesX * mNumTilesY);
+
+    int levelWidth = mWidth;
+    int levelHeight = mHeight;
+    for (;;)
+    {
+        mLevels.emplace_back(std::size_t(levelWidth) * levelHeight, 1.0f);
+        mLevelWidths.push_back(levelWidth);
+        mLevelHeights.push_back(levelHeight);
+
+        if (levelWidth == 1 && levelHeight == 1)
+        {
+            break;
+        }
+
+        levelWidth = (levelWidth + 1) / 2;
+        levelHeight = (levelHeight + 1) / 2;
+    }
+}
+
+void OcclusionCuller::AddTriangle(const vec4& a, const vec4& b, const vec4& c)
+{
+    const vec4* corners[3] = { &a, &b, &c };
+
+    // entirely outside one of the planes other than the near one.
+    for (int axis = 0; axis < 2; axis++)
+    {
+        if ((a[axis] > a.w && b[axis] > b.w && c[axis] > c.w) ||
+            (a[axis] < -a.w && b[axis] < -b.w && c[axis] < -c.w))
+        {
+            return;
+        }
+    }
+
+    if (a.z > a.w && b.z > b.w && c.z > c.w)
+    {
+        return;
+    }
+
+    int numInside = 0;
+    for (const vec4* corner : corners)
+    {
+        numInside += corner->z + corner->w >= 0.0f;
+    }
+
+    if (numInside == 3)
+    {
+        AddClippedTriangle(a, b, c);
+        return;
+    }
+
+    if (numInside == 0)
+    {
+        return;
+    }
+
+    // clips the triangle to the near plane, leaving one or two triangles.
+    vec4 polygon[4];
+    int numVertices = 0;
+
+    for (int i = 0; i < 3; i++)
+    {
+        const vec4& current = *corners[i];
+        const vec4& next = *corners[(i + 1) % 3];
+
+        bool currentInside = current.z + current.w >= 0.0f;
+        bool nextInside = next.z + next.w >= 0.0f;
+
+        if (currentInside)
+        {
+            polygon[numVertices++] = current;
+        }
+
+        if (currentInside != nextInside)
+        {
+            polygon[numVertices++] = currentInside
+                    ? ClipToNear(current, next)
+                    : ClipToNear(next, current);
+        }
+    }
+
+    for (int i = 2; i < numVertices; i++)
+    {
+        AddClippedTriangle(polygon[0], polygon[i - 1], polygon[i]);
+    }
+}
+
+void OcclusionCuller::AddClippedTriangle(const vec4& a, const vec4& b, const vec4& c)
+{
+    vec3 screen[3];
+    const vec4* corners[3] = { &a, &b, &c };
+
+    for (int i = 0; i < 3; i++)
+    {
+        const vec4& corner = *corners[i];
+        screen[i] = vec3((corner.x / corner.w * 0.5f + 0.5f) * mWidth,
+                         (corner.y / corner.w * 0.5f + 0.5f) * mHeight,
+                         corner.z / corner.w * 0.5f + 0.5f);
+    }
+
+    float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y)
+               - (screen[2].x - screen[0].x) * (screen[1].y - screen[0].y);
+
+    if (std::abs(area) < 1e-8f)
+    {
+        return;
+    }
+
+    ScreenTriangle triangle;
+
+    // the pixels whose centers are within the triangle's bounds.
+    float minX = std::min(screen[0].x, std::min(screen[1].x, screen[2].x));
+    float maxX = std::max(screen[0].x, std::max(screen[1].x, screen[2].x));
+    float minY = std::min(screen[0].y, std::min(screen[1].y, screen[2].y));
+    float maxY = std::max(screen[0].y, std::max(screen[1].y, screen[2].y));
+
+    triangle.MinX = std::max(0, int(std::ceil(minX - 0.5f)));
+    triangle.MaxX = std::min(mWidth - 1, int(std::floor(maxX - 0.5f)));
+    triangle.MinY = std::max(0, int(std::ceil(minY - 0.5f)));
+    triangle.MaxY = std::min(mHeight - 1, int(std::floor(maxY - 0.5f)));
+
+    if (triangle.MinX > triangle.MaxX || triangle.MinY > triangle.MaxY)
+    {
+        return;
+    }
+
+    // edges go counter-clockwise, so the inside is on their left.
+    float orientation = area > 0.0f ? 1.0f : -1.0f;
+    for (int edge = 0; edge < 3; edge++)
+    {
+        const vec3& from = screen[edge];
+        const vec3& to = screen[(edge + 1) % 3];
+
+        triangle.EdgeA[edge] = orientation * (from.y - to.y);
+        triangle.EdgeB[edge] = orientation * (to.x - from.x);
+        triangle.EdgeC[edge] = orientation * (from.x * to.y - from.y * to.x);
+    }
+
+    float dz1 = screen[1].z - screen[0].z;
+    float dz2 = screen[2].z - screen[0].z;
+
+    triangle.DepthA = (dz1 * (screen[2].y - screen[0].y) - dz2 * (screen[1].y - screen[0].y)) / area;
+    triangle.DepthB = (dz2 * (screen[1].x - screen[0].x) - dz1 * (screen[2].x - screen[0].x)) / area;
+    triangle.DepthC = screen[0].z - triangle.DepthA * screen[0].x - triangle.DepthB * screen[0].y;
+
+    std::uint32_t index = std::uint32_t(mTriangles.size());
+    mTriangles.push_back(triangle);
+
+    for (int tileY = triangle.MinY / kTileHeight; tileY <= triangle.MaxY / kTileHeight; tileY++)
+    {
+        for (int tileX = triangle.MinX / kTileWidth; tileX <= triangle.MaxX / kTileWidth; tileX++)
+        {
+            mTileBins[tileY * mNumTilesX + tileX].push_back(index);
+        }
+    }
+}
+
+void OcclusionCuller::RasterizeTile(int tile)
+{
+    int tileMinX = (tile % mNumTilesX) * kTileWidth;
+    int tileMinY = (tile / mNumTilesX) * kTileHeight;
+    int tileMaxX = tileMinX + kTileWidth - 1;
+    int tileMaxY = tileMinY + kTileHeight - 1;
+
+    float* depthBuffer = mLevels.front().data();
+
+    for (std::uint32_t index : mTileBins[tile])
+    {
+        const ScreenTriangle& triangle = mTriangles[index];
+
+        // rows are rasterized from a multiple of 4, which stays in the tile.
+        int minX = std::max(tileMinX, triangle.MinX) & ~3;
+        int maxX = std::min(tileMaxX, triangle.MaxX);
+        int minY = std::max(tileMinY, triangle.MinY);
+        int maxY = std::min(tileMaxY, triangle.MaxY);
+
+        for (int y = minY; y <= maxY; y++)
+        {
+            float centerY = y + 0.5f;
+            float* row = depthBuffer + std::size_t(y) * mWidth;
+
+            float rowEdges[3];
+            for (int edge = 0; edge < 3; edge++)
+            {
+                rowEdges[edge] = triangle.EdgeB[edge] * centerY + triangle.EdgeC[edge];
+            }
+            float rowDepth = triangle.DepthB * centerY + triangle.DepthC;
+
+#if defined(__SSE__)
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+            for (int x = minX; x <= maxX; x += 4)
+            {
+                __m128 centerX = _mm_add_ps(_mm_set1_ps(float(x)), offsets);
+
+                __m128 inside = _mm_cmpge_ps(
+                            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.EdgeA[0]), centerX), _mm_set1_ps(rowEdges[0])),
+                            zero);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(
+                            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.EdgeA[1]), centerX), _mm_set1_ps(rowEdges[1])),
+                            zero));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(
+                            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.EdgeA[2]), centerX), _mm_set1_ps(rowEdges[2])),
+                            zero));
+
+                __m128 depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.DepthA), centerX), _mm_set1_ps(rowDepth));
+
+                __m128 previous = _mm_loadu_ps(row + x);
+                __m128 nearest = _mm_min_ps(previous, depth);
+
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, previous)));
+            }
+#else
+            for (int x = minX; x <= maxX; x++)
+            {
+                float centerX = x + 0.5f;
+
+                if (triangle.EdgeA[0] * centerX + rowEdges[0] >= 0.0f &&
+                    triangle.EdgeA[1] * centerX + rowEdges[1] >= 0.0f &&
+                    triangle.EdgeA[2] * centerX + rowEdges[2] >= 0.0f)
+                {
+                    row[x] = std::min(row[x], triangle.DepthA * centerX + rowDepth);
+                }
+            }
+#endif
+        }
+    }
+}
+
+void OcclusionCuller::BuildPyramid()
+{
+    for (std::size_t level = 1; level < mLevels.size(); level++)
+    {
+        const std::vector<float>& below = mLevels[level - 1];
+        int belowWidth = mLevelWidths[level - 1];
+        int belowHeight = mLevelHeights[level - 1];
+
+        std::vector<float>& current = mLevels[level];
+        int width = mLevelWidths[level];
+        int height = mLevelHeights[level];
+
+        for (int y = 0; y < height; y++)
+        {
+            int y0 = 2 * y;
+            int y1 = std::min(2 * y + 1, belowHeight - 1);
+
+            for (int x = 0; x < width; x++)
+            {
+                int x0 = 2 * x;
+                int x1 = std::min(2 * x + 1, belowWidth - 1);
+
+                current[y * width + x] = std::max(
+                            std::max(below[y0 * belowWidth + x0], below[y0 * belowWidth + x1]),
+                            std::max(below[y1 * belowWidth + x0], below[y1 * belowWidth + x1]));
+            }
+        }
+    }
+}
+
+void OcclusionCuller::RenderOccluders(const RenderCamera& camera, const std::vector<Occluder>& occluders,
+                                      OcclusionStats* stats)
+{
+    auto rasterizeStart = std::chrono::high_resolution_clock::now();
+
+    mViewProjection = camera.Projection * camera.WorldView;
+
+    mTriangles.clear();
+    for (std::vector<std::uint32_t>& bin : mTileBins)
+    {
+        bin.clear();
+    }
+
+    std::size_t numOccluderTriangles = 0;
+    std::vector<vec4> clipPositions;
+
+    for (const Occluder& occluder : occluders)
+    {
+        if (occluder.Mesh == nullptr)
+        {
+            continue;
+        }
+
+        const OccluderMesh& mesh = *occluder.Mesh;
+        mat4 worldViewProjection = mViewProjection * occluder.WorldTransform;
+
+        clipPositions.resize(mesh.Positions.size());
+        for (std::size_t i = 0; i < mesh.Positions.size(); i++)
+        {
+            clipPositions[i] = worldViewProjection * vec4(mesh.Positions[i], 1.0f);
+        }
+
+        for (std::size_t i = 0; i + 2 < mesh.Indices.size(); i += 3)
+        {
+            AddTriangle(clipPositions[mesh.Indices[i]],
+                        clipPositions[mesh.Indices[i + 1]],
+                        clipPositions[mesh.Indices[i + 2]]);
+        }
+
+        numOccluderTriangles += mesh.Indices.size() / 3;
+    }
+
+    std::fill(mLevels.front().begin(), mLevels.front().end(), 1.0f);
+
+    parallel_for(mTileBins.size(), mNumWorkers, [&](std::size_t tile)
+    {
+        RasterizeTile(int(tile));
+    });
+
+    double rasterizeMs = MillisecondsSince(rasterizeStart);
+
+    auto pyramidStart = std::chrono::high_resolution_clock::now();
+    BuildPyramid();
+    double pyramidMs = MillisecondsSince(pyramidStart);
+
+    if (stats != nullptr)
+    {
+        stats->NumOccluderTriangles += numOccluderTriangles;
+        stats->RasterizeMilliseconds += rasterizeMs;
+        stats->PyramidMilliseconds += pyramidMs;
+    }
+}
+
+bool OcclusionCuller::IsOccluded(const AxisAlignedBoundingBox<float>& worldBounds) const
+{
+    float minX = std::numeric_limits<float>::infinity();
+    float minY = minX;
+    float maxX = -minX;
+    float maxY = -minX;
+    float minDepth = minX;
+
+    for (int corner = 0; corner < 8; corner++)
+    {
+        vec4 position = mViewProjection * vec4(
+                    (corner & 1) ? worldBounds.Maximum.x : worldBounds.Minimum.x,
+                    (corner & 2) ? worldBounds.Maximum.y : worldBounds.Minimum.y,
+                    (corner & 4) ? worldBounds.Maximum.z : worldBounds.Minimum.z,
+                    1.0f);
+
+        // also catches infinite bounds, which end up as NaN or infinity.
+        if (!(position.z + position.w >= 0.0f) || !(position.w > 0.0f) || !std::isfinite(position.w))
+        {
+            return false;
+        }
+
+        float x = (position.x / position.w * 0.5f + 0.5f) * mWidth;
+        float y = (position.y / position.w * 0.5f + 0.5f) * mHeight;
+        float depth = position.z / position.w * 0.5f + 0.5f;
+
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        minDepth = std::min(minDepth, depth);
+    }
+
+    if (maxX < 0.0f || maxY < 0.0f || minX >= mWidth || minY >= mHeight)
+    {
+        return false;
+    }
+
+    // every pixel the box's rectangle touches.
+    int x0 = std::max(0, int(std::floor(minX)));
+    int x1 = std::min(mWidth - 1, int(std::floor(maxX)));
+    int y0 = std::max(0, int(std::floor(minY)));
+    int y1 = std::min(mHeight - 1, int(std::floor(maxY)));
+
+    // the first level where the rectangle covers at most 2x2 texels.
+    std::size_t level = 0;
+    while ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)
+    {
+        level++;
+    }
+
+    const std::vector<float>& depths = mLevels[level];
+    int width = mLevelWidths[level];
+
+    for (int y = y0 >> level; y <= y1 >> level; y++)
+    {
+        for (int x = x0 >> level; x <= x1 >> level; x++)
+        {
+            if (minDepth <= depths[y * width + x])
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+OcclusionStats OcclusionCuller::Cull(RenderBatch& batch, const std::vector<Occluder>& occluders)
+{
+    OcclusionStats stats;
+
+    std::vector<RenderObject>& objects = batch.RenderObjects;
+    if (occluders.empty() || batch.RenderCameras.empty() || objects.empty())
+    {
+        return stats;
+    }
+
+    // objects stay if any camera sees them.
+    std::vector<std::uint8_t> occluded(objects.size(), 1);
+
+    for (const RenderCamera& camera : batch.RenderCameras)
+    {
+        RenderOccluders(camera, occluders, &stats);
+
+        auto testStart = std::chrono::high_resolution_clock::now();
+
+        std::size_t numTasks = (objects.size() + kObjectsPerTask - 1) / kObjectsPerTask;
+        parallel_for(numTasks, mNumWorkers, [&](std::size_t task)
+        {
+            std::size_t begin = task * kObjectsPerTask;
+            std::size_t end = std::min(begin + kObjectsPerTask, objects.size());
+
+            for (std::size_t i = begin; i < end; i++)
+            {
+                if (occluded[i] && !IsOccluded(objects[i].WorldBounds))
+                {
+                    occluded[i] = 0;
+                }
+            }
+        });
+
+        stats.TestMilliseconds += MillisecondsSince(testStart);
+    }
+
+    // keeps the order of the objects that are left.
+    std::size_t numVisible = 0;
+    for (std::size_t i = 0; i < objects.size(); i++)
+    {
+        if (!occluded[i])
+        {
+            objects[numVisible++] = objects[i];
+        }
+    }
+
+    stats.NumTested = objects.size();
+    stats.NumOccluded = objects.size() - numVisible;
+
+    objects.resize(numVisible);
+
+    return stats;
+}
+
+} // end namespace ng
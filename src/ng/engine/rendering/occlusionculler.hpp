@@ -0,0 +1,105 @@
+#ifndef NG_OCCLUSIONCULLER_HPP
+#define NG_OCCLUSIONCULLER_HPP
+
+#include "ng/engine/rendering/occluder.hpp"
+#include "ng/engine/rendering/renderbatch.hpp"
+
+#include "ng/engine/math/linearalgebra.hpp"
+#include "ng/engine/math/geometry.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ng
+{
+
+// Culls the objects hidden behind occluders, entirely on the CPU.
+//
+// The occluders are rasterized into a small depth buffer, split into
+// tiles that workers rasterize in parallel. A pyramid of the furthest
+// depth of each 2x2 block is built on top of it, so an object's bounds
+// are tested against at most 4 texels of the level that matches their
+// size on screen.
+//
+// Occluders are sampled at the center of pixels, so an object seen
+// through a gap narrower than a pixel of the depth buffer can be culled.
+class OcclusionCuller
+{
+    int mWidth;
+    int mHeight;
+    std::size_t mNumWorkers;
+
+    int mNumTilesX;
+    int mNumTilesY;
+
+    mat4 mViewProjection;
+
+    // each level is half the size of the previous one. the first is the
+    // depth buffer, with depths from 0 (near) to 1 (far).
+    std::vector<std::vector<float>> mLevels;
+    std::vector<int> mLevelWidths;
+    std::vector<int> mLevelHeights;
+
+    class ScreenTriangle
+    {
+    public:
+        // inside where all three are >= 0: EdgeA * x + EdgeB * y + EdgeC
+        float EdgeA[3];
+        float EdgeB[3];
+        float EdgeC[3];
+
+        // DepthA * x + DepthB * y + DepthC
+        float DepthA;
+        float DepthB;
+        float DepthC;
+
+        // the pixels whose center may be inside, on screen.
+        int MinX, MinY, MaxX, MaxY;
+    };
+
+    std::vector<ScreenTriangle> mTriangles;
+    std::vector<std::vector<std::uint32_t>> mTileBins;
+
+    void AddTriangle(const vec4& a, const vec4& b, const vec4& c);
+    void AddClippedTriangle(const vec4& a, const vec4& b, const vec4& c);
+    void RasterizeTile(int tile);
+    void BuildPyramid();
+
+public:
+    // the depth buffer's size is rounded up to a whole number of tiles.
+    explicit OcclusionCuller(int width = 256, int height = 128, std::size_t numWorkers = 1);
+
+    int GetWidth() const
+    {
+        return mWidth;
+    }
+
+    int GetHeight() const
+    {
+        return mHeight;
+    }
+
+    // clears the depth buffer, then rasterizes the occluders as seen
+    // through the camera, and builds the pyramid.
+    void RenderOccluders(const RenderCamera& camera, const std::vector<Occluder>& occluders,
+                         OcclusionStats* stats = nullptr);
+
+    // whether a box is entirely hidden behind the occluders rendered last.
+    // boxes crossing the near plane or outside the view never are.
+    bool IsOccluded(const AxisAlignedBoundingBox<float>& worldBounds) const;
+
+    // the depth buffer of the occluders rendered last, one row after the other.
+    const std::vector<float>& GetDepthBuffer() const
+    {
+        return mLevels.front();
+    }
+
+    // removes the scene objects that the occluders hide from all the
+    // batch's cameras. The overlay isn't touched.
+    OcclusionStats Cull(RenderBatch& batch, const std::vector<Occluder>& occluders);
+};
+
+} // end namespace ng
+
+#endif // NG_OCCLUSIONCULLER_HPP
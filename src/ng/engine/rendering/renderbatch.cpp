@@ -1,15 +1,25 @@
 #include "ng/engine/rendering/renderbatch.hpp"
 
 #include "ng/engine/rendering/scenegraph.hpp"
+#include "ng/engine/rendering/flatscenegraph.hpp"
+#include "ng/engine/rendering/scenesnapshot.hpp"
+#include "ng/engine/rendering/scenebvh.hpp"
 
 #include "ng/engine/util/scopeguard.hpp"
+#include "ng/engine/util/parallelfor.hpp"
+
+#include <algorithm>
+#include <stdexcept>
 
 namespace ng
 {
 
+const std::uint32_t RenderObject::kNoNode;
+
 static void ConvertToRenderBatch(
         const std::shared_ptr<const SceneGraphNode>& node,
         const std::vector<std::shared_ptr<SceneGraphCameraNode>>& cameras,
+        RenderResources& resources,
         mat4 modelView,
         std::vector<RenderObject>& renderObjects,
         std::vector<RenderCamera>& renderCameras)
@@ -25,11 +35,18 @@ static void ConvertToRenderBatch(
 
     if (node->Mesh != nullptr)
     {
+        MeshHandle mesh = resources.AddTransientMesh(node->Mesh);
+        MaterialHandle material = resources.AddTransientMaterial(node->Material);
+
         renderObjects.push_back(
                     RenderObject{
-                        node->Mesh,
-                        node->Material,
-                        modelView});
+                        mesh,
+                        material,
+                        modelView,
+                        InfiniteBounds<float>(),
+                        RenderObject::kNoNode,
+                        0,
+                        MakeDrawKey(mesh, material)});
     }
 
     // check if we're visiting a camera
@@ -61,13 +78,14 @@ static void ConvertToRenderBatch(
         ConvertToRenderBatch(
                     child,
                     cameras,
+                    resources,
                     modelView,
                     renderObjects,
                     renderCameras);
     }
 }
 
-RenderBatch RenderBatch::FromScene(const SceneGraph& scene)
+RenderBatch RenderBatch::FromScene(const SceneGraph& scene, RenderResources& resources)
 {
     RenderBatch batch;
 
@@ -75,6 +93,7 @@ RenderBatch RenderBatch::FromScene(const SceneGraph& scene)
     ConvertToRenderBatch(
                 scene.Root,
                 scene.ActiveCameras,
+                resources,
                 mat4(),
                 batch.RenderObjects,
                 batch.RenderCameras);
@@ -83,6 +102,7 @@ RenderBatch RenderBatch::FromScene(const SceneGraph& scene)
     ConvertToRenderBatch(
                 scene.OverlayRoot,
                 scene.OverlayActiveCameras,
+                resources,
                 mat4(),
                 batch.OverlayRenderObjects,
                 batch.OverlayRenderCameras);
@@ -90,4 +110,192 @@ RenderBatch RenderBatch::FromScene(const SceneGraph& scene)
     return std::move(batch);
 }
 
+// works on anything with the flat arrays of FlatSceneGraph.
+// without a visible set, all the nodes with a mesh are drawn.
+template<class FlatScene>
+static RenderBatch FromFlatScene(const FlatScene& scene, const std::vector<std::uint8_t>* visible, std::size_t numWorkers)
+{
+    RenderBatch batch;
+
+    const std::vector<std::uint8_t>& flags = scene.GetFlags();
+    const std::vector<mat4>& worldTransforms = scene.GetWorldTransforms();
+    const std::vector<AxisAlignedBoundingBox<float>>& worldBounds = scene.GetWorldBounds();
+    const std::vector<MeshHandle>& meshes = scene.GetMeshes();
+    const std::vector<MaterialHandle>& materials = scene.GetMaterials();
+
+    auto isDrawn = [&](std::size_t node) {
+        return meshes[node] && (visible == nullptr || (*visible)[node]);
+    };
+
+    // nodes are split into fixed ranges, so the output doesn't depend
+    // on the number of workers. the objects in each range are counted
+    // first, then each range writes its objects at its own offset.
+    const std::size_t kNodesPerRange = 16384;
+
+    std::size_t numNodes = scene.GetNumNodes();
+    std::size_t numRanges = (numNodes + kNodesPerRange - 1) / kNodesPerRange;
+
+    std::vector<std::size_t> sceneOffsets(numRanges + 1, 0);
+    std::vector<std::size_t> overlayOffsets(numRanges + 1, 0);
+
+    parallel_for(numRanges, numWorkers, [&](std::size_t range)
+    {
+        std::size_t begin = range * kNodesPerRange;
+        std::size_t end = std::min(begin + kNodesPerRange, numNodes);
+
+        std::size_t numScene = 0;
+        std::size_t numOverlay = 0;
+
+        for (std::size_t i = begin; i < end; i++)
+        {
+            if (isDrawn(i))
+            {
+                if (flags[i] & FlatSceneGraph::kOverlayFlag)
+                {
+                    numOverlay++;
+                }
+                else
+                {
+                    numScene++;
+                }
+            }
+        }
+
+        sceneOffsets[range + 1] = numScene;
+        overlayOffsets[range + 1] = numOverlay;
+    });
+
+    for (std::size_t range = 0; range < numRanges; range++)
+    {
+        sceneOffsets[range + 1] += sceneOffsets[range];
+        overlayOffsets[range + 1] += overlayOffsets[range];
+    }
+
+    batch.RenderObjects.resize(sceneOffsets[numRanges]);
+    batch.OverlayRenderObjects.resize(overlayOffsets[numRanges]);
+
+    parallel_for(numRanges, numWorkers, [&](std::size_t range)
+    {
+        std::size_t begin = range * kNodesPerRange;
+        std::size_t end = std::min(begin + kNodesPerRange, numNodes);
+
+        RenderObject* sceneOut = batch.RenderObjects.data() + sceneOffsets[range];
+        RenderObject* overlayOut = batch.OverlayRenderObjects.data() + overlayOffsets[range];
+
+        for (std::size_t i = begin; i < end; i++)
+        {
+            if (!isDrawn(i))
+            {
+                continue;
+            }
+
+            MeshHandle mesh = meshes[i];
+
+            MaterialHandle material = materials[i];
+
+            RenderObject*& out = (flags[i] & FlatSceneGraph::kOverlayFlag)
+                    ? overlayOut
+                    : sceneOut;
+
+            *out++ = RenderObject{
+                        mesh,
+                        material,
+                        worldTransforms[i],
+                        worldBounds[i],
+                        std::uint32_t(i),
+                        0,
+                        MakeDrawKey(mesh, material)};
+        }
+    });
+
+    // cameras are flagged, so this doesn't search for them.
+    for (const std::pair<FlatSceneGraph::NodeIndex, FlatSceneCamera>& cam : scene.GetCameras())
+    {
+        std::uint8_t cameraFlags = flags[cam.first];
+        if (!(cameraFlags & FlatSceneGraph::kActiveCameraFlag))
+        {
+            continue;
+        }
+
+        std::vector<RenderCamera>& renderCameras =
+                (cameraFlags & FlatSceneGraph::kOverlayFlag)
+                ? batch.OverlayRenderCameras
+                : batch.RenderCameras;
+
+        // unlike SceneGraph cameras, which only use their own Transform,
+        // flat scene cameras are placed by their world transform, so a
+        // camera parented to a node moves with it.
+        renderCameras.push_back(
+                    RenderCamera{
+                        cam.second.Projection,
+                        inverse(worldTransforms[cam.first]),
+                        cam.second.ViewportTopLeft,
+                        cam.second.ViewportSize});
+    }
+
+    return batch;
+}
+
+RenderBatch RenderBatch::FromScene(const FlatSceneGraph& scene, std::size_t numWorkers)
+{
+    if (scene.HasStaleWorldTransforms())
+    {
+        throw std::logic_error("FlatSceneGraph has stale world transforms, "
+                               "call UpdateWorldTransforms() first");
+    }
+
+    return FromFlatScene(scene, nullptr, numWorkers);
+}
+
+RenderBatch RenderBatch::FromScene(const FlatSceneGraph& scene, const SceneBVH& bvh, std::size_t numWorkers)
+{
+    if (scene.HasStaleWorldTransforms())
+    {
+        throw std::logic_error("FlatSceneGraph has stale world transforms, "
+                               "call UpdateWorldTransforms() first");
+    }
+
+    if (bvh.GetVersion() != scene.GetVersion())
+    {
+        throw std::logic_error("SceneBVH doesn't match the scene, call Update() first");
+    }
+
+    const std::vector<std::uint8_t>& flags = scene.GetFlags();
+
+    // the overlay and the nodes without bounds aren't in the tree, so they're never culled.
+    std::vector<std::uint8_t> visible(scene.GetNumNodes());
+    for (std::size_t i = 0; i < visible.size(); i++)
+    {
+        visible[i] = (flags[i] & FlatSceneGraph::kOverlayFlag) || !(flags[i] & FlatSceneGraph::kBoundsFlag);
+    }
+
+    std::vector<FlatSceneGraph::NodeIndex> visibleNodes;
+    for (const std::pair<FlatSceneGraph::NodeIndex, FlatSceneCamera>& cam : scene.GetCameras())
+    {
+        std::uint8_t cameraFlags = flags[cam.first];
+        if (!(cameraFlags & FlatSceneGraph::kActiveCameraFlag) ||
+             (cameraFlags & FlatSceneGraph::kOverlayFlag))
+        {
+            continue;
+        }
+
+        Frustum<float> frustum(cam.second.Projection * inverse(scene.GetWorldTransforms()[cam.first]));
+
+        visibleNodes.clear();
+        bvh.QueryFrustum(frustum, visibleNodes);
+
+        for (FlatSceneGraph::NodeIndex node : visibleNodes)
+        {
+            visible[node] = 1;
+        }
+    }
+
+    return FromFlatScene(scene, &visible, numWorkers);
+}
+
+RenderBatch RenderBatch::FromScene(const SceneSnapshot& snapshot, std::size_t numWorkers)
+{
+    return FromFlatScene(snapshot, nullptr, numWorkers);
+}
+
 } // end namespace ng
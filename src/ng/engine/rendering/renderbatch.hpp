@@ -1,27 +1,56 @@
 #ifndef NG_RENDERBATCH_HPP
 #define NG_RENDERBATCH_HPP
 
-#include "ng/engine/rendering/material.hpp"
+#include "ng/engine/rendering/renderresources.hpp"
 
 #include "ng/engine/math/linearalgebra.hpp"
+#include "ng/engine/math/geometry.hpp"
 
-#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
 #include <vector>
 
 namespace ng
 {
 
-class IMesh;
 class SceneGraph;
+class FlatSceneGraph;
+class SceneSnapshot;
+class SceneBVH;
 
+// refers to its mesh and material by handle, so copying and sorting
+// render objects doesn't touch any reference counts.
 class RenderObject
 {
 public:
-    std::shared_ptr<IMesh> Mesh;
-    ng::Material Material;
+    MeshHandle Mesh;
+    MaterialHandle Material;
     mat4 WorldTransform;
+
+    // infinite if the object's bounds aren't known.
+    AxisAlignedBoundingBox<float> WorldBounds;
+
+    // the FlatSceneGraph or snapshot node the object came from, or kNoNode.
+    std::uint32_t Node;
+
+    // 0 for the full mesh, set when a coarser level of detail is picked.
+    std::uint32_t LodLevel;
+
+    // objects sorted by this are grouped by material, then by mesh.
+    std::uint64_t DrawKey;
+
+    static const std::uint32_t kNoNode = ~std::uint32_t(0);
 };
 
+inline std::uint64_t MakeDrawKey(MeshHandle mesh, MaterialHandle material)
+{
+    return (std::uint64_t(material.index) << 32) | mesh.index;
+}
+
+static_assert(std::is_trivially_copyable<RenderObject>::value,
+              "RenderObject should be cheap to copy around");
+
 class RenderCamera
 {
 public:
@@ -35,7 +64,20 @@ public:
 class RenderBatch
 {
 public:
-    static RenderBatch FromScene(const SceneGraph& scene);
+    // the scene's meshes and materials are added to the resources as
+    // transient resources, for the current frame.
+    static RenderBatch FromScene(const SceneGraph& scene, RenderResources& resources);
+
+    // the scene's world transforms must be up to date. With more than one
+    // worker, ranges of nodes are extracted in parallel, into the same
+    // order as with a single worker.
+    static RenderBatch FromScene(const FlatSceneGraph& scene, std::size_t numWorkers = 1);
+
+    // leaves out the objects outside the frustums of the scene's cameras.
+    // The tree must be updated after the scene's world transforms.
+    static RenderBatch FromScene(const FlatSceneGraph& scene, const SceneBVH& bvh, std::size_t numWorkers = 1);
+
+    static RenderBatch FromScene(const SceneSnapshot& snapshot, std::size_t numWorkers = 1);
 
     std::vector<RenderObject> RenderObjects;
     std::vector<RenderCamera> RenderCameras;
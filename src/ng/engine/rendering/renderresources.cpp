@@ -0,0 +1,348 @@
+#include "ng/engine/rendering/renderresources.hpp"
+
+#include "ng/engine/rendering/mesh.hpp"
+#include "ng/engine/rendering/meshsimplifier.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+
+namespace ng
+{
+
+MeshHandle RenderResources::InsertMesh(std::shared_ptr<IMesh> mesh, std::size_t numTriangles)
+{
+    MeshHandle handle = mMeshes.insert(MeshEntry{std::move(mesh), {}});
+    mMeshes.find(handle)->Lods.push_back(MeshLod{handle, 0.0f, numTriangles});
+    return handle;
+}
+
+MeshHandle RenderResources::InsertMeshLod(MeshHandle mesh, std::shared_ptr<IMesh> lod, float error, std::size_t numTriangles)
+{
+    const MeshEntry* entry = mMeshes.find(mesh);
+    if (entry == nullptr)
+    {
+        throw std::logic_error("AddMeshLod() of a stale or null mesh handle");
+    }
+
+    if (error < entry->Lods.back().Error)
+    {
+        throw std::logic_error("Levels of detail must be added from the finest to the coarsest");
+    }
+
+    MeshHandle handle = InsertMesh(std::move(lod), numTriangles);
+
+    // inserting may have moved the entry.
+    mMeshes.find(mesh)->Lods.push_back(MeshLod{handle, error, numTriangles});
+    return handle;
+}
+
+void RenderResources::EraseMesh(MeshHandle mesh, std::vector<MeshEntry>& removed)
+{
+    removed.push_back(mMeshes.erase(mesh));
+
+    // the levels may have been removed on their own already.
+    std::vector<MeshLod> lods = removed.back().Lods;
+    for (std::size_t i = 1; i < lods.size(); i++)
+    {
+        if (mMeshes.find(lods[i].Mesh) != nullptr)
+        {
+            EraseMesh(lods[i].Mesh, removed);
+        }
+    }
+}
+
+MeshHandle RenderResources::AddMesh(std::shared_ptr<IMesh> mesh)
+{
+    std::size_t numTriangles = mesh != nullptr ? GetMaxNumTriangles(*mesh) : 0;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    return InsertMesh(std::move(mesh), numTriangles);
+}
+
+TextureHandle RenderResources::AddTexture(std::shared_ptr<ITexture> texture)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mTextures.insert(std::move(texture));
+}
+
+MaterialHandle RenderResources::AddMaterial(Material material)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mMaterials.insert(std::move(material));
+}
+
+MeshHandle RenderResources::AddMeshLod(MeshHandle mesh, std::shared_ptr<IMesh> lod, float error)
+{
+    std::size_t numTriangles = lod != nullptr ? GetMaxNumTriangles(*lod) : 0;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    return InsertMeshLod(mesh, std::move(lod), error, numTriangles);
+}
+
+MeshHandle RenderResources::AddMeshWithLods(std::shared_ptr<IMesh> mesh,
+                                            std::size_t maxLevels,
+                                            std::size_t minTriangles)
+{
+    if (mesh == nullptr)
+    {
+        throw std::logic_error("AddMeshWithLods() needs a mesh");
+    }
+
+    std::vector<std::shared_ptr<SimplifiedMesh>> lods = BuildLodChain(*mesh, maxLevels, minTriangles);
+    std::size_t numTriangles = GetMaxNumTriangles(*mesh);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    MeshHandle handle = InsertMesh(std::move(mesh), numTriangles);
+    for (const std::shared_ptr<SimplifiedMesh>& lod : lods)
+    {
+        InsertMeshLod(handle, lod, lod->GetError(), lod->GetNumTriangles());
+    }
+
+    return handle;
+}
+
+// the removed resources are destroyed after unlocking, since
+// destroying them might take a while or need the lock itself.
+
+void RenderResources::RemoveMesh(MeshHandle mesh)
+{
+    std::vector<MeshEntry> removed;
+    std::lock_guard<std::mutex> lock(mMutex);
+    EraseMesh(mesh, removed);
+}
+
+void RenderResources::RemoveTexture(TextureHandle texture)
+{
+    std::shared_ptr<ITexture> removed;
+    std::lock_guard<std::mutex> lock(mMutex);
+    removed = mTextures.erase(texture);
+}
+
+void RenderResources::RemoveMaterial(MaterialHandle material)
+{
+    Material removed;
+    std::lock_guard<std::mutex> lock(mMutex);
+    removed = mMaterials.erase(material);
+}
+
+std::shared_ptr<IMesh> RenderResources::GetMesh(MeshHandle mesh) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const MeshEntry* found = mMeshes.find(mesh);
+    return found != nullptr ? found->Mesh : nullptr;
+}
+
+std::shared_ptr<ITexture> RenderResources::GetTexture(TextureHandle texture) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const std::shared_ptr<ITexture>* found = mTextures.find(texture);
+    return found != nullptr ? *found : nullptr;
+}
+
+bool RenderResources::TryGetMaterial(MaterialHandle material, Material& result) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const Material* found = mMaterials.find(material);
+    if (found == nullptr)
+    {
+        return false;
+    }
+
+    result = *found;
+    return true;
+}
+
+RenderResources::MaterialKey::MaterialKey(const Material& material)
+    : Type(material.Type)
+    , Tint(material.Tint)
+    , Texture0(material.Texture0.get())
+    , Sampler0(material.Sampler0)
+{ }
+
+bool RenderResources::MaterialKey::operator==(const MaterialKey& other) const
+{
+    return Type == other.Type &&
+           Tint == other.Tint &&
+           Texture0 == other.Texture0 &&
+           Sampler0.MinFilter == other.Sampler0.MinFilter &&
+           Sampler0.MagFilter == other.Sampler0.MagFilter &&
+           Sampler0.WrapX == other.Sampler0.WrapX &&
+           Sampler0.WrapY == other.Sampler0.WrapY &&
+           Sampler0.WrapZ == other.Sampler0.WrapZ;
+}
+
+std::size_t RenderResources::MaterialKeyHash::operator()(const MaterialKey& key) const
+{
+    std::size_t h = std::hash<const ITexture*>()(key.Texture0);
+
+    auto combine = [&h](std::uint32_t value) {
+        h ^= value + 0x9e3779b9 + (h << 6) + (h >> 2);
+    };
+
+    // the tint is hashed by its bits, std::hash<float> hashes bytes one by one.
+    for (int i = 0; i < 3; i++)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &key.Tint[i], sizeof(bits));
+        combine(bits);
+    }
+
+    combine(std::uint32_t(key.Type) |
+            std::uint32_t(key.Sampler0.MinFilter) << 4 |
+            std::uint32_t(key.Sampler0.MagFilter) << 8 |
+            std::uint32_t(key.Sampler0.WrapX) << 12 |
+            std::uint32_t(key.Sampler0.WrapY) << 16 |
+            std::uint32_t(key.Sampler0.WrapZ) << 20);
+
+    return h;
+}
+
+// finds a transient resource added in this frame or the previous one, and
+// moves it to this frame so it isn't removed.
+template<class Map>
+static bool FindTransient(Map& current, Map& previous,
+                          const typename Map::key_type& key,
+                          typename Map::mapped_type& handle)
+{
+    auto found = current.find(key);
+    if (found != current.end())
+    {
+        handle = found->second;
+        return true;
+    }
+
+    found = previous.find(key);
+    if (found == previous.end())
+    {
+        return false;
+    }
+
+    handle = found->second;
+    current.emplace(key, handle);
+    previous.erase(found);
+    return true;
+}
+
+MeshHandle RenderResources::AddTransientMesh(const std::shared_ptr<IMesh>& mesh)
+{
+    if (mesh == nullptr)
+    {
+        return MeshHandle();
+    }
+
+    TransientFrame& current = mTransientFrames[mCurrentTransientFrame];
+    TransientFrame& previous = mTransientFrames[1 - mCurrentTransientFrame];
+
+    MeshHandle handle;
+    if (!FindTransient(current.Meshes, previous.Meshes, mesh.get(), handle))
+    {
+        handle = AddMesh(mesh);
+        current.Meshes.emplace(mesh.get(), handle);
+    }
+
+    return handle;
+}
+
+MaterialHandle RenderResources::AddTransientMaterial(const Material& material)
+{
+    TransientFrame& current = mTransientFrames[mCurrentTransientFrame];
+    TransientFrame& previous = mTransientFrames[1 - mCurrentTransientFrame];
+
+    MaterialKey key(material);
+
+    MaterialHandle handle;
+    if (!FindTransient(current.Materials, previous.Materials, key, handle))
+    {
+        handle = AddMaterial(material);
+        current.Materials.emplace(key, handle);
+    }
+
+    return handle;
+}
+
+void RenderResources::AdvanceTransientFrame()
+{
+    mCurrentTransientFrame = 1 - mCurrentTransientFrame;
+
+    // what's left in the oldest frame wasn't used in the last one.
+    TransientFrame& oldest = mTransientFrames[mCurrentTransientFrame];
+
+    if (oldest.Meshes.empty() && oldest.Materials.empty())
+    {
+        return;
+    }
+
+    std::vector<MeshEntry> removedMeshes;
+    std::vector<Material> removedMaterials;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        removedMeshes.reserve(oldest.Meshes.size());
+        for (const std::pair<const IMesh* const, MeshHandle>& mesh : oldest.Meshes)
+        {
+            EraseMesh(mesh.second, removedMeshes);
+        }
+
+        removedMaterials.reserve(oldest.Materials.size());
+        for (const std::pair<const MaterialKey, MaterialHandle>& material : oldest.Materials)
+        {
+            removedMaterials.push_back(mMaterials.erase(material.second));
+        }
+    }
+
+    oldest.Meshes.clear();
+    oldest.Materials.clear();
+}
+
+const IMesh* RenderResources::ResolveMesh(MeshHandle mesh) const
+{
+    const MeshEntry* found = mMeshes.find(mesh);
+    return found != nullptr ? found->Mesh.get() : nullptr;
+}
+
+std::shared_ptr<IMesh> RenderResources::ResolveSharedMesh(MeshHandle mesh) const
+{
+    const MeshEntry* found = mMeshes.find(mesh);
+    return found != nullptr ? found->Mesh : nullptr;
+}
+
+const ITexture* RenderResources::ResolveTexture(TextureHandle texture) const
+{
+    const std::shared_ptr<ITexture>* found = mTextures.find(texture);
+    return found != nullptr ? found->get() : nullptr;
+}
+
+const Material* RenderResources::ResolveMaterial(MaterialHandle material) const
+{
+    return mMaterials.find(material);
+}
+
+const std::vector<MeshLod>* RenderResources::ResolveMeshLods(MeshHandle mesh) const
+{
+    const MeshEntry* found = mMeshes.find(mesh);
+    return found != nullptr ? &found->Lods : nullptr;
+}
+
+std::size_t RenderResources::GetNumMeshes() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mMeshes.size();
+}
+
+std::size_t RenderResources::GetNumTextures() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mTextures.size();
+}
+
+std::size_t RenderResources::GetNumMaterials() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mMaterials.size();
+}
+
+} // end namespace ng
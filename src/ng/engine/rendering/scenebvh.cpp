@@ -0,0 +1,447 @@
+#include "ng/engine/rendering/scenebvh.hpp"
+
+#include "ng/engine/rendering/bvhbuild.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace ng
+{
+
+const std::uint32_t SceneBVH::kNoNode;
+
+namespace
+{
+
+const std::size_t kMaxLeafSize = 4;
+
+// rebuilt once traversing the refitted tree costs this much more than right after building it.
+const float kMaxCostGrowth = 1.5f;
+
+class BuildItem
+{
+public:
+    FlatSceneGraph::NodeIndex Node;
+    AxisAlignedBoundingBox<float> Bounds;
+    vec3 Centroid;
+};
+
+bool SameBounds(const AxisAlignedBoundingBox<float>& a, const AxisAlignedBoundingBox<float>& b)
+{
+    return a.Minimum.x == b.Minimum.x && a.Minimum.y == b.Minimum.y && a.Minimum.z == b.Minimum.z &&
+           a.Maximum.x == b.Maximum.x && a.Maximum.y == b.Maximum.y && a.Maximum.z == b.Maximum.z;
+}
+
+bool IsInTree(std::uint8_t flags)
+{
+    return (flags & FlatSceneGraph::kBoundsFlag) && !(flags & FlatSceneGraph::kOverlayFlag);
+}
+
+// where a box is relative to a frustum.
+enum FrustumTest
+{
+    kOutside,
+    kIntersecting,
+    kInside
+};
+
+FrustumTest TestFrustum(const Frustum<float>& frustum, const AxisAlignedBoundingBox<float>& box)
+{
+    FrustumTest result = kInside;
+
+    for (const Plane<float>& plane : frustum.Planes)
+    {
+        vec3 outerCorner(
+            plane.Normal.x >= 0 ? box.Maximum.x : box.Minimum.x,
+            plane.Normal.y >= 0 ? box.Maximum.y : box.Minimum.y,
+            plane.Normal.z >= 0 ? box.Maximum.z : box.Minimum.z);
+
+        if (dot(plane.Normal, outerCorner) + plane.D < 0)
+        {
+            return kOutside;
+        }
+
+        vec3 innerCorner(
+            plane.Normal.x >= 0 ? box.Minimum.x : box.Maximum.x,
+            plane.Normal.y >= 0 ? box.Minimum.y : box.Maximum.y,
+            plane.Normal.z >= 0 ? box.Minimum.z : box.Maximum.z);
+
+        if (dot(plane.Normal, innerCorner) + plane.D < 0)
+        {
+            result = kIntersecting;
+        }
+    }
+
+    return result;
+}
+
+} // end anonymous namespace
+
+float SceneBVH::GetNodeCost(std::uint32_t node) const
+{
+    const Node& n = mNodes[node];
+    float area = n.Bounds.GetSurfaceArea();
+    return n.Left != 0 ? area : area * (n.ItemEnd - n.ItemBegin);
+}
+
+float SceneBVH::GetRelativeCost(float cost) const
+{
+    float rootArea = mNodes.empty() ? 0.0f : mNodes[0].Bounds.GetSurfaceArea();
+    return rootArea > 0.0f ? cost / rootArea : 0.0f;
+}
+
+void SceneBVH::Build(const FlatSceneGraph& scene)
+{
+    if (scene.HasStaleWorldTransforms())
+    {
+        throw std::logic_error("FlatSceneGraph has stale world transforms, "
+                               "call UpdateWorldTransforms() first");
+    }
+
+    const std::vector<std::uint8_t>& flags = scene.GetFlags();
+    const std::vector<AxisAlignedBoundingBox<float>>& worldBounds = scene.GetWorldBounds();
+
+    std::vector<BuildItem> items;
+    for (std::size_t i = 0; i < scene.GetNumNodes(); i++)
+    {
+        if (IsInTree(flags[i]))
+        {
+            items.push_back(BuildItem{NodeIndex(i), worldBounds[i], worldBounds[i].GetCenter()});
+        }
+    }
+
+    mNodes.clear();
+    mParents.clear();
+    mItems.clear();
+    mItemBounds.clear();
+    mLeaves.assign(items.size(), kNoNode);
+    mItemOfNode.assign(scene.GetNumNodes(), kNoNode);
+
+    mVersion = scene.GetVersion();
+    mNeedsRebuild = false;
+    mCost = 0.0f;
+    mNumBuilds++;
+
+    if (items.empty())
+    {
+        mBuildCost = 0.0f;
+        return;
+    }
+
+    mNodes.reserve(2 * items.size());
+    mParents.reserve(2 * items.size());
+
+    mNodes.push_back(Node{AxisAlignedBoundingBox<float>(), 0, 0, std::uint32_t(items.size())});
+    mParents.push_back(kNoNode);
+
+    std::vector<std::uint32_t> stack(1, 0);
+    while (!stack.empty())
+    {
+        std::uint32_t node = stack.back();
+        stack.pop_back();
+
+        BuildItem* begin = items.data() + mNodes[node].ItemBegin;
+        BuildItem* end = items.data() + mNodes[node].ItemEnd;
+
+        AxisAlignedBoundingBox<float> bounds = EmptyBounds();
+        for (BuildItem* item = begin; item != end; ++item)
+        {
+            bounds.AddBox(item->Bounds);
+        }
+        mNodes[node].Bounds = bounds;
+
+        int axis;
+        float position;
+        if (!FindSAHSplit(begin, end, bounds, kMaxLeafSize, axis, position))
+        {
+            continue;
+        }
+
+        BuildItem* middle = std::partition(begin, end, [&](const BuildItem& item) {
+            return item.Centroid[axis] < position;
+        });
+
+        std::uint32_t middleIndex = std::uint32_t(middle - items.data());
+        std::uint32_t left = std::uint32_t(mNodes.size());
+
+        mNodes[node].Left = left;
+        mNodes.push_back(Node{AxisAlignedBoundingBox<float>(), 0, mNodes[node].ItemBegin, middleIndex});
+        mNodes.push_back(Node{AxisAlignedBoundingBox<float>(), 0, middleIndex, mNodes[node].ItemEnd});
+        mParents.push_back(node);
+        mParents.push_back(node);
+
+        stack.push_back(left);
+        stack.push_back(left + 1);
+    }
+
+    mItems.reserve(items.size());
+    mItemBounds.reserve(items.size());
+    for (const BuildItem& item : items)
+    {
+        mItemOfNode[item.Node] = std::uint32_t(mItems.size());
+        mItems.push_back(item.Node);
+        mItemBounds.push_back(item.Bounds);
+    }
+
+    for (std::uint32_t node = 0; node < mNodes.size(); node++)
+    {
+        if (mNodes[node].Left == 0)
+        {
+            for (std::uint32_t item = mNodes[node].ItemBegin; item < mNodes[node].ItemEnd; item++)
+            {
+                mLeaves[item] = node;
+            }
+        }
+
+        mCost += GetNodeCost(node);
+    }
+
+    mBuildCost = GetRelativeCost(mCost);
+}
+
+void SceneBVH::Refit(const FlatSceneGraph& scene)
+{
+    if (scene.HasStaleWorldTransforms())
+    {
+        throw std::logic_error("FlatSceneGraph has stale world transforms, "
+                               "call UpdateWorldTransforms() first");
+    }
+
+    const std::vector<std::uint64_t>& nodeVersions = scene.GetNodeVersions();
+    const std::vector<std::uint8_t>& flags = scene.GetFlags();
+    const std::vector<AxisAlignedBoundingBox<float>>& worldBounds = scene.GetWorldBounds();
+
+    // the leaves of the nodes that changed, possibly more than once.
+    std::vector<std::uint32_t> changedLeaves;
+
+    std::size_t numNodes = std::min(mItemOfNode.size(), scene.GetNumNodes());
+    for (std::size_t i = 0; i < numNodes; i++)
+    {
+        if (nodeVersions[i] <= mVersion)
+        {
+            continue;
+        }
+
+        std::uint32_t item = mItemOfNode[i];
+        if (item != kNoNode)
+        {
+            mItemBounds[item] = worldBounds[i];
+            changedLeaves.push_back(mLeaves[item]);
+        }
+        else if (IsInTree(flags[i]))
+        {
+            mNeedsRebuild = true;
+        }
+    }
+
+    mVersion = scene.GetVersion();
+
+    std::sort(changedLeaves.begin(), changedLeaves.end());
+    changedLeaves.erase(std::unique(changedLeaves.begin(), changedLeaves.end()), changedLeaves.end());
+
+    for (std::uint32_t leaf : changedLeaves)
+    {
+        AxisAlignedBoundingBox<float> bounds = EmptyBounds();
+        for (std::uint32_t item = mNodes[leaf].ItemBegin; item < mNodes[leaf].ItemEnd; item++)
+        {
+            bounds.AddBox(mItemBounds[item]);
+        }
+
+        // walks up until a node's bounds don't change.
+        std::uint32_t node = leaf;
+        while (!SameBounds(mNodes[node].Bounds, bounds))
+        {
+            mCost -= GetNodeCost(node);
+            mNodes[node].Bounds = bounds;
+            mCost += GetNodeCost(node);
+
+            node = mParents[node];
+            if (node == kNoNode)
+            {
+                break;
+            }
+
+            bounds = mNodes[mNodes[node].Left].Bounds;
+            bounds.AddBox(mNodes[mNodes[node].Left + 1].Bounds);
+        }
+    }
+}
+
+bool SceneBVH::Update(const FlatSceneGraph& scene)
+{
+    if (mNumBuilds == 0 || mNeedsRebuild || scene.GetNumNodes() != mItemOfNode.size())
+    {
+        Build(scene);
+        return true;
+    }
+
+    Refit(scene);
+
+    if (mNeedsRebuild || GetCostGrowth() > kMaxCostGrowth)
+    {
+        Build(scene);
+        return true;
+    }
+
+    return false;
+}
+
+float SceneBVH::GetCostGrowth() const
+{
+    return mBuildCost > 0.0f ? GetRelativeCost(mCost) / mBuildCost : 1.0f;
+}
+
+void SceneBVH::QueryFrustum(const Frustum<float>& frustum, std::vector<NodeIndex>& nodes) const
+{
+    if (mNodes.empty())
+    {
+        return;
+    }
+
+    std::vector<std::uint32_t> stack(1, 0);
+    while (!stack.empty())
+    {
+        const Node& node = mNodes[stack.back()];
+        stack.pop_back();
+
+        FrustumTest test = TestFrustum(frustum, node.Bounds);
+        if (test == kOutside)
+        {
+            continue;
+        }
+
+        // everything under a node inside the frustum is visible, and
+        // the subtree's items are all next to each other.
+        if (test == kInside)
+        {
+            nodes.insert(nodes.end(), mItems.begin() + node.ItemBegin, mItems.begin() + node.ItemEnd);
+        }
+        else if (node.Left != 0)
+        {
+            stack.push_back(node.Left);
+            stack.push_back(node.Left + 1);
+        }
+        else
+        {
+            for (std::uint32_t item = node.ItemBegin; item < node.ItemEnd; item++)
+            {
+                if (FrustumAABBoxIntersect(frustum, mItemBounds[item]))
+                {
+                    nodes.push_back(mItems[item]);
+                }
+            }
+        }
+    }
+}
+
+void SceneBVH::QueryBox(const AxisAlignedBoundingBox<float>& box, std::vector<NodeIndex>& nodes) const
+{
+    if (mNodes.empty())
+    {
+        return;
+    }
+
+    std::vector<std::uint32_t> stack(1, 0);
+    while (!stack.empty())
+    {
+        const Node& node = mNodes[stack.back()];
+        stack.pop_back();
+
+        if (!AABBoxIntersect(node.Bounds, box))
+        {
+            continue;
+        }
+
+        if (node.Left != 0)
+        {
+            stack.push_back(node.Left);
+            stack.push_back(node.Left + 1);
+        }
+        else
+        {
+            for (std::uint32_t item = node.ItemBegin; item < node.ItemEnd; item++)
+            {
+                if (AABBoxIntersect(mItemBounds[item], box))
+                {
+                    nodes.push_back(mItems[item]);
+                }
+            }
+        }
+    }
+}
+
+bool SceneBVH::RayCast(const Ray<float>& ray, float tmin, float tmax, NodeIndex& node, float& t) const
+{
+    if (mNodes.empty())
+    {
+        return false;
+    }
+
+    float entry;
+    if (!RayAABBoxIntersect(ray, mNodes[0].Bounds, tmin, tmax, entry))
+    {
+        return false;
+    }
+
+    bool hit = false;
+
+    std::vector<std::pair<std::uint32_t, float>> stack(1, std::make_pair(0u, entry));
+    while (!stack.empty())
+    {
+        std::pair<std::uint32_t, float> top = stack.back();
+        stack.pop_back();
+
+        // something closer was hit since this node was pushed.
+        if (top.second > tmax)
+        {
+            continue;
+        }
+
+        const Node& current = mNodes[top.first];
+
+        if (current.Left == 0)
+        {
+            for (std::uint32_t item = current.ItemBegin; item < current.ItemEnd; item++)
+            {
+                float itemEntry;
+                if (RayAABBoxIntersect(ray, mItemBounds[item], tmin, tmax, itemEntry))
+                {
+                    // only closer hits are looked for from now on.
+                    tmax = itemEntry;
+                    node = mItems[item];
+                    t = itemEntry;
+                    hit = true;
+                }
+            }
+            continue;
+        }
+
+        std::uint32_t children[2] = { current.Left, current.Left + 1 };
+        float entries[2];
+        bool hits[2];
+        for (int i = 0; i < 2; i++)
+        {
+            hits[i] = RayAABBoxIntersect(ray, mNodes[children[i]].Bounds, tmin, tmax, entries[i]);
+        }
+
+        // the nearest child is visited first, so it's pushed last.
+        int nearest = (hits[0] && hits[1]) ? (entries[0] <= entries[1] ? 0 : 1) : (hits[0] ? 0 : 1);
+        int furthest = 1 - nearest;
+
+        if (hits[furthest])
+        {
+            stack.push_back(std::make_pair(children[furthest], entries[furthest]));
+        }
+
+        if (hits[nearest])
+        {
+            stack.push_back(std::make_pair(children[nearest], entries[nearest]));
+        }
+    }
+
+    return hit;
+}
+
+} // end namespace ng
@@ -0,0 +1,143 @@
+#include "ng/engine/rendering/scenesnapshot.hpp"
+
+#include <mutex>
+#include <stdexcept>
+
+namespace ng
+{
+
+class SceneSnapshotPublisher::Pool
+{
+public:
+    std::mutex Mutex;
+    std::vector<std::unique_ptr<SceneSnapshot>> Free;
+    std::size_t NumSnapshots = 0;
+};
+
+// the deleter of published snapshots, which puts them back in the pool
+// once the publisher and all the readers let go of them.
+class SceneSnapshotPublisher::Recycler
+{
+    std::weak_ptr<Pool> mPool;
+
+public:
+    explicit Recycler(std::weak_ptr<Pool> pool)
+        : mPool(std::move(pool))
+    { }
+
+    void operator()(const SceneSnapshot* snapshot) const
+    {
+        std::unique_ptr<SceneSnapshot> owned(const_cast<SceneSnapshot*>(snapshot));
+
+        if (std::shared_ptr<Pool> pool = mPool.lock())
+        {
+            std::lock_guard<std::mutex> lock(pool->Mutex);
+            pool->Free.push_back(std::move(owned));
+        }
+    }
+};
+
+SceneSnapshotPublisher::SceneSnapshotPublisher()
+    : mPool(std::make_shared<Pool>())
+{ }
+
+SceneSnapshotPublisher::~SceneSnapshotPublisher() = default;
+
+void SceneSnapshotPublisher::Publish(const FlatSceneGraph& scene)
+{
+    if (scene.HasStaleWorldTransforms())
+    {
+        throw std::logic_error("FlatSceneGraph has stale world transforms, "
+                               "call UpdateWorldTransforms() first");
+    }
+
+    std::unique_ptr<SceneSnapshot> snapshot;
+
+    {
+        std::lock_guard<std::mutex> lock(mPool->Mutex);
+
+        // the most recent free snapshot has the fewest nodes to catch up on.
+        auto newest = mPool->Free.end();
+        for (auto it = mPool->Free.begin(); it != mPool->Free.end(); ++it)
+        {
+            if (newest == mPool->Free.end() || (*it)->mVersion > (*newest)->mVersion)
+            {
+                newest = it;
+            }
+        }
+
+        if (newest != mPool->Free.end())
+        {
+            snapshot = std::move(*newest);
+            mPool->Free.erase(newest);
+        }
+        else
+        {
+            mPool->NumSnapshots++;
+        }
+    }
+
+    if (snapshot == nullptr)
+    {
+        snapshot.reset(new SceneSnapshot());
+    }
+
+    std::size_t numNodes = scene.GetNumNodes();
+    std::size_t numOldNodes = snapshot->mFlags.size();
+
+    snapshot->mFlags.resize(numNodes);
+    snapshot->mWorldTransforms.resize(numNodes);
+    snapshot->mWorldBounds.resize(numNodes);
+    snapshot->mMeshes.resize(numNodes);
+    snapshot->mMaterials.resize(numNodes);
+
+    const std::vector<std::uint64_t>& nodeVersions = scene.GetNodeVersions();
+    const std::vector<std::uint8_t>& flags = scene.GetFlags();
+    const std::vector<mat4>& worldTransforms = scene.GetWorldTransforms();
+    const std::vector<AxisAlignedBoundingBox<float>>& worldBounds = scene.GetWorldBounds();
+    const std::vector<MeshHandle>& meshes = scene.GetMeshes();
+    const std::vector<MaterialHandle>& materials = scene.GetMaterials();
+
+    std::size_t numCopied = 0;
+
+    for (std::size_t i = 0; i < numNodes; i++)
+    {
+        if (i < numOldNodes && nodeVersions[i] <= snapshot->mVersion)
+        {
+            continue;
+        }
+
+        snapshot->mFlags[i] = flags[i];
+        snapshot->mWorldTransforms[i] = worldTransforms[i];
+        snapshot->mWorldBounds[i] = worldBounds[i];
+        snapshot->mMeshes[i] = meshes[i];
+        snapshot->mMaterials[i] = materials[i];
+        numCopied++;
+    }
+
+    // there are only ever a handful of cameras.
+    snapshot->mCameras = scene.GetCameras();
+
+    snapshot->mVersion = scene.GetVersion();
+
+    mNumCopiedNodes = numCopied;
+
+    std::shared_ptr<const SceneSnapshot> published(
+                snapshot.release(),
+                Recycler(mPool));
+
+    std::atomic_store(&mCurrent, std::move(published));
+}
+
+std::shared_ptr<const SceneSnapshot> SceneSnapshotPublisher::Acquire() const
+{
+    return std::atomic_load(&mCurrent);
+}
+
+std::size_t SceneSnapshotPublisher::GetNumSnapshots() const
+{
+    std::lock_guard<std::mutex> lock(mPool->Mutex);
+    return mPool->NumSnapshots;
+}
+
+} // end namespace ng
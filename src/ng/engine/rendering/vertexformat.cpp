@@ -3,6 +3,16 @@
 namespace ng
 {
 
+std::ptrdiff_t GetEffectiveStride(const VertexAttribute& attribute)
+{
+    if (attribute.Stride != 0)
+    {
+        return attribute.Stride;
+    }
+
+    return std::ptrdiff_t(attribute.Cardinality * SizeOfArithmeticType(attribute.Type));
+}
+
 std::array<std::reference_wrapper<const VertexAttribute>,5>
     GetAttribArray(const VertexFormat& fmt)
 {
@@ -0,0 +1,163 @@
+#include "ng/engine/util/charconv.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace ng
+{
+
+static bool IsDigit(char ch)
+{
+    return ch >= '0' && ch <= '9';
+}
+
+const char* parse_float(const char* first, const char* last, float& value)
+{
+    const char* p = first;
+
+    bool negative = false;
+    if (p != last && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+
+    // digits beyond what the mantissa can hold only affect the exponent.
+    const std::uint64_t kMaxMantissa = 100000000000000000ull;
+
+    std::uint64_t mantissa = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+
+    for (; p != last && IsDigit(*p); ++p)
+    {
+        hasDigits = true;
+        if (mantissa < kMaxMantissa)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+        }
+        else
+        {
+            exponent++;
+        }
+    }
+
+    if (p != last && *p == '.')
+    {
+        for (++p; p != last && IsDigit(*p); ++p)
+        {
+            hasDigits = true;
+            if (mantissa < kMaxMantissa)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                exponent--;
+            }
+        }
+    }
+
+    if (!hasDigits)
+    {
+        return nullptr;
+    }
+
+    // the exponent is only part of the number if it has digits.
+    if (p != last && (*p == 'e' || *p == 'E'))
+    {
+        const char* exponentStart = p + 1;
+
+        bool negativeExponent = false;
+        if (exponentStart != last && (*exponentStart == '-' || *exponentStart == '+'))
+        {
+            negativeExponent = *exponentStart == '-';
+            ++exponentStart;
+        }
+
+        if (exponentStart != last && IsDigit(*exponentStart))
+        {
+            int explicitExponent = 0;
+            for (p = exponentStart; p != last && IsDigit(*p); ++p)
+            {
+                if (explicitExponent < 10000)
+                {
+                    explicitExponent = explicitExponent * 10 + (*p - '0');
+                }
+            }
+
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+        }
+    }
+
+    // powers of ten up to 1e22 are exact in a double,
+    // so dividing or multiplying by them only rounds once.
+    static const double kPowersOfTen[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+        1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+        1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    double result = double(mantissa);
+
+    if (mantissa != 0)
+    {
+        if (exponent < 0 && exponent >= -22)
+        {
+            result /= kPowersOfTen[-exponent];
+        }
+        else if (exponent > 0 && exponent <= 22)
+        {
+            result *= kPowersOfTen[exponent];
+        }
+        else if (exponent != 0)
+        {
+            result *= std::pow(10.0, exponent);
+        }
+    }
+
+    if (result > std::numeric_limits<float>::max())
+    {
+        return nullptr;
+    }
+
+    value = float(negative ? -result : result);
+    return p;
+}
+
+const char* parse_int(const char* first, const char* last, int& value)
+{
+    const char* p = first;
+
+    bool negative = false;
+    if (p != last && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+
+    if (p == last || !IsDigit(*p))
+    {
+        return nullptr;
+    }
+
+    std::int64_t result = 0;
+    for (; p != last && IsDigit(*p); ++p)
+    {
+        result = result * 10 + (*p - '0');
+        if (result > std::int64_t(std::numeric_limits<int>::max()) + 1)
+        {
+            return nullptr;
+        }
+    }
+
+    result = negative ? -result : result;
+
+    if (result > std::numeric_limits<int>::max())
+    {
+        return nullptr;
+    }
+
+    value = int(result);
+    return p;
+}
+
+} // end namespace ng
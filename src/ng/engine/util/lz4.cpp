@@ -0,0 +1,324 @@
+#include "ng/engine/util/lz4.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace ng
+{
+
+namespace
+{
+
+const std::size_t kMinMatch = 4;
+
+// the format requires the last 5 bytes to be literals,
+// and the last match to start at least 12 bytes before the end.
+const std::size_t kLastLiterals = 5;
+const std::size_t kMatchStartLimit = 12;
+
+const std::size_t kMaxOffset = 65535;
+
+const int kHashBits = 12;
+
+std::uint32_t Read32(const char* p)
+{
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+std::uint32_t Hash(std::uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - kHashBits);
+}
+
+class BlockWriter
+{
+    char* mCursor;
+    char* mEnd;
+
+public:
+    BlockWriter(char* dst, std::size_t capacity)
+        : mCursor(dst)
+        , mEnd(dst + capacity)
+    { }
+
+    char* GetCursor() const
+    {
+        return mCursor;
+    }
+
+    bool WriteByte(unsigned char byte)
+    {
+        if (mCursor == mEnd)
+        {
+            return false;
+        }
+
+        *mCursor++ = static_cast<char>(byte);
+        return true;
+    }
+
+    // the part of a length that didn't fit in the token's 4 bits.
+    bool WriteLengthExtension(std::size_t length)
+    {
+        for (; length >= 255; length -= 255)
+        {
+            if (!WriteByte(255))
+            {
+                return false;
+            }
+        }
+
+        return WriteByte(static_cast<unsigned char>(length));
+    }
+
+    bool WriteBytes(const char* data, std::size_t size)
+    {
+        if (std::size_t(mEnd - mCursor) < size)
+        {
+            return false;
+        }
+
+        std::memcpy(mCursor, data, size);
+        mCursor += size;
+        return true;
+    }
+
+    // a match length of 0 writes the final, literals-only sequence.
+    bool WriteSequence(
+            const char* literals, std::size_t numLiterals,
+            std::size_t offset, std::size_t matchLength)
+    {
+        std::size_t matchCode = matchLength == 0 ? 0 : matchLength - kMinMatch;
+
+        unsigned char token =
+                static_cast<unsigned char>((numLiterals < 15 ? numLiterals : 15) << 4)
+              | static_cast<unsigned char>(matchCode < 15 ? matchCode : 15);
+
+        if (!WriteByte(token))
+        {
+            return false;
+        }
+
+        if (numLiterals >= 15 && !WriteLengthExtension(numLiterals - 15))
+        {
+            return false;
+        }
+
+        if (!WriteBytes(literals, numLiterals))
+        {
+            return false;
+        }
+
+        if (matchLength == 0)
+        {
+            return true;
+        }
+
+        if (!WriteByte(offset & 0xFF) || !WriteByte(offset >> 8))
+        {
+            return false;
+        }
+
+        return matchCode < 15 || WriteLengthExtension(matchCode - 15);
+    }
+};
+
+// copies in 8 byte steps, so it may write up to 7 bytes past dst + size.
+// with src before dst, that's fine for overlapping copies as long as
+// they're at least 8 bytes apart.
+void WildCopy(char* dst, const char* src, std::size_t size)
+{
+    char* end = dst + size;
+    do
+    {
+        std::memcpy(dst, src, 8);
+        dst += 8;
+        src += 8;
+    } while (dst < end);
+}
+
+// how much room the fast paths need past what they copy.
+const std::size_t kWildCopySlack = 8;
+
+// reads the part of a length that didn't fit in the token's 4 bits.
+bool ReadLengthExtension(const char*& cursor, const char* end, std::size_t& length)
+{
+    unsigned char byte;
+    do
+    {
+        if (cursor == end)
+        {
+            return false;
+        }
+
+        byte = static_cast<unsigned char>(*cursor++);
+        length += byte;
+    } while (byte == 255);
+
+    return true;
+}
+
+} // end anonymous namespace
+
+std::size_t lz4_compress_bound(std::size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+std::size_t lz4_compress(
+        const char* src, std::size_t srcSize,
+        char* dst, std::size_t capacity)
+{
+    BlockWriter writer(dst, capacity);
+
+    std::size_t anchor = 0;
+
+    if (srcSize > kMatchStartLimit)
+    {
+        // positions of the last 4-byte sequences seen with each hash.
+        std::vector<std::uint32_t> table(std::size_t(1) << kHashBits, 0);
+
+        std::size_t matchStartLimit = srcSize - kMatchStartLimit;
+        std::size_t matchEndLimit = srcSize - kLastLiterals;
+
+        std::size_t pos = 1;
+        while (pos <= matchStartLimit)
+        {
+            std::uint32_t sequence = Read32(src + pos);
+            std::uint32_t& slot = table[Hash(sequence)];
+            std::size_t candidate = slot;
+            slot = static_cast<std::uint32_t>(pos);
+
+            if (pos - candidate > kMaxOffset || Read32(src + candidate) != sequence)
+            {
+                // skip ahead faster the longer nothing matched.
+                pos += 1 + ((pos - anchor) >> 6);
+                continue;
+            }
+
+            std::size_t matchLength = kMinMatch;
+            while (pos + matchLength < matchEndLimit &&
+                   src[candidate + matchLength] == src[pos + matchLength])
+            {
+                matchLength++;
+            }
+
+            if (!writer.WriteSequence(src + anchor, pos - anchor, pos - candidate, matchLength))
+            {
+                return 0;
+            }
+
+            pos += matchLength;
+            anchor = pos;
+        }
+    }
+
+    if (!writer.WriteSequence(src + anchor, srcSize - anchor, 0, 0))
+    {
+        return 0;
+    }
+
+    return writer.GetCursor() - dst;
+}
+
+bool lz4_decompress(
+        const char* src, std::size_t srcSize,
+        char* dst, std::size_t dstSize)
+{
+    const char* in = src;
+    const char* inEnd = src + srcSize;
+    char* out = dst;
+    char* outEnd = dst + dstSize;
+
+    for (;;)
+    {
+        if (in == inEnd)
+        {
+            return false;
+        }
+
+        unsigned char token = static_cast<unsigned char>(*in++);
+
+        std::size_t numLiterals = token >> 4;
+        if (numLiterals == 15 && !ReadLengthExtension(in, inEnd, numLiterals))
+        {
+            return false;
+        }
+
+        if (std::size_t(inEnd - in) < numLiterals ||
+            std::size_t(outEnd - out) < numLiterals)
+        {
+            return false;
+        }
+
+        if (std::size_t(inEnd - in) >= numLiterals + kWildCopySlack &&
+            std::size_t(outEnd - out) >= numLiterals + kWildCopySlack)
+        {
+            WildCopy(out, in, numLiterals);
+        }
+        else
+        {
+            std::memcpy(out, in, numLiterals);
+        }
+        in += numLiterals;
+        out += numLiterals;
+
+        // the last sequence has no match.
+        if (in == inEnd)
+        {
+            return out == outEnd;
+        }
+
+        if (inEnd - in < 2)
+        {
+            return false;
+        }
+
+        std::size_t offset = static_cast<unsigned char>(in[0])
+                           | static_cast<unsigned char>(in[1]) << 8;
+        in += 2;
+
+        if (offset == 0 || offset > std::size_t(out - dst))
+        {
+            return false;
+        }
+
+        std::size_t matchLength = token & 15;
+        if (matchLength == 15 && !ReadLengthExtension(in, inEnd, matchLength))
+        {
+            return false;
+        }
+        matchLength += kMinMatch;
+
+        if (std::size_t(outEnd - out) < matchLength)
+        {
+            return false;
+        }
+
+        const char* match = out - offset;
+
+        if (offset >= 8 && std::size_t(outEnd - out) >= matchLength + kWildCopySlack)
+        {
+            WildCopy(out, match, matchLength);
+            out += matchLength;
+        }
+        else if (offset >= matchLength)
+        {
+            std::memcpy(out, match, matchLength);
+            out += matchLength;
+        }
+        else
+        {
+            // the match overlaps what it's writing, which repeats the last offset bytes.
+            for (std::size_t i = 0; i < matchLength; i++)
+            {
+                *out++ = *match++;
+            }
+        }
+    }
+}
+
+} // end namespace ng
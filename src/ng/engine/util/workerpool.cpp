@@ -0,0 +1,115 @@
+#include "ng/engine/util/workerpool.hpp"
+
+#include <system_error>
+
+namespace ng
+{
+
+worker_pool::worker_pool(std::size_t numWorkers)
+{
+    try
+    {
+        for (std::size_t i = 1; i < numWorkers; i++)
+        {
+            mThreads.emplace_back(&worker_pool::thread_main, this, i);
+        }
+    }
+    catch (const std::system_error&)
+    {
+    }
+}
+
+worker_pool::~worker_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+
+    mStarted.notify_all();
+
+    for (std::thread& t : mThreads)
+    {
+        t.join();
+    }
+}
+
+void worker_pool::run_guarded(const std::function<void(std::size_t)>& f, std::size_t worker)
+{
+    try
+    {
+        f(worker);
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mError)
+        {
+            mError = std::current_exception();
+        }
+    }
+}
+
+void worker_pool::thread_main(std::size_t worker)
+{
+    std::size_t lastRun = 0;
+
+    for (;;)
+    {
+        const std::function<void(std::size_t)>* work;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mStarted.wait(lock, [&]{ return mStopping || mRun != lastRun; });
+
+            if (mStopping)
+            {
+                return;
+            }
+
+            lastRun = mRun;
+            work = mWork;
+        }
+
+        run_guarded(*work, worker);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (--mNumRunning == 0)
+        {
+            mFinished.notify_one();
+        }
+    }
+}
+
+void worker_pool::run(const std::function<void(std::size_t)>& f)
+{
+    if (!mThreads.empty())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mWork = &f;
+            mNumRunning = mThreads.size();
+            mRun++;
+        }
+
+        mStarted.notify_all();
+    }
+
+    run_guarded(f, 0);
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mFinished.wait(lock, [this]{ return mNumRunning == 0; });
+
+        mWork = nullptr;
+        error = mError;
+        mError = nullptr;
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+} // end namespace ng
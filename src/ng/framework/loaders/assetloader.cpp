@@ -0,0 +1,343 @@
+#include "ng/framework/loaders/assetloader.hpp"
+
+#include "ng/framework/loaders/md5loader.hpp"
+#include "ng/framework/loaders/objloader.hpp"
+
+#include "ng/framework/models/md5model.hpp"
+#include "ng/framework/models/objmodel.hpp"
+
+#include "ng/engine/rendering/scenegraph.hpp"
+
+#include "ng/engine/filesystem/filesystem.hpp"
+#include "ng/engine/filesystem/readfile.hpp"
+
+#include "ng/engine/util/parallelfor.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <system_error>
+
+namespace ng
+{
+
+namespace
+{
+
+// std::push_heap keeps the "largest" job on top,
+// which has to be the highest priority job that was requested first.
+struct JobOrder
+{
+    template<class Job>
+    bool operator()(const Job& a, const Job& b) const
+    {
+        if (a.Priority != b.Priority)
+        {
+            return a.Priority < b.Priority;
+        }
+
+        return a.Sequence > b.Sequence;
+    }
+};
+
+bool IsFinished(AssetLoadStatus status)
+{
+    return status != AssetLoadStatus::Pending &&
+           status != AssetLoadStatus::Loading;
+}
+
+} // end anonymous namespace
+
+AssetLoadStatus AssetLoadState::GetStatus() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStatus;
+}
+
+void AssetLoadState::Wait() const
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDone.wait(lock, [this]{ return IsFinished(mStatus); });
+}
+
+std::shared_ptr<void> AssetLoadState::TryGetValue() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStatus == AssetLoadStatus::Loaded ? mValue : nullptr;
+}
+
+std::shared_ptr<void> AssetLoadState::GetValue() const
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDone.wait(lock, [this]{ return IsFinished(mStatus); });
+
+    if (mStatus == AssetLoadStatus::Failed)
+    {
+        std::rethrow_exception(mError);
+    }
+
+    if (mStatus == AssetLoadStatus::Cancelled)
+    {
+        throw std::logic_error("Asset load was cancelled");
+    }
+
+    return mValue;
+}
+
+bool AssetLoadState::Cancel()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mStatus == AssetLoadStatus::Pending)
+    {
+        mStatus = AssetLoadStatus::Cancelled;
+        mDone.notify_all();
+        return true;
+    }
+
+    if (mStatus == AssetLoadStatus::Loading)
+    {
+        mCancelRequested = true;
+        return true;
+    }
+
+    return false;
+}
+
+bool AssetLoadState::TryStart()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mStatus != AssetLoadStatus::Pending)
+    {
+        return false;
+    }
+
+    mStatus = AssetLoadStatus::Loading;
+    return true;
+}
+
+void AssetLoadState::Finish(std::shared_ptr<void> value, std::exception_ptr error)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mCancelRequested)
+    {
+        mStatus = AssetLoadStatus::Cancelled;
+    }
+    else if (error)
+    {
+        mStatus = AssetLoadStatus::Failed;
+        mError = std::move(error);
+    }
+    else
+    {
+        mStatus = AssetLoadStatus::Loaded;
+        mValue = std::move(value);
+    }
+
+    mDone.notify_all();
+}
+
+AssetLoader::AssetLoader(std::shared_ptr<IFileSystem> fileSystem, std::size_t numWorkers)
+    : mFileSystem(std::move(fileSystem))
+{
+    try
+    {
+        for (std::size_t i = 0; i < numWorkers; i++)
+        {
+            mWorkers.emplace_back(&AssetLoader::WorkerLoop, this);
+        }
+    }
+    catch (const std::system_error&)
+    {
+        // fall back to however many threads could be created,
+        // possibly none, in which case loads become synchronous.
+    }
+}
+
+AssetLoader::AssetLoader(std::shared_ptr<IFileSystem> fileSystem)
+    : AssetLoader(std::move(fileSystem), default_worker_count())
+{ }
+
+AssetLoader::~AssetLoader()
+{
+    std::vector<Job> abandoned;
+
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        mStopping = true;
+        abandoned.swap(mQueue);
+    }
+
+    mQueueCondition.notify_all();
+
+    for (Job& job : abandoned)
+    {
+        job.State->Cancel();
+    }
+
+    for (std::thread& worker : mWorkers)
+    {
+        worker.join();
+    }
+}
+
+void AssetLoader::Submit(
+        std::shared_ptr<AssetLoadState> state,
+        std::function<std::shared_ptr<void>()> load,
+        AssetLoadPriority priority)
+{
+    if (mWorkers.empty())
+    {
+        state->TryStart();
+
+        try
+        {
+            state->Finish(load(), nullptr);
+        }
+        catch (...)
+        {
+            state->Finish(nullptr, std::current_exception());
+        }
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+
+        Job job;
+        job.Priority = priority;
+        job.Sequence = mNextSequence++;
+        job.State = std::move(state);
+        job.Load = std::move(load);
+
+        mQueue.push_back(std::move(job));
+        std::push_heap(mQueue.begin(), mQueue.end(), JobOrder());
+    }
+
+    mQueueCondition.notify_one();
+}
+
+void AssetLoader::WorkerLoop()
+{
+    for (;;)
+    {
+        Job job;
+
+        {
+            std::unique_lock<std::mutex> lock(mQueueMutex);
+            mQueueCondition.wait(lock, [this]{ return mStopping || !mQueue.empty(); });
+
+            if (mStopping)
+            {
+                return;
+            }
+
+            std::pop_heap(mQueue.begin(), mQueue.end(), JobOrder());
+            job = std::move(mQueue.back());
+            mQueue.pop_back();
+        }
+
+        if (!job.State->TryStart())
+        {
+            // cancelled while it was queued.
+            continue;
+        }
+
+        std::shared_ptr<void> value;
+        std::exception_ptr error;
+
+        try
+        {
+            value = job.Load();
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        // drop whatever the load captured before anyone can see it finished,
+        // so reference counts of finished loads don't depend on scheduling.
+        job.Load = nullptr;
+
+        std::shared_ptr<AssetLoadState> state = std::move(job.State);
+        state->Finish(std::move(value), std::move(error));
+    }
+}
+
+std::size_t AssetLoader::GetNumQueued()
+{
+    std::lock_guard<std::mutex> lock(mQueueMutex);
+    return mQueue.size();
+}
+
+AssetHandle<ObjModel> AssetLoader::LoadObjAsync(
+        std::string path,
+        AssetLoadPriority priority)
+{
+    std::shared_ptr<IFileSystem> fileSystem = mFileSystem;
+
+    return Load<ObjModel>([fileSystem, path]{
+        std::shared_ptr<ObjModel> model = std::make_shared<ObjModel>();
+        LoadObj(*model, *fileSystem->GetReadFile(path.c_str(), FileReadMode::Text));
+        return model;
+    }, priority);
+}
+
+AssetHandle<MD5Model> AssetLoader::LoadMD5MeshAsync(
+        std::string path,
+        AssetLoadPriority priority)
+{
+    std::shared_ptr<IFileSystem> fileSystem = mFileSystem;
+
+    return Load<MD5Model>([fileSystem, path]{
+        std::shared_ptr<MD5Model> model = std::make_shared<MD5Model>();
+        LoadMD5Mesh(*model, *fileSystem->GetReadFile(path.c_str(), FileReadMode::Text));
+        return model;
+    }, priority);
+}
+
+AssetHandle<MD5Anim> AssetLoader::LoadMD5AnimAsync(
+        std::string path,
+        AssetLoadPriority priority)
+{
+    std::shared_ptr<IFileSystem> fileSystem = mFileSystem;
+
+    return Load<MD5Anim>([fileSystem, path]{
+        std::shared_ptr<MD5Anim> anim = std::make_shared<MD5Anim>();
+        LoadMD5Anim(*anim, *fileSystem->GetReadFile(path.c_str(), FileReadMode::Text));
+        return anim;
+    }, priority);
+}
+
+PlaceholderMeshSwap::PlaceholderMeshSwap(
+        std::shared_ptr<SceneGraphNode> node,
+        std::shared_ptr<IMesh> placeholder,
+        AssetHandle<IMesh> mesh)
+    : mNode(std::move(node))
+    , mMesh(std::move(mesh))
+{
+    mNode->Mesh = std::move(placeholder);
+}
+
+bool PlaceholderMeshSwap::Update()
+{
+    if (mDone || !mMesh.IsDone())
+    {
+        return mDone;
+    }
+
+    if (std::shared_ptr<IMesh> mesh = mMesh.TryGet())
+    {
+        mNode->Mesh = std::move(mesh);
+    }
+
+    mDone = true;
+    mNode.reset();
+    mMesh = AssetHandle<IMesh>();
+
+    return true;
+}
+
+} // end namespace ng
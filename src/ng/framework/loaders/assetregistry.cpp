@@ -0,0 +1,367 @@
+#include "ng/framework/loaders/assetregistry.hpp"
+
+#include "ng/framework/loaders/md5loader.hpp"
+#include "ng/framework/loaders/objloader.hpp"
+
+#include "ng/framework/meshes/md5mesh.hpp"
+#include "ng/framework/meshes/objmesh.hpp"
+
+#include "ng/framework/models/md5model.hpp"
+#include "ng/framework/models/objmodel.hpp"
+
+#include "ng/engine/filesystem/filesystem.hpp"
+#include "ng/engine/filesystem/path.hpp"
+#include "ng/engine/filesystem/readfile.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <tuple>
+
+namespace ng
+{
+
+namespace
+{
+
+// memory owned by the asset besides the object itself.
+
+template<class T>
+std::size_t GetHeapBytes(const std::vector<T>& v)
+{
+    return v.capacity() * sizeof(T);
+}
+
+std::size_t GetHeapBytes(const ObjModel& model)
+{
+    return GetHeapBytes(model.Positions)
+         + GetHeapBytes(model.Texcoords)
+         + GetHeapBytes(model.Normals)
+         + GetHeapBytes(model.Indices);
+}
+
+std::size_t GetHeapBytes(const MD5Model& model)
+{
+    std::size_t bytes = model.CommandLine.size()
+                      + GetHeapBytes(model.BindPoseJoints)
+                      + GetHeapBytes(model.Meshes);
+
+    for (const MD5Joint& joint : model.BindPoseJoints)
+    {
+        bytes += joint.Name.size();
+    }
+
+    for (const MD5MeshData& mesh : model.Meshes)
+    {
+        bytes += mesh.Shader.size()
+               + GetHeapBytes(mesh.Vertices)
+               + GetHeapBytes(mesh.Triangles)
+               + GetHeapBytes(mesh.Weights);
+    }
+
+    return bytes;
+}
+
+std::size_t GetHeapBytes(const MD5Anim& anim)
+{
+    std::size_t bytes = anim.CommandLine.size()
+                      + GetHeapBytes(anim.Joints)
+                      + GetHeapBytes(anim.FrameBounds)
+                      + GetHeapBytes(anim.BaseFrame)
+                      + GetHeapBytes(anim.FrameComponents);
+
+    for (const MD5AnimationJoint& joint : anim.Joints)
+    {
+        bytes += joint.Name.size();
+    }
+
+    return bytes;
+}
+
+std::shared_ptr<IReadFile> OpenTextFile(AssetLoader& loader, const std::string& path)
+{
+    return loader.GetFileSystem()->GetReadFile(path.c_str(), FileReadMode::Text);
+}
+
+} // end anonymous namespace
+
+bool AssetRegistry::Key::operator<(const Key& other) const
+{
+    return std::tie(Type, Path, Options) < std::tie(other.Type, other.Path, other.Options);
+}
+
+bool AssetRegistry::Record::IsReferenced() const
+{
+    // the registry holds one reference to the handles' owner of the state,
+    // and a loaded value is shared by the state and the registry.
+    return State.use_count() > 1 || (Value && Value.use_count() > 2);
+}
+
+AssetRegistry::AssetRegistry(AssetLoader& loader, std::size_t memoryBudget)
+    : mLoader(loader)
+    , mMemoryBudget(memoryBudget)
+{ }
+
+std::shared_ptr<AssetLoadState> AssetRegistry::AcquireState(
+        std::string type,
+        string_view path,
+        std::string options,
+        LoadFunction load,
+        AssetLoadPriority priority)
+{
+    Key key;
+    key.Type = std::move(type);
+    key.Path = NormalizePath(path);
+    key.Options = std::move(options);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    std::shared_ptr<Record>& record = mRecords[key];
+
+    // failed and cancelled loads get another try.
+    if (record != nullptr)
+    {
+        AssetLoadStatus status = record->State->GetStatus();
+        if (status == AssetLoadStatus::Failed || status == AssetLoadStatus::Cancelled)
+        {
+            record = nullptr;
+        }
+    }
+
+    if (record == nullptr)
+    {
+        record = std::make_shared<Record>();
+
+        std::shared_ptr<Record> loadingRecord = record;
+        std::string normalizedPath = key.Path;
+
+        std::shared_ptr<AssetLoadState> loadState =
+                mLoader.Load<void>([loadingRecord, normalizedPath, load]{
+            auto start = std::chrono::steady_clock::now();
+
+            std::size_t bytes = 0;
+            std::shared_ptr<void> value = load(normalizedPath, bytes);
+
+            auto end = std::chrono::steady_clock::now();
+
+            loadingRecord->Bytes = bytes;
+            loadingRecord->LoadNanoseconds =
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+            return value;
+        }, priority).GetState();
+
+        // handles share their own owner of the state, so counting them
+        // isn't thrown off by the references the loader keeps while it runs.
+        std::shared_ptr<std::shared_ptr<AssetLoadState>> owner =
+                std::make_shared<std::shared_ptr<AssetLoadState>>(loadState);
+
+        record->State = std::shared_ptr<AssetLoadState>(owner, loadState.get());
+    }
+
+    record->LastUsed = ++mUseCounter;
+    record->NumRequests++;
+
+    std::shared_ptr<AssetLoadState> state = record->State;
+
+    TrimLocked();
+
+    return state;
+}
+
+void AssetRegistry::TrimLocked()
+{
+    std::size_t usage = 0;
+    std::vector<std::map<Key, std::shared_ptr<Record>>::iterator> candidates;
+
+    for (auto it = mRecords.begin(); it != mRecords.end(); ++it)
+    {
+        Record& record = *it->second;
+
+        if (record.Value == nullptr)
+        {
+            record.Value = record.State->TryGetValue();
+        }
+
+        if (record.Value != nullptr)
+        {
+            usage += record.Bytes;
+
+            if (!record.IsReferenced())
+            {
+                candidates.push_back(it);
+            }
+        }
+    }
+
+    if (usage <= mMemoryBudget)
+    {
+        return;
+    }
+
+    std::sort(candidates.begin(), candidates.end(),
+              [](const std::map<Key, std::shared_ptr<Record>>::iterator& a,
+                 const std::map<Key, std::shared_ptr<Record>>::iterator& b) {
+        return a->second->LastUsed < b->second->LastUsed;
+    });
+
+    for (auto it : candidates)
+    {
+        if (usage <= mMemoryBudget)
+        {
+            break;
+        }
+
+        usage -= it->second->Bytes;
+        mRecords.erase(it);
+        mNumEvictions++;
+    }
+}
+
+void AssetRegistry::Trim()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    TrimLocked();
+}
+
+std::size_t AssetRegistry::GetMemoryBudget()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mMemoryBudget;
+}
+
+void AssetRegistry::SetMemoryBudget(std::size_t memoryBudget)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mMemoryBudget = memoryBudget;
+    TrimLocked();
+}
+
+std::size_t AssetRegistry::GetMemoryUsage()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    std::size_t usage = 0;
+
+    for (const auto& keyAndRecord : mRecords)
+    {
+        const Record& record = *keyAndRecord.second;
+
+        if (record.State->GetStatus() == AssetLoadStatus::Loaded)
+        {
+            usage += record.Bytes;
+        }
+    }
+
+    return usage;
+}
+
+std::size_t AssetRegistry::GetNumEvictions()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mNumEvictions;
+}
+
+std::vector<AssetStats> AssetRegistry::GetStats()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    std::vector<AssetStats> stats;
+    stats.reserve(mRecords.size());
+
+    for (const auto& keyAndRecord : mRecords)
+    {
+        const Key& key = keyAndRecord.first;
+        const Record& record = *keyAndRecord.second;
+
+        AssetStats stat;
+        stat.Type = key.Type;
+        stat.Path = key.Path;
+        stat.Options = key.Options;
+        stat.Status = record.State->GetStatus();
+        stat.Bytes = stat.Status == AssetLoadStatus::Loaded ? record.Bytes.load() : 0;
+        stat.LoadSeconds = record.LoadNanoseconds / 1e9;
+        stat.NumRequests = record.NumRequests;
+        stat.IsReferenced = record.IsReferenced();
+
+        stats.push_back(std::move(stat));
+    }
+
+    return stats;
+}
+
+AssetHandle<ObjModel> AssetRegistry::AcquireObjModel(
+        string_view path,
+        AssetLoadPriority priority)
+{
+    AssetLoader& loader = mLoader;
+
+    return Acquire<ObjModel>("ObjModel", path, "",
+            [&loader](const std::string& normalizedPath, std::size_t& bytes) {
+        std::shared_ptr<ObjModel> model = std::make_shared<ObjModel>();
+        LoadObj(*model, *OpenTextFile(loader, normalizedPath));
+        bytes = sizeof(ObjModel) + GetHeapBytes(*model);
+        return model;
+    }, priority);
+}
+
+AssetHandle<MD5Model> AssetRegistry::AcquireMD5Model(
+        string_view path,
+        AssetLoadPriority priority)
+{
+    AssetLoader& loader = mLoader;
+
+    return Acquire<MD5Model>("MD5Model", path, "",
+            [&loader](const std::string& normalizedPath, std::size_t& bytes) {
+        std::shared_ptr<MD5Model> model = std::make_shared<MD5Model>();
+        LoadMD5Mesh(*model, *OpenTextFile(loader, normalizedPath));
+        bytes = sizeof(MD5Model) + GetHeapBytes(*model);
+        return model;
+    }, priority);
+}
+
+AssetHandle<MD5Anim> AssetRegistry::AcquireMD5Anim(
+        string_view path,
+        AssetLoadPriority priority)
+{
+    AssetLoader& loader = mLoader;
+
+    return Acquire<MD5Anim>("MD5Anim", path, "",
+            [&loader](const std::string& normalizedPath, std::size_t& bytes) {
+        std::shared_ptr<MD5Anim> anim = std::make_shared<MD5Anim>();
+        LoadMD5Anim(*anim, *OpenTextFile(loader, normalizedPath));
+        bytes = sizeof(MD5Anim) + GetHeapBytes(*anim);
+        return anim;
+    }, priority);
+}
+
+AssetHandle<IMesh> AssetRegistry::AcquireObjMesh(
+        string_view path,
+        AssetLoadPriority priority)
+{
+    AssetLoader& loader = mLoader;
+
+    return Acquire<IMesh>("ObjMesh", path, "",
+            [&loader](const std::string& normalizedPath, std::size_t& bytes) {
+        ObjModel model;
+        LoadObj(model, *OpenTextFile(loader, normalizedPath));
+        bytes = sizeof(ObjMesh) + GetHeapBytes(model);
+        return std::make_shared<ObjMesh>(std::move(model));
+    }, priority);
+}
+
+AssetHandle<IMesh> AssetRegistry::AcquireMD5Mesh(
+        string_view path,
+        AssetLoadPriority priority)
+{
+    AssetLoader& loader = mLoader;
+
+    return Acquire<IMesh>("MD5Mesh", path, "",
+            [&loader](const std::string& normalizedPath, std::size_t& bytes) {
+        MD5Model model;
+        LoadMD5Mesh(model, *OpenTextFile(loader, normalizedPath));
+        bytes = sizeof(MD5Mesh) + GetHeapBytes(model);
+        return std::make_shared<MD5Mesh>(std::move(model));
+    }, priority);
+}
+
+} // end namespace ng
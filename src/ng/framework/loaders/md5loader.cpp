@@ -1,8 +1,12 @@
 #include "ng/framework/loaders/md5loader.hpp"
 #include "ng/framework/models/md5model.hpp"
 #include "ng/engine/filesystem/readfile.hpp"
+#include "ng/engine/util/charconv.hpp"
 
-#include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
 
 namespace ng
 {
@@ -11,50 +15,85 @@ class MD5ParserBase
 {
 protected:
     std::string& mError;
-    std::stringstream mInputStream;
 
+    // the text that's left to parse, which points straight into the file.
+    const char* mCursor;
+    const char* mEnd;
+
+    bool AtEnd() const
+    {
+        return mCursor == mEnd;
+    }
+
+    // returns the next character without consuming it, or 0 at the end.
+    char Peek() const
+    {
+        return mCursor != mEnd ? *mCursor : '\0';
+    }
+
+    // skips whitespace and // comments
     void EatWhitespace()
     {
-        while (std::isspace(mInputStream.peek()))
+        while (mCursor != mEnd)
         {
-            mInputStream.get();
+            if (is_space(*mCursor))
+            {
+                ++mCursor;
+            }
+            else if (*mCursor == '/' && mEnd - mCursor >= 2 && mCursor[1] == '/')
+            {
+                const void* newline = std::memchr(mCursor, '\n', mEnd - mCursor);
+                mCursor = newline ? static_cast<const char*>(newline) : mEnd;
+            }
+            else
+            {
+                break;
+            }
         }
     }
 
-    bool AcceptIdentifier(std::string& id)
+    bool AcceptIdentifier(string_view& id)
     {
-        if (!(mInputStream >> id))
+        EatWhitespace();
+
+        if (AtEnd())
         {
             mError = "Expected identifier";
             return false;
         }
 
-        if (!std::isalpha(id[0]))
+        if (!std::isalpha(static_cast<unsigned char>(*mCursor)))
         {
             mError = "Expected identifier "
                      "(identifiers begin with alpha character)";
             return false;
         }
 
-        for (std::size_t i = 1; i < id.size(); i++)
+        // identifiers run until the next whitespace or comment
+        const char* start = mCursor;
+        while (mCursor != mEnd && !is_space(*mCursor) &&
+               !(*mCursor == '/' && mEnd - mCursor >= 2 && mCursor[1] == '/'))
         {
-            if (!std::isalnum(id[i]))
+            if (!std::isalnum(static_cast<unsigned char>(*mCursor)))
             {
-                mError =
-                        "Expected identifier "
-                        "(identifiers must be made of alphanumeric characters)";
+                mError = "Expected identifier "
+                         "(identifiers must be made of alphanumeric characters)";
+                return false;
             }
+
+            ++mCursor;
         }
 
+        id = string_view(start, mCursor - start);
         return true;
     }
 
-    bool RequireIdentifier(const std::string& required)
+    bool RequireIdentifier(const char* required)
     {
-        std::string id;
+        string_view id;
         if (!AcceptIdentifier(id) || id != required)
         {
-            mError = "Expected " + required;
+            mError = std::string("Expected ") + required;
             return false;
         }
         return true;
@@ -66,9 +105,15 @@ protected:
         {
             s.clear();
             bool escaped = false;
-            while (escaped || mInputStream.peek() != '"')
+            while (escaped || Peek() != '"')
             {
-                char peeked = mInputStream.peek();
+                if (AtEnd())
+                {
+                    mError = "Unterminated string";
+                    return false;
+                }
+
+                char peeked = *mCursor;
 
                 if (escaped)
                 {
@@ -109,7 +154,7 @@ protected:
                     }
                 }
 
-                mInputStream.get();
+                ++mCursor;
             }
 
             if (RequireChar('"'))
@@ -123,11 +168,15 @@ protected:
 
     bool AcceptChar(char& ch)
     {
-        if (!(mInputStream >> ch))
+        EatWhitespace();
+
+        if (AtEnd())
         {
             mError = "Expected char";
             return false;
         }
+
+        ch = *mCursor++;
         return true;
     }
 
@@ -145,11 +194,16 @@ protected:
 
     bool AcceptInt(int& i)
     {
-        if (!(mInputStream >> i))
+        EatWhitespace();
+
+        const char* numberEnd = parse_int(mCursor, mEnd, i);
+        if (!numberEnd)
         {
             mError = "Expected int";
             return false;
         }
+
+        mCursor = numberEnd;
         return true;
     }
 
@@ -158,7 +212,7 @@ protected:
         int i;
         if (!AcceptInt(i) || i != required)
         {
-            mError = "Expected " + std::to_string(i);
+            mError = "Expected " + std::to_string(required);
             return false;
         }
         return true;
@@ -166,11 +220,16 @@ protected:
 
     bool AcceptFloat(float& f)
     {
-        if (!(mInputStream >> f))
+        EatWhitespace();
+
+        const char* numberEnd = parse_float(mCursor, mEnd, f);
+        if (!numberEnd)
         {
             mError = "Expected float";
             return false;
         }
+
+        mCursor = numberEnd;
         return true;
     }
 
@@ -179,7 +238,7 @@ protected:
         float f;
         if (!AcceptFloat(f) || f != required)
         {
-            mError = "Expected " + std::to_string(f);
+            mError = "Expected " + std::to_string(required);
             return false;
         }
         return true;
@@ -210,9 +269,13 @@ protected:
     }
 
 public:
-    MD5ParserBase(std::string& error)
+    MD5ParserBase(IReadFile& file, std::string& error)
         : mError(error)
-    { }
+    {
+        string_view contents = file.GetContents();
+        mCursor = contents.begin();
+        mEnd = contents.end();
+    }
 
     virtual bool Parse() = 0;
 };
@@ -318,9 +381,9 @@ class MD5MeshParser : public MD5ParserBase
             while (true)
             {
                 EatWhitespace();
-                if (mInputStream.peek() == '}')
+                if (Peek() == '}')
                 {
-                    mInputStream.get();
+                    ++mCursor;
                     break;
                 }
 
@@ -423,7 +486,7 @@ class MD5MeshParser : public MD5ParserBase
         {
             EatWhitespace();
 
-            if (mInputStream.peek() != 'v')
+            if (Peek() != 'v')
             {
                 break;
             }
@@ -531,7 +594,7 @@ class MD5MeshParser : public MD5ParserBase
         {
             EatWhitespace();
 
-            if (mInputStream.peek() != 't')
+            if (Peek() != 't')
             {
                 break;
             }
@@ -629,7 +692,7 @@ class MD5MeshParser : public MD5ParserBase
         {
             EatWhitespace();
 
-            if (mInputStream.peek() != 'w')
+            if (Peek() != 'w')
             {
                 break;
             }
@@ -693,7 +756,7 @@ class MD5MeshParser : public MD5ParserBase
         {
             EatWhitespace();
 
-            if (mInputStream.peek() == std::stringstream::traits_type::eof())
+            if (AtEnd())
             {
                 break;
             }
@@ -721,16 +784,9 @@ public:
             MD5Model& model,
             IReadFile& md5meshFile,
             std::string& error)
-        : MD5ParserBase(error)
+        : MD5ParserBase(md5meshFile, error)
         , mModel(model)
-    {
-        std::string line;
-        while (getline(line, md5meshFile))
-        {
-            line = line.substr(0, line.find("//"));
-            mInputStream << line << '\n';
-        }
-    }
+    { }
 
     bool Parse() override
     {
@@ -763,7 +819,7 @@ class MD5AnimParser : public MD5ParserBase
             }
 
             mAnim.FrameBounds.reserve(numFrames);
-            mAnim.Frames.reserve(numFrames);
+            mAnim.NumFrames = numFrames;
             mNumExpectedFrames = numFrames;
 
             return true;
@@ -824,6 +880,7 @@ class MD5AnimParser : public MD5ParserBase
                 return false;
             }
 
+            mAnim.NumAnimatedComponents = numAnimatedComponents;
             mNumExpectedAnimatedComponents = numAnimatedComponents;
 
             return true;
@@ -893,9 +950,9 @@ class MD5AnimParser : public MD5ParserBase
             {
                 EatWhitespace();
 
-                if (mInputStream.peek() == '}')
+                if (Peek() == '}')
                 {
-                    mInputStream.get();
+                    ++mCursor;
 
                     break;
                 }
@@ -962,9 +1019,9 @@ class MD5AnimParser : public MD5ParserBase
             {
                 EatWhitespace();
 
-                if (mInputStream.peek() == '}')
+                if (Peek() == '}')
                 {
-                    mInputStream.get();
+                    ++mCursor;
                     break;
                 }
 
@@ -1019,9 +1076,9 @@ class MD5AnimParser : public MD5ParserBase
             {
                 EatWhitespace();
 
-                if (mInputStream.peek() == '}')
+                if (Peek() == '}')
                 {
-                    mInputStream.get();
+                    ++mCursor;
                     break;
                 }
 
@@ -1050,12 +1107,10 @@ class MD5AnimParser : public MD5ParserBase
     {
         int numAcceptedAnimationComponents = 0;
 
-        MD5Frame& frame = mAnim.Frames.back();
-
         while (true)
         {
             EatWhitespace();
-            if (mInputStream.peek() == '}')
+            if (Peek() == '}')
             {
                 break;
             }
@@ -1066,7 +1121,7 @@ class MD5AnimParser : public MD5ParserBase
                 return false;
             }
 
-            frame.AnimationComponents.push_back(value);
+            mAnim.FrameComponents.push_back(value);
 
             numAcceptedAnimationComponents++;
         }
@@ -1105,11 +1160,18 @@ class MD5AnimParser : public MD5ParserBase
     {
         int numAcceptedFrames = 0;
 
+        // every component takes at least two characters of text,
+        // which keeps a bogus header from reserving absurd amounts of memory.
+        std::size_t numExpectedComponents =
+                std::size_t(mNumExpectedFrames) * mNumExpectedAnimatedComponents;
+        mAnim.FrameComponents.reserve(
+                    std::min(numExpectedComponents, std::size_t(mEnd - mCursor) / 2));
+
         while (true)
         {
             EatWhitespace();
 
-            if (mInputStream.peek() == std::stringstream::traits_type::eof())
+            if (AtEnd())
             {
                 break;
             }
@@ -1119,14 +1181,12 @@ class MD5AnimParser : public MD5ParserBase
                 AcceptInt(frameNumber) &&
                 RequireChar('{'))
             {
-                if (frameNumber != (int) mAnim.Frames.size())
+                if (frameNumber != numAcceptedFrames)
                 {
                     mError = "Incorrect frame index";
                     return false;
                 }
 
-                mAnim.Frames.emplace_back();
-
                 if (!AcceptAnimationComponents())
                 {
                     return false;
@@ -1160,16 +1220,9 @@ public:
             MD5Anim& anim,
             IReadFile& md5animFile,
             std::string& error)
-        : MD5ParserBase(error)
+        : MD5ParserBase(md5animFile, error)
         , mAnim(anim)
-    {
-        std::string line;
-        while (getline(line, md5animFile))
-        {
-            line = line.substr(0, line.find("//"));
-            mInputStream << line << '\n';
-        }
-    }
+    { }
 
     bool Parse() override
     {
@@ -3,320 +3,514 @@
 #include "ng/engine/filesystem/readfile.hpp"
 
 #include "ng/engine/util/scopeguard.hpp"
+#include "ng/engine/util/parallelfor.hpp"
+#include "ng/engine/util/charconv.hpp"
 #include "ng/engine/util/debug.hpp"
 
 #include "ng/framework/models/objmodel.hpp"
 
 #include <stdexcept>
-#include <sstream>
 
 namespace ng
 {
 
-bool TryLoadObj(
-        ObjModel& model,
-        IReadFile& objFile,
-        std::string& error)
+namespace
 {
-    ObjModel newShape;
 
-    error.clear();
+// files are only split across threads in chunks at least this big,
+// smaller ones aren't worth the thread startup.
+const std::size_t kMinObjChunkSize = 64 * 1024;
 
-    int lineno = 1;
+// the result of parsing a range of whole lines out of an obj file.
+// consistency between chunks (index presence, face size, group name)
+// is checked when the chunks are merged back together in file order.
+struct ObjChunk
+{
+    std::vector<vec4> Positions;
+    std::vector<vec3> Texcoords;
+    std::vector<vec3> Normals;
+    std::vector<int> Indices;
+
+    // negative (relative) indices are resolved against the attributes
+    // seen so far in this chunk. They still need to be offset by the
+    // number of attributes in all preceding chunks once those are known.
+    std::vector<std::size_t> PositionsToPatch;
+    std::vector<std::size_t> TexcoordsToPatch;
+    std::vector<std::size_t> NormalsToPatch;
+
+    std::string Name;
+    int NameLine = 0;
+
+    int PosIndexState = -1;
+    int TexIndexState = -1;
+    int NormIndexState = -1;
+    int VerticesPerFace = 0;
+    int FirstFaceLine = 0;
+
+    // lines are counted from the start of the chunk.
+    int NumLines = 0;
+
+    std::string Error;
+    int ErrorLine = 0;
+};
+
+// numbers have to span the whole token, "1.0abc" isn't a number.
+bool ParseFloat(string_view token, float& f)
+{
+    return parse_float(token.begin(), token.end(), f) == token.end();
+}
 
-    auto linenoErrorScope = make_scope_guard([&]{
-        if (error.length() > 0)
+bool ParseInt(string_view token, int& i)
+{
+    return parse_int(token.begin(), token.end(), i) == token.end();
+}
+
+// reads floats into dst until it runs into something that isn't one.
+// returns the number of floats that were on the line.
+template<class Vec>
+int ParseFloats(string_view& rest, Vec& dst, int maxComponents)
+{
+    int n = 0;
+
+    string_view remaining = rest;
+    for (string_view token; gettoken(token, remaining); n++)
+    {
+        float f;
+        if (!ParseFloat(token, f))
         {
-            error = "Line " + std::to_string(lineno)
-                  + ": " + error;
+            break;
         }
-    });
 
-    std::vector<std::size_t> negativePositionsToPatch;
-    std::vector<std::size_t> negativeTexcoordsToPatch;
-    std::vector<std::size_t> negativeNormalsToPatch;
+        if (n < maxComponents)
+        {
+            dst[n] = f;
+        }
 
-    int posIndexState = -1;
-    int texIndexState = -1;
-    int normIndexState = -1;
+        rest = remaining;
+    }
+
+    return n;
+}
 
-    for (std::string line; getline(line, objFile); lineno++)
+bool ParseFace(string_view rest, ObjChunk& chunk)
+{
+    int numVertices = 0;
+
+    for (string_view vertex; gettoken(vertex, rest); numVertices++)
     {
-        // strip comment
-        line = line.substr(0, line.find('#'));
+        // split "p/t/n", where any of them may be left empty.
+        std::size_t firstSlash = vertex.find('/');
+        string_view pidxToken = vertex.substr(0, firstSlash);
+        string_view tidxToken, nidxToken;
 
-        // strip leading whitespace
-        std::size_t firstNonWs = line.find_first_not_of(" \t\n\r");
-        line = line.substr(firstNonWs == std::string::npos ? 0 : firstNonWs);
+        if (firstSlash != string_view::npos)
+        {
+            string_view afterFirst = vertex.substr(firstSlash + 1);
+            std::size_t secondSlash = afterFirst.find('/');
+            tidxToken = afterFirst.substr(0, secondSlash);
 
-        // strip trailing whitespace
-        std::size_t lastNonWs = line.find_last_not_of(" \t\n\r");
-        line = line.substr(0, lastNonWs == std::string::npos ? 0 : lastNonWs + 1);
+            if (secondSlash != string_view::npos)
+            {
+                nidxToken = afterFirst.substr(secondSlash + 1);
+            }
+        }
+
+        bool haspidx = !pidxToken.empty();
+        bool hastidx = !tidxToken.empty();
+        bool hasnidx = !nidxToken.empty();
+
+        int pidx = 0, tidx = 0, nidx = 0;
 
-        // ignore empty lines
-        if (line.length() == 0)
+        if (haspidx && !ParseInt(pidxToken, pidx))
         {
-            continue;
+            chunk.Error = "Couldn't read position index";
+            return false;
         }
 
-        // dump it into a stream
-        std::stringstream ss;
-        ss << line;
+        if (hastidx && !ParseInt(tidxToken, tidx))
+        {
+            chunk.Error = "Couldn't read texcoord index";
+            return false;
+        }
 
-        // get the command
-        std::string command;
-        if (!(ss >> command))
+        if (hasnidx && !ParseInt(nidxToken, nidx))
         {
-            error = "Couldn't read command";
+            chunk.Error = "Couldn't read normal index";
             return false;
         }
 
-        if (command == "v")
+        if (chunk.FirstFaceLine == 0)
         {
-            float f;
-            int n;
-            newShape.Positions.emplace_back();
-            for (n = 0; ss >> f; n++)
-            {
-                if (n < 4)
-                    newShape.Positions.back()[n] = f;
-            }
+            chunk.FirstFaceLine = chunk.NumLines;
+            chunk.PosIndexState = haspidx;
+            chunk.TexIndexState = hastidx;
+            chunk.NormIndexState = hasnidx;
+        }
 
-            if (n < 3 || n > 4)
-            {
-                error = "Positions must be 3D or 4D";
-                return false;
-            }
+        if (chunk.PosIndexState != int(haspidx))
+        {
+            chunk.Error = "Inconsistency in position index presence";
+            return false;
         }
-        else if (command == "vt")
+
+        if (chunk.TexIndexState != int(hastidx))
         {
-            float f;
-            int n;
-            newShape.Texcoords.emplace_back();
-            for (n = 0; ss >> f; n++)
-            {
-                if (n < 3)
-                    newShape.Texcoords.back()[n] = f;
-            }
+            chunk.Error = "Inconsistency in texcoord index presence";
+            return false;
+        }
+
+        if (chunk.NormIndexState != int(hasnidx))
+        {
+            chunk.Error = "Inconsistency in normal index presence";
+            return false;
+        }
+
+        if ((haspidx && pidx == 0) || (hastidx && tidx == 0) || (hasnidx && nidx == 0))
+        {
+            chunk.Error = "0 is an invalid index for obj";
+            return false;
+        }
 
-            if (n < 2 || n > 3)
+        if (haspidx)
+        {
+            if (pidx < 0)
             {
-                error = "Texcoords must be 2D or 3D";
-                return false;
+                pidx = int(chunk.Positions.size()) + pidx + 1;
+                chunk.PositionsToPatch.push_back(chunk.Indices.size());
             }
+            chunk.Indices.push_back(pidx);
         }
-        else if (command == "vn")
+
+        if (hastidx)
         {
-            float f;
-            int n;
-            newShape.Normals.emplace_back();
-            for (n = 0; ss >> f; n++)
+            if (tidx < 0)
             {
-                if (n < 3)
-                    newShape.Normals.back()[n] = f;
+                tidx = int(chunk.Texcoords.size()) + tidx + 1;
+                chunk.TexcoordsToPatch.push_back(chunk.Indices.size());
             }
+            chunk.Indices.push_back(tidx);
+        }
 
-            if (n != 3)
+        if (hasnidx)
+        {
+            if (nidx < 0)
             {
-                error = "Normals must be 3D";
-                return false;
+                nidx = int(chunk.Normals.size()) + nidx + 1;
+                chunk.NormalsToPatch.push_back(chunk.Indices.size());
             }
+            chunk.Indices.push_back(nidx);
+        }
+    }
+
+    // the face size is validated when merging,
+    // since only the first face of the whole file decides it.
+    if (chunk.VerticesPerFace == 0)
+    {
+        chunk.VerticesPerFace = numVertices;
+    }
+    else if (chunk.VerticesPerFace != numVertices)
+    {
+        chunk.Error = "Inconsistent number of vertices per face";
+        return false;
+    }
+
+    return true;
+}
+
+bool ParseObjLine(string_view line, ObjChunk& chunk)
+{
+    // strip comment
+    line = line.substr(0, line.find('#'));
+
+    string_view rest = line;
+
+    // get the command, ignoring empty lines
+    string_view command;
+    if (!gettoken(command, rest))
+    {
+        return true;
+    }
+
+    if (command == "v")
+    {
+        chunk.Positions.emplace_back();
+        int n = ParseFloats(rest, chunk.Positions.back(), 4);
+        if (n < 3 || n > 4)
+        {
+            chunk.Error = "Positions must be 3D or 4D";
+            return false;
+        }
+    }
+    else if (command == "vt")
+    {
+        chunk.Texcoords.emplace_back();
+        int n = ParseFloats(rest, chunk.Texcoords.back(), 3);
+        if (n < 2 || n > 3)
+        {
+            chunk.Error = "Texcoords must be 2D or 3D";
+            return false;
+        }
+    }
+    else if (command == "vn")
+    {
+        chunk.Normals.emplace_back();
+        int n = ParseFloats(rest, chunk.Normals.back(), 3);
+        if (n != 3)
+        {
+            chunk.Error = "Normals must be 3D";
+            return false;
         }
-        else if (command == "f")
+    }
+    else if (command == "f")
+    {
+        if (!ParseFace(rest, chunk))
         {
-            int pidx, tidx, nidx;
-            bool haspidx = false, hastidx = false, hasnidx = false;
+            return false;
+        }
 
-            int numVertices = 0;
+        rest = string_view();
+    }
+    else if (command == "g")
+    {
+        if (chunk.Name.length() > 0)
+        {
+            chunk.Error = "Doesn't handle multiple group names";
+            return false;
+        }
 
-            while (ss.peek() != std::stringstream::traits_type::eof())
-            {
-                while (std::isspace(ss.peek()))
-                {
-                    ss.get();
-                }
+        string_view name;
+        if (!gettoken(name, rest))
+        {
+            chunk.Error = "Couldn't get group name";
+            return false;
+        }
 
-                if (ss.peek() != '/')
-                {
-                    if (!(ss >> pidx))
-                    {
-                        error = "Couldn't read position index";
-                        return false;
-                    }
+        chunk.Name = name.to_string();
+        chunk.NameLine = chunk.NumLines;
+    }
+    else
+    {
+        chunk.Error = "Unhandled command: " + command.to_string();
+        return false;
+    }
 
-                    haspidx = true;
-                }
+    if (!trim(rest).empty())
+    {
+        chunk.Error = "Extra text on line";
+        return false;
+    }
 
-                if (ss.peek() == '/')
-                {
-                    ss.get();
+    return true;
+}
 
-                    if (ss.peek() != '/')
-                    {
-                        if (!(ss >> tidx))
-                        {
-                            error = "Couldn't read texcoord index";
-                            return false;
-                        }
+void ParseObjChunk(string_view text, ObjChunk& chunk)
+{
+    for (string_view line; getline(line, text); )
+    {
+        chunk.NumLines++;
 
-                        hastidx = true;
-                    }
-                }
+        if (!ParseObjLine(line, chunk))
+        {
+            chunk.ErrorLine = chunk.NumLines;
+            return;
+        }
+    }
+}
 
-                if (ss.peek() == '/')
-                {
-                    ss.get();
+// splits text into about numChunks pieces, each ending on a line boundary.
+std::vector<string_view> SplitLines(string_view text, std::size_t numChunks)
+{
+    std::vector<string_view> chunks;
 
-                    if (ss.peek() != '/')
-                    {
-                        if (!(ss >> nidx))
-                        {
-                            error = "Couldn't read normal index";
-                            return false;
-                        }
+    std::size_t begin = 0;
+    for (std::size_t i = 1; i <= numChunks && begin < text.size(); i++)
+    {
+        std::size_t end = text.size();
 
-                        hasnidx = true;
-                    }
-                }
+        if (i < numChunks)
+        {
+            std::size_t newline = text.find('\n', std::max(begin, text.size() * i / numChunks));
+            end = newline == string_view::npos ? text.size() : newline + 1;
+        }
 
-                if (posIndexState == -1)
-                {
-                    posIndexState = haspidx;
-                    newShape.HasPositionIndices = haspidx;
-                }
-                else if (posIndexState != int(haspidx))
-                {
-                    error = "Inconsistency in position index presence";
-                    return false;
-                }
+        chunks.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
 
-                if (texIndexState == -1)
-                {
-                    texIndexState = hastidx;
-                    newShape.HasTexcoordIndices = hastidx;
-                }
-                else if (texIndexState != int(hastidx))
-                {
-                    error = "Inconsistency in texcoord index presence";
-                    return false;
-                }
+    return chunks;
+}
 
-                if (normIndexState == -1)
-                {
-                    normIndexState = hasnidx;
-                    newShape.HasNormalIndices = hasnidx;
-                }
-                else if (normIndexState != int(hasnidx))
-                {
-                    error = "Inconsistency in normal index presence";
-                    return false;
-                }
+template<class T>
+void Append(std::vector<T>& dst, const std::vector<T>& src)
+{
+    dst.insert(dst.end(), src.begin(), src.end());
+}
 
-                if (haspidx)
-                {
-                    if (pidx == 0)
-                    {
-                        error = "0 is an invalid index for obj";
-                        return false;
-                    }
-                    if (pidx < 0)
-                    {
-                        negativePositionsToPatch.push_back(newShape.Indices.size());
-                    }
-                    newShape.Indices.push_back(pidx);
-                }
+} // end anonymous namespace
 
-                if (hastidx)
-                {
-                    if (tidx == 0)
-                    {
-                        error = "0 is an invalid index for obj";
-                        return false;
-                    }
-                    if (tidx < 0)
-                    {
-                        negativeTexcoordsToPatch.push_back(newShape.Indices.size());
-                    }
-                    newShape.Indices.push_back(tidx);
-                }
+bool TryLoadObj(
+        ObjModel& model,
+        IReadFile& objFile,
+        std::string& error)
+{
+    ObjModel newShape;
 
-                if (hasnidx)
-                {
-                    if (nidx == 0)
-                    {
-                        error = "0 is an invalid index for obj";
-                        return false;
-                    }
-                    if (nidx < 0)
-                    {
-                        negativeNormalsToPatch.push_back(newShape.Indices.size());
-                    }
-                    newShape.Indices.push_back(nidx);
-                }
+    error.clear();
 
-                numVertices++;
-            }
+    int lineno = 1;
 
-            if (newShape.VerticesPerFace == 0)
-            {
-                if (numVertices < 3 || numVertices > 4)
-                {
-                    error = "Faces must be triangles or quads";
-                    return false;
-                }
+    auto linenoErrorScope = make_scope_guard([&]{
+        if (error.length() > 0)
+        {
+            error = "Line " + std::to_string(lineno)
+                  + ": " + error;
+        }
+    });
+
+    string_view contents = objFile.GetContents();
+
+    std::size_t numWorkers = std::min(
+                default_worker_count(),
+                std::max<std::size_t>(1, contents.size() / kMinObjChunkSize));
+
+    std::vector<string_view> chunkTexts = SplitLines(contents, numWorkers);
+    std::vector<ObjChunk> chunks(chunkTexts.size());
+
+    parallel_for(chunks.size(), numWorkers, [&](std::size_t i)
+    {
+        ParseObjChunk(chunkTexts[i], chunks[i]);
+    });
+
+    std::size_t numPositions = 0, numTexcoords = 0, numNormals = 0, numIndices = 0;
+    for (const ObjChunk& chunk : chunks)
+    {
+        numPositions += chunk.Positions.size();
+        numTexcoords += chunk.Texcoords.size();
+        numNormals += chunk.Normals.size();
+        numIndices += chunk.Indices.size();
+    }
+
+    newShape.Positions.reserve(numPositions);
+    newShape.Texcoords.reserve(numTexcoords);
+    newShape.Normals.reserve(numNormals);
+    newShape.Indices.reserve(numIndices);
+
+    int posIndexState = -1;
+    int texIndexState = -1;
+    int normIndexState = -1;
+
+    int firstLine = 0;
 
-                newShape.VerticesPerFace = numVertices;
+    for (ObjChunk& chunk : chunks)
+    {
+        // errors that depend on earlier chunks come before any error
+        // in this chunk, since the chunk stopped parsing at its own error.
+        bool faceConflicts = false;
+        bool nameConflicts = chunk.NameLine != 0 && newShape.Name.length() > 0;
+
+        if (chunk.FirstFaceLine != 0)
+        {
+            if (posIndexState != -1 && posIndexState != chunk.PosIndexState)
+            {
+                error = "Inconsistency in position index presence";
             }
-            else if (newShape.VerticesPerFace != numVertices)
+            else if (texIndexState != -1 && texIndexState != chunk.TexIndexState)
             {
-                error = "Inconsistent number of vertices per face";
-                return false;
+                error = "Inconsistency in texcoord index presence";
             }
-        }
-        else if (command == "g")
-        {
-            if (newShape.Name.length() > 0)
+            else if (normIndexState != -1 && normIndexState != chunk.NormIndexState)
             {
-                error = "Doesn't handle multiple group names";
-                return false;
+                error = "Inconsistency in normal index presence";
             }
-
-            if (!(ss >> newShape.Name))
+            else if (chunk.VerticesPerFace != 0)
             {
-                error = "Couldn't get group name";
-                return false;
+                if (newShape.VerticesPerFace == 0)
+                {
+                    if (chunk.VerticesPerFace < 3 || chunk.VerticesPerFace > 4)
+                    {
+                        error = "Faces must be triangles or quads";
+                    }
+                }
+                else if (newShape.VerticesPerFace != chunk.VerticesPerFace)
+                {
+                    error = "Inconsistent number of vertices per face";
+                }
             }
+
+            faceConflicts = !error.empty();
+        }
+
+        if (nameConflicts && (!faceConflicts || chunk.NameLine < chunk.FirstFaceLine))
+        {
+            error = "Doesn't handle multiple group names";
+            lineno = firstLine + chunk.NameLine;
+            return false;
         }
-        else
+        else if (faceConflicts)
         {
-            error = "Unhandled command: ";
-            error += command;
+            lineno = firstLine + chunk.FirstFaceLine;
             return false;
         }
 
-        if (ss.peek() != std::stringstream::traits_type::eof())
+        if (!chunk.Error.empty())
         {
-            error = "Extra text on line";
+            error = chunk.Error;
+            lineno = firstLine + chunk.ErrorLine;
             return false;
         }
-    }
 
-    // patch negative indices
-    for (std::size_t i : negativePositionsToPatch)
-    {
-        newShape.Indices[i] = newShape.Positions.size() + newShape.Indices[i] + 1;
-    }
+        if (chunk.FirstFaceLine != 0 && posIndexState == -1)
+        {
+            posIndexState = chunk.PosIndexState;
+            texIndexState = chunk.TexIndexState;
+            normIndexState = chunk.NormIndexState;
+            newShape.HasPositionIndices = posIndexState;
+            newShape.HasTexcoordIndices = texIndexState;
+            newShape.HasNormalIndices = normIndexState;
+        }
 
-    for (std::size_t i : negativeTexcoordsToPatch)
-    {
-        newShape.Indices[i] = newShape.Texcoords.size() + newShape.Indices[i] + 1;
-    }
+        if (newShape.VerticesPerFace == 0)
+        {
+            newShape.VerticesPerFace = chunk.VerticesPerFace;
+        }
 
-    for (std::size_t i : negativeNormalsToPatch)
-    {
-        newShape.Indices[i] = newShape.Normals.size() + newShape.Indices[i] + 1;
+        if (chunk.NameLine != 0)
+        {
+            newShape.Name = std::move(chunk.Name);
+        }
+
+        // make relative indices absolute now that the preceding chunks are known
+        std::size_t indexBase = newShape.Indices.size();
+
+        Append(newShape.Indices, chunk.Indices);
+
+        for (std::size_t i : chunk.PositionsToPatch)
+        {
+            newShape.Indices[indexBase + i] += int(newShape.Positions.size());
+        }
+
+        for (std::size_t i : chunk.TexcoordsToPatch)
+        {
+            newShape.Indices[indexBase + i] += int(newShape.Texcoords.size());
+        }
+
+        for (std::size_t i : chunk.NormalsToPatch)
+        {
+            newShape.Indices[indexBase + i] += int(newShape.Normals.size());
+        }
+
+        Append(newShape.Positions, chunk.Positions);
+        Append(newShape.Texcoords, chunk.Texcoords);
+        Append(newShape.Normals, chunk.Normals);
+
+        firstLine += chunk.NumLines;
+
+        // release the chunk's memory early, the merged copy can be large.
+        chunk = ObjChunk();
     }
 
+    lineno = firstLine + 1;
+
     // perform bounds-checking
     int indicesPerVertex = int(newShape.HasPositionIndices)
                          + int(newShape.HasTexcoordIndices)
@@ -330,7 +524,8 @@ bool TryLoadObj(
              i < newShape.Indices.size();
              i += indicesPerVertex)
         {
-            if (std::size_t(newShape.Indices[i]) > newShape.Positions.size())
+            if (newShape.Indices[i] < 1 ||
+                std::size_t(newShape.Indices[i]) > newShape.Positions.size())
             {
                 error = "Position index out of bounds";
                 return false;
@@ -345,7 +540,8 @@ bool TryLoadObj(
              i < newShape.Indices.size();
              i += indicesPerVertex)
         {
-            if (std::size_t(newShape.Indices[i]) > newShape.Texcoords.size())
+            if (newShape.Indices[i] < 1 ||
+                std::size_t(newShape.Indices[i]) > newShape.Texcoords.size())
             {
                 error = "Texcoord index out of bounds";
                 return false;
@@ -361,7 +557,8 @@ bool TryLoadObj(
              i < newShape.Indices.size();
              i += indicesPerVertex)
         {
-            if (std::size_t(newShape.Indices[i]) > newShape.Normals.size())
+            if (newShape.Indices[i] < 1 ||
+                std::size_t(newShape.Indices[i]) > newShape.Normals.size())
             {
                 error = "Normal index out of bounds";
                 return false;
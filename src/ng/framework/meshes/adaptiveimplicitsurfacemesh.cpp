@@ -0,0 +1,747 @@
+#include "ng/framework/meshes/adaptiveimplicitsurfacemesh.hpp"
+
+#include "ng/engine/util/parallelfor.hpp"
+
+#include <cstddef>
+#include <array>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace ng
+{
+
+namespace
+{
+
+constexpr std::uint32_t kNoNode = std::numeric_limits<std::uint32_t>::max();
+constexpr std::uint32_t kNoVertex = std::numeric_limits<std::uint32_t>::max();
+
+// the octree can't be deeper than this, so sizes fit comfortably in an int.
+constexpr int kMaxDepth = 20;
+
+// corner (and child) i of a cell is at offset (bit 0, bit 1, bit 2) along (x, y, z).
+ivec3 CornerOffset(int corner)
+{
+    return ivec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1);
+}
+
+// the edges of a cell as pairs of corners, going in the +x, +y and +z direction.
+const std::array<std::pair<int,int>,12> kCellEdges = {{
+    {0,1}, {2,3}, {4,5}, {6,7},
+    {0,2}, {1,3}, {4,6}, {5,7},
+    {0,4}, {1,5}, {2,6}, {3,7}
+}};
+
+class OctreeNode
+{
+public:
+    // in units of the smallest cells.
+    ivec3 Minimum;
+    int Size;
+    int Depth;
+
+    std::array<float,8> Corners;
+
+    std::uint32_t FirstChild = kNoNode;
+    std::uint32_t Vertex = kNoVertex;
+};
+
+// leaves around an edge of the octree, in counter-clockwise order seen
+// from the end the surface normal points to.
+class Polygon
+{
+public:
+    std::array<std::uint32_t,4> Leaves;
+
+    // size of the edge, in units of the smallest cells.
+    int EdgeSize;
+};
+
+class AdaptivePolygonizer
+{
+    const ImplicitSurfaceField& mField;
+    const float mIsoValue;
+    const AdaptiveImplicitSurfaceOptions& mOptions;
+    const std::size_t mNumWorkers;
+
+    std::vector<OctreeNode> mNodes;
+
+    // polygons around the edges owned by each leaf, indexed like mNodes.
+    std::vector<std::vector<Polygon>> mNodePolygons;
+
+    vec3 ToWorld(ivec3 point) const
+    {
+        return vec3(point) * mOptions.MinVoxelSize;
+    }
+
+    float GetTolerance(vec3 position) const
+    {
+        if (mOptions.UseCamera && mOptions.PixelsPerUnit > 0.0f)
+        {
+            float distance = std::max(length(position - mOptions.CameraPosition), mOptions.MinVoxelSize);
+            return mOptions.MaxScreenSpaceError * distance / mOptions.PixelsPerUnit;
+        }
+
+        return mOptions.MaxGeometricError;
+    }
+
+    // decides whether a node needs splitting from the field and its gradient
+    // sampled at the node's corners (in corner order) followed by its center.
+    bool ShouldSplit(
+            OctreeNode& node,
+            const std::array<float,9>& values,
+            const std::array<vec3,9>& gradients) const
+    {
+        std::copy(values.begin(), values.begin() + 8, node.Corners.begin());
+
+        if (node.Size == 1)
+        {
+            return false;
+        }
+
+        // big cells are split regardless, their few samples can miss the surface entirely.
+        const float cellSize = node.Size * mOptions.MinVoxelSize;
+        if (cellSize > mOptions.MaxVoxelSize)
+        {
+            return true;
+        }
+
+        // the surface can only pass through the cell if the field crosses the iso value
+        // within the cell, assuming it changes no faster than its steepest gradient.
+        const float halfDiagonal = cellSize * std::sqrt(3.0f) * 0.5f;
+
+        bool anyInside = false;
+        bool anyOutside = false;
+        float maxSlope = 0.0f;
+        for (std::size_t i = 0; i < values.size(); i++)
+        {
+            anyInside |= values[i] >= mIsoValue;
+            anyOutside |= values[i] < mIsoValue;
+            maxSlope = std::max(maxSlope, length(gradients[i]));
+        }
+
+        if (!(anyInside && anyOutside) && std::abs(values[8] - mIsoValue) > maxSlope * halfDiagonal)
+        {
+            return false;
+        }
+
+        const float tolerance = GetTolerance(ToWorld(node.Minimum) + vec3(cellSize * 0.5f));
+
+        // distance between the surface and the trilinear interpolation of the corners,
+        // estimated at the center of the cell.
+        float trilinear = 0.0f;
+        for (int corner = 0; corner < 8; corner++)
+        {
+            trilinear += values[corner];
+        }
+        trilinear /= 8.0f;
+
+        float centerSlope = length(gradients[8]);
+        if (centerSlope > 0.0f && std::abs(values[8] - trilinear) / centerSlope > tolerance)
+        {
+            return true;
+        }
+
+        // the surface curves a lot in the cell. not worth splitting cells
+        // which are already smaller than the error that is tolerated.
+        if (cellSize > tolerance && centerSlope > 0.0f)
+        {
+            const float minCos = std::cos(mOptions.MaxNormalDeviation.Value);
+            vec3 centerNormal = gradients[8] / centerSlope;
+
+            for (int corner = 0; corner < 8; corner++)
+            {
+                float slope = length(gradients[corner]);
+                if (slope > 0.0f && dot(gradients[corner] / slope, centerNormal) < minCos)
+                {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    bool EvaluateNode(OctreeNode& node) const
+    {
+        std::array<vec3,9> positions;
+        for (int corner = 0; corner < 8; corner++)
+        {
+            positions[corner] = ToWorld(node.Minimum + CornerOffset(corner) * node.Size);
+        }
+        positions[8] = ToWorld(node.Minimum) + vec3(node.Size * mOptions.MinVoxelSize * 0.5f);
+
+        std::array<float,9> values;
+        std::array<vec3,9> gradients;
+        mField.GetFieldValuesAndGradients(positions.data(), values.data(), gradients.data(), positions.size());
+
+        return ShouldSplit(node, values, gradients);
+    }
+
+    // the children of a node share the 27 points of a 3x3x3 lattice,
+    // which are sampled in one go along with the 8 centers of the children.
+    void EvaluateChildren(std::uint32_t parent, char* split)
+    {
+        const OctreeNode& node = mNodes[parent];
+        const int half = node.Size / 2;
+
+        std::array<vec3,35> positions;
+        for (int z = 0; z < 3; z++)
+        {
+            for (int y = 0; y < 3; y++)
+            {
+                for (int x = 0; x < 3; x++)
+                {
+                    positions[(z * 3 + y) * 3 + x] = ToWorld(node.Minimum + ivec3(x, y, z) * half);
+                }
+            }
+        }
+        for (int child = 0; child < 8; child++)
+        {
+            positions[27 + child] = ToWorld(mNodes[node.FirstChild + child].Minimum)
+                                  + vec3(half * mOptions.MinVoxelSize * 0.5f);
+        }
+
+        std::array<float,35> values;
+        std::array<vec3,35> gradients;
+        mField.GetFieldValuesAndGradients(positions.data(), values.data(), gradients.data(), positions.size());
+
+        for (int child = 0; child < 8; child++)
+        {
+            std::array<float,9> childValues;
+            std::array<vec3,9> childGradients;
+            for (int corner = 0; corner < 8; corner++)
+            {
+                ivec3 point = CornerOffset(child) + CornerOffset(corner);
+                childValues[corner] = values[(point.z * 3 + point.y) * 3 + point.x];
+                childGradients[corner] = gradients[(point.z * 3 + point.y) * 3 + point.x];
+            }
+            childValues[8] = values[27 + child];
+            childGradients[8] = gradients[27 + child];
+
+            split[child] = ShouldSplit(mNodes[node.FirstChild + child], childValues, childGradients);
+        }
+    }
+
+    void SplitNode(std::uint32_t parent)
+    {
+        mNodes[parent].FirstChild = mNodes.size();
+
+        for (int child = 0; child < 8; child++)
+        {
+            OctreeNode node;
+            node.Size = mNodes[parent].Size / 2;
+            node.Minimum = mNodes[parent].Minimum + CornerOffset(child) * node.Size;
+            node.Depth = mNodes[parent].Depth + 1;
+            mNodes.push_back(node);
+        }
+    }
+
+    // evaluates the children of the split nodes and splits them for as long as
+    // they need it, one depth at a time, evaluating the nodes of a depth in parallel.
+    void Refine(std::vector<std::uint32_t> parents)
+    {
+        while (!parents.empty())
+        {
+            std::vector<char> split(parents.size() * 8);
+            parallel_for(parents.size(), mNumWorkers, [&](std::size_t i)
+            {
+                EvaluateChildren(parents[i], &split[i * 8]);
+            });
+
+            std::vector<std::uint32_t> nextParents;
+            for (std::size_t i = 0; i < parents.size(); i++)
+            {
+                for (int child = 0; child < 8; child++)
+                {
+                    if (split[i * 8 + child])
+                    {
+                        std::uint32_t node = mNodes[parents[i]].FirstChild + child;
+                        SplitNode(node);
+                        nextParents.push_back(node);
+                    }
+                }
+            }
+
+            parents.swap(nextParents);
+        }
+    }
+
+    std::vector<std::uint32_t> GetLeaves(std::uint32_t firstNode) const
+    {
+        std::vector<std::uint32_t> leaves;
+        for (std::uint32_t i = firstNode; i < mNodes.size(); i++)
+        {
+            if (mNodes[i].FirstChild == kNoNode)
+            {
+                leaves.push_back(i);
+            }
+        }
+        return leaves;
+    }
+
+    void ContourLeaves(const std::vector<std::uint32_t>& leaves)
+    {
+        mNodePolygons.resize(mNodes.size());
+        parallel_for(leaves.size(), mNumWorkers, [&](std::size_t i)
+        {
+            mNodePolygons[leaves[i]].clear();
+            EmitPolygons(leaves[i], mNodePolygons[leaves[i]]);
+        });
+    }
+
+    // a leaf that only touches the surface on its boundary can't tell from its samples,
+    // and would join the small polygons around it into long thin triangles cutting
+    // through the surface. such leaves are split until they are at most twice as
+    // big as the edges around them, which keeps the transitions between levels smooth.
+    // returns the leaves whose polygons have to be contoured again.
+    std::vector<std::uint32_t> SplitCoarseLeaves()
+    {
+        std::vector<std::uint32_t> coarseLeaves;
+        for (const std::vector<Polygon>& polygons : mNodePolygons)
+        {
+            for (const Polygon& polygon : polygons)
+            {
+                for (std::uint32_t leaf : polygon.Leaves)
+                {
+                    if (mNodes[leaf].Size > 2 * polygon.EdgeSize)
+                    {
+                        coarseLeaves.push_back(leaf);
+                    }
+                }
+            }
+        }
+
+        if (coarseLeaves.empty())
+        {
+            return std::vector<std::uint32_t>();
+        }
+
+        std::sort(coarseLeaves.begin(), coarseLeaves.end());
+        coarseLeaves.erase(std::unique(coarseLeaves.begin(), coarseLeaves.end()), coarseLeaves.end());
+
+        // the edges around a split leaf may now belong to another leaf.
+        std::vector<std::uint32_t> recontoured;
+        for (std::uint32_t owner = 0; owner < mNodePolygons.size(); owner++)
+        {
+            for (const Polygon& polygon : mNodePolygons[owner])
+            {
+                bool touchesCoarseLeaf = std::any_of(
+                            polygon.Leaves.begin(), polygon.Leaves.end(),
+                            [&](std::uint32_t leaf) {
+                    return std::binary_search(coarseLeaves.begin(), coarseLeaves.end(), leaf);
+                });
+
+                if (touchesCoarseLeaf)
+                {
+                    recontoured.push_back(owner);
+                    break;
+                }
+            }
+        }
+
+        const std::uint32_t firstNewNode = mNodes.size();
+
+        for (std::uint32_t leaf : coarseLeaves)
+        {
+            mNodePolygons[leaf].clear();
+            SplitNode(leaf);
+        }
+
+        Refine(coarseLeaves);
+
+        std::vector<std::uint32_t> newLeaves = GetLeaves(firstNewNode);
+        recontoured.erase(std::remove_if(recontoured.begin(), recontoured.end(), [this](std::uint32_t node) {
+            return mNodes[node].FirstChild != kNoNode;
+        }), recontoured.end());
+        recontoured.insert(recontoured.end(), newLeaves.begin(), newLeaves.end());
+
+        return recontoured;
+    }
+
+    // finds the leaf containing the smallest cell whose minimum is at the given point.
+    std::uint32_t FindLeaf(ivec3 cell) const
+    {
+        const OctreeNode& root = mNodes[0];
+        for (std::size_t i = 0; i < 3; i++)
+        {
+            if (cell[i] < root.Minimum[i] || cell[i] >= root.Minimum[i] + root.Size)
+            {
+                return kNoNode;
+            }
+        }
+
+        std::uint32_t index = 0;
+        while (mNodes[index].FirstChild != kNoNode)
+        {
+            const OctreeNode& node = mNodes[index];
+            int half = node.Size / 2;
+            ivec3 relative = cell - node.Minimum;
+            int child = (relative.x >= half) | ((relative.y >= half) << 1) | ((relative.z >= half) << 2);
+            index = node.FirstChild + child;
+        }
+        return index;
+    }
+
+    // an edge of a leaf is only contoured by the leaf if no smaller leaf splits it,
+    // and if it comes first among the leaves of the same size around it.
+    void EmitPolygons(std::uint32_t leafIndex, std::vector<Polygon>& polygons) const
+    {
+        const OctreeNode& leaf = mNodes[leafIndex];
+
+        for (std::size_t edge = 0; edge < kCellEdges.size(); edge++)
+        {
+            int first = kCellEdges[edge].first;
+            int second = kCellEdges[edge].second;
+
+            bool firstInside = leaf.Corners[first] >= mIsoValue;
+            if (firstInside == (leaf.Corners[second] >= mIsoValue))
+            {
+                continue;
+            }
+
+            int axis = static_cast<int>(edge / 4);
+            int u = (axis + 1) % 3;
+            int v = (axis + 2) % 3;
+            ivec3 start = leaf.Minimum + CornerOffset(first) * leaf.Size;
+
+            // the cells around the edge, counter-clockwise around the axis.
+            static const std::array<std::pair<int,int>,4> kQuadrants = {{
+                { -1, -1 }, { 0, -1 }, { 0, 0 }, { -1, 0 }
+            }};
+
+            Polygon polygon;
+            polygon.EdgeSize = leaf.Size;
+
+            bool owned = true;
+            bool foundOwner = false;
+            for (std::size_t q = 0; q < kQuadrants.size() && owned; q++)
+            {
+                ivec3 cell = start;
+                cell[u] += kQuadrants[q].first;
+                cell[v] += kQuadrants[q].second;
+
+                std::uint32_t neighbour = FindLeaf(cell);
+                if (neighbour == kNoNode || mNodes[neighbour].Size < leaf.Size)
+                {
+                    owned = false;
+                }
+                else if (mNodes[neighbour].Size == leaf.Size && !foundOwner)
+                {
+                    foundOwner = true;
+                    owned = neighbour == leafIndex;
+                }
+
+                polygon.Leaves[q] = neighbour;
+            }
+
+            if (!owned)
+            {
+                continue;
+            }
+
+            // the field decreases going out of the surface,
+            // so the surface faces the end of the edge which is outside.
+            if (!firstInside)
+            {
+                std::reverse(polygon.Leaves.begin(), polygon.Leaves.end());
+            }
+
+            polygons.push_back(polygon);
+        }
+    }
+
+    // places the vertex at the average of the surface crossings on the leaf's edges,
+    // then pulls it onto the surface with a couple of Newton steps along the gradient.
+    void CreateVertex(const OctreeNode& leaf, vec3& position, vec3& normal) const
+    {
+        vec3 minimum = ToWorld(leaf.Minimum);
+        vec3 maximum = ToWorld(leaf.Minimum + ivec3(leaf.Size));
+
+        vec3 sum(0.0f);
+        int numCrossings = 0;
+        for (const std::pair<int,int>& edge : kCellEdges)
+        {
+            float v1 = leaf.Corners[edge.first];
+            float v2 = leaf.Corners[edge.second];
+            if ((v1 >= mIsoValue) != (v2 >= mIsoValue))
+            {
+                vec3 p1 = ToWorld(leaf.Minimum + CornerOffset(edge.first) * leaf.Size);
+                vec3 p2 = ToWorld(leaf.Minimum + CornerOffset(edge.second) * leaf.Size);
+                sum += p1 + (mIsoValue - v1) * (p2 - p1) / (v2 - v1);
+                numCrossings++;
+            }
+        }
+
+        position = numCrossings > 0 ? sum / static_cast<float>(numCrossings)
+                                    : (minimum + maximum) * 0.5f;
+
+        vec3 gradient;
+        for (int step = 0; step < 2; step++)
+        {
+            float value = mField.GetFieldValueAndGradient(position, gradient);
+            float slope2 = dot(gradient, gradient);
+            if (slope2 <= 0.0f)
+            {
+                break;
+            }
+
+            position -= (value - mIsoValue) / slope2 * gradient;
+
+            // stay in the leaf, or neighbouring polygons may fold over.
+            for (std::size_t i = 0; i < 3; i++)
+            {
+                position[i] = std::min(std::max(position[i], minimum[i]), maximum[i]);
+            }
+        }
+
+        mField.GetFieldValueAndGradient(position, gradient);
+        normal = normalize(-gradient);
+    }
+
+public:
+    AdaptivePolygonizer(
+            const ImplicitSurfaceField& field,
+            float isoValue,
+            const AdaptiveImplicitSurfaceOptions& options)
+        : mField(field)
+        , mIsoValue(isoValue)
+        , mOptions(options)
+        , mNumWorkers(default_worker_count())
+    { }
+
+    template<class VertexT>
+    void Polygonize(
+            const AxisAlignedBoundingBox<float>& bounds,
+            std::vector<VertexT>& vertices,
+            std::vector<std::uint32_t>& indices,
+            AdaptiveImplicitSurfaceStats& stats)
+    {
+        // one empty cell of padding around the bounds, so the surface is closed.
+        ivec3 minimum, maximum;
+        for (std::size_t i = 0; i < 3; i++)
+        {
+            minimum[i] = static_cast<int>(std::floor(bounds.Minimum[i] / mOptions.MinVoxelSize)) - 1;
+            maximum[i] = static_cast<int>(std::ceil(bounds.Maximum[i] / mOptions.MinVoxelSize)) + 1;
+        }
+
+        int extent = std::max(maximum.x - minimum.x, std::max(maximum.y - minimum.y, maximum.z - minimum.z));
+        int rootSize = 1;
+        while (rootSize < extent)
+        {
+            rootSize *= 2;
+            if (rootSize > (1 << kMaxDepth))
+            {
+                throw std::logic_error("MinVoxelSize is too small for the size of the surface");
+            }
+        }
+
+        OctreeNode root;
+        root.Minimum = minimum;
+        root.Size = rootSize;
+        root.Depth = 0;
+        mNodes.push_back(root);
+
+        if (EvaluateNode(mNodes[0]))
+        {
+            SplitNode(0);
+            Refine(std::vector<std::uint32_t>(1, 0));
+        }
+
+        for (std::vector<std::uint32_t> leaves = GetLeaves(0); !leaves.empty(); leaves = SplitCoarseLeaves())
+        {
+            ContourLeaves(leaves);
+        }
+
+        // every leaf around a contoured edge needs a vertex, even when the
+        // surface doesn't cross its own edges (eg. next to smaller leaves.)
+        std::vector<std::uint32_t> vertexLeaves;
+        for (const std::vector<Polygon>& polygons : mNodePolygons)
+        {
+            for (const Polygon& polygon : polygons)
+            {
+                for (std::uint32_t leaf : polygon.Leaves)
+                {
+                    if (mNodes[leaf].Vertex == kNoVertex)
+                    {
+                        mNodes[leaf].Vertex = vertexLeaves.size();
+                        vertexLeaves.push_back(leaf);
+                    }
+                }
+            }
+        }
+
+        vertices.resize(vertexLeaves.size());
+        parallel_for(vertexLeaves.size(), mNumWorkers, [&](std::size_t i)
+        {
+            CreateVertex(mNodes[vertexLeaves[i]], vertices[i].Position, vertices[i].Normal);
+        });
+
+        stats = AdaptiveImplicitSurfaceStats();
+
+        for (const std::vector<Polygon>& polygons : mNodePolygons)
+        {
+            for (const Polygon& polygon : polygons)
+            {
+                // leaves bigger than the edge can appear more than once around it.
+                std::array<std::uint32_t,4> corners;
+                std::size_t numCorners = 0;
+                for (std::size_t i = 0; i < polygon.Leaves.size(); i++)
+                {
+                    std::uint32_t vertex = mNodes[polygon.Leaves[i]].Vertex;
+                    if (numCorners == 0 || (corners[numCorners - 1] != vertex && corners[0] != vertex))
+                    {
+                        corners[numCorners++] = vertex;
+                    }
+                }
+
+                for (std::size_t i = 2; i < numCorners; i++)
+                {
+                    indices.push_back(corners[0]);
+                    indices.push_back(corners[i - 1]);
+                    indices.push_back(corners[i]);
+                }
+
+                // a uniform grid would need two triangles per smallest cell
+                // of the area the polygon covers.
+                stats.NumUniformTriangles += 2 * polygon.EdgeSize * polygon.EdgeSize;
+            }
+        }
+
+        stats.NumTriangles = indices.size() / 3;
+        stats.NumVertices = vertices.size();
+        std::vector<std::uint32_t> leaves = GetLeaves(0);
+        stats.NumLeaves = leaves.size();
+        for (std::uint32_t leaf : leaves)
+        {
+            std::size_t depth = mNodes[leaf].Depth;
+            if (stats.NumLeavesPerDepth.size() <= depth)
+            {
+                stats.NumLeavesPerDepth.resize(depth + 1);
+            }
+            stats.NumLeavesPerDepth[depth]++;
+        }
+    }
+};
+
+} // end anonymous namespace
+
+AdaptiveImplicitSurfaceMesh::AdaptiveImplicitSurfaceMesh(
+        std::vector<ImplicitSurfacePrimitive> primitives,
+        float isoValue,
+        const AdaptiveImplicitSurfaceOptions& options)
+{
+    if (!(options.MinVoxelSize > 0.0f))
+    {
+        throw std::logic_error("MinVoxelSize must be > 0");
+    }
+
+    if (primitives.empty())
+    {
+        return;
+    }
+
+    // the octree has to cover every place the surface can be.
+    AxisAlignedBoundingBox<float> bounds = primitives[0].GetSupportBounds();
+    for (const ImplicitSurfacePrimitive& primitive : primitives)
+    {
+        AxisAlignedBoundingBox<float> support = primitive.GetSupportBounds();
+        bounds.AddPoint(support.Minimum);
+        bounds.AddPoint(support.Maximum);
+    }
+
+    for (std::size_t i = 0; i < 3; i++)
+    {
+        if (!std::isfinite(bounds.Minimum[i]) || !std::isfinite(bounds.Maximum[i]))
+        {
+            throw std::logic_error("Adaptive polygonization needs primitives with bounded support");
+        }
+    }
+
+    ImplicitSurfaceField field(std::move(primitives), options.MinVoxelSize);
+
+    AdaptivePolygonizer polygonizer(field, isoValue, options);
+    polygonizer.Polygonize(bounds, mVertices, mIndices, mStats);
+}
+
+const AdaptiveImplicitSurfaceStats& AdaptiveImplicitSurfaceMesh::GetStats() const
+{
+    return mStats;
+}
+
+VertexFormat AdaptiveImplicitSurfaceMesh::GetVertexFormat() const
+{
+    VertexFormat fmt;
+
+    fmt.PrimitiveType = PrimitiveType::Triangles;
+
+    fmt.Position = VertexAttribute(
+                3,
+                ArithmeticType::Float,
+                false,
+                sizeof(AdaptiveImplicitSurfaceMesh::Vertex),
+                offsetof(AdaptiveImplicitSurfaceMesh::Vertex, Position));
+
+    fmt.Normal = VertexAttribute(
+                3,
+                ArithmeticType::Float,
+                false,
+                sizeof(AdaptiveImplicitSurfaceMesh::Vertex),
+                offsetof(AdaptiveImplicitSurfaceMesh::Vertex, Normal));
+
+    fmt.IsIndexed = true;
+    fmt.IndexType = GetIndexType();
+    fmt.IndexOffset = 0;
+
+    return fmt;
+}
+
+ArithmeticType AdaptiveImplicitSurfaceMesh::GetIndexType() const
+{
+    return mVertices.size() <= std::numeric_limits<std::uint16_t>::max() + 1
+         ? ArithmeticType::UInt16
+         : ArithmeticType::UInt32;
+}
+
+std::size_t AdaptiveImplicitSurfaceMesh::GetMaxVertexBufferSize() const
+{
+    return mVertices.size() * sizeof(AdaptiveImplicitSurfaceMesh::Vertex);
+}
+
+std::size_t AdaptiveImplicitSurfaceMesh::GetMaxIndexBufferSize() const
+{
+    return mIndices.size() * SizeOfArithmeticType(GetIndexType());
+}
+
+std::size_t AdaptiveImplicitSurfaceMesh::WriteVertices(void* buffer) const
+{
+    if (buffer != nullptr)
+    {
+        std::copy(mVertices.begin(), mVertices.end(),
+                  static_cast<AdaptiveImplicitSurfaceMesh::Vertex*>(buffer));
+    }
+
+    return mVertices.size();
+}
+
+std::size_t AdaptiveImplicitSurfaceMesh::WriteIndices(void* buffer) const
+{
+    if (buffer != nullptr)
+    {
+        if (GetIndexType() == ArithmeticType::UInt16)
+        {
+            std::copy(mIndices.begin(), mIndices.end(),
+                      static_cast<std::uint16_t*>(buffer));
+        }
+        else
+        {
+            std::copy(mIndices.begin(), mIndices.end(),
+                      static_cast<std::uint32_t*>(buffer));
+        }
+    }
+
+    return mIndices.size();
+}
+
+} // end namespace ng
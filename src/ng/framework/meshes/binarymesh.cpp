@@ -0,0 +1,379 @@
+#include "ng/framework/meshes/binarymesh.hpp"
+
+#include "ng/engine/filesystem/readfile.hpp"
+
+#include "ng/engine/util/rangecheck.hpp"
+#include "ng/engine/util/scopeguard.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ng
+{
+
+namespace
+{
+
+// Layout of an .ngmesh file, all in the byte order of the machine that wrote it:
+//
+//   NGMeshHeader
+//   vertex data, starting at VertexDataOffset
+//   index data, starting at IndexDataOffset
+//
+// Both blobs start on a kBlobAlignment boundary, so they are suitably
+// aligned for any vertex or index type once the file is mapped.
+// Bump kNGMeshVersion whenever the layout changes.
+
+const char kNGMeshMagic[4] = { 'N', 'G', 'M', 'S' };
+const std::uint32_t kNGMeshVersion = 1;
+const std::uint32_t kNGMeshByteOrderMark = 0x01020304;
+const std::size_t kBlobAlignment = 64;
+
+struct NGMeshAttribute
+{
+    std::uint8_t Enabled;
+    std::uint8_t Type;
+    std::uint8_t Normalized;
+    std::uint8_t Padding;
+    std::uint32_t Cardinality;
+    std::int64_t Stride;
+    std::uint64_t Offset;
+};
+
+static_assert(sizeof(NGMeshAttribute) == 24, "NGMeshAttribute must not have implicit padding");
+
+const std::size_t kNumNGMeshAttributes = 6;
+
+struct NGMeshHeader
+{
+    char Magic[4];
+    std::uint32_t Version;
+    std::uint32_t ByteOrderMark;
+    std::uint32_t PrimitiveType;
+
+    // Position, Normal, TexCoord0, Color, JointIndices, JointWeights
+    NGMeshAttribute Attributes[kNumNGMeshAttributes];
+
+    std::uint8_t IsIndexed;
+    std::uint8_t IndexType;
+    std::uint8_t Padding[6];
+    std::uint64_t IndexOffset;
+
+    std::uint64_t NumVertices;
+    std::uint64_t VertexDataOffset;
+    std::uint64_t VertexDataSize;
+
+    std::uint64_t NumIndices;
+    std::uint64_t IndexDataOffset;
+    std::uint64_t IndexDataSize;
+};
+
+static_assert(sizeof(NGMeshHeader) == 224, "NGMeshHeader must not have implicit padding");
+
+std::array<VertexAttribute*,kNumNGMeshAttributes> GetSerializedAttributes(VertexFormat& fmt)
+{
+    return {{
+        &fmt.Position, &fmt.Normal, &fmt.TexCoord0,
+        &fmt.Color, &fmt.JointIndices, &fmt.JointWeights
+    }};
+}
+
+bool IsValidArithmeticType(std::uint32_t type)
+{
+    return type <= std::uint32_t(ArithmeticType::Double);
+}
+
+std::uint64_t AlignBlob(std::uint64_t offset)
+{
+    return (offset + kBlobAlignment - 1) / kBlobAlignment * kBlobAlignment;
+}
+
+// checks that count elements of elementSize bytes, the first at offset
+// and each stride bytes after the last, lie within a blob of blobSize bytes.
+bool FitsInBlob(std::uint64_t offset, std::uint64_t stride, std::uint64_t elementSize,
+                std::uint64_t count, std::uint64_t blobSize)
+{
+    if (count == 0)
+    {
+        return true;
+    }
+
+    if (!is_in_range(offset, elementSize, blobSize))
+    {
+        return false;
+    }
+
+    std::uint64_t room = blobSize - offset - elementSize;
+    return count - 1 == 0 || (stride != 0 && count - 1 <= room / stride);
+}
+
+} // end anonymous namespace
+
+BinaryMesh::BinaryMesh(std::shared_ptr<IReadFile> ngmeshFile)
+    : mFile(std::move(ngmeshFile))
+{
+    string_view contents = mFile->GetContents();
+
+    NGMeshHeader header;
+
+    if (contents.size() < sizeof(header))
+    {
+        throw std::runtime_error("Not an .ngmesh file: too small for the header");
+    }
+
+    std::memcpy(&header, contents.data(), sizeof(header));
+
+    if (std::memcmp(header.Magic, kNGMeshMagic, sizeof(kNGMeshMagic)) != 0)
+    {
+        throw std::runtime_error("Not an .ngmesh file: bad magic number");
+    }
+
+    if (header.ByteOrderMark != kNGMeshByteOrderMark)
+    {
+        throw std::runtime_error(".ngmesh file was written with a different byte order");
+    }
+
+    if (header.Version != kNGMeshVersion)
+    {
+        throw std::runtime_error(
+                    "Unsupported .ngmesh version " + std::to_string(header.Version)
+                  + " (expected " + std::to_string(kNGMeshVersion) + ")");
+    }
+
+    if (header.PrimitiveType > std::uint32_t(PrimitiveType::Lines))
+    {
+        throw std::runtime_error("Corrupt .ngmesh file: invalid primitive type");
+    }
+
+    mVertexFormat.PrimitiveType = static_cast<PrimitiveType>(header.PrimitiveType);
+
+    std::array<VertexAttribute*,kNumNGMeshAttributes> attributes =
+            GetSerializedAttributes(mVertexFormat);
+
+    for (std::size_t i = 0; i < kNumNGMeshAttributes; i++)
+    {
+        const NGMeshAttribute& serialized = header.Attributes[i];
+
+        if (!serialized.Enabled)
+        {
+            continue;
+        }
+
+        if (!IsValidArithmeticType(serialized.Type))
+        {
+            throw std::runtime_error("Corrupt .ngmesh file: invalid attribute type");
+        }
+
+        *attributes[i] = VertexAttribute(
+                    serialized.Cardinality,
+                    static_cast<ArithmeticType>(serialized.Type),
+                    serialized.Normalized != 0,
+                    serialized.Stride,
+                    serialized.Offset);
+    }
+
+    mVertexFormat.IsIndexed = header.IsIndexed != 0;
+
+    if (mVertexFormat.IsIndexed)
+    {
+        if (!IsValidArithmeticType(header.IndexType))
+        {
+            throw std::runtime_error("Corrupt .ngmesh file: invalid index type");
+        }
+
+        mVertexFormat.IndexType = static_cast<ArithmeticType>(header.IndexType);
+        mVertexFormat.IndexOffset = header.IndexOffset;
+    }
+
+    if (!is_in_range(header.VertexDataOffset, header.VertexDataSize, contents.size()) ||
+        !is_in_range(header.IndexDataOffset, header.IndexDataSize, contents.size()))
+    {
+        throw std::runtime_error("Corrupt .ngmesh file: data is out of bounds");
+    }
+
+    // the counts must not promise more than the blobs hold, or the mesh
+    // would be drawn reading past them.
+    for (std::size_t i = 0; i < kNumNGMeshAttributes; i++)
+    {
+        const VertexAttribute& attribute = *attributes[i];
+
+        if (!attribute.Enabled)
+        {
+            continue;
+        }
+
+        if (attribute.Stride < 0)
+        {
+            throw std::runtime_error("Corrupt .ngmesh file: negative attribute stride");
+        }
+
+        std::uint64_t size = std::uint64_t(attribute.Cardinality) * SizeOfArithmeticType(attribute.Type);
+
+        if (!FitsInBlob(attribute.Offset, std::uint64_t(GetEffectiveStride(attribute)), size,
+                        header.NumVertices, header.VertexDataSize))
+        {
+            throw std::runtime_error("Corrupt .ngmesh file: more vertices than the vertex data holds");
+        }
+    }
+
+    if (mVertexFormat.IsIndexed)
+    {
+        std::uint64_t size = SizeOfArithmeticType(mVertexFormat.IndexType);
+
+        if (!FitsInBlob(header.IndexOffset, size, size, header.NumIndices, header.IndexDataSize))
+        {
+            throw std::runtime_error("Corrupt .ngmesh file: more indices than the index data holds");
+        }
+    }
+    else if (header.NumIndices != 0)
+    {
+        throw std::runtime_error("Corrupt .ngmesh file: indices in a mesh that isn't indexed");
+    }
+
+    mVertexData = contents.data() + header.VertexDataOffset;
+    mVertexDataSize = header.VertexDataSize;
+    mNumVertices = header.NumVertices;
+
+    mIndexData = contents.data() + header.IndexDataOffset;
+    mIndexDataSize = header.IndexDataSize;
+    mNumIndices = header.NumIndices;
+}
+
+VertexFormat BinaryMesh::GetVertexFormat() const
+{
+    return mVertexFormat;
+}
+
+std::size_t BinaryMesh::GetMaxVertexBufferSize() const
+{
+    return mVertexDataSize;
+}
+
+std::size_t BinaryMesh::GetMaxIndexBufferSize() const
+{
+    return mIndexDataSize;
+}
+
+std::size_t BinaryMesh::WriteVertices(void* buffer) const
+{
+    if (buffer != nullptr)
+    {
+        std::memcpy(buffer, mVertexData, mVertexDataSize);
+    }
+
+    return mNumVertices;
+}
+
+std::size_t BinaryMesh::WriteIndices(void* buffer) const
+{
+    if (buffer != nullptr)
+    {
+        std::memcpy(buffer, mIndexData, mIndexDataSize);
+    }
+
+    return mNumIndices;
+}
+
+void SaveBinaryMesh(const IMesh& mesh, const char* path)
+{
+    VertexFormat fmt = mesh.GetVertexFormat();
+
+    // fill the buffers the same way the renderer does.
+    std::vector<char> vertexData(mesh.GetMaxVertexBufferSize());
+    std::size_t numVertices = vertexData.empty() ? 0 : mesh.WriteVertices(vertexData.data());
+
+    std::vector<char> indexData(mesh.GetMaxIndexBufferSize());
+    std::size_t numIndices = indexData.empty() ? 0 : mesh.WriteIndices(indexData.data());
+
+    NGMeshHeader header;
+    std::memset(&header, 0, sizeof(header));
+
+    std::memcpy(header.Magic, kNGMeshMagic, sizeof(kNGMeshMagic));
+    header.Version = kNGMeshVersion;
+    header.ByteOrderMark = kNGMeshByteOrderMark;
+    header.PrimitiveType = std::uint32_t(fmt.PrimitiveType);
+
+    std::array<VertexAttribute*,kNumNGMeshAttributes> attributes =
+            GetSerializedAttributes(fmt);
+
+    for (std::size_t i = 0; i < kNumNGMeshAttributes; i++)
+    {
+        const VertexAttribute& attribute = *attributes[i];
+        NGMeshAttribute& serialized = header.Attributes[i];
+
+        if (attribute.Enabled)
+        {
+            serialized.Enabled = 1;
+            serialized.Type = std::uint8_t(attribute.Type);
+            serialized.Normalized = attribute.Normalized;
+            serialized.Cardinality = attribute.Cardinality;
+            serialized.Stride = attribute.Stride;
+            serialized.Offset = attribute.Offset;
+        }
+    }
+
+    if (fmt.IsIndexed)
+    {
+        header.IsIndexed = 1;
+        header.IndexType = std::uint8_t(fmt.IndexType);
+        header.IndexOffset = fmt.IndexOffset;
+    }
+
+    header.NumVertices = numVertices;
+    header.VertexDataOffset = AlignBlob(sizeof(header));
+    header.VertexDataSize = vertexData.size();
+
+    header.NumIndices = numIndices;
+    header.IndexDataOffset = AlignBlob(header.VertexDataOffset + header.VertexDataSize);
+    header.IndexDataSize = indexData.size();
+
+    FILE* filePtr = std::fopen(path, "wb");
+    if (filePtr == NULL)
+    {
+        throw std::runtime_error(std::string("Failed to open ") + path + " for writing");
+    }
+
+    bool closed = false;
+    auto closeScope = make_scope_guard([&]{
+        if (!closed)
+        {
+            std::fclose(filePtr);
+        }
+    });
+
+    const char zeros[kBlobAlignment] = { };
+    std::uint64_t written = 0;
+
+    auto write = [&](const void* data, std::size_t size)
+    {
+        if (size > 0 && std::fwrite(data, 1, size, filePtr) != size)
+        {
+            throw std::runtime_error(std::string("Failed to write ") + path);
+        }
+        written += size;
+    };
+
+    auto pad = [&](std::uint64_t offset)
+    {
+        write(zeros, offset - written);
+    };
+
+    write(&header, sizeof(header));
+    pad(header.VertexDataOffset);
+    write(vertexData.data(), vertexData.size());
+    pad(header.IndexDataOffset);
+    write(indexData.data(), indexData.size());
+
+    closed = true;
+    if (std::fclose(filePtr) != 0)
+    {
+        throw std::runtime_error(std::string("Failed to write ") + path);
+    }
+}
+
+} // end namespace ng
@@ -1,8 +1,19 @@
 #include "ng/framework/meshes/implicitsurfacemesh.hpp"
 
+#include "ng/engine/util/scopeguard.hpp"
+#include "ng/engine/util/workerpool.hpp"
+
 #include <cstddef>
 #include <unordered_map>
-#include <queue>
+#include <deque>
+#include <bitset>
+#include <tuple>
+#include <algorithm>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
 
 namespace ng
 {
@@ -10,610 +21,1682 @@ namespace ng
 namespace
 {
 
-template<unsigned int Nbits=5>
-class WyvillHash
+// vertex indices
+//
+//        4----------5
+//       /|         /|
+//      7----------6 |
+//      | |        | |
+//      | |        | |
+//      | 0--------|-1
+//      |/         |/
+//      3----------2
+//
+// edge indices
+//
+//        .----4-----.
+//       7|         5|
+//      .-----6----. |
+//      | 8        | 9
+//     11 |       10 |
+//      | .----0---|-.
+//      |3         |1
+//      .-----2----.
+//
+// face indices
+//
+// 0: left
+// 1: right
+// 2: bottom
+// 3: top
+// 4: back
+// 5: front
+//
+//              -z
+//               ^
+//         +y   /
+//          ^  /
+//          | /
+//    -x <-- --> +x
+//         /|
+//        / v
+//       / -y
+//      v
+//     +z
+
+const std::array<ivec3,8> kVertexToDirection = {{
+    { 0, 0, 0 }, // 0
+    { 1, 0, 0 }, // 1
+    { 1, 0, 1 }, // 2
+    { 0, 0, 1 }, // 3
+    { 0, 1, 0 }, // 4
+    { 1, 1, 0 }, // 5
+    { 1, 1, 1 }, // 6
+    { 0, 1, 1 }  // 7
+}};
+
+const std::array<ivec3,6> kFaceToDirection = {{
+    { -1,  0,  0 },
+    { +1,  0,  0 },
+    {  0, -1,  0 },
+    {  0, +1,  0 },
+    {  0,  0, -1 },
+    {  0,  0, +1 }
+}};
+
+const std::array<std::uint16_t,6> kFaceToEdges = {{
+    0x988, 0x622, 0xf, 0xf0, 0x311, 0xc44
+}};
+
+// precomputed tables from: http://paulbourke.net/geometry/polygonise/
+
+// maps bitsets representing the polarity of vertices to a bitset of edges
+const std::array<std::uint16_t,256> kEdges = {{
+    0x0  , 0x109, 0x203, 0x30a, 0x406, 0x50f, 0x605, 0x70c,
+    0x80c, 0x905, 0xa0f, 0xb06, 0xc0a, 0xd03, 0xe09, 0xf00,
+    0x190, 0x99 , 0x393, 0x29a, 0x596, 0x49f, 0x795, 0x69c,
+    0x99c, 0x895, 0xb9f, 0xa96, 0xd9a, 0xc93, 0xf99, 0xe90,
+    0x230, 0x339, 0x33 , 0x13a, 0x636, 0x73f, 0x435, 0x53c,
+    0xa3c, 0xb35, 0x83f, 0x936, 0xe3a, 0xf33, 0xc39, 0xd30,
+    0x3a0, 0x2a9, 0x1a3, 0xaa , 0x7a6, 0x6af, 0x5a5, 0x4ac,
+    0xbac, 0xaa5, 0x9af, 0x8a6, 0xfaa, 0xea3, 0xda9, 0xca0,
+    0x460, 0x569, 0x663, 0x76a, 0x66 , 0x16f, 0x265, 0x36c,
+    0xc6c, 0xd65, 0xe6f, 0xf66, 0x86a, 0x963, 0xa69, 0xb60,
+    0x5f0, 0x4f9, 0x7f3, 0x6fa, 0x1f6, 0xff , 0x3f5, 0x2fc,
+    0xdfc, 0xcf5, 0xfff, 0xef6, 0x9fa, 0x8f3, 0xbf9, 0xaf0,
+    0x650, 0x759, 0x453, 0x55a, 0x256, 0x35f, 0x55 , 0x15c,
+    0xe5c, 0xf55, 0xc5f, 0xd56, 0xa5a, 0xb53, 0x859, 0x950,
+    0x7c0, 0x6c9, 0x5c3, 0x4ca, 0x3c6, 0x2cf, 0x1c5, 0xcc ,
+    0xfcc, 0xec5, 0xdcf, 0xcc6, 0xbca, 0xac3, 0x9c9, 0x8c0,
+    0x8c0, 0x9c9, 0xac3, 0xbca, 0xcc6, 0xdcf, 0xec5, 0xfcc,
+    0xcc , 0x1c5, 0x2cf, 0x3c6, 0x4ca, 0x5c3, 0x6c9, 0x7c0,
+    0x950, 0x859, 0xb53, 0xa5a, 0xd56, 0xc5f, 0xf55, 0xe5c,
+    0x15c, 0x55 , 0x35f, 0x256, 0x55a, 0x453, 0x759, 0x650,
+    0xaf0, 0xbf9, 0x8f3, 0x9fa, 0xef6, 0xfff, 0xcf5, 0xdfc,
+    0x2fc, 0x3f5, 0xff , 0x1f6, 0x6fa, 0x7f3, 0x4f9, 0x5f0,
+    0xb60, 0xa69, 0x963, 0x86a, 0xf66, 0xe6f, 0xd65, 0xc6c,
+    0x36c, 0x265, 0x16f, 0x66 , 0x76a, 0x663, 0x569, 0x460,
+    0xca0, 0xda9, 0xea3, 0xfaa, 0x8a6, 0x9af, 0xaa5, 0xbac,
+    0x4ac, 0x5a5, 0x6af, 0x7a6, 0xaa , 0x1a3, 0x2a9, 0x3a0,
+    0xd30, 0xc39, 0xf33, 0xe3a, 0x936, 0x83f, 0xb35, 0xa3c,
+    0x53c, 0x435, 0x73f, 0x636, 0x13a, 0x33 , 0x339, 0x230,
+    0xe90, 0xf99, 0xc93, 0xd9a, 0xa96, 0xb9f, 0x895, 0x99c,
+    0x69c, 0x795, 0x49f, 0x596, 0x29a, 0x393, 0x99 , 0x190,
+    0xf00, 0xe09, 0xd03, 0xc0a, 0xb06, 0xa0f, 0x905, 0x80c,
+    0x70c, 0x605, 0x50f, 0x406, 0x30a, 0x203, 0x109, 0x0
+}};
+
+const std::array<std::array<int,16>,256> kTriangleEdges = {{
+    {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 1, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 8, 3, 9, 8, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 8, 3, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {9, 2, 10, 0, 2, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {2, 8, 3, 2, 10, 8, 10, 9, 8, -1, -1, -1, -1, -1, -1, -1},
+    {3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 11, 2, 8, 11, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 9, 0, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 11, 2, 1, 9, 11, 9, 8, 11, -1, -1, -1, -1, -1, -1, -1},
+    {3, 10, 1, 11, 10, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 10, 1, 0, 8, 10, 8, 11, 10, -1, -1, -1, -1, -1, -1, -1},
+    {3, 9, 0, 3, 11, 9, 11, 10, 9, -1, -1, -1, -1, -1, -1, -1},
+    {9, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {4, 3, 0, 7, 3, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 1, 9, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {4, 1, 9, 4, 7, 1, 7, 3, 1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 2, 10, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {3, 4, 7, 3, 0, 4, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1},
+    {9, 2, 10, 9, 0, 2, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1},
+    {2, 10, 9, 2, 9, 7, 2, 7, 3, 7, 9, 4, -1, -1, -1, -1},
+    {8, 4, 7, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {11, 4, 7, 11, 2, 4, 2, 0, 4, -1, -1, -1, -1, -1, -1, -1},
+    {9, 0, 1, 8, 4, 7, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1},
+    {4, 7, 11, 9, 4, 11, 9, 11, 2, 9, 2, 1, -1, -1, -1, -1},
+    {3, 10, 1, 3, 11, 10, 7, 8, 4, -1, -1, -1, -1, -1, -1, -1},
+    {1, 11, 10, 1, 4, 11, 1, 0, 4, 7, 11, 4, -1, -1, -1, -1},
+    {4, 7, 8, 9, 0, 11, 9, 11, 10, 11, 0, 3, -1, -1, -1, -1},
+    {4, 7, 11, 4, 11, 9, 9, 11, 10, -1, -1, -1, -1, -1, -1, -1},
+    {9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {9, 5, 4, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 5, 4, 1, 5, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {8, 5, 4, 8, 3, 5, 3, 1, 5, -1, -1, -1, -1, -1, -1, -1},
+    {1, 2, 10, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {3, 0, 8, 1, 2, 10, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1},
+    {5, 2, 10, 5, 4, 2, 4, 0, 2, -1, -1, -1, -1, -1, -1, -1},
+    {2, 10, 5, 3, 2, 5, 3, 5, 4, 3, 4, 8, -1, -1, -1, -1},
+    {9, 5, 4, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 11, 2, 0, 8, 11, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1},
+    {0, 5, 4, 0, 1, 5, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1},
+    {2, 1, 5, 2, 5, 8, 2, 8, 11, 4, 8, 5, -1, -1, -1, -1},
+    {10, 3, 11, 10, 1, 3, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1},
+    {4, 9, 5, 0, 8, 1, 8, 10, 1, 8, 11, 10, -1, -1, -1, -1},
+    {5, 4, 0, 5, 0, 11, 5, 11, 10, 11, 0, 3, -1, -1, -1, -1},
+    {5, 4, 8, 5, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1},
+    {9, 7, 8, 5, 7, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {9, 3, 0, 9, 5, 3, 5, 7, 3, -1, -1, -1, -1, -1, -1, -1},
+    {0, 7, 8, 0, 1, 7, 1, 5, 7, -1, -1, -1, -1, -1, -1, -1},
+    {1, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {9, 7, 8, 9, 5, 7, 10, 1, 2, -1, -1, -1, -1, -1, -1, -1},
+    {10, 1, 2, 9, 5, 0, 5, 3, 0, 5, 7, 3, -1, -1, -1, -1},
+    {8, 0, 2, 8, 2, 5, 8, 5, 7, 10, 5, 2, -1, -1, -1, -1},
+    {2, 10, 5, 2, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1},
+    {7, 9, 5, 7, 8, 9, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1},
+    {9, 5, 7, 9, 7, 2, 9, 2, 0, 2, 7, 11, -1, -1, -1, -1},
+    {2, 3, 11, 0, 1, 8, 1, 7, 8, 1, 5, 7, -1, -1, -1, -1},
+    {11, 2, 1, 11, 1, 7, 7, 1, 5, -1, -1, -1, -1, -1, -1, -1},
+    {9, 5, 8, 8, 5, 7, 10, 1, 3, 10, 3, 11, -1, -1, -1, -1},
+    {5, 7, 0, 5, 0, 9, 7, 11, 0, 1, 0, 10, 11, 10, 0, -1},
+    {11, 10, 0, 11, 0, 3, 10, 5, 0, 8, 0, 7, 5, 7, 0, -1},
+    {11, 10, 5, 7, 11, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 8, 3, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {9, 0, 1, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 8, 3, 1, 9, 8, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1},
+    {1, 6, 5, 2, 6, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 6, 5, 1, 2, 6, 3, 0, 8, -1, -1, -1, -1, -1, -1, -1},
+    {9, 6, 5, 9, 0, 6, 0, 2, 6, -1, -1, -1, -1, -1, -1, -1},
+    {5, 9, 8, 5, 8, 2, 5, 2, 6, 3, 2, 8, -1, -1, -1, -1},
+    {2, 3, 11, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {11, 0, 8, 11, 2, 0, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1},
+    {0, 1, 9, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1},
+    {5, 10, 6, 1, 9, 2, 9, 11, 2, 9, 8, 11, -1, -1, -1, -1},
+    {6, 3, 11, 6, 5, 3, 5, 1, 3, -1, -1, -1, -1, -1, -1, -1},
+    {0, 8, 11, 0, 11, 5, 0, 5, 1, 5, 11, 6, -1, -1, -1, -1},
+    {3, 11, 6, 0, 3, 6, 0, 6, 5, 0, 5, 9, -1, -1, -1, -1},
+    {6, 5, 9, 6, 9, 11, 11, 9, 8, -1, -1, -1, -1, -1, -1, -1},
+    {5, 10, 6, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {4, 3, 0, 4, 7, 3, 6, 5, 10, -1, -1, -1, -1, -1, -1, -1},
+    {1, 9, 0, 5, 10, 6, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1},
+    {10, 6, 5, 1, 9, 7, 1, 7, 3, 7, 9, 4, -1, -1, -1, -1},
+    {6, 1, 2, 6, 5, 1, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1},
+    {1, 2, 5, 5, 2, 6, 3, 0, 4, 3, 4, 7, -1, -1, -1, -1},
+    {8, 4, 7, 9, 0, 5, 0, 6, 5, 0, 2, 6, -1, -1, -1, -1},
+    {7, 3, 9, 7, 9, 4, 3, 2, 9, 5, 9, 6, 2, 6, 9, -1},
+    {3, 11, 2, 7, 8, 4, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1},
+    {5, 10, 6, 4, 7, 2, 4, 2, 0, 2, 7, 11, -1, -1, -1, -1},
+    {0, 1, 9, 4, 7, 8, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1},
+    {9, 2, 1, 9, 11, 2, 9, 4, 11, 7, 11, 4, 5, 10, 6, -1},
+    {8, 4, 7, 3, 11, 5, 3, 5, 1, 5, 11, 6, -1, -1, -1, -1},
+    {5, 1, 11, 5, 11, 6, 1, 0, 11, 7, 11, 4, 0, 4, 11, -1},
+    {0, 5, 9, 0, 6, 5, 0, 3, 6, 11, 6, 3, 8, 4, 7, -1},
+    {6, 5, 9, 6, 9, 11, 4, 7, 9, 7, 11, 9, -1, -1, -1, -1},
+    {10, 4, 9, 6, 4, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {4, 10, 6, 4, 9, 10, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1},
+    {10, 0, 1, 10, 6, 0, 6, 4, 0, -1, -1, -1, -1, -1, -1, -1},
+    {8, 3, 1, 8, 1, 6, 8, 6, 4, 6, 1, 10, -1, -1, -1, -1},
+    {1, 4, 9, 1, 2, 4, 2, 6, 4, -1, -1, -1, -1, -1, -1, -1},
+    {3, 0, 8, 1, 2, 9, 2, 4, 9, 2, 6, 4, -1, -1, -1, -1},
+    {0, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {8, 3, 2, 8, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1},
+    {10, 4, 9, 10, 6, 4, 11, 2, 3, -1, -1, -1, -1, -1, -1, -1},
+    {0, 8, 2, 2, 8, 11, 4, 9, 10, 4, 10, 6, -1, -1, -1, -1},
+    {3, 11, 2, 0, 1, 6, 0, 6, 4, 6, 1, 10, -1, -1, -1, -1},
+    {6, 4, 1, 6, 1, 10, 4, 8, 1, 2, 1, 11, 8, 11, 1, -1},
+    {9, 6, 4, 9, 3, 6, 9, 1, 3, 11, 6, 3, -1, -1, -1, -1},
+    {8, 11, 1, 8, 1, 0, 11, 6, 1, 9, 1, 4, 6, 4, 1, -1},
+    {3, 11, 6, 3, 6, 0, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1},
+    {6, 4, 8, 11, 6, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {7, 10, 6, 7, 8, 10, 8, 9, 10, -1, -1, -1, -1, -1, -1, -1},
+    {0, 7, 3, 0, 10, 7, 0, 9, 10, 6, 7, 10, -1, -1, -1, -1},
+    {10, 6, 7, 1, 10, 7, 1, 7, 8, 1, 8, 0, -1, -1, -1, -1},
+    {10, 6, 7, 10, 7, 1, 1, 7, 3, -1, -1, -1, -1, -1, -1, -1},
+    {1, 2, 6, 1, 6, 8, 1, 8, 9, 8, 6, 7, -1, -1, -1, -1},
+    {2, 6, 9, 2, 9, 1, 6, 7, 9, 0, 9, 3, 7, 3, 9, -1},
+    {7, 8, 0, 7, 0, 6, 6, 0, 2, -1, -1, -1, -1, -1, -1, -1},
+    {7, 3, 2, 6, 7, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {2, 3, 11, 10, 6, 8, 10, 8, 9, 8, 6, 7, -1, -1, -1, -1},
+    {2, 0, 7, 2, 7, 11, 0, 9, 7, 6, 7, 10, 9, 10, 7, -1},
+    {1, 8, 0, 1, 7, 8, 1, 10, 7, 6, 7, 10, 2, 3, 11, -1},
+    {11, 2, 1, 11, 1, 7, 10, 6, 1, 6, 7, 1, -1, -1, -1, -1},
+    {8, 9, 6, 8, 6, 7, 9, 1, 6, 11, 6, 3, 1, 3, 6, -1},
+    {0, 9, 1, 11, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {7, 8, 0, 7, 0, 6, 3, 11, 0, 11, 6, 0, -1, -1, -1, -1},
+    {7, 11, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {3, 0, 8, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 1, 9, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {8, 1, 9, 8, 3, 1, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1},
+    {10, 1, 2, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 2, 10, 3, 0, 8, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1},
+    {2, 9, 0, 2, 10, 9, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1},
+    {6, 11, 7, 2, 10, 3, 10, 8, 3, 10, 9, 8, -1, -1, -1, -1},
+    {7, 2, 3, 6, 2, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {7, 0, 8, 7, 6, 0, 6, 2, 0, -1, -1, -1, -1, -1, -1, -1},
+    {2, 7, 6, 2, 3, 7, 0, 1, 9, -1, -1, -1, -1, -1, -1, -1},
+    {1, 6, 2, 1, 8, 6, 1, 9, 8, 8, 7, 6, -1, -1, -1, -1},
+    {10, 7, 6, 10, 1, 7, 1, 3, 7, -1, -1, -1, -1, -1, -1, -1},
+    {10, 7, 6, 1, 7, 10, 1, 8, 7, 1, 0, 8, -1, -1, -1, -1},
+    {0, 3, 7, 0, 7, 10, 0, 10, 9, 6, 10, 7, -1, -1, -1, -1},
+    {7, 6, 10, 7, 10, 8, 8, 10, 9, -1, -1, -1, -1, -1, -1, -1},
+    {6, 8, 4, 11, 8, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {3, 6, 11, 3, 0, 6, 0, 4, 6, -1, -1, -1, -1, -1, -1, -1},
+    {8, 6, 11, 8, 4, 6, 9, 0, 1, -1, -1, -1, -1, -1, -1, -1},
+    {9, 4, 6, 9, 6, 3, 9, 3, 1, 11, 3, 6, -1, -1, -1, -1},
+    {6, 8, 4, 6, 11, 8, 2, 10, 1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 2, 10, 3, 0, 11, 0, 6, 11, 0, 4, 6, -1, -1, -1, -1},
+    {4, 11, 8, 4, 6, 11, 0, 2, 9, 2, 10, 9, -1, -1, -1, -1},
+    {10, 9, 3, 10, 3, 2, 9, 4, 3, 11, 3, 6, 4, 6, 3, -1},
+    {8, 2, 3, 8, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1},
+    {0, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 9, 0, 2, 3, 4, 2, 4, 6, 4, 3, 8, -1, -1, -1, -1},
+    {1, 9, 4, 1, 4, 2, 2, 4, 6, -1, -1, -1, -1, -1, -1, -1},
+    {8, 1, 3, 8, 6, 1, 8, 4, 6, 6, 10, 1, -1, -1, -1, -1},
+    {10, 1, 0, 10, 0, 6, 6, 0, 4, -1, -1, -1, -1, -1, -1, -1},
+    {4, 6, 3, 4, 3, 8, 6, 10, 3, 0, 3, 9, 10, 9, 3, -1},
+    {10, 9, 4, 6, 10, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {4, 9, 5, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 8, 3, 4, 9, 5, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1},
+    {5, 0, 1, 5, 4, 0, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1},
+    {11, 7, 6, 8, 3, 4, 3, 5, 4, 3, 1, 5, -1, -1, -1, -1},
+    {9, 5, 4, 10, 1, 2, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1},
+    {6, 11, 7, 1, 2, 10, 0, 8, 3, 4, 9, 5, -1, -1, -1, -1},
+    {7, 6, 11, 5, 4, 10, 4, 2, 10, 4, 0, 2, -1, -1, -1, -1},
+    {3, 4, 8, 3, 5, 4, 3, 2, 5, 10, 5, 2, 11, 7, 6, -1},
+    {7, 2, 3, 7, 6, 2, 5, 4, 9, -1, -1, -1, -1, -1, -1, -1},
+    {9, 5, 4, 0, 8, 6, 0, 6, 2, 6, 8, 7, -1, -1, -1, -1},
+    {3, 6, 2, 3, 7, 6, 1, 5, 0, 5, 4, 0, -1, -1, -1, -1},
+    {6, 2, 8, 6, 8, 7, 2, 1, 8, 4, 8, 5, 1, 5, 8, -1},
+    {9, 5, 4, 10, 1, 6, 1, 7, 6, 1, 3, 7, -1, -1, -1, -1},
+    {1, 6, 10, 1, 7, 6, 1, 0, 7, 8, 7, 0, 9, 5, 4, -1},
+    {4, 0, 10, 4, 10, 5, 0, 3, 10, 6, 10, 7, 3, 7, 10, -1},
+    {7, 6, 10, 7, 10, 8, 5, 4, 10, 4, 8, 10, -1, -1, -1, -1},
+    {6, 9, 5, 6, 11, 9, 11, 8, 9, -1, -1, -1, -1, -1, -1, -1},
+    {3, 6, 11, 0, 6, 3, 0, 5, 6, 0, 9, 5, -1, -1, -1, -1},
+    {0, 11, 8, 0, 5, 11, 0, 1, 5, 5, 6, 11, -1, -1, -1, -1},
+    {6, 11, 3, 6, 3, 5, 5, 3, 1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 2, 10, 9, 5, 11, 9, 11, 8, 11, 5, 6, -1, -1, -1, -1},
+    {0, 11, 3, 0, 6, 11, 0, 9, 6, 5, 6, 9, 1, 2, 10, -1},
+    {11, 8, 5, 11, 5, 6, 8, 0, 5, 10, 5, 2, 0, 2, 5, -1},
+    {6, 11, 3, 6, 3, 5, 2, 10, 3, 10, 5, 3, -1, -1, -1, -1},
+    {5, 8, 9, 5, 2, 8, 5, 6, 2, 3, 8, 2, -1, -1, -1, -1},
+    {9, 5, 6, 9, 6, 0, 0, 6, 2, -1, -1, -1, -1, -1, -1, -1},
+    {1, 5, 8, 1, 8, 0, 5, 6, 8, 3, 8, 2, 6, 2, 8, -1},
+    {1, 5, 6, 2, 1, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 3, 6, 1, 6, 10, 3, 8, 6, 5, 6, 9, 8, 9, 6, -1},
+    {10, 1, 0, 10, 0, 6, 9, 5, 0, 5, 6, 0, -1, -1, -1, -1},
+    {0, 3, 8, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {10, 5, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {11, 5, 10, 7, 5, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {11, 5, 10, 11, 7, 5, 8, 3, 0, -1, -1, -1, -1, -1, -1, -1},
+    {5, 11, 7, 5, 10, 11, 1, 9, 0, -1, -1, -1, -1, -1, -1, -1},
+    {10, 7, 5, 10, 11, 7, 9, 8, 1, 8, 3, 1, -1, -1, -1, -1},
+    {11, 1, 2, 11, 7, 1, 7, 5, 1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 8, 3, 1, 2, 7, 1, 7, 5, 7, 2, 11, -1, -1, -1, -1},
+    {9, 7, 5, 9, 2, 7, 9, 0, 2, 2, 11, 7, -1, -1, -1, -1},
+    {7, 5, 2, 7, 2, 11, 5, 9, 2, 3, 2, 8, 9, 8, 2, -1},
+    {2, 5, 10, 2, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1},
+    {8, 2, 0, 8, 5, 2, 8, 7, 5, 10, 2, 5, -1, -1, -1, -1},
+    {9, 0, 1, 5, 10, 3, 5, 3, 7, 3, 10, 2, -1, -1, -1, -1},
+    {9, 8, 2, 9, 2, 1, 8, 7, 2, 10, 2, 5, 7, 5, 2, -1},
+    {1, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 8, 7, 0, 7, 1, 1, 7, 5, -1, -1, -1, -1, -1, -1, -1},
+    {9, 0, 3, 9, 3, 5, 5, 3, 7, -1, -1, -1, -1, -1, -1, -1},
+    {9, 8, 7, 5, 9, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {5, 8, 4, 5, 10, 8, 10, 11, 8, -1, -1, -1, -1, -1, -1, -1},
+    {5, 0, 4, 5, 11, 0, 5, 10, 11, 11, 3, 0, -1, -1, -1, -1},
+    {0, 1, 9, 8, 4, 10, 8, 10, 11, 10, 4, 5, -1, -1, -1, -1},
+    {10, 11, 4, 10, 4, 5, 11, 3, 4, 9, 4, 1, 3, 1, 4, -1},
+    {2, 5, 1, 2, 8, 5, 2, 11, 8, 4, 5, 8, -1, -1, -1, -1},
+    {0, 4, 11, 0, 11, 3, 4, 5, 11, 2, 11, 1, 5, 1, 11, -1},
+    {0, 2, 5, 0, 5, 9, 2, 11, 5, 4, 5, 8, 11, 8, 5, -1},
+    {9, 4, 5, 2, 11, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {2, 5, 10, 3, 5, 2, 3, 4, 5, 3, 8, 4, -1, -1, -1, -1},
+    {5, 10, 2, 5, 2, 4, 4, 2, 0, -1, -1, -1, -1, -1, -1, -1},
+    {3, 10, 2, 3, 5, 10, 3, 8, 5, 4, 5, 8, 0, 1, 9, -1},
+    {5, 10, 2, 5, 2, 4, 1, 9, 2, 9, 4, 2, -1, -1, -1, -1},
+    {8, 4, 5, 8, 5, 3, 3, 5, 1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 4, 5, 1, 0, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {8, 4, 5, 8, 5, 3, 9, 0, 5, 0, 3, 5, -1, -1, -1, -1},
+    {9, 4, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {4, 11, 7, 4, 9, 11, 9, 10, 11, -1, -1, -1, -1, -1, -1, -1},
+    {0, 8, 3, 4, 9, 7, 9, 11, 7, 9, 10, 11, -1, -1, -1, -1},
+    {1, 10, 11, 1, 11, 4, 1, 4, 0, 7, 4, 11, -1, -1, -1, -1},
+    {3, 1, 4, 3, 4, 8, 1, 10, 4, 7, 4, 11, 10, 11, 4, -1},
+    {4, 11, 7, 9, 11, 4, 9, 2, 11, 9, 1, 2, -1, -1, -1, -1},
+    {9, 7, 4, 9, 11, 7, 9, 1, 11, 2, 11, 1, 0, 8, 3, -1},
+    {11, 7, 4, 11, 4, 2, 2, 4, 0, -1, -1, -1, -1, -1, -1, -1},
+    {11, 7, 4, 11, 4, 2, 8, 3, 4, 3, 2, 4, -1, -1, -1, -1},
+    {2, 9, 10, 2, 7, 9, 2, 3, 7, 7, 4, 9, -1, -1, -1, -1},
+    {9, 10, 7, 9, 7, 4, 10, 2, 7, 8, 7, 0, 2, 0, 7, -1},
+    {3, 7, 10, 3, 10, 2, 7, 4, 10, 1, 10, 0, 4, 0, 10, -1},
+    {1, 10, 2, 8, 7, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {4, 9, 1, 4, 1, 7, 7, 1, 3, -1, -1, -1, -1, -1, -1, -1},
+    {4, 9, 1, 4, 1, 7, 0, 8, 1, 8, 7, 1, -1, -1, -1, -1},
+    {4, 0, 3, 7, 4, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {4, 8, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {9, 10, 8, 10, 11, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {3, 0, 9, 3, 9, 11, 11, 9, 10, -1, -1, -1, -1, -1, -1, -1},
+    {0, 1, 10, 0, 10, 8, 8, 10, 11, -1, -1, -1, -1, -1, -1, -1},
+    {3, 1, 10, 11, 3, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 2, 11, 1, 11, 9, 9, 11, 8, -1, -1, -1, -1, -1, -1, -1},
+    {3, 0, 9, 3, 9, 11, 1, 2, 9, 2, 11, 9, -1, -1, -1, -1},
+    {0, 2, 11, 8, 0, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {3, 2, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {2, 3, 8, 2, 8, 10, 10, 8, 9, -1, -1, -1, -1, -1, -1, -1},
+    {9, 10, 2, 0, 9, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {2, 3, 8, 2, 8, 10, 0, 1, 8, 1, 10, 8, -1, -1, -1, -1},
+    {1, 10, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {1, 3, 8, 9, 1, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 9, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {0, 3, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}
+}};
+
+const std::array<std::pair<int,int>,12> kVerticesOfEdge = { {
+    {0,1}, {1,2}, {2,3}, {0,3}, {4,5}, {5,6},
+    {6,7}, {4,7}, {0,4}, {1,5}, {2,6}, {3,7}
+}};
+
+// each cube edge is a lattice edge leaving one of the cube's corners
+// along one of the axes. find which, so neighbouring cubes share vertices.
+std::array<std::pair<int,int>,12> MakeEdgeToCornerAndAxis()
 {
-public:
-    static constexpr unsigned int NBits = Nbits;
-    static constexpr unsigned int BMask = (1 << NBits) - 1;
+    std::array<std::pair<int,int>,12> edgeToCornerAndAxis;
+    for (std::size_t edge = 0; edge < edgeToCornerAndAxis.size(); edge++)
+    {
+        int first = kVerticesOfEdge[edge].first;
+        int second = kVerticesOfEdge[edge].second;
+        ivec3 delta = kVertexToDirection[second] - kVertexToDirection[first];
+
+        int axis = delta.x != 0 ? 0 : delta.y != 0 ? 1 : 2;
+        int corner = delta[axis] > 0 ? first : second;
+
+        edgeToCornerAndAxis[edge] = { corner, axis };
+    }
+    return edgeToCornerAndAxis;
+}
+
+const std::array<std::pair<int,int>,12> kEdgeToCornerAndAxis = MakeEdgeToCornerAndAxis();
+
+vec3 IsoLerp(float isoValue, vec3 P1, vec3 P2, float V1, float V2)
+{
+    return P1 + (isoValue - V1) * (P2 - P1) / (V2 - V1);
+}
+
+// the lattice is split into bricks of kBrickSize^3 cells,
+// which are the unit of work handed out to the polygonizing threads.
+constexpr int kBrickSize = 8;
+constexpr int kBrickPoints = kBrickSize + 1;
+constexpr std::size_t kCellsPerBrick = kBrickSize * kBrickSize * kBrickSize;
+constexpr std::size_t kPointsPerBrick = kBrickPoints * kBrickPoints * kBrickPoints;
+
+constexpr std::uint32_t kNoVertex = std::numeric_limits<std::uint32_t>::max();
+
+int FloorDiv(int a, int b)
+{
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+ivec3 BrickOfCell(ivec3 cell)
+{
+    return ivec3(FloorDiv(cell.x, kBrickSize),
+                 FloorDiv(cell.y, kBrickSize),
+                 FloorDiv(cell.z, kBrickSize));
+}
+
+std::size_t CellIndex(ivec3 local)
+{
+    return (local.z * kBrickSize + local.y) * kBrickSize + local.x;
+}
+
+ivec3 CellOfIndex(std::size_t cellIndex)
+{
+    int i = static_cast<int>(cellIndex);
+    return ivec3(i % kBrickSize, i / kBrickSize % kBrickSize, i / (kBrickSize * kBrickSize));
+}
+
+std::size_t PointIndex(ivec3 local)
+{
+    return (local.z * kBrickPoints + local.y) * kBrickPoints + local.x;
+}
 
-    constexpr std::uint16_t operator()(ivec3 i) const
+class BrickHash
+{
+public:
+    std::size_t operator()(ivec3 i) const
     {
-        // takes 5 least significant bits of x,y,z and combines them
-        // result: 0xxxxxyyyyyzzzzz
-        return ((((i.x & BMask) << NBits) | (i.y & BMask)) << NBits) | (i.z & BMask);
+        return (i.x * 73856093u) ^ (i.y * 19349663u) ^ (i.z * 83492791u);
     }
 };
 
-} // end anonymous namespace
+// triangle corners are stored as an edge vertex of the brick itself or of one of
+// the 7 bricks after it, so they stay valid when only the other bricks are re-meshed.
+constexpr int kEdgeVertexBits = 11;
+static_assert(3 * kCellsPerBrick <= (1 << kEdgeVertexBits),
+              "Edge vertices of a brick must fit in the encoded triangle corners");
 
-class ImplicitSurfaceMesh::Vertex
+class Brick
 {
 public:
-    vec3 Position;
-    vec3 Normal;
+    explicit Brick(ivec3 coordinate)
+        : Coordinate(coordinate)
+        , Field(kPointsPerBrick, std::numeric_limits<float>::quiet_NaN())
+    { }
+
+    const ivec3 Coordinate;
+
+    // field values at the corners of the brick's cells, NaN until evaluated.
+    std::vector<float> Field;
+    std::bitset<kCellsPerBrick> Visited;
+
+    // the field of an invalidated brick was thrown away by an edit.
+    // the visited cells of a modified brick changed since it was last meshed.
+    bool Invalidated = false;
+    bool Modified = false;
+
+    // cells handed over by neighbouring bricks, and whether a worker owns the brick.
+    std::mutex PendingMutex;
+    std::vector<ivec3> PendingCells;
+    bool Scheduled = false;
+
+    // vertices on the lattice edges leaving corner 0 of each cell along +x, +y and +z.
+    std::vector<std::array<std::uint32_t,3>> EdgeVertices;
+    std::vector<vec3> Positions;
+    std::vector<vec3> Normals;
+
+    std::vector<std::uint16_t> Triangles;
+
+    // index of the brick's first vertex in the merged mesh.
+    std::uint32_t FirstVertex = 0;
 };
 
-ImplicitSurfaceMesh::ImplicitSurfaceMesh(
+ivec3 OffsetOfOwnerCode(int code)
+{
+    return ivec3(code & 1, (code >> 1) & 1, (code >> 2) & 1);
+}
+
+std::uint32_t DecodeEdgeVertex(const std::array<const Brick*,8>& owners, std::uint16_t corner)
+{
+    const Brick* owner = owners[corner >> kEdgeVertexBits];
+    if (owner == nullptr)
+    {
+        throw std::logic_error("Triangle refers to a brick that no longer exists");
+    }
+    return owner->FirstVertex + (corner & ((1 << kEdgeVertexBits) - 1));
+}
+
+bool BoxesOverlap(vec3 minimumA, vec3 maximumA, vec3 minimumB, vec3 maximumB)
+{
+    for (std::size_t i = 0; i < 3; i++)
+    {
+        if (maximumA[i] < minimumB[i] || maximumB[i] < minimumA[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// keeps the dense grid from growing out of hand when primitives are sparse.
+constexpr std::size_t kMaxCellsPerPrimitive = 64;
+constexpr std::size_t kMinMaxCells = 1 << 12;
+
+bool IsBounded(const AxisAlignedBoundingBox<float>& bounds)
+{
+    return std::isfinite(bounds.Minimum.x) && std::isfinite(bounds.Maximum.x)
+        && std::isfinite(bounds.Minimum.y) && std::isfinite(bounds.Maximum.y)
+        && std::isfinite(bounds.Minimum.z) && std::isfinite(bounds.Maximum.z);
+}
+
+} // end anonymous namespace
+
+constexpr std::size_t ImplicitSurfaceField::MaxBatchSize;
+
+ImplicitSurfaceField::ImplicitSurfaceField(
         std::vector<ImplicitSurfacePrimitive> primitives,
-        float isoValue,
-        float voxelSize)
+        float minCellSize)
     : mPrimitives(std::move(primitives))
-    , mIsoValue(isoValue)
-    , mVoxelSize(voxelSize)
-{ }
+    , mCellSize(minCellSize > 0.0f ? minCellSize
+              : throw std::logic_error("minCellSize must be > 0"))
+{
+    std::vector<AxisAlignedBoundingBox<float>> supportBounds;
+    std::vector<std::uint32_t> boundedPrimitives;
 
-VertexFormat ImplicitSurfaceMesh::GetVertexFormat() const
+    float totalSupportSize = 0.0f;
+
+    for (std::size_t i = 0; i < mPrimitives.size(); i++)
+    {
+        AxisAlignedBoundingBox<float> bounds = mPrimitives[i].GetSupportBounds();
+
+        if (IsBounded(bounds))
+        {
+            vec3 size = bounds.Maximum - bounds.Minimum;
+            totalSupportSize += std::max(size.x, std::max(size.y, size.z));
+            supportBounds.push_back(bounds);
+            boundedPrimitives.push_back(i);
+        }
+        else
+        {
+            mUnboundedPrimitives.push_back(i);
+        }
+    }
+
+    if (boundedPrimitives.empty())
+    {
+        mCellStarts.assign(1, 0);
+        return;
+    }
+
+    // cells about the size of the average support diameter
+    // keep the number of cells each primitive touches small.
+    mCellSize = std::max(mCellSize, totalSupportSize / boundedPrimitives.size());
+
+    AxisAlignedBoundingBox<float> gridBounds = supportBounds.front();
+    for (const AxisAlignedBoundingBox<float>& bounds : supportBounds)
+    {
+        gridBounds.AddPoint(bounds.Minimum);
+        gridBounds.AddPoint(bounds.Maximum);
+    }
+
+    std::size_t maxCells = std::max(
+                kMinMaxCells,
+                kMaxCellsPerPrimitive * boundedPrimitives.size());
+
+    while (true)
+    {
+        mGridMinimum = GetCellIndex(gridBounds.Minimum) - ivec3(1);
+        mGridSize = GetCellIndex(gridBounds.Maximum) - mGridMinimum + ivec3(1);
+
+        std::size_t numCells = std::size_t(mGridSize.x)
+                             * std::size_t(mGridSize.y)
+                             * std::size_t(mGridSize.z);
+
+        if (numCells <= maxCells)
+        {
+            break;
+        }
+
+        mCellSize *= 2.0f;
+    }
+
+    // A batch of points is looked up in the cell containing its minimum,
+    // and may spill up to one cell over in each direction.
+    // Extending each primitive by one cell downwards keeps that lookup exact.
+    auto forEachCell = [&](const AxisAlignedBoundingBox<float>& bounds,
+                           const std::function<void(std::size_t)>& f)
+    {
+        ivec3 first = GetCellIndex(bounds.Minimum) - ivec3(1) - mGridMinimum;
+        ivec3 last = GetCellIndex(bounds.Maximum) - mGridMinimum;
+
+        for (int z = first.z; z <= last.z; z++)
+        {
+            for (int y = first.y; y <= last.y; y++)
+            {
+                for (int x = first.x; x <= last.x; x++)
+                {
+                    f((std::size_t(z) * mGridSize.y + y) * mGridSize.x + x);
+                }
+            }
+        }
+    };
+
+    std::size_t numCells = std::size_t(mGridSize.x)
+                         * std::size_t(mGridSize.y)
+                         * std::size_t(mGridSize.z);
+
+    // counting sort of the primitives into their cells
+    mCellStarts.assign(numCells + 1, 0);
+
+    for (const AxisAlignedBoundingBox<float>& bounds : supportBounds)
+    {
+        forEachCell(bounds, [&](std::size_t cell) {
+            mCellStarts[cell + 1]++;
+        });
+    }
+
+    for (std::size_t cell = 0; cell < numCells; cell++)
+    {
+        mCellStarts[cell + 1] += mCellStarts[cell];
+    }
+
+    mCellPrimitives.resize(mCellStarts.back());
+
+    std::vector<std::uint32_t> cellFill(mCellStarts.begin(), mCellStarts.end() - 1);
+
+    for (std::size_t i = 0; i < supportBounds.size(); i++)
+    {
+        forEachCell(supportBounds[i], [&](std::size_t cell) {
+            mCellPrimitives[cellFill[cell]++] = boundedPrimitives[i];
+        });
+    }
+}
+
+const std::vector<ImplicitSurfacePrimitive>& ImplicitSurfaceField::GetPrimitives() const
 {
-    VertexFormat fmt;
+    return mPrimitives;
+}
 
-    fmt.PrimitiveType = PrimitiveType::Triangles;
+ivec3 ImplicitSurfaceField::GetCellIndex(vec3 position) const
+{
+    return ivec3(int(std::floor(position.x / mCellSize)),
+                 int(std::floor(position.y / mCellSize)),
+                 int(std::floor(position.z / mCellSize)));
+}
 
-    fmt.Position = VertexAttribute(
-                3,
-                ArithmeticType::Float,
-                false,
-                sizeof(ImplicitSurfaceMesh::Vertex),
-                offsetof(ImplicitSurfaceMesh::Vertex, Position));
+bool ImplicitSurfaceField::GetBatchCell(
+        const float* xs, const float* ys, const float* zs,
+        std::size_t count,
+        ivec3& cell) const
+{
+    vec3 minimum(xs[0], ys[0], zs[0]);
+    vec3 maximum(xs[0], ys[0], zs[0]);
 
-    fmt.Normal = VertexAttribute(
-                3,
-                ArithmeticType::Float,
-                false,
-                sizeof(ImplicitSurfaceMesh::Vertex),
-                offsetof(ImplicitSurfaceMesh::Vertex, Normal));
+    for (std::size_t i = 1; i < count; i++)
+    {
+        minimum = vec3(std::min(minimum.x, xs[i]), std::min(minimum.y, ys[i]), std::min(minimum.z, zs[i]));
+        maximum = vec3(std::max(maximum.x, xs[i]), std::max(maximum.y, ys[i]), std::max(maximum.z, zs[i]));
+    }
 
-    return fmt;
+    ivec3 minCell = GetCellIndex(minimum);
+    ivec3 maxCell = GetCellIndex(maximum);
+
+    cell = minCell;
+
+    return maxCell.x - minCell.x <= 1
+        && maxCell.y - minCell.y <= 1
+        && maxCell.z - minCell.z <= 1;
 }
 
-std::size_t ImplicitSurfaceMesh::GetMaxVertexBufferSize() const
+template<class FunctionT>
+void ImplicitSurfaceField::ForEachPrimitiveInCell(ivec3 cell, FunctionT f) const
 {
-    std::size_t numVertices = WriteVertices(nullptr);
-    return numVertices * sizeof(ImplicitSurfaceMesh::Vertex);
+    for (std::uint32_t prim : mUnboundedPrimitives)
+    {
+        f(mPrimitives[prim]);
+    }
+
+    cell -= mGridMinimum;
+
+    if (cell.x < 0 || cell.x >= mGridSize.x ||
+        cell.y < 0 || cell.y >= mGridSize.y ||
+        cell.z < 0 || cell.z >= mGridSize.z)
+    {
+        return;
+    }
+
+    std::size_t cellIndex = (std::size_t(cell.z) * mGridSize.y + cell.y) * mGridSize.x + cell.x;
+
+    for (std::uint32_t i = mCellStarts[cellIndex]; i < mCellStarts[cellIndex + 1]; i++)
+    {
+        f(mPrimitives[mCellPrimitives[i]]);
+    }
 }
 
-std::size_t ImplicitSurfaceMesh::GetMaxIndexBufferSize() const
+float ImplicitSurfaceField::GetFieldValue(vec3 position) const
 {
-    return 0;
+    float value = 0.0f;
+    GetFieldValues(&position, &value, 1);
+    return value;
 }
 
-std::size_t ImplicitSurfaceMesh::WriteVertices(void* buffer) const
+void ImplicitSurfaceField::GetFieldValues(
+        const vec3* positions,
+        float* values,
+        std::size_t count) const
 {
-    struct TableEntry
+    for (std::size_t batchStart = 0; batchStart < count; batchStart += MaxBatchSize)
     {
-        float Field;
-        bool Visited;
-    };
+        std::size_t batchSize = std::min(MaxBatchSize, count - batchStart);
 
-    std::unordered_map<ivec3, TableEntry, WyvillHash<>> hashTable;
-    hashTable.reserve(1 << (WyvillHash<>::NBits * 3));
+        // transpose into SoA for the filter kernels
+        float xs[MaxBatchSize], ys[MaxBatchSize], zs[MaxBatchSize];
+        float batchValues[MaxBatchSize] = { };
 
-    std::function<float(vec3)> fieldFunction = [&](vec3 p){
-        float f = 0;
-        for (const ImplicitSurfacePrimitive& prim : mPrimitives)
+        for (std::size_t i = 0; i < batchSize; i++)
         {
-            f += prim.GetFieldValue(p);
+            xs[i] = positions[batchStart + i].x;
+            ys[i] = positions[batchStart + i].y;
+            zs[i] = positions[batchStart + i].z;
         }
-        return f;
-    };
 
-    // queue of nodes to visit
-    std::queue<ivec3> toVisit;
-
-    // search for initial seed nodes to visit
-    for (const ImplicitSurfacePrimitive& prim : mPrimitives)
-    {
-        ivec3 seed = ivec3(prim.GetPointOnSkeleton() / mVoxelSize);
-        while (prim.GetFieldValue(vec3(seed) * mVoxelSize) >= mIsoValue)
-        {
-            seed.x++;
-        }
-        if (seed.x > 0) seed.x--;
-        toVisit.push(seed);
-    }
-
-    // vertex indices
-    //
-    //        4----------5
-    //       /|         /|
-    //      7----------6 |
-    //      | |        | |
-    //      | |        | |
-    //      | 0--------|-1
-    //      |/         |/
-    //      3----------2
-    //
-    // edge indices
-    //
-    //        .----4-----.
-    //       7|         5|
-    //      .-----6----. |
-    //      | 8        | 9
-    //     11 |       10 |
-    //      | .----0---|-.
-    //      |3         |1
-    //      .-----2----.
-    //
-    // face indices
-    //
-    // 0: left
-    // 1: right
-    // 2: bottom
-    // 3: top
-    // 4: back
-    // 5: front
-    //
-    //              -z
-    //               ^
-    //         +y   /
-    //          ^  /
-    //          | /
-    //    -x <-- --> +x
-    //         /|
-    //        / v
-    //       / -y
-    //      v
-    //     +z
-
-    const std::array<ivec3,8> kVertexToDirection = {{
-        { 0, 0, 0 }, // 0
-        { 1, 0, 0 }, // 1
-        { 1, 0, 1 }, // 2
-        { 0, 0, 1 }, // 3
-        { 0, 1, 0 }, // 4
-        { 1, 1, 0 }, // 5
-        { 1, 1, 1 }, // 6
-        { 0, 1, 1 }  // 7
-    }};
-
-    const std::array<ivec3,6> kFaceToDirection = {{
-        { -1,  0,  0 },
-        { +1,  0,  0 },
-        {  0, -1,  0 },
-        {  0, +1,  0 },
-        {  0,  0, -1 },
-        {  0,  0, +1 }
-    }};
-
-    const std::array<std::uint16_t,6> kFaceToEdges = {{
-        0x988, 0x622, 0xf, 0xf0, 0x311, 0xc44
-    }};
-
-    // precomputed tables from: http://paulbourke.net/geometry/polygonise/
-
-    // maps bitsets representing the polarity of vertices to a bitset of edges
-    const std::array<std::uint16_t,256> kEdges = {{
-        0x0  , 0x109, 0x203, 0x30a, 0x406, 0x50f, 0x605, 0x70c,
-        0x80c, 0x905, 0xa0f, 0xb06, 0xc0a, 0xd03, 0xe09, 0xf00,
-        0x190, 0x99 , 0x393, 0x29a, 0x596, 0x49f, 0x795, 0x69c,
-        0x99c, 0x895, 0xb9f, 0xa96, 0xd9a, 0xc93, 0xf99, 0xe90,
-        0x230, 0x339, 0x33 , 0x13a, 0x636, 0x73f, 0x435, 0x53c,
-        0xa3c, 0xb35, 0x83f, 0x936, 0xe3a, 0xf33, 0xc39, 0xd30,
-        0x3a0, 0x2a9, 0x1a3, 0xaa , 0x7a6, 0x6af, 0x5a5, 0x4ac,
-        0xbac, 0xaa5, 0x9af, 0x8a6, 0xfaa, 0xea3, 0xda9, 0xca0,
-        0x460, 0x569, 0x663, 0x76a, 0x66 , 0x16f, 0x265, 0x36c,
-        0xc6c, 0xd65, 0xe6f, 0xf66, 0x86a, 0x963, 0xa69, 0xb60,
-        0x5f0, 0x4f9, 0x7f3, 0x6fa, 0x1f6, 0xff , 0x3f5, 0x2fc,
-        0xdfc, 0xcf5, 0xfff, 0xef6, 0x9fa, 0x8f3, 0xbf9, 0xaf0,
-        0x650, 0x759, 0x453, 0x55a, 0x256, 0x35f, 0x55 , 0x15c,
-        0xe5c, 0xf55, 0xc5f, 0xd56, 0xa5a, 0xb53, 0x859, 0x950,
-        0x7c0, 0x6c9, 0x5c3, 0x4ca, 0x3c6, 0x2cf, 0x1c5, 0xcc ,
-        0xfcc, 0xec5, 0xdcf, 0xcc6, 0xbca, 0xac3, 0x9c9, 0x8c0,
-        0x8c0, 0x9c9, 0xac3, 0xbca, 0xcc6, 0xdcf, 0xec5, 0xfcc,
-        0xcc , 0x1c5, 0x2cf, 0x3c6, 0x4ca, 0x5c3, 0x6c9, 0x7c0,
-        0x950, 0x859, 0xb53, 0xa5a, 0xd56, 0xc5f, 0xf55, 0xe5c,
-        0x15c, 0x55 , 0x35f, 0x256, 0x55a, 0x453, 0x759, 0x650,
-        0xaf0, 0xbf9, 0x8f3, 0x9fa, 0xef6, 0xfff, 0xcf5, 0xdfc,
-        0x2fc, 0x3f5, 0xff , 0x1f6, 0x6fa, 0x7f3, 0x4f9, 0x5f0,
-        0xb60, 0xa69, 0x963, 0x86a, 0xf66, 0xe6f, 0xd65, 0xc6c,
-        0x36c, 0x265, 0x16f, 0x66 , 0x76a, 0x663, 0x569, 0x460,
-        0xca0, 0xda9, 0xea3, 0xfaa, 0x8a6, 0x9af, 0xaa5, 0xbac,
-        0x4ac, 0x5a5, 0x6af, 0x7a6, 0xaa , 0x1a3, 0x2a9, 0x3a0,
-        0xd30, 0xc39, 0xf33, 0xe3a, 0x936, 0x83f, 0xb35, 0xa3c,
-        0x53c, 0x435, 0x73f, 0x636, 0x13a, 0x33 , 0x339, 0x230,
-        0xe90, 0xf99, 0xc93, 0xd9a, 0xa96, 0xb9f, 0x895, 0x99c,
-        0x69c, 0x795, 0x49f, 0x596, 0x29a, 0x393, 0x99 , 0x190,
-        0xf00, 0xe09, 0xd03, 0xc0a, 0xb06, 0xa0f, 0x905, 0x80c,
-        0x70c, 0x605, 0x50f, 0x406, 0x30a, 0x203, 0x109, 0x0
-    }};
-
-    const std::array<std::array<int,16>,256> kTriangleEdges = {{
-        {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {0, 1, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {1, 8, 3, 9, 8, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {0, 8, 3, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {9, 2, 10, 0, 2, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {2, 8, 3, 2, 10, 8, 10, 9, 8, -1, -1, -1, -1, -1, -1, -1},
-        {3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {0, 11, 2, 8, 11, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {1, 9, 0, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {1, 11, 2, 1, 9, 11, 9, 8, 11, -1, -1, -1, -1, -1, -1, -1},
-        {3, 10, 1, 11, 10, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {0, 10, 1, 0, 8, 10, 8, 11, 10, -1, -1, -1, -1, -1, -1, -1},
-        {3, 9, 0, 3, 11, 9, 11, 10, 9, -1, -1, -1, -1, -1, -1, -1},
-        {9, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {4, 3, 0, 7, 3, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {0, 1, 9, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {4, 1, 9, 4, 7, 1, 7, 3, 1, -1, -1, -1, -1, -1, -1, -1},
-        {1, 2, 10, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {3, 4, 7, 3, 0, 4, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1},
-        {9, 2, 10, 9, 0, 2, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1},
-        {2, 10, 9, 2, 9, 7, 2, 7, 3, 7, 9, 4, -1, -1, -1, -1},
-        {8, 4, 7, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {11, 4, 7, 11, 2, 4, 2, 0, 4, -1, -1, -1, -1, -1, -1, -1},
-        {9, 0, 1, 8, 4, 7, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1},
-        {4, 7, 11, 9, 4, 11, 9, 11, 2, 9, 2, 1, -1, -1, -1, -1},
-        {3, 10, 1, 3, 11, 10, 7, 8, 4, -1, -1, -1, -1, -1, -1, -1},
-        {1, 11, 10, 1, 4, 11, 1, 0, 4, 7, 11, 4, -1, -1, -1, -1},
-        {4, 7, 8, 9, 0, 11, 9, 11, 10, 11, 0, 3, -1, -1, -1, -1},
-        {4, 7, 11, 4, 11, 9, 9, 11, 10, -1, -1, -1, -1, -1, -1, -1},
-        {9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {9, 5, 4, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {0, 5, 4, 1, 5, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {8, 5, 4, 8, 3, 5, 3, 1, 5, -1, -1, -1, -1, -1, -1, -1},
-        {1, 2, 10, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {3, 0, 8, 1, 2, 10, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1},
-        {5, 2, 10, 5, 4, 2, 4, 0, 2, -1, -1, -1, -1, -1, -1, -1},
-        {2, 10, 5, 3, 2, 5, 3, 5, 4, 3, 4, 8, -1, -1, -1, -1},
-        {9, 5, 4, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {0, 11, 2, 0, 8, 11, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1},
-        {0, 5, 4, 0, 1, 5, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1},
-        {2, 1, 5, 2, 5, 8, 2, 8, 11, 4, 8, 5, -1, -1, -1, -1},
-        {10, 3, 11, 10, 1, 3, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1},
-        {4, 9, 5, 0, 8, 1, 8, 10, 1, 8, 11, 10, -1, -1, -1, -1},
-        {5, 4, 0, 5, 0, 11, 5, 11, 10, 11, 0, 3, -1, -1, -1, -1},
-        {5, 4, 8, 5, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1},
-        {9, 7, 8, 5, 7, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {9, 3, 0, 9, 5, 3, 5, 7, 3, -1, -1, -1, -1, -1, -1, -1},
-        {0, 7, 8, 0, 1, 7, 1, 5, 7, -1, -1, -1, -1, -1, -1, -1},
-        {1, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {9, 7, 8, 9, 5, 7, 10, 1, 2, -1, -1, -1, -1, -1, -1, -1},
-        {10, 1, 2, 9, 5, 0, 5, 3, 0, 5, 7, 3, -1, -1, -1, -1},
-        {8, 0, 2, 8, 2, 5, 8, 5, 7, 10, 5, 2, -1, -1, -1, -1},
-        {2, 10, 5, 2, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1},
-        {7, 9, 5, 7, 8, 9, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1},
-        {9, 5, 7, 9, 7, 2, 9, 2, 0, 2, 7, 11, -1, -1, -1, -1},
-        {2, 3, 11, 0, 1, 8, 1, 7, 8, 1, 5, 7, -1, -1, -1, -1},
-        {11, 2, 1, 11, 1, 7, 7, 1, 5, -1, -1, -1, -1, -1, -1, -1},
-        {9, 5, 8, 8, 5, 7, 10, 1, 3, 10, 3, 11, -1, -1, -1, -1},
-        {5, 7, 0, 5, 0, 9, 7, 11, 0, 1, 0, 10, 11, 10, 0, -1},
-        {11, 10, 0, 11, 0, 3, 10, 5, 0, 8, 0, 7, 5, 7, 0, -1},
-        {11, 10, 5, 7, 11, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {0, 8, 3, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {9, 0, 1, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {1, 8, 3, 1, 9, 8, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1},
-        {1, 6, 5, 2, 6, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {1, 6, 5, 1, 2, 6, 3, 0, 8, -1, -1, -1, -1, -1, -1, -1},
-        {9, 6, 5, 9, 0, 6, 0, 2, 6, -1, -1, -1, -1, -1, -1, -1},
-        {5, 9, 8, 5, 8, 2, 5, 2, 6, 3, 2, 8, -1, -1, -1, -1},
-        {2, 3, 11, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {11, 0, 8, 11, 2, 0, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1},
-        {0, 1, 9, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1},
-        {5, 10, 6, 1, 9, 2, 9, 11, 2, 9, 8, 11, -1, -1, -1, -1},
-        {6, 3, 11, 6, 5, 3, 5, 1, 3, -1, -1, -1, -1, -1, -1, -1},
-        {0, 8, 11, 0, 11, 5, 0, 5, 1, 5, 11, 6, -1, -1, -1, -1},
-        {3, 11, 6, 0, 3, 6, 0, 6, 5, 0, 5, 9, -1, -1, -1, -1},
-        {6, 5, 9, 6, 9, 11, 11, 9, 8, -1, -1, -1, -1, -1, -1, -1},
-        {5, 10, 6, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {4, 3, 0, 4, 7, 3, 6, 5, 10, -1, -1, -1, -1, -1, -1, -1},
-        {1, 9, 0, 5, 10, 6, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1},
-        {10, 6, 5, 1, 9, 7, 1, 7, 3, 7, 9, 4, -1, -1, -1, -1},
-        {6, 1, 2, 6, 5, 1, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1},
-        {1, 2, 5, 5, 2, 6, 3, 0, 4, 3, 4, 7, -1, -1, -1, -1},
-        {8, 4, 7, 9, 0, 5, 0, 6, 5, 0, 2, 6, -1, -1, -1, -1},
-        {7, 3, 9, 7, 9, 4, 3, 2, 9, 5, 9, 6, 2, 6, 9, -1},
-        {3, 11, 2, 7, 8, 4, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1},
-        {5, 10, 6, 4, 7, 2, 4, 2, 0, 2, 7, 11, -1, -1, -1, -1},
-        {0, 1, 9, 4, 7, 8, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1},
-        {9, 2, 1, 9, 11, 2, 9, 4, 11, 7, 11, 4, 5, 10, 6, -1},
-        {8, 4, 7, 3, 11, 5, 3, 5, 1, 5, 11, 6, -1, -1, -1, -1},
-        {5, 1, 11, 5, 11, 6, 1, 0, 11, 7, 11, 4, 0, 4, 11, -1},
-        {0, 5, 9, 0, 6, 5, 0, 3, 6, 11, 6, 3, 8, 4, 7, -1},
-        {6, 5, 9, 6, 9, 11, 4, 7, 9, 7, 11, 9, -1, -1, -1, -1},
-        {10, 4, 9, 6, 4, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {4, 10, 6, 4, 9, 10, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1},
-        {10, 0, 1, 10, 6, 0, 6, 4, 0, -1, -1, -1, -1, -1, -1, -1},
-        {8, 3, 1, 8, 1, 6, 8, 6, 4, 6, 1, 10, -1, -1, -1, -1},
-        {1, 4, 9, 1, 2, 4, 2, 6, 4, -1, -1, -1, -1, -1, -1, -1},
-        {3, 0, 8, 1, 2, 9, 2, 4, 9, 2, 6, 4, -1, -1, -1, -1},
-        {0, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {8, 3, 2, 8, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1},
-        {10, 4, 9, 10, 6, 4, 11, 2, 3, -1, -1, -1, -1, -1, -1, -1},
-        {0, 8, 2, 2, 8, 11, 4, 9, 10, 4, 10, 6, -1, -1, -1, -1},
-        {3, 11, 2, 0, 1, 6, 0, 6, 4, 6, 1, 10, -1, -1, -1, -1},
-        {6, 4, 1, 6, 1, 10, 4, 8, 1, 2, 1, 11, 8, 11, 1, -1},
-        {9, 6, 4, 9, 3, 6, 9, 1, 3, 11, 6, 3, -1, -1, -1, -1},
-        {8, 11, 1, 8, 1, 0, 11, 6, 1, 9, 1, 4, 6, 4, 1, -1},
-        {3, 11, 6, 3, 6, 0, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1},
-        {6, 4, 8, 11, 6, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {7, 10, 6, 7, 8, 10, 8, 9, 10, -1, -1, -1, -1, -1, -1, -1},
-        {0, 7, 3, 0, 10, 7, 0, 9, 10, 6, 7, 10, -1, -1, -1, -1},
-        {10, 6, 7, 1, 10, 7, 1, 7, 8, 1, 8, 0, -1, -1, -1, -1},
-        {10, 6, 7, 10, 7, 1, 1, 7, 3, -1, -1, -1, -1, -1, -1, -1},
-        {1, 2, 6, 1, 6, 8, 1, 8, 9, 8, 6, 7, -1, -1, -1, -1},
-        {2, 6, 9, 2, 9, 1, 6, 7, 9, 0, 9, 3, 7, 3, 9, -1},
-        {7, 8, 0, 7, 0, 6, 6, 0, 2, -1, -1, -1, -1, -1, -1, -1},
-        {7, 3, 2, 6, 7, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {2, 3, 11, 10, 6, 8, 10, 8, 9, 8, 6, 7, -1, -1, -1, -1},
-        {2, 0, 7, 2, 7, 11, 0, 9, 7, 6, 7, 10, 9, 10, 7, -1},
-        {1, 8, 0, 1, 7, 8, 1, 10, 7, 6, 7, 10, 2, 3, 11, -1},
-        {11, 2, 1, 11, 1, 7, 10, 6, 1, 6, 7, 1, -1, -1, -1, -1},
-        {8, 9, 6, 8, 6, 7, 9, 1, 6, 11, 6, 3, 1, 3, 6, -1},
-        {0, 9, 1, 11, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {7, 8, 0, 7, 0, 6, 3, 11, 0, 11, 6, 0, -1, -1, -1, -1},
-        {7, 11, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {3, 0, 8, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {0, 1, 9, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {8, 1, 9, 8, 3, 1, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1},
-        {10, 1, 2, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {1, 2, 10, 3, 0, 8, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1},
-        {2, 9, 0, 2, 10, 9, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1},
-        {6, 11, 7, 2, 10, 3, 10, 8, 3, 10, 9, 8, -1, -1, -1, -1},
-        {7, 2, 3, 6, 2, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {7, 0, 8, 7, 6, 0, 6, 2, 0, -1, -1, -1, -1, -1, -1, -1},
-        {2, 7, 6, 2, 3, 7, 0, 1, 9, -1, -1, -1, -1, -1, -1, -1},
-        {1, 6, 2, 1, 8, 6, 1, 9, 8, 8, 7, 6, -1, -1, -1, -1},
-        {10, 7, 6, 10, 1, 7, 1, 3, 7, -1, -1, -1, -1, -1, -1, -1},
-        {10, 7, 6, 1, 7, 10, 1, 8, 7, 1, 0, 8, -1, -1, -1, -1},
-        {0, 3, 7, 0, 7, 10, 0, 10, 9, 6, 10, 7, -1, -1, -1, -1},
-        {7, 6, 10, 7, 10, 8, 8, 10, 9, -1, -1, -1, -1, -1, -1, -1},
-        {6, 8, 4, 11, 8, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {3, 6, 11, 3, 0, 6, 0, 4, 6, -1, -1, -1, -1, -1, -1, -1},
-        {8, 6, 11, 8, 4, 6, 9, 0, 1, -1, -1, -1, -1, -1, -1, -1},
-        {9, 4, 6, 9, 6, 3, 9, 3, 1, 11, 3, 6, -1, -1, -1, -1},
-        {6, 8, 4, 6, 11, 8, 2, 10, 1, -1, -1, -1, -1, -1, -1, -1},
-        {1, 2, 10, 3, 0, 11, 0, 6, 11, 0, 4, 6, -1, -1, -1, -1},
-        {4, 11, 8, 4, 6, 11, 0, 2, 9, 2, 10, 9, -1, -1, -1, -1},
-        {10, 9, 3, 10, 3, 2, 9, 4, 3, 11, 3, 6, 4, 6, 3, -1},
-        {8, 2, 3, 8, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1},
-        {0, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {1, 9, 0, 2, 3, 4, 2, 4, 6, 4, 3, 8, -1, -1, -1, -1},
-        {1, 9, 4, 1, 4, 2, 2, 4, 6, -1, -1, -1, -1, -1, -1, -1},
-        {8, 1, 3, 8, 6, 1, 8, 4, 6, 6, 10, 1, -1, -1, -1, -1},
-        {10, 1, 0, 10, 0, 6, 6, 0, 4, -1, -1, -1, -1, -1, -1, -1},
-        {4, 6, 3, 4, 3, 8, 6, 10, 3, 0, 3, 9, 10, 9, 3, -1},
-        {10, 9, 4, 6, 10, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {4, 9, 5, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {0, 8, 3, 4, 9, 5, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1},
-        {5, 0, 1, 5, 4, 0, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1},
-        {11, 7, 6, 8, 3, 4, 3, 5, 4, 3, 1, 5, -1, -1, -1, -1},
-        {9, 5, 4, 10, 1, 2, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1},
-        {6, 11, 7, 1, 2, 10, 0, 8, 3, 4, 9, 5, -1, -1, -1, -1},
-        {7, 6, 11, 5, 4, 10, 4, 2, 10, 4, 0, 2, -1, -1, -1, -1},
-        {3, 4, 8, 3, 5, 4, 3, 2, 5, 10, 5, 2, 11, 7, 6, -1},
-        {7, 2, 3, 7, 6, 2, 5, 4, 9, -1, -1, -1, -1, -1, -1, -1},
-        {9, 5, 4, 0, 8, 6, 0, 6, 2, 6, 8, 7, -1, -1, -1, -1},
-        {3, 6, 2, 3, 7, 6, 1, 5, 0, 5, 4, 0, -1, -1, -1, -1},
-        {6, 2, 8, 6, 8, 7, 2, 1, 8, 4, 8, 5, 1, 5, 8, -1},
-        {9, 5, 4, 10, 1, 6, 1, 7, 6, 1, 3, 7, -1, -1, -1, -1},
-        {1, 6, 10, 1, 7, 6, 1, 0, 7, 8, 7, 0, 9, 5, 4, -1},
-        {4, 0, 10, 4, 10, 5, 0, 3, 10, 6, 10, 7, 3, 7, 10, -1},
-        {7, 6, 10, 7, 10, 8, 5, 4, 10, 4, 8, 10, -1, -1, -1, -1},
-        {6, 9, 5, 6, 11, 9, 11, 8, 9, -1, -1, -1, -1, -1, -1, -1},
-        {3, 6, 11, 0, 6, 3, 0, 5, 6, 0, 9, 5, -1, -1, -1, -1},
-        {0, 11, 8, 0, 5, 11, 0, 1, 5, 5, 6, 11, -1, -1, -1, -1},
-        {6, 11, 3, 6, 3, 5, 5, 3, 1, -1, -1, -1, -1, -1, -1, -1},
-        {1, 2, 10, 9, 5, 11, 9, 11, 8, 11, 5, 6, -1, -1, -1, -1},
-        {0, 11, 3, 0, 6, 11, 0, 9, 6, 5, 6, 9, 1, 2, 10, -1},
-        {11, 8, 5, 11, 5, 6, 8, 0, 5, 10, 5, 2, 0, 2, 5, -1},
-        {6, 11, 3, 6, 3, 5, 2, 10, 3, 10, 5, 3, -1, -1, -1, -1},
-        {5, 8, 9, 5, 2, 8, 5, 6, 2, 3, 8, 2, -1, -1, -1, -1},
-        {9, 5, 6, 9, 6, 0, 0, 6, 2, -1, -1, -1, -1, -1, -1, -1},
-        {1, 5, 8, 1, 8, 0, 5, 6, 8, 3, 8, 2, 6, 2, 8, -1},
-        {1, 5, 6, 2, 1, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {1, 3, 6, 1, 6, 10, 3, 8, 6, 5, 6, 9, 8, 9, 6, -1},
-        {10, 1, 0, 10, 0, 6, 9, 5, 0, 5, 6, 0, -1, -1, -1, -1},
-        {0, 3, 8, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {10, 5, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {11, 5, 10, 7, 5, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {11, 5, 10, 11, 7, 5, 8, 3, 0, -1, -1, -1, -1, -1, -1, -1},
-        {5, 11, 7, 5, 10, 11, 1, 9, 0, -1, -1, -1, -1, -1, -1, -1},
-        {10, 7, 5, 10, 11, 7, 9, 8, 1, 8, 3, 1, -1, -1, -1, -1},
-        {11, 1, 2, 11, 7, 1, 7, 5, 1, -1, -1, -1, -1, -1, -1, -1},
-        {0, 8, 3, 1, 2, 7, 1, 7, 5, 7, 2, 11, -1, -1, -1, -1},
-        {9, 7, 5, 9, 2, 7, 9, 0, 2, 2, 11, 7, -1, -1, -1, -1},
-        {7, 5, 2, 7, 2, 11, 5, 9, 2, 3, 2, 8, 9, 8, 2, -1},
-        {2, 5, 10, 2, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1},
-        {8, 2, 0, 8, 5, 2, 8, 7, 5, 10, 2, 5, -1, -1, -1, -1},
-        {9, 0, 1, 5, 10, 3, 5, 3, 7, 3, 10, 2, -1, -1, -1, -1},
-        {9, 8, 2, 9, 2, 1, 8, 7, 2, 10, 2, 5, 7, 5, 2, -1},
-        {1, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {0, 8, 7, 0, 7, 1, 1, 7, 5, -1, -1, -1, -1, -1, -1, -1},
-        {9, 0, 3, 9, 3, 5, 5, 3, 7, -1, -1, -1, -1, -1, -1, -1},
-        {9, 8, 7, 5, 9, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {5, 8, 4, 5, 10, 8, 10, 11, 8, -1, -1, -1, -1, -1, -1, -1},
-        {5, 0, 4, 5, 11, 0, 5, 10, 11, 11, 3, 0, -1, -1, -1, -1},
-        {0, 1, 9, 8, 4, 10, 8, 10, 11, 10, 4, 5, -1, -1, -1, -1},
-        {10, 11, 4, 10, 4, 5, 11, 3, 4, 9, 4, 1, 3, 1, 4, -1},
-        {2, 5, 1, 2, 8, 5, 2, 11, 8, 4, 5, 8, -1, -1, -1, -1},
-        {0, 4, 11, 0, 11, 3, 4, 5, 11, 2, 11, 1, 5, 1, 11, -1},
-        {0, 2, 5, 0, 5, 9, 2, 11, 5, 4, 5, 8, 11, 8, 5, -1},
-        {9, 4, 5, 2, 11, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {2, 5, 10, 3, 5, 2, 3, 4, 5, 3, 8, 4, -1, -1, -1, -1},
-        {5, 10, 2, 5, 2, 4, 4, 2, 0, -1, -1, -1, -1, -1, -1, -1},
-        {3, 10, 2, 3, 5, 10, 3, 8, 5, 4, 5, 8, 0, 1, 9, -1},
-        {5, 10, 2, 5, 2, 4, 1, 9, 2, 9, 4, 2, -1, -1, -1, -1},
-        {8, 4, 5, 8, 5, 3, 3, 5, 1, -1, -1, -1, -1, -1, -1, -1},
-        {0, 4, 5, 1, 0, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {8, 4, 5, 8, 5, 3, 9, 0, 5, 0, 3, 5, -1, -1, -1, -1},
-        {9, 4, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {4, 11, 7, 4, 9, 11, 9, 10, 11, -1, -1, -1, -1, -1, -1, -1},
-        {0, 8, 3, 4, 9, 7, 9, 11, 7, 9, 10, 11, -1, -1, -1, -1},
-        {1, 10, 11, 1, 11, 4, 1, 4, 0, 7, 4, 11, -1, -1, -1, -1},
-        {3, 1, 4, 3, 4, 8, 1, 10, 4, 7, 4, 11, 10, 11, 4, -1},
-        {4, 11, 7, 9, 11, 4, 9, 2, 11, 9, 1, 2, -1, -1, -1, -1},
-        {9, 7, 4, 9, 11, 7, 9, 1, 11, 2, 11, 1, 0, 8, 3, -1},
-        {11, 7, 4, 11, 4, 2, 2, 4, 0, -1, -1, -1, -1, -1, -1, -1},
-        {11, 7, 4, 11, 4, 2, 8, 3, 4, 3, 2, 4, -1, -1, -1, -1},
-        {2, 9, 10, 2, 7, 9, 2, 3, 7, 7, 4, 9, -1, -1, -1, -1},
-        {9, 10, 7, 9, 7, 4, 10, 2, 7, 8, 7, 0, 2, 0, 7, -1},
-        {3, 7, 10, 3, 10, 2, 7, 4, 10, 1, 10, 0, 4, 0, 10, -1},
-        {1, 10, 2, 8, 7, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {4, 9, 1, 4, 1, 7, 7, 1, 3, -1, -1, -1, -1, -1, -1, -1},
-        {4, 9, 1, 4, 1, 7, 0, 8, 1, 8, 7, 1, -1, -1, -1, -1},
-        {4, 0, 3, 7, 4, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {4, 8, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {9, 10, 8, 10, 11, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {3, 0, 9, 3, 9, 11, 11, 9, 10, -1, -1, -1, -1, -1, -1, -1},
-        {0, 1, 10, 0, 10, 8, 8, 10, 11, -1, -1, -1, -1, -1, -1, -1},
-        {3, 1, 10, 11, 3, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {1, 2, 11, 1, 11, 9, 9, 11, 8, -1, -1, -1, -1, -1, -1, -1},
-        {3, 0, 9, 3, 9, 11, 1, 2, 9, 2, 11, 9, -1, -1, -1, -1},
-        {0, 2, 11, 8, 0, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {3, 2, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {2, 3, 8, 2, 8, 10, 10, 8, 9, -1, -1, -1, -1, -1, -1, -1},
-        {9, 10, 2, 0, 9, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {2, 3, 8, 2, 8, 10, 0, 1, 8, 1, 10, 8, -1, -1, -1, -1},
-        {1, 10, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {1, 3, 8, 9, 1, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {0, 9, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {0, 3, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-        {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}
-    }};
-
-    const std::array<std::pair<int,int>,12> kVerticesOfEdge = { {
-        {0,1}, {1,2}, {2,3}, {0,3}, {4,5}, {5,6},
-        {6,7}, {4,7}, {0,4}, {1,5}, {2,6}, {3,7}
-    }};
-
-    const auto isoLerp = [](float isoValue, vec3 P1, vec3 P2, float V1, float V2)
-    {
-        return P1 + (isoValue - V1) * (P2 - P1) / (V2 - V1);
-    };
+        ivec3 cell;
+        if (GetBatchCell(xs, ys, zs, batchSize, cell))
+        {
+            ForEachPrimitiveInCell(cell, [&](const ImplicitSurfacePrimitive& prim) {
+                prim.AccumulateFieldValues(xs, ys, zs, batchValues, batchSize);
+            });
+        }
+        else
+        {
+            // too spread out to share a cell
+            for (std::size_t i = 0; i < batchSize; i++)
+            {
+                ForEachPrimitiveInCell(GetCellIndex(positions[batchStart + i]),
+                                       [&](const ImplicitSurfacePrimitive& prim) {
+                    prim.AccumulateFieldValues(&xs[i], &ys[i], &zs[i], &batchValues[i], 1);
+                });
+            }
+        }
 
-    // 0.01f found empirically (from Fundamentals of Computer Graphics page 399)
-    const float gradientDelta = 0.01f * mVoxelSize;
+        std::copy(batchValues, batchValues + batchSize, values + batchStart);
+    }
+}
 
-    ImplicitSurfaceMesh::Vertex* vertexBuffer = static_cast<ImplicitSurfaceMesh::Vertex*>(buffer);
-    std::size_t vertexBufferIndex = 0;
+float ImplicitSurfaceField::GetFieldValueAndGradient(vec3 position, vec3& gradient) const
+{
+    float value = 0.0f;
+    GetFieldValuesAndGradients(&position, &value, &gradient, 1);
+    return value;
+}
 
-    while (!toVisit.empty())
+void ImplicitSurfaceField::GetFieldValuesAndGradients(
+        const vec3* positions,
+        float* values,
+        vec3* gradients,
+        std::size_t count) const
+{
+    for (std::size_t batchStart = 0; batchStart < count; batchStart += MaxBatchSize)
     {
-        ivec3 vertexToVisit = toVisit.front();
-        toVisit.pop();
+        std::size_t batchSize = std::min(MaxBatchSize, count - batchStart);
+
+        float xs[MaxBatchSize], ys[MaxBatchSize], zs[MaxBatchSize];
+        float batchValues[MaxBatchSize] = { };
+        float gxs[MaxBatchSize] = { }, gys[MaxBatchSize] = { }, gzs[MaxBatchSize] = { };
+
+        for (std::size_t i = 0; i < batchSize; i++)
+        {
+            xs[i] = positions[batchStart + i].x;
+            ys[i] = positions[batchStart + i].y;
+            zs[i] = positions[batchStart + i].z;
+        }
 
+        ivec3 cell;
+        if (GetBatchCell(xs, ys, zs, batchSize, cell))
+        {
+            ForEachPrimitiveInCell(cell, [&](const ImplicitSurfacePrimitive& prim) {
+                prim.AccumulateFieldValuesAndGradients(
+                            xs, ys, zs, batchValues, gxs, gys, gzs, batchSize);
+            });
+        }
+        else
         {
-            // check if it was already visited
-            auto it = hashTable.find(vertexToVisit);
-            if (it != hashTable.end() && it->second.Visited)
+            for (std::size_t i = 0; i < batchSize; i++)
             {
-                continue;
+                ForEachPrimitiveInCell(GetCellIndex(positions[batchStart + i]),
+                                       [&](const ImplicitSurfacePrimitive& prim) {
+                    prim.AccumulateFieldValuesAndGradients(
+                                &xs[i], &ys[i], &zs[i], &batchValues[i],
+                                &gxs[i], &gys[i], &gzs[i], 1);
+                });
             }
         }
 
-        // calculate the absolute values of the lattice indices
-        std::array<ivec3,8> latticeIndices;
-        for (std::size_t i = 0; i < latticeIndices.size(); i++)
+        for (std::size_t i = 0; i < batchSize; i++)
+        {
+            values[batchStart + i] = batchValues[i];
+            gradients[batchStart + i] = vec3(gxs[i], gys[i], gzs[i]);
+        }
+    }
+}
+
+class ImplicitSurface::Polygonizer
+{
+    class WorkQueue
+    {
+    public:
+        std::mutex Mutex;
+        std::deque<Brick*> Bricks;
+    };
+
+    const float mIsoValue;
+    const float mVoxelSize;
+
+    // started once, since surfaces are usually updated every frame.
+    worker_pool mWorkers;
+
+    // only set while updating.
+    const ImplicitSurfaceField* mField = nullptr;
+
+    std::mutex mBricksMutex;
+    std::unordered_map<ivec3, std::unique_ptr<Brick>, BrickHash> mBricks;
+    std::vector<Brick*> mSortedBricks;
+
+    // the cell where stepping out of each primitive last crossed the surface.
+    std::unordered_map<PrimitiveID, ivec3> mSurfaceCells;
+
+    std::vector<std::unique_ptr<WorkQueue>> mQueues;
+    std::atomic<std::size_t> mOutstanding;
+    std::atomic<bool> mAborted;
+
+    // workers with nothing to do wait for a brick to be queued, or for the
+    // traversal to end. mNumQueued counts the bricks in all the queues.
+    std::mutex mIdleMutex;
+    std::condition_variable mIdleCondition;
+    std::atomic<std::size_t> mNumQueued;
+    std::atomic<std::size_t> mNumIdle;
+
+    // waking idle workers only takes the lock if one might be waiting. the
+    // waiter counts itself idle before checking for work, so either it sees
+    // the new work or the notifier sees it waiting.
+    void WakeIdleWorkers(bool all)
+    {
+        if (mNumIdle == 0)
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mIdleMutex);
+        }
+
+        if (all)
+        {
+            mIdleCondition.notify_all();
+        }
+        else
+        {
+            mIdleCondition.notify_one();
+        }
+    }
+
+    Brick& GetOrCreateBrick(ivec3 coordinate)
+    {
+        std::lock_guard<std::mutex> lock(mBricksMutex);
+        std::unique_ptr<Brick>& brick = mBricks[coordinate];
+        if (!brick)
         {
-            latticeIndices[i] = vertexToVisit + kVertexToDirection[i];
+            brick = ng::make_unique<Brick>(coordinate);
         }
+        return *brick;
+    }
+
+    void QueueCell(ivec3 cell, std::size_t worker)
+    {
+        Brick& brick = GetOrCreateBrick(BrickOfCell(cell));
 
-        std::array<vec3,8> absolutePositions;
-        for (std::size_t i = 0; i < absolutePositions.size(); i++)
+        bool schedule;
         {
-            absolutePositions[i] = vec3(latticeIndices[i]) * mVoxelSize;
+            std::lock_guard<std::mutex> lock(brick.PendingMutex);
+            brick.PendingCells.push_back(cell - brick.Coordinate * kBrickSize);
+            schedule = !brick.Scheduled;
+            brick.Scheduled = true;
         }
 
-        // calculate the field value at all indices or grab the cached ones.
-        std::array<float,8> fieldValues;
-        for (std::size_t i = 0; i < fieldValues.size(); i++)
+        if (schedule)
         {
-            ivec3 latticeIndex = latticeIndices[i];
-            auto it = hashTable.find(latticeIndex);
-            if (it != hashTable.end())
+            mOutstanding++;
             {
-                fieldValues[i] = it->second.Field;
+                std::lock_guard<std::mutex> lock(mQueues[worker]->Mutex);
+                mQueues[worker]->Bricks.push_back(&brick);
+                mNumQueued++;
             }
-            else
+            WakeIdleWorkers(false);
+        }
+    }
+
+    // takes the most recently queued brick of the worker's own queue,
+    // or steals the oldest brick of another worker's queue.
+    Brick* PopBrick(std::size_t worker)
+    {
+        {
+            WorkQueue& own = *mQueues[worker];
+            std::lock_guard<std::mutex> lock(own.Mutex);
+            if (!own.Bricks.empty())
             {
-                fieldValues[i] = fieldFunction(absolutePositions[i]);
-                hashTable.emplace(latticeIndex, TableEntry{fieldValues[i], false});
+                Brick* brick = own.Bricks.back();
+                own.Bricks.pop_back();
+                mNumQueued--;
+                return brick;
             }
         }
 
-        // calculate the signs of all corners
-        // inside  = 1 / '+' / f >= iso
-        // outside = 0 / '-' / f <  iso
-        std::uint8_t signBits = 0;
-        for (std::size_t i = 0; i < fieldValues.size(); i++)
+        for (std::size_t i = 1; i < mQueues.size(); i++)
         {
-            signBits |= (fieldValues[i] >= mIsoValue) << i;
+            WorkQueue& victim = *mQueues[(worker + i) % mQueues.size()];
+            std::lock_guard<std::mutex> lock(victim.Mutex);
+            if (!victim.Bricks.empty())
+            {
+                Brick* brick = victim.Bricks.front();
+                victim.Bricks.pop_front();
+                mNumQueued--;
+                return brick;
+            }
         }
 
-        hashTable[vertexToVisit].Visited = true;
+        return nullptr;
+    }
+
+    // the worker that scheduled the brick is the only one touching
+    // its field and visited cells until the pending cells run out.
+    void ProcessBrick(Brick& brick, std::size_t worker)
+    {
+        std::vector<ivec3> toVisit;
 
-        std::uint16_t edgeBits = kEdges[signBits];
-        if (edgeBits)
+        for (;;)
         {
-            // interpolate vertices between edges
-            std::array<vec3,12> surfaceVertices;
-            for (std::size_t edge = 0; edge < surfaceVertices.size(); edge++)
             {
-                if (edgeBits & (1 << edge))
+                std::lock_guard<std::mutex> lock(brick.PendingMutex);
+                if (brick.PendingCells.empty())
                 {
-                    std::pair<int,int> vertices = kVerticesOfEdge[edge];
-                    surfaceVertices[edge] = isoLerp(
-                                mIsoValue,
-                                absolutePositions[vertices.first], absolutePositions[vertices.second],
-                                fieldValues[vertices.first], fieldValues[vertices.second]);
+                    brick.Scheduled = false;
+                    return;
                 }
+                toVisit.swap(brick.PendingCells);
             }
 
-            const std::array<int,16>& triangles = kTriangleEdges[signBits];
-            for (std::size_t i = 0; triangles[i] != -1; i += 3)
+            while (!toVisit.empty())
             {
-                for (std::size_t j = 0; j < 3; j++)
-                {
-                    if (vertexBuffer != nullptr)
-                    {
-                        vec3 position = surfaceVertices[triangles[i + j]];
-                        vertexBuffer[vertexBufferIndex].Position = position;
+                ivec3 local = toVisit.back();
+                toVisit.pop_back();
+                VisitCell(brick, local, toVisit, worker);
+            }
+        }
+    }
 
-                        vec3 fp(fieldFunction(position));
-                        vec3 gradient(fieldFunction(position + vec3(gradientDelta,0,0)),
-                                      fieldFunction(position + vec3(0,gradientDelta,0)),
-                                      fieldFunction(position + vec3(0,0,gradientDelta)));
-                        gradient -= fp;
+    std::uint8_t GetSignBits(const Brick& brick, ivec3 local) const
+    {
+        std::uint8_t signBits = 0;
+        for (std::size_t i = 0; i < kVertexToDirection.size(); i++)
+        {
+            signBits |= (brick.Field[PointIndex(local + kVertexToDirection[i])] >= mIsoValue) << i;
+        }
+        return signBits;
+    }
 
-                        // dunno why the sign needs to be flipped.
-                        // I guess I use the isovalue the opposite way as most people do?
-                        gradient /= vec3(-gradientDelta);
+    void VisitCell(Brick& brick, ivec3 local, std::vector<ivec3>& toVisit, std::size_t worker)
+    {
+        std::size_t cellIndex = CellIndex(local);
+        if (brick.Visited[cellIndex])
+        {
+            return;
+        }
+        brick.Visited[cellIndex] = true;
+        brick.Modified = true;
 
-                        vertexBuffer[vertexBufferIndex].Normal = normalize(gradient);
-                    }
+        ivec3 cell = brick.Coordinate * kBrickSize + local;
 
-                    vertexBufferIndex++;
-                }
+        // evaluate the corners no neighbouring cell has evaluated yet in one batch.
+        std::array<vec3,8> missingPositions;
+        std::array<std::size_t,8> missingPoints;
+        std::size_t numMissing = 0;
+        for (std::size_t i = 0; i < kVertexToDirection.size(); i++)
+        {
+            std::size_t point = PointIndex(local + kVertexToDirection[i]);
+            if (std::isnan(brick.Field[point]))
+            {
+                missingPositions[numMissing] = vec3(cell + kVertexToDirection[i]) * mVoxelSize;
+                missingPoints[numMissing] = point;
+                numMissing++;
+            }
+        }
+
+        if (numMissing > 0)
+        {
+            std::array<float,8> missingValues;
+            mField->GetFieldValues(missingPositions.data(), missingValues.data(), numMissing);
+
+            for (std::size_t i = 0; i < numMissing; i++)
+            {
+                brick.Field[missingPoints[i]] = missingValues[i];
             }
+        }
 
-            // add neighbours if their faces intersect with the surface of the field
-            for (std::size_t i = 0; i < kFaceToEdges.size(); i++)
+        // add neighbours if their faces intersect with the surface of the field
+        std::uint16_t edgeBits = kEdges[GetSignBits(brick, local)];
+        for (std::size_t i = 0; i < kFaceToEdges.size(); i++)
+        {
+            if (kFaceToEdges[i] & edgeBits)
             {
-                std::uint16_t faceBits = kFaceToEdges[i];
-                if (faceBits & edgeBits)
+                ivec3 neighbour = local + kFaceToDirection[i];
+                if (neighbour.x >= 0 && neighbour.x < kBrickSize &&
+                    neighbour.y >= 0 && neighbour.y < kBrickSize &&
+                    neighbour.z >= 0 && neighbour.z < kBrickSize)
                 {
-                    ivec3 toQueue = vertexToVisit + kFaceToDirection[i];
-                    auto it = hashTable.find(toQueue);
-                    if (it == hashTable.end() || !it->second.Visited)
+                    if (!brick.Visited[CellIndex(neighbour)])
                     {
-                        toVisit.push(toQueue);
+                        toVisit.push_back(neighbour);
                     }
                 }
+                else
+                {
+                    QueueCell(cell + kFaceToDirection[i], worker);
+                }
             }
         }
     }
 
-    return vertexBufferIndex;
-}
-
-std::size_t ImplicitSurfaceMesh::WriteIndices(void*) const
-{
-    return 0;
+    void TraversalWorker(std::size_t worker)
+    {
+        while (mOutstanding > 0 && !mAborted)
+        {
+            Brick* brick = PopBrick(worker);
+            if (brick == nullptr)
+            {
+                std::unique_lock<std::mutex> lock(mIdleMutex);
+                mNumIdle++;
+                mIdleCondition.wait(lock, [this]{
+                    return mNumQueued > 0 || mOutstanding == 0 || mAborted;
+                });
+                mNumIdle--;
+                continue;
+            }
+
+            try
+            {
+                ProcessBrick(*brick, worker);
+            }
+            catch (...)
+            {
+                mAborted = true;
+                WakeIdleWorkers(true);
+                throw;
+            }
+
+            if (--mOutstanding == 0)
+            {
+                WakeIdleWorkers(true);
+            }
+        }
+    }
+
+    // after a worker threw, nothing is left queued or scheduled, and the bricks
+    // the traversal reached are thrown away like edited ones, so the next update
+    // walks them again rather than keeping the cells it didn't get to as holes.
+    void ResetTraversal()
+    {
+        for (const std::unique_ptr<WorkQueue>& queue : mQueues)
+        {
+            queue->Bricks.clear();
+        }
+
+        mOutstanding = 0;
+        mNumQueued = 0;
+
+        for (const auto& entry : mBricks)
+        {
+            Brick& brick = *entry.second;
+            brick.PendingCells.clear();
+            brick.Scheduled = false;
+
+            if (brick.Modified)
+            {
+                brick.Field.assign(kPointsPerBrick, std::numeric_limits<float>::quiet_NaN());
+                brick.Visited.reset();
+                brick.Invalidated = true;
+            }
+        }
+    }
+
+    // steps along +x from a point inside the surface to the cell crossing it.
+    // stepping through the whole field rather than through the primitive alone
+    // avoids starting inside surfaces made of several primitives.
+    ivec3 FindSurfaceCell(ivec3 start) const
+    {
+        ivec3 cell = start;
+        if (mField->GetFieldValue(vec3(cell) * mVoxelSize) >= mIsoValue)
+        {
+            while (mField->GetFieldValue(vec3(cell + ivec3(1, 0, 0)) * mVoxelSize) >= mIsoValue)
+            {
+                cell.x++;
+            }
+        }
+        return cell;
+    }
+
+    bool CrossesSurface(ivec3 cell) const
+    {
+        return mField->GetFieldValue(vec3(cell) * mVoxelSize) >= mIsoValue &&
+               mField->GetFieldValue(vec3(cell + ivec3(1, 0, 0)) * mVoxelSize) < mIsoValue;
+    }
+
+    // only steps out of the primitive again if it was edited, or if edits
+    // to the others moved the surface away from where it was found last.
+    ivec3 GetSurfaceCell(PrimitiveID id, ivec3 start)
+    {
+        auto found = mSurfaceCells.find(id);
+        if (found != mSurfaceCells.end() && CrossesSurface(found->second))
+        {
+            return found->second;
+        }
+
+        ivec3 cell = FindSurfaceCell(start);
+        mSurfaceCells[id] = cell;
+        return cell;
+    }
+
+    // throws away the field of the bricks the edited primitives reach,
+    // padded by a voxel so the field at the points of the other bricks is
+    // exactly the same as before (the edited primitives add exactly zero there.)
+    void Invalidate(const std::vector<AxisAlignedBoundingBox<float>>& dirtyBounds)
+    {
+        const float brickExtent = kBrickSize * mVoxelSize;
+        const vec3 padding(mVoxelSize);
+
+        for (const auto& entry : mBricks)
+        {
+            Brick& brick = *entry.second;
+            vec3 minimum = vec3(brick.Coordinate) * brickExtent;
+            vec3 maximum = minimum + vec3(brickExtent);
+
+            for (const AxisAlignedBoundingBox<float>& bounds : dirtyBounds)
+            {
+                if (BoxesOverlap(minimum, maximum, bounds.Minimum - padding, bounds.Maximum + padding))
+                {
+                    brick.Field.assign(kPointsPerBrick, std::numeric_limits<float>::quiet_NaN());
+                    brick.Visited.reset();
+                    brick.Invalidated = true;
+                    brick.Modified = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    // the surface leaving the visited cells of untouched bricks
+    // continues into the invalidated bricks next to them.
+    void QueueInvalidatedBoundaries()
+    {
+        for (const auto& entry : mBricks)
+        {
+            const Brick& brick = *entry.second;
+            if (!brick.Invalidated)
+            {
+                continue;
+            }
+
+            for (std::size_t face = 0; face < kFaceToDirection.size(); face++)
+            {
+                const Brick* neighbour = FindBrick(brick.Coordinate + kFaceToDirection[face]);
+                if (neighbour == nullptr || neighbour->Invalidated)
+                {
+                    continue;
+                }
+
+                // faces come in pairs of opposite directions.
+                std::size_t neighbourFace = face ^ 1;
+                int axis = static_cast<int>(face / 2);
+                int layer = kFaceToDirection[face][axis] > 0 ? 0 : kBrickSize - 1;
+
+                for (int u = 0; u < kBrickSize; u++)
+                {
+                    for (int v = 0; v < kBrickSize; v++)
+                    {
+                        ivec3 local;
+                        local[axis] = layer;
+                        local[(axis + 1) % 3] = u;
+                        local[(axis + 2) % 3] = v;
+
+                        if (neighbour->Visited[CellIndex(local)] &&
+                            (kEdges[GetSignBits(*neighbour, local)] & kFaceToEdges[neighbourFace]))
+                        {
+                            ivec3 cell = neighbour->Coordinate * kBrickSize + local;
+                            QueueCell(cell + kFaceToDirection[neighbourFace], 0);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // every visited cell creates the vertices on the edges leaving its corner 0,
+    // so each vertex is created by exactly one brick.
+    void CreateVertices(Brick& brick) const
+    {
+        brick.EdgeVertices.assign(kCellsPerBrick, {{ kNoVertex, kNoVertex, kNoVertex }});
+        brick.Positions.clear();
+        brick.Normals.clear();
+
+        for (std::size_t cellIndex = 0; cellIndex < kCellsPerBrick; cellIndex++)
+        {
+            if (!brick.Visited[cellIndex])
+            {
+                continue;
+            }
+
+            ivec3 local = CellOfIndex(cellIndex);
+            ivec3 cell = brick.Coordinate * kBrickSize + local;
+            float value = brick.Field[PointIndex(local)];
+
+            for (int axis = 0; axis < 3; axis++)
+            {
+                ivec3 direction(0, 0, 0);
+                direction[axis] = 1;
+
+                float otherValue = brick.Field[PointIndex(local + direction)];
+                if ((value >= mIsoValue) != (otherValue >= mIsoValue))
+                {
+                    brick.EdgeVertices[cellIndex][axis] = brick.Positions.size();
+                    brick.Positions.push_back(IsoLerp(
+                                mIsoValue,
+                                vec3(cell) * mVoxelSize, vec3(cell + direction) * mVoxelSize,
+                                value, otherValue));
+                }
+            }
+        }
+
+        std::vector<float> values(brick.Positions.size());
+        std::vector<vec3> gradients(brick.Positions.size());
+        mField->GetFieldValuesAndGradients(
+                    brick.Positions.data(), values.data(), gradients.data(), brick.Positions.size());
+
+        // the field decreases going out of the surface,
+        // so the outward normal is against the gradient.
+        brick.Normals.reserve(gradients.size());
+        for (vec3 gradient : gradients)
+        {
+            brick.Normals.push_back(normalize(-gradient));
+        }
+    }
+
+    std::uint16_t EncodeEdgeVertex(const Brick& brick, ivec3 point, int axis) const
+    {
+        // lattice points on the far faces of the brick belong to the bricks after it.
+        ivec3 offset(point.x / kBrickSize, point.y / kBrickSize, point.z / kBrickSize);
+
+        const Brick* owner = offset == ivec3(0) ? &brick : FindBrick(brick.Coordinate + offset);
+        std::uint32_t vertex = owner != nullptr
+                ? owner->EdgeVertices[CellIndex(point - offset * kBrickSize)][axis]
+                : kNoVertex;
+
+        if (vertex == kNoVertex)
+        {
+            throw std::logic_error("Surface edge was not visited by the polygonizer");
+        }
+
+        int code = offset.x | (offset.y << 1) | (offset.z << 2);
+        return static_cast<std::uint16_t>((code << kEdgeVertexBits) | vertex);
+    }
+
+    void EmitTriangles(Brick& brick) const
+    {
+        brick.Triangles.clear();
+
+        for (std::size_t cellIndex = 0; cellIndex < kCellsPerBrick; cellIndex++)
+        {
+            if (!brick.Visited[cellIndex])
+            {
+                continue;
+            }
+
+            ivec3 local = CellOfIndex(cellIndex);
+
+            const std::array<int,16>& triangles = kTriangleEdges[GetSignBits(brick, local)];
+            for (std::size_t i = 0; triangles[i] != -1; i++)
+            {
+                int corner = kEdgeToCornerAndAxis[triangles[i]].first;
+                int axis = kEdgeToCornerAndAxis[triangles[i]].second;
+                brick.Triangles.push_back(EncodeEdgeVertex(brick, local + kVertexToDirection[corner], axis));
+            }
+        }
+    }
+
+    // re-creates the vertices of the modified bricks, and the triangles of
+    // all the bricks that refer to them. bricks the surface left are dropped.
+    void Remesh()
+    {
+        std::vector<Brick*> modified;
+        std::vector<Brick*> retriangulated;
+
+        for (const auto& entry : mBricks)
+        {
+            Brick* brick = entry.second.get();
+            if (!brick->Modified)
+            {
+                continue;
+            }
+
+            modified.push_back(brick);
+
+            for (int code = 0; code < 8; code++)
+            {
+                Brick* referrer = FindBrick(brick->Coordinate - OffsetOfOwnerCode(code));
+                if (referrer != nullptr)
+                {
+                    retriangulated.push_back(referrer);
+                }
+            }
+        }
+
+        if (modified.empty())
+        {
+            return;
+        }
+
+        std::sort(retriangulated.begin(), retriangulated.end());
+        retriangulated.erase(std::unique(retriangulated.begin(), retriangulated.end()), retriangulated.end());
+
+        const auto isEmpty = [](const Brick* brick) { return brick->Visited.none(); };
+        retriangulated.erase(std::remove_if(retriangulated.begin(), retriangulated.end(), isEmpty), retriangulated.end());
+
+        auto firstEmpty = std::partition(modified.begin(), modified.end(), [&](const Brick* brick) { return !isEmpty(brick); });
+        for (auto it = firstEmpty; it != modified.end(); ++it)
+        {
+            mBricks.erase((*it)->Coordinate);
+        }
+        modified.erase(firstEmpty, modified.end());
+
+        mWorkers.parallel_for(modified.size(), [&](std::size_t i)
+        {
+            CreateVertices(*modified[i]);
+        });
+
+        mWorkers.parallel_for(retriangulated.size(), [&](std::size_t i)
+        {
+            EmitTriangles(*retriangulated[i]);
+        });
+
+        for (Brick* brick : modified)
+        {
+            brick->Invalidated = false;
+            brick->Modified = false;
+        }
+
+        mSortedBricks.clear();
+        for (const auto& entry : mBricks)
+        {
+            mSortedBricks.push_back(entry.second.get());
+        }
+
+        std::sort(mSortedBricks.begin(), mSortedBricks.end(), [](const Brick* a, const Brick* b)
+        {
+            return std::make_tuple(a->Coordinate.z, a->Coordinate.y, a->Coordinate.x)
+                 < std::make_tuple(b->Coordinate.z, b->Coordinate.y, b->Coordinate.x);
+        });
+    }
+
+public:
+    Polygonizer(float isoValue, float voxelSize)
+        : mIsoValue(isoValue)
+        , mVoxelSize(voxelSize)
+        , mOutstanding(0)
+        , mAborted(false)
+        , mNumQueued(0)
+        , mNumIdle(0)
+    {
+        for (std::size_t i = 0; i < mWorkers.size(); i++)
+        {
+            mQueues.push_back(ng::make_unique<WorkQueue>());
+        }
+    }
+
+    Brick* FindBrick(ivec3 coordinate) const
+    {
+        auto it = mBricks.find(coordinate);
+        return it != mBricks.end() ? it->second.get() : nullptr;
+    }
+
+    // to be called when a primitive is edited or removed.
+    void ForgetSurfaceCell(PrimitiveID id)
+    {
+        mSurfaceCells.erase(id);
+    }
+
+    // brings the bricks up to date with the edits within dirtyBounds.
+    // ids are those of the field's primitives, in the same order.
+    // the result only depends on the set of visited cells, not on the order
+    // or the threads they were visited by.
+    void Update(
+            const ImplicitSurfaceField& field,
+            const std::vector<PrimitiveID>& ids,
+            const std::vector<AxisAlignedBoundingBox<float>>& dirtyBounds)
+    {
+        mField = &field;
+        auto fieldScope = make_scope_guard([&]{
+            mField = nullptr;
+        });
+
+        Invalidate(dirtyBounds);
+
+        // the surface around each primitive is found by stepping out of it.
+        // primitives in untouched bricks were already found by earlier updates.
+        const std::vector<ImplicitSurfacePrimitive>& primitives = field.GetPrimitives();
+
+        std::vector<ivec3> seeds;
+        for (std::size_t i = 0; i < primitives.size(); i++)
+        {
+            ivec3 seed = ivec3(primitives[i].GetPointOnSkeleton() / mVoxelSize);
+
+            const Brick* brick = FindBrick(BrickOfCell(seed));
+            if (brick == nullptr || brick->Invalidated)
+            {
+                seeds.push_back(GetSurfaceCell(ids[i], seed));
+            }
+        }
+
+        for (ivec3 seed : seeds)
+        {
+            QueueCell(seed, 0);
+        }
+
+        QueueInvalidatedBoundaries();
+
+        mAborted = false;
+        {
+            auto abortScope = make_scope_guard([&]{
+                if (mAborted)
+                {
+                    ResetTraversal();
+                }
+            });
+
+            mWorkers.run([this](std::size_t worker)
+            {
+                TraversalWorker(worker);
+            });
+        }
+
+        Remesh();
+
+        std::uint32_t firstVertex = 0;
+        for (Brick* brick : mSortedBricks)
+        {
+            brick->FirstVertex = firstVertex;
+            firstVertex += brick->Positions.size();
+        }
+    }
+
+    const std::vector<Brick*>& GetSortedBricks() const
+    {
+        return mSortedBricks;
+    }
+};
+
+ImplicitSurface::ImplicitSurface(float isoValue, float voxelSize)
+    : mVoxelSize(voxelSize > 0.0f ? voxelSize
+               : throw std::logic_error("voxelSize must be > 0"))
+    , mPolygonizer(ng::make_unique<Polygonizer>(isoValue, voxelSize))
+{ }
+
+ImplicitSurface::~ImplicitSurface() = default;
+
+ImplicitSurface::PrimitiveID ImplicitSurface::AddPrimitive(ImplicitSurfacePrimitive primitive)
+{
+    PrimitiveID id = mNextPrimitiveID++;
+
+    mDirtyBounds.push_back(primitive.GetSupportBounds());
+    mPrimitives.emplace(id, std::move(primitive));
+
+    return id;
+}
+
+void ImplicitSurface::SetPrimitive(PrimitiveID id, ImplicitSurfacePrimitive primitive)
+{
+    auto it = mPrimitives.find(id);
+    if (it == mPrimitives.end())
+    {
+        throw std::logic_error("No implicit surface primitive with this ID");
+    }
+
+    mDirtyBounds.push_back(it->second.GetSupportBounds());
+    mDirtyBounds.push_back(primitive.GetSupportBounds());
+    mPolygonizer->ForgetSurfaceCell(id);
+
+    it->second = std::move(primitive);
+}
+
+void ImplicitSurface::RemovePrimitive(PrimitiveID id)
+{
+    auto it = mPrimitives.find(id);
+    if (it == mPrimitives.end())
+    {
+        throw std::logic_error("No implicit surface primitive with this ID");
+    }
+
+    mDirtyBounds.push_back(it->second.GetSupportBounds());
+    mPolygonizer->ForgetSurfaceCell(id);
+
+    mPrimitives.erase(it);
+}
+
+std::shared_ptr<ImplicitSurfaceMesh> ImplicitSurface::Polygonize()
+{
+    if (mMesh && mDirtyBounds.empty())
+    {
+        return mMesh;
+    }
+
+    std::vector<PrimitiveID> ids;
+    std::vector<ImplicitSurfacePrimitive> primitives;
+    for (const auto& entry : mPrimitives)
+    {
+        ids.push_back(entry.first);
+        primitives.push_back(entry.second);
+    }
+
+    ImplicitSurfaceField field(std::move(primitives), mVoxelSize);
+
+    mPolygonizer->Update(field, ids, mDirtyBounds);
+    mDirtyBounds.clear();
+
+    const std::vector<Brick*>& bricks = mPolygonizer->GetSortedBricks();
+
+    std::size_t numVertices = 0;
+    std::size_t numIndices = 0;
+    for (const Brick* brick : bricks)
+    {
+        numVertices += brick->Positions.size();
+        numIndices += brick->Triangles.size();
+    }
+
+    std::vector<ImplicitSurfaceMesh::Vertex> vertices;
+    std::vector<std::uint32_t> indices;
+    vertices.reserve(numVertices);
+    indices.reserve(numIndices);
+
+    for (const Brick* brick : bricks)
+    {
+        for (std::size_t i = 0; i < brick->Positions.size(); i++)
+        {
+            vertices.push_back(ImplicitSurfaceMesh::Vertex{brick->Positions[i], brick->Normals[i]});
+        }
+
+        std::array<const Brick*,8> owners;
+        for (int code = 0; code < 8; code++)
+        {
+            owners[code] = mPolygonizer->FindBrick(brick->Coordinate + OffsetOfOwnerCode(code));
+        }
+
+        for (std::uint16_t corner : brick->Triangles)
+        {
+            indices.push_back(DecodeEdgeVertex(owners, corner));
+        }
+    }
+
+    mMesh = std::shared_ptr<ImplicitSurfaceMesh>(
+                new ImplicitSurfaceMesh(std::move(vertices), std::move(indices)));
+
+    return mMesh;
+}
+
+ImplicitSurfaceMesh::ImplicitSurfaceMesh(
+        std::vector<Vertex> vertices,
+        std::vector<std::uint32_t> indices)
+    : mVertices(std::move(vertices))
+    , mIndices(std::move(indices))
+{ }
+
+ImplicitSurfaceMesh::ImplicitSurfaceMesh(
+        std::vector<ImplicitSurfacePrimitive> primitives,
+        float isoValue,
+        float voxelSize)
+{
+    ImplicitSurface surface(isoValue, voxelSize);
+    for (ImplicitSurfacePrimitive& primitive : primitives)
+    {
+        surface.AddPrimitive(std::move(primitive));
+    }
+
+    // nobody else holds the mesh of a surface that is about to be destroyed.
+    std::shared_ptr<ImplicitSurfaceMesh> mesh = surface.Polygonize();
+    mVertices = std::move(mesh->mVertices);
+    mIndices = std::move(mesh->mIndices);
+}
+
+VertexFormat ImplicitSurfaceMesh::GetVertexFormat() const
+{
+    VertexFormat fmt;
+
+    fmt.PrimitiveType = PrimitiveType::Triangles;
+
+    fmt.Position = VertexAttribute(
+                3,
+                ArithmeticType::Float,
+                false,
+                sizeof(ImplicitSurfaceMesh::Vertex),
+                offsetof(ImplicitSurfaceMesh::Vertex, Position));
+
+    fmt.Normal = VertexAttribute(
+                3,
+                ArithmeticType::Float,
+                false,
+                sizeof(ImplicitSurfaceMesh::Vertex),
+                offsetof(ImplicitSurfaceMesh::Vertex, Normal));
+
+    fmt.IsIndexed = true;
+    fmt.IndexType = GetIndexType();
+    fmt.IndexOffset = 0;
+
+    return fmt;
+}
+
+ArithmeticType ImplicitSurfaceMesh::GetIndexType() const
+{
+    return mVertices.size() <= std::numeric_limits<std::uint16_t>::max() + 1
+         ? ArithmeticType::UInt16
+         : ArithmeticType::UInt32;
+}
+
+std::size_t ImplicitSurfaceMesh::GetMaxVertexBufferSize() const
+{
+    return mVertices.size() * sizeof(ImplicitSurfaceMesh::Vertex);
+}
+
+std::size_t ImplicitSurfaceMesh::GetMaxIndexBufferSize() const
+{
+    return mIndices.size() * SizeOfArithmeticType(GetIndexType());
+}
+
+std::size_t ImplicitSurfaceMesh::WriteVertices(void* buffer) const
+{
+    if (buffer != nullptr)
+    {
+        std::copy(mVertices.begin(), mVertices.end(),
+                  static_cast<ImplicitSurfaceMesh::Vertex*>(buffer));
+    }
+
+    return mVertices.size();
+}
+
+std::size_t ImplicitSurfaceMesh::WriteIndices(void* buffer) const
+{
+    if (buffer != nullptr)
+    {
+        if (GetIndexType() == ArithmeticType::UInt16)
+        {
+            std::copy(mIndices.begin(), mIndices.end(),
+                      static_cast<std::uint16_t*>(buffer));
+        }
+        else
+        {
+            std::copy(mIndices.begin(), mIndices.end(),
+                      static_cast<std::uint32_t*>(buffer));
+        }
+    }
+
+    return mIndices.size();
 }
 
 } // end namespace ng
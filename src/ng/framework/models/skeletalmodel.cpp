@@ -63,12 +63,13 @@ SkeletonLocalPose SkeletonLocalPose::FromMD5AnimFrame(
     }
 
     if (frameIndex < 0 ||
-        frameIndex >= (int) anim.Frames.size())
+        frameIndex >= anim.NumFrames)
     {
         throw std::logic_error("frame out of bounds");
     }
 
-    const MD5Frame& frame = anim.Frames[frameIndex];
+    const float* frameComponents = anim.FrameComponents.data()
+            + std::size_t(frameIndex) * anim.NumAnimatedComponents;
 
     for (std::size_t j = 0; j < skeleton.Joints.size(); j++)
     {
@@ -98,42 +99,42 @@ SkeletonLocalPose SkeletonLocalPose::FromMD5AnimFrame(
         if (flags & MD5AnimationJoint::PositionXFlag)
         {
             localPoseJoint.Translation[0] =
-                    frame.AnimationComponents[frameDataOffset];
+                    frameComponents[frameDataOffset];
             frameDataOffset++;
         }
 
         if (flags & MD5AnimationJoint::PositionYFlag)
         {
             localPoseJoint.Translation[1] =
-                    frame.AnimationComponents[frameDataOffset];
+                    frameComponents[frameDataOffset];
             frameDataOffset++;
         }
 
         if (flags & MD5AnimationJoint::PositionZFlag)
         {
             localPoseJoint.Translation[2] =
-                    frame.AnimationComponents[frameDataOffset];
+                    frameComponents[frameDataOffset];
             frameDataOffset++;
         }
 
         if (flags & MD5AnimationJoint::QuaternionXFlag)
         {
             quat.Components[0] =
-                    frame.AnimationComponents[frameDataOffset];
+                    frameComponents[frameDataOffset];
             frameDataOffset++;
         }
 
         if (flags & MD5AnimationJoint::QuaternionYFlag)
         {
             quat.Components[1] =
-                    frame.AnimationComponents[frameDataOffset];
+                    frameComponents[frameDataOffset];
             frameDataOffset++;
         }
 
         if (flags & MD5AnimationJoint::QuaternionZFlag)
         {
             quat.Components[2] =
-                    frame.AnimationComponents[frameDataOffset];
+                    frameComponents[frameDataOffset];
             frameDataOffset++;
         }
 
@@ -0,0 +1,101 @@
+#include "ng/engine/filesystem/filesystem.hpp"
+#include "ng/engine/filesystem/readfile.hpp"
+
+#include "ng/framework/loaders/objloader.hpp"
+#include "ng/framework/loaders/md5loader.hpp"
+
+#include "ng/framework/meshes/binarymesh.hpp"
+#include "ng/framework/meshes/objmesh.hpp"
+#include "ng/framework/meshes/md5mesh.hpp"
+
+#include "ng/framework/models/objmodel.hpp"
+#include "ng/framework/models/md5model.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+
+bool EndsWith(const std::string& s, const char* suffix)
+{
+    std::size_t suffixLength = std::strlen(suffix);
+    return s.size() >= suffixLength &&
+           s.compare(s.size() - suffixLength, suffixLength, suffix) == 0;
+}
+
+std::unique_ptr<ng::IMesh> LoadTextMesh(ng::IFileSystem& fileSystem, const std::string& path)
+{
+    if (EndsWith(path, ".obj"))
+    {
+        std::shared_ptr<ng::IReadFile> objFile =
+                fileSystem.GetReadFile(path.c_str(), ng::FileReadMode::Text);
+
+        ng::ObjModel model;
+        ng::LoadObj(model, *objFile);
+        return std::unique_ptr<ng::IMesh>(new ng::ObjMesh(std::move(model)));
+    }
+    else if (EndsWith(path, ".md5mesh"))
+    {
+        std::shared_ptr<ng::IReadFile> md5meshFile =
+                fileSystem.GetReadFile(path.c_str(), ng::FileReadMode::Text);
+
+        ng::MD5Model model;
+        ng::LoadMD5Mesh(model, *md5meshFile);
+        return std::unique_ptr<ng::IMesh>(new ng::MD5Mesh(std::move(model)));
+    }
+
+    throw std::runtime_error("Don't know how to convert " + path
+                           + " (expected .obj or .md5mesh)");
+}
+
+} // end anonymous namespace
+
+int main(int argc, char* argv[]) try
+{
+    if (argc != 2 && argc != 3)
+    {
+        std::fprintf(stderr,
+                     "usage: %s <input.obj|input.md5mesh> [output.ngmesh]\n"
+                     "converts a mesh to the binary .ngmesh format.\n"
+                     "the output defaults to the input with its extension "
+                     "replaced by .ngmesh\n",
+                     argv[0]);
+        return 1;
+    }
+
+    std::string inputPath = argv[1];
+    std::string outputPath;
+
+    if (argc == 3)
+    {
+        outputPath = argv[2];
+    }
+    else
+    {
+        outputPath = inputPath.substr(0, inputPath.find_last_of('.')) + ".ngmesh";
+    }
+
+    std::shared_ptr<ng::IFileSystem> fileSystem = ng::CreateFileSystem();
+
+    std::unique_ptr<ng::IMesh> mesh = LoadTextMesh(*fileSystem, inputPath);
+    ng::SaveBinaryMesh(*mesh, outputPath.c_str());
+
+    // read it back to make sure the output is valid
+    ng::BinaryMesh converted(fileSystem->GetReadFile(outputPath.c_str(),
+                                                     ng::FileReadMode::Binary));
+
+    std::printf("%s -> %s: %zu vertices (%zu bytes), %zu indices (%zu bytes)\n",
+                inputPath.c_str(), outputPath.c_str(),
+                converted.WriteVertices(nullptr), converted.GetMaxVertexBufferSize(),
+                converted.WriteIndices(nullptr), converted.GetMaxIndexBufferSize());
+}
+catch (const std::exception& e)
+{
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+}
@@ -0,0 +1,91 @@
+#include "ng/engine/filesystem/archivefilesystem.hpp"
+#include "ng/engine/filesystem/filesystem.hpp"
+#include "ng/engine/filesystem/readfile.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) try
+{
+    bool compress = true;
+    int firstArg = 1;
+
+    if (argc > 1 && std::strcmp(argv[1], "--store") == 0)
+    {
+        compress = false;
+        firstArg++;
+    }
+
+    if (argc - firstArg < 2)
+    {
+        std::fprintf(stderr,
+                     "usage: %s [--store] <output.ngpak> <file>...\n"
+                     "packs files into an .ngpak archive, under the paths they're given with.\n"
+                     "files are LZ4 compressed unless --store is given.\n",
+                     argv[0]);
+        return 1;
+    }
+
+    const char* outputPath = argv[firstArg];
+
+    std::shared_ptr<ng::IFileSystem> fileSystem = ng::CreateFileSystem();
+
+    // keep the files open so their contents can be packed without copying them.
+    std::vector<std::shared_ptr<ng::IReadFile>> files;
+    std::vector<ng::ArchiveInput> inputs;
+
+    for (int i = firstArg + 1; i < argc; i++)
+    {
+        files.push_back(fileSystem->GetReadFile(argv[i], ng::FileReadMode::Binary));
+
+        ng::ArchiveInput input;
+        input.Path = argv[i];
+        input.Contents = files.back()->GetContents();
+        inputs.push_back(input);
+    }
+
+    ng::SaveArchive(outputPath, inputs, compress);
+
+    // read it back to make sure the output is valid
+    ng::ArchiveFileSystem archive(
+                fileSystem->GetReadFile(outputPath, ng::FileReadMode::Binary));
+
+    std::size_t totalSize = 0;
+    std::size_t totalStoredSize = 0;
+
+    for (const ng::ArchiveInput& input : inputs)
+    {
+        std::shared_ptr<ng::IReadFile> packed =
+                archive.GetReadFile(input.Path.c_str(), ng::FileReadMode::Binary);
+
+        if (packed->GetContents() != input.Contents)
+        {
+            throw std::runtime_error("Packed contents of " + input.Path
+                                   + " don't match the original");
+        }
+    }
+
+    for (const ng::ArchiveFileSystem::Entry& entry : archive.GetEntries())
+    {
+        totalSize += entry.Size;
+        totalStoredSize += entry.StoredSize;
+
+        std::printf("%-40s %10zu -> %10zu bytes%s\n",
+                    entry.Path.to_string().c_str(), entry.Size, entry.StoredSize,
+                    entry.IsCompressed ? " (lz4)" : "");
+    }
+
+    std::printf("%s: %zu files, %zu -> %zu bytes (%.1f%%)\n",
+                outputPath, archive.GetEntries().size(), totalSize, totalStoredSize,
+                totalSize > 0 ? 100.0 * totalStoredSize / totalSize : 100.0);
+}
+catch (const std::exception& e)
+{
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+}